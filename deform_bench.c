@@ -0,0 +1,151 @@
+// Vertex deformation throughput: morph target blending and the procedural wave of deform.h over
+// the armadillo, optionally tiled into a larger mesh, in millions of vertices per second.
+// Build with and without -DDEFORM_NO_SIMD, and run with PAR_NUM_THREADS=1, to compare the SIMD
+// kernels with the scalar path and one thread with all of them (see deform_bench.sh).
+#define _POSIX_C_SOURCE 199309L
+#define _VEC_MATH_IMPLEMENTATION_
+#define _MESH_IMPLEMENTATION_
+#define _PARALLEL_IMPLEMENTATION_
+#define _DEFORM_IMPLEMENTATION_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "libs/vec_math.h"
+#include "libs/mesh.h"
+#include "libs/parallel.h"
+#include "libs/deform.h"
+
+#define BENCH_RUNS 20
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Vertices of the armadillo in the SoA layout, repeated `copies` times side by side
+static int32_t load_vertices(const char* filename, int32_t copies, MeshSoA* out_soa) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        perror("Failed to open file");
+        return EXIT_FAILURE;
+    }
+    int32_t counts[2];
+    if (fread(counts, sizeof(int32_t), 2, file) != 2) {
+        perror("Failed to read counts");
+        fclose(file);
+        return EXIT_FAILURE;
+    }
+    size_t size = (size_t)counts[0] * 6 * sizeof(float);
+    float* vertices = (float*)malloc(size);
+    if (!vertices || fread(vertices, 1, size, file) != size) {
+        perror("Failed to read vertex data");
+        free(vertices);
+        fclose(file);
+        return EXIT_FAILURE;
+    }
+    fclose(file);
+
+    if (mesh_soa_alloc(out_soa, counts[0] * copies)) {
+        free(vertices);
+        return EXIT_FAILURE;
+    }
+    for (int32_t i = 0; i < out_soa->capacity; ++i) {
+        int32_t copy = i / counts[0] < copies ? i / counts[0] : copies - 1;
+        const float* v = vertices + 6 * (size_t)(i < out_soa->vertex_count ? i % counts[0] : counts[0] - 1);
+        out_soa->x[i] = v[0] + 2.0f * (float)copy;
+        out_soa->y[i] = v[1];
+        out_soa->z[i] = v[2];
+        out_soa->nx[i] = v[3];
+        out_soa->ny[i] = v[4];
+        out_soa->nz[i] = v[5];
+    }
+    free(vertices);
+    return 0;
+}
+
+// Best of BENCH_RUNS, in millions of vertices per second
+static double bench(const Deformer* deformer, MeshSoA* out_soa, float* out_vertices) {
+    double best = 1e30;
+    for (int32_t run = 0; run < BENCH_RUNS; ++run) {
+        double start = now_seconds();
+        if (out_soa) {
+            deform_run_soa(deformer, out_soa);
+        } else {
+            deform_run(deformer, out_vertices, 6 * sizeof(float), 0, 3 * sizeof(float));
+        }
+        double elapsed = now_seconds() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    return (double)deformer->base->vertex_count / best * 1e-6;
+}
+
+int32_t main(int32_t argc, char** argv) {
+    int32_t copies = argc > 1 ? atoi(argv[1]) : 4;
+    MeshSoA base = {0};
+    if (copies < 1 || load_vertices("data/armadillo.bin", copies, &base)) {
+        return EXIT_FAILURE;
+    }
+
+    // Two targets as in takehome.c: inflated along the normals, stretched along y
+    MeshSoA target = {0};
+    MeshSoA out_soa = {0};
+    float* out_vertices = (float*)malloc((size_t)base.vertex_count * 6 * sizeof(float));
+    if (mesh_soa_alloc(&target, base.vertex_count) || mesh_soa_alloc(&out_soa, base.vertex_count) || !out_vertices) {
+        return EXIT_FAILURE;
+    }
+    Deformer deformer;
+    deformer_init(&deformer, &base);
+    memcpy(target.x, base.x, 6 * (size_t)base.capacity * sizeof(float));
+    for (int32_t i = 0; i < base.capacity; ++i) {
+        target.x[i] += 0.05f * base.nx[i];
+        target.y[i] += 0.05f * base.ny[i];
+        target.z[i] += 0.05f * base.nz[i];
+    }
+    deformer_add_target(&deformer, &target);
+    for (int32_t i = 0; i < base.capacity; ++i) {
+        target.x[i] = base.x[i];
+        target.y[i] = 1.2f * base.y[i];
+        target.z[i] = base.z[i];
+        target.ny[i] = base.ny[i] / 1.2f;
+    }
+    deformer_add_target(&deformer, &target);
+
+#if defined(DEFORM_SIMD) && defined(VEC_MATH_SIMD_AVX)
+    const char* path = "AVX";
+#elif defined(DEFORM_SIMD) && defined(VEC_MATH_SIMD_SSE2)
+    const char* path = "SSE2";
+#elif defined(DEFORM_SIMD) && defined(VEC_MATH_SIMD_NEON)
+    const char* path = "NEON";
+#elif defined(DEFORM_SIMD)
+    const char* path = "float8 array";
+#else
+    const char* path = "scalar";
+#endif
+    printf("%d vertices, %s kernels, %d threads\n", base.vertex_count, path, par_worker_count());
+    printf("%-28s %12s %14s\n", "case", "SoA Mvert/s", "interleaved");
+
+    const char* names[4] = { "copy", "1 target", "2 targets", "2 targets + wave" };
+    for (int32_t c = 0; c < 4; ++c) {
+        deformer.weights[0] = c >= 1 ? 0.5f : 0.0f;
+        deformer.weights[1] = c >= 2 ? 0.25f : 0.0f;
+        deformer.wave.wave_vector = vec3(0.0f, 2.0f * PI / 0.4f, 0.0f);
+        deformer.wave.amplitude = c >= 3 ? 0.01f : 0.0f;
+        deformer.wave.phase = 0.3f;
+        double soa = bench(&deformer, &out_soa, NULL);
+        double interleaved = bench(&deformer, NULL, out_vertices);
+        printf("%-28s %12.1f %14.1f\n", names[c], soa, interleaved);
+    }
+
+    deformer_destroy(&deformer);
+    mesh_soa_free(&target);
+    mesh_soa_free(&out_soa);
+    mesh_soa_free(&base);
+    free(out_vertices);
+    par_shutdown();
+    return 0;
+}
@@ -0,0 +1,6 @@
+gcc deform_bench.c -Wall -std=c11 -O2 -march=native -o deform_bench.out -lm -lrt -lpthread
+gcc deform_bench.c -Wall -std=c11 -O2 -march=native -DDEFORM_NO_SIMD -o deform_bench_scalar.out -lm -lrt -lpthread
+
+PAR_NUM_THREADS=1 ./deform_bench_scalar.out
+PAR_NUM_THREADS=1 ./deform_bench.out
+./deform_bench.out
@@ -0,0 +1,5 @@
+gcc frustum_bench.c -Wall -std=c11 -O2 -march=native -o frustum_bench.out -lm -lrt
+gcc frustum_bench.c -Wall -std=c11 -O2 -march=native -DFRUSTUM_NO_SIMD -o frustum_bench_scalar.out -lm -lrt
+
+./frustum_bench_scalar.out
+./frustum_bench.out
@@ -0,0 +1,327 @@
+// Regression check for the QuickHull of convex_hull.h on inputs that used to break it: dense
+// ellipsoids where neighbouring faces are almost coplanar, and lattices full of coplanar and
+// collinear points. Every hull has to be a closed two-manifold with Euler characteristic 2,
+// every edge has to be convex, every face has to face away from the hull centroid and the
+// input points have to lie below every face, all within HULL_CHECK_TOLERANCE of the extent of
+// the input. The point test runs against all faces for the lattices and for a stride of
+// HULL_CHECK_SAMPLES points of the ellipsoids. Exits with EXIT_FAILURE when a hull fails.
+// See hull_check.sh.
+#define _POSIX_C_SOURCE 199309L
+#define _VEC_MATH_IMPLEMENTATION_
+#define _PARALLEL_IMPLEMENTATION_
+#define _CONVEX_HULL_IMPLEMENTATION_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "libs/vec_math.h"
+#include "libs/mesh.h"
+#include "libs/parallel.h"
+#include "libs/convex_hull.h"
+
+// Allowed distance outside the hull, relative to the largest coordinate of the input
+#define HULL_CHECK_TOLERANCE 1e-5
+#define HULL_CHECK_SAMPLES 4000
+
+typedef struct HullReport {
+    int32_t open_edges;
+    int32_t euler;
+    int32_t concave_edges;
+    int32_t inverted_faces;
+    int32_t outside_points;
+    double max_outside;
+} HullReport;
+
+typedef struct PointJob {
+    const ConvexHull* hull;
+    const double* planes;
+    const vec3_t* points;
+    int32_t stride;
+    double tolerance;
+    int32_t outside[PAR_MAX_WORKERS];
+    double max_outside[PAR_MAX_WORKERS];
+} PointJob;
+
+static uint32_t rng_state = 0x2545F491u;
+
+static double random_unit(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return (double)(rng_state >> 8) * (1.0 / 16777216.0);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Unit normal and offset of every hull triangle in double precision
+static double* hull_planes(const ConvexHull* hull) {
+    double* planes = (double*)malloc((size_t)hull->triangle_count * 4 * sizeof(double));
+    if (!planes) {
+        return NULL;
+    }
+    for (int32_t t = 0; t < hull->triangle_count; ++t) {
+        const vec3_t a = hull->vertices[hull->triangles[3 * t + 0]];
+        const vec3_t b = hull->vertices[hull->triangles[3 * t + 1]];
+        const vec3_t c = hull->vertices[hull->triangles[3 * t + 2]];
+        double u[3] = { (double)b.x - a.x, (double)b.y - a.y, (double)b.z - a.z };
+        double w[3] = { (double)c.x - a.x, (double)c.y - a.y, (double)c.z - a.z };
+        double n[3] = { u[1] * w[2] - u[2] * w[1], u[2] * w[0] - u[0] * w[2], u[0] * w[1] - u[1] * w[0] };
+        double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        double scale = length > 0.0 ? 1.0 / length : 0.0;
+        double* plane = &planes[4 * t];
+        plane[0] = n[0] * scale;
+        plane[1] = n[1] * scale;
+        plane[2] = n[2] * scale;
+        plane[3] = plane[0] * a.x + plane[1] * a.y + plane[2] * a.z;
+    }
+    return planes;
+}
+
+static double plane_distance(const double* plane, vec3_t p) {
+    return plane[0] * p.x + plane[1] * p.y + plane[2] * p.z - plane[3];
+}
+
+static void point_range(void* user, int32_t begin, int32_t end, int32_t worker) {
+    PointJob* job = (PointJob*)user;
+    for (int32_t i = begin; i < end; ++i) {
+        const vec3_t p = job->points[(int64_t)i * job->stride];
+        double worst = -INFINITY;
+        for (int32_t t = 0; t < job->hull->triangle_count; ++t) {
+            double d = plane_distance(&job->planes[4 * t], p);
+            worst = d > worst ? d : worst;
+        }
+        if (worst > job->tolerance) {
+            job->outside[worker]++;
+        }
+        job->max_outside[worker] = worst > job->max_outside[worker] ? worst : job->max_outside[worker];
+    }
+}
+
+static int compare_edges(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int32_t find_edge(const uint64_t* edges, int32_t count, uint64_t key) {
+    int32_t lo = 0;
+    int32_t hi = count;
+    while (lo < hi) {
+        int32_t mid = lo + (hi - lo) / 2;
+        if ((edges[mid] >> 32) < (key >> 32)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (; lo < count && (edges[lo] >> 32) == (key >> 32); ++lo) {
+        if (edges[lo] == key) {
+            return lo;
+        }
+    }
+    return -1;
+}
+
+static int32_t check_hull(const ConvexHull* hull, const vec3_t* points, int32_t point_count, int32_t stride,
+                          double tolerance, HullReport* report) {
+    memset(report, 0, sizeof(*report));
+    const int32_t edge_count = 3 * hull->triangle_count;
+    double* planes = hull_planes(hull);
+    // Directed edges as (from << 32 | to) with the owning triangle, sorted by the key
+    uint64_t* edges = (uint64_t*)malloc((size_t)edge_count * sizeof(uint64_t));
+    uint64_t* keys = (uint64_t*)malloc((size_t)edge_count * sizeof(uint64_t));
+    if (!planes || !edges || !keys) {
+        free(planes);
+        free(edges);
+        free(keys);
+        return EXIT_FAILURE;
+    }
+    for (int32_t t = 0; t < hull->triangle_count; ++t) {
+        for (int32_t k = 0; k < 3; ++k) {
+            uint64_t from = hull->triangles[3 * t + k];
+            uint64_t to = hull->triangles[3 * t + (k + 1) % 3];
+            edges[3 * t + k] = from << 32 | to;
+        }
+    }
+    memcpy(keys, edges, (size_t)edge_count * sizeof(uint64_t));
+    qsort(keys, (size_t)edge_count, sizeof(uint64_t), compare_edges);
+
+    // Every directed edge exactly once and its twin in the neighbouring triangle
+    for (int32_t e = 1; e < edge_count; ++e) {
+        report->open_edges += keys[e] == keys[e - 1];
+    }
+    report->euler = hull->vertex_count - edge_count / 2 + hull->triangle_count;
+
+    // Convexity of every edge: the far corner of a triangle lies below the plane of the neighbour
+    // owning the twin edge, found through a table of triangles per sorted key
+    int32_t* owner = (int32_t*)malloc((size_t)edge_count * sizeof(int32_t));
+    if (!owner) {
+        free(planes);
+        free(edges);
+        free(keys);
+        return EXIT_FAILURE;
+    }
+    for (int32_t e = 0; e < edge_count; ++e) {
+        int32_t slot = find_edge(keys, edge_count, edges[e]);
+        owner[slot] = e / 3;
+    }
+    vec3_t centroid = vec3(0.0f, 0.0f, 0.0f);
+    for (int32_t v = 0; v < hull->vertex_count; ++v) {
+        centroid = vec3_add(centroid, vec3_scalar_mul(hull->vertices[v], 1.0f / (float)hull->vertex_count));
+    }
+    for (int32_t t = 0; t < hull->triangle_count; ++t) {
+        report->inverted_faces += plane_distance(&planes[4 * t], centroid) >= 0.0;
+        for (int32_t k = 0; k < 3; ++k) {
+            uint64_t key = edges[3 * t + k];
+            int32_t slot = find_edge(keys, edge_count, (key & 0xffffffffu) << 32 | key >> 32);
+            if (slot < 0) {
+                report->open_edges++;
+                continue;
+            }
+            const vec3_t corner = hull->vertices[hull->triangles[3 * t + (k + 2) % 3]];
+            report->concave_edges += plane_distance(&planes[4 * owner[slot]], corner) > tolerance;
+        }
+    }
+
+    PointJob* job = (PointJob*)calloc(1, sizeof(PointJob));
+    if (!job) {
+        free(owner);
+        free(planes);
+        free(edges);
+        free(keys);
+        return EXIT_FAILURE;
+    }
+    job->hull = hull;
+    job->planes = planes;
+    job->points = points;
+    job->stride = stride;
+    job->tolerance = tolerance;
+    for (int32_t w = 0; w < PAR_MAX_WORKERS; ++w) {
+        job->max_outside[w] = -INFINITY;
+    }
+    par_for(point_count / stride, 16, point_range, job);
+    report->max_outside = -INFINITY;
+    for (int32_t w = 0; w < PAR_MAX_WORKERS; ++w) {
+        report->outside_points += job->outside[w];
+        report->max_outside = job->max_outside[w] > report->max_outside ? job->max_outside[w] : report->max_outside;
+    }
+    free(job);
+    free(owner);
+    free(planes);
+    free(edges);
+    free(keys);
+    return 0;
+}
+
+// Runs hull_build over `points` and checks the result, returns the number of failed checks
+static int32_t check_case(const char* name, const vec3_t* points, int32_t point_count, int32_t stride) {
+    MeshData mesh;
+    memset(&mesh, 0, sizeof(mesh));
+    mesh.vertex_count = point_count;
+    mesh.vertex_data = (float*)points;
+    mesh.vertex_size = (int32_t)sizeof(vec3_t);
+    mesh.positions_size = 3;
+    mesh.positions_offset = 0;
+
+    double extent = 0.0;
+    for (int32_t i = 0; i < point_count; ++i) {
+        for (int32_t k = 0; k < 3; ++k) {
+            extent = fmax(extent, fabs(points[i].data[k]));
+        }
+    }
+    const double tolerance = HULL_CHECK_TOLERANCE * extent;
+
+    ConvexHull hull;
+    double start = now_seconds();
+    if (hull_build(&mesh, &hull)) {
+        printf("  %-28s hull_build failed\n", name);
+        return 1;
+    }
+    double elapsed = now_seconds() - start;
+    HullReport r;
+    if (check_hull(&hull, points, point_count, stride, tolerance, &r)) {
+        hull_free(&hull);
+        fprintf(stderr, "Failed to allocate the check buffers\n");
+        return 1;
+    }
+    int32_t failed = (r.open_edges > 0) + (r.euler != 2) + (r.concave_edges > 0) + (r.inverted_faces > 0) +
+                     (r.outside_points > 0);
+    printf("  %-28s %8d pts %7d verts %7d tris %8.1f ms  open %d euler %d concave %d inverted %d outside %d "
+           "(max %.3g, tol %.3g) %s\n",
+           name, point_count, hull.vertex_count, hull.triangle_count, elapsed * 1e3, r.open_edges, r.euler,
+           r.concave_edges, r.inverted_faces, r.outside_points, r.max_outside, tolerance, failed ? "FAIL" : "ok");
+    hull_free(&hull);
+    return failed;
+}
+
+// Points on the surface of an ellipsoid with the given radii
+static void ellipsoid(vec3_t* points, int32_t count, double rx, double ry, double rz) {
+    for (int32_t i = 0; i < count; ++i) {
+        double z = 2.0 * random_unit() - 1.0;
+        double phi = 2.0 * PI * random_unit();
+        double r = sqrt(fmax(0.0, 1.0 - z * z));
+        points[i] = vec3((float)(rx * r * cos(phi)), (float)(ry * r * sin(phi)), (float)(rz * z));
+    }
+}
+
+// n x n x n grid with unit spacing around `origin`, in shuffled order
+static int32_t lattice(vec3_t* points, int32_t n, vec3_t origin) {
+    int32_t count = 0;
+    for (int32_t i = 0; i < n; ++i) {
+        for (int32_t j = 0; j < n; ++j) {
+            for (int32_t k = 0; k < n; ++k) {
+                points[count++] = vec3_add(origin, vec3((float)i, (float)j, (float)k));
+            }
+        }
+    }
+    for (int32_t i = count - 1; i > 0; --i) {
+        int32_t j = (int32_t)(random_unit() * (i + 1));
+        vec3_t swap = points[i];
+        points[i] = points[j];
+        points[j] = swap;
+    }
+    return count;
+}
+
+int32_t main(void) {
+    const int32_t capacity = 300000;
+    vec3_t* points = (vec3_t*)malloc((size_t)capacity * sizeof(vec3_t));
+    if (!points) {
+        return EXIT_FAILURE;
+    }
+    printf("hull checks, %d threads\n", par_worker_count());
+    int32_t failed = 0;
+
+    ellipsoid(points, 100000, 40.0, 25.0, 10.0);
+    failed += check_case("ellipsoid 100k", points, 100000, 100000 / HULL_CHECK_SAMPLES);
+    ellipsoid(points, 300000, 40.0, 25.0, 10.0);
+    failed += check_case("ellipsoid 300k", points, 300000, 300000 / HULL_CHECK_SAMPLES);
+    ellipsoid(points, 300000, 1.0, 1.0, 1.0);
+    failed += check_case("unit sphere 300k", points, 300000, 300000 / HULL_CHECK_SAMPLES);
+
+    int32_t count = lattice(points, 40, vec3(0.0f, 0.0f, 0.0f));
+    failed += check_case("lattice 40^3", points, count, 1);
+    count = lattice(points, 40, vec3(1000.0f, -2000.0f, 500.0f));
+    failed += check_case("lattice 40^3 off origin", points, count, 1);
+    // A flat lattice on a thin slab: coplanar points on two large faces
+    for (int32_t i = 0; i < count; ++i) {
+        points[i].z = points[i].z < 520.0f ? 500.0f : 501.0f;
+    }
+    failed += check_case("lattice 40^2 x 2 slab", points, count, 1);
+
+    par_shutdown();
+    free(points);
+    if (failed) {
+        printf("%d checks failed\n", failed);
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,3 @@
+gcc hull_check.c -Wall -std=c11 -O2 -march=native -o hull_check.out -lm -lrt -lpthread
+
+./hull_check.out
@@ -0,0 +1,279 @@
+// Agreement and speed of the k-d tree queries of kd_tree.h against brute force scans over every
+// point. kNN results have to report the same squared distances as the k smallest of the scan, with
+// every returned index at its reported distance (ties may pick different points); radius results
+// have to be the same index sets. The inputs mix a uniform cloud, tight clusters and duplicated
+// points, the queries are points of the cloud, jittered copies and points far outside it.
+// Prints queries per second for single queries, the par_for batches and the scans. Exits with
+// EXIT_FAILURE on any mismatch. Build with and without -DMESH_NO_SIMD to cover both leaf kernels
+// (see kd_tree_check.sh).
+#define _POSIX_C_SOURCE 199309L
+#define _VEC_MATH_IMPLEMENTATION_
+#define _MESH_IMPLEMENTATION_
+#define _PARALLEL_IMPLEMENTATION_
+#define _KD_TREE_IMPLEMENTATION_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <float.h>
+#include <time.h>
+
+#include "libs/vec_math.h"
+#include "libs/mesh.h"
+#include "libs/parallel.h"
+#include "libs/kd_tree.h"
+
+#define KD_CHECK_POINTS 200000
+// Queries checked against the brute force scan
+#define KD_CHECK_QUERIES 2000
+// Queries per timed pass
+#define KD_CHECK_TIMED 100000
+#define KD_CHECK_K 8
+#define KD_CHECK_RADIUS 0.02f
+#define KD_CHECK_MAX_RADIUS_COUNT 4096
+
+// Vertex layout of the mesh files: position, normal
+typedef struct CheckVertex {
+    vec3_t position;
+    vec3_t normal;
+} CheckVertex;
+
+static uint32_t rng_state = 0x6C8E9CF5u;
+
+static float random_float(float lo, float hi) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return lo + (hi - lo) * (float)(rng_state >> 8) * (1.0f / 16777216.0f);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Same expression and order as the leaf kernels, so squared distances agree bit for bit
+static float distance_sq(vec3_t p, vec3_t q) {
+    float dx = p.x - q.x;
+    float dy = p.y - q.y;
+    float dz = p.z - q.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// The k smallest squared distances from the scan, ascending
+static int32_t brute_knn(const CheckVertex* vertices, int32_t count, vec3_t q, int32_t k, float* out_dist_sq) {
+    int32_t found = 0;
+    for (int32_t i = 0; i < count; ++i) {
+        float d = distance_sq(vertices[i].position, q);
+        if (found == k && d >= out_dist_sq[k - 1]) {
+            continue;
+        }
+        int32_t slot = found < k ? found++ : k - 1;
+        while (slot > 0 && out_dist_sq[slot - 1] > d) {
+            out_dist_sq[slot] = out_dist_sq[slot - 1];
+            slot--;
+        }
+        out_dist_sq[slot] = d;
+    }
+    return found;
+}
+
+static int32_t brute_radius(const CheckVertex* vertices, int32_t count, vec3_t q, float radius, uint32_t* out_indices,
+                            int32_t max_count) {
+    int32_t found = 0;
+    for (int32_t i = 0; i < count; ++i) {
+        if (distance_sq(vertices[i].position, q) <= radius * radius) {
+            if (found < max_count) {
+                out_indices[found] = (uint32_t)i;
+            }
+            found++;
+        }
+    }
+    return found;
+}
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static vec3_t make_query(const CheckVertex* vertices, int32_t i) {
+    const vec3_t p = vertices[(int32_t)random_float(0.0f, (float)KD_CHECK_POINTS - 1.0f)].position;
+    switch (i % 3) {
+    case 0:
+        return p;
+    case 1:
+        return vec3_add(p, vec3(random_float(-0.01f, 0.01f), random_float(-0.01f, 0.01f), random_float(-0.01f, 0.01f)));
+    default:
+        return vec3(random_float(-3.0f, 3.0f), random_float(-3.0f, 3.0f), random_float(-3.0f, 3.0f));
+    }
+}
+
+int32_t main(void) {
+#if defined(MESH_SIMD_SSE2)
+    const char* backend = "SSE2";
+#elif defined(MESH_SIMD_NEON)
+    const char* backend = "NEON";
+#else
+    const char* backend = "scalar";
+#endif
+    CheckVertex* vertices = (CheckVertex*)malloc(KD_CHECK_POINTS * sizeof(CheckVertex));
+    vec3_t* queries = (vec3_t*)malloc(KD_CHECK_TIMED * sizeof(vec3_t));
+    uint32_t* indices = (uint32_t*)malloc((size_t)KD_CHECK_TIMED * KD_CHECK_K * sizeof(uint32_t));
+    float* dist_sq = (float*)malloc((size_t)KD_CHECK_TIMED * KD_CHECK_K * sizeof(float));
+    int32_t* counts = (int32_t*)malloc(KD_CHECK_TIMED * sizeof(int32_t));
+    uint32_t* found = (uint32_t*)malloc(KD_CHECK_MAX_RADIUS_COUNT * sizeof(uint32_t));
+    uint32_t* expected = (uint32_t*)malloc(KD_CHECK_MAX_RADIUS_COUNT * sizeof(uint32_t));
+    if (!vertices || !queries || !indices || !dist_sq || !counts || !found || !expected) {
+        return EXIT_FAILURE;
+    }
+
+    // Half uniform in the unit cube, a quarter in 64 tight clusters, a quarter repeating earlier points
+    for (int32_t i = 0; i < KD_CHECK_POINTS; ++i) {
+        vec3_t p;
+        if (i < KD_CHECK_POINTS / 2) {
+            p = vec3(random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f));
+        } else if (i < 3 * KD_CHECK_POINTS / 4) {
+            const vec3_t center = vertices[(i % 64) * 97].position;
+            p = vec3_add(center, vec3(random_float(-0.005f, 0.005f), random_float(-0.005f, 0.005f),
+                                      random_float(-0.005f, 0.005f)));
+        } else {
+            p = vertices[(int32_t)random_float(0.0f, (float)i - 1.0f)].position;
+        }
+        vertices[i].position = p;
+        vertices[i].normal = vec3(0.0f, 0.0f, 1.0f);
+    }
+    MeshData mesh;
+    memset(&mesh, 0, sizeof(mesh));
+    mesh.vertex_count = KD_CHECK_POINTS;
+    mesh.vertex_data = (float*)vertices;
+    mesh.vertex_size = (int32_t)sizeof(CheckVertex);
+    mesh.positions_size = 3 * sizeof(float);
+    mesh.positions_offset = 0;
+    mesh.normals_size = 3 * sizeof(float);
+    mesh.normals_offset = 3 * sizeof(float);
+
+    KdTree tree;
+    double start = now_seconds();
+    if (kd_tree_build(&mesh, &tree)) {
+        fprintf(stderr, "Failed to build the k-d tree\n");
+        return EXIT_FAILURE;
+    }
+    double build_ms = (now_seconds() - start) * 1e3;
+    for (int32_t i = 0; i < KD_CHECK_TIMED; ++i) {
+        queries[i] = make_query(vertices, i);
+    }
+
+    // kNN: same distances as the scan, every index at its distance
+    int32_t knn_mismatches = 0;
+    for (int32_t q = 0; q < KD_CHECK_QUERIES; ++q) {
+        float reference[KD_CHECK_K];
+        uint32_t got_index[KD_CHECK_K];
+        float got_dist[KD_CHECK_K];
+        int32_t n = brute_knn(vertices, KD_CHECK_POINTS, queries[q], KD_CHECK_K, reference);
+        int32_t m = kd_tree_knn(&tree, queries[q], KD_CHECK_K, got_index, got_dist);
+        int32_t bad = n != m;
+        for (int32_t i = 0; i < n && !bad; ++i) {
+            bad = got_dist[i] != reference[i] || got_index[i] >= KD_CHECK_POINTS ||
+                  distance_sq(vertices[got_index[i]].position, queries[q]) != got_dist[i];
+        }
+        knn_mismatches += bad;
+    }
+    // The batch has to give the single query results
+    kd_tree_knn_batch(&tree, queries, KD_CHECK_QUERIES, KD_CHECK_K, indices, dist_sq);
+    int32_t knn_batch_mismatches = 0;
+    for (int32_t q = 0; q < KD_CHECK_QUERIES; ++q) {
+        uint32_t got_index[KD_CHECK_K];
+        float got_dist[KD_CHECK_K];
+        int32_t m = kd_tree_knn(&tree, queries[q], KD_CHECK_K, got_index, got_dist);
+        knn_batch_mismatches += m != KD_CHECK_K ||
+                                memcmp(got_index, indices + (size_t)q * KD_CHECK_K, sizeof(got_index)) != 0 ||
+                                memcmp(got_dist, dist_sq + (size_t)q * KD_CHECK_K, sizeof(got_dist)) != 0;
+    }
+
+    // Radius: same index sets, single and batched
+    int32_t radius_mismatches = 0;
+    int64_t radius_total = 0;
+    for (int32_t q = 0; q < KD_CHECK_QUERIES; ++q) {
+        int32_t n = brute_radius(vertices, KD_CHECK_POINTS, queries[q], KD_CHECK_RADIUS, expected,
+                                 KD_CHECK_MAX_RADIUS_COUNT);
+        int32_t m = kd_tree_radius(&tree, queries[q], KD_CHECK_RADIUS, found, KD_CHECK_MAX_RADIUS_COUNT);
+        radius_total += n;
+        int32_t bad = n != m || n > KD_CHECK_MAX_RADIUS_COUNT;
+        if (!bad) {
+            qsort(expected, (size_t)n, sizeof(uint32_t), compare_u32);
+            qsort(found, (size_t)m, sizeof(uint32_t), compare_u32);
+            bad = memcmp(expected, found, (size_t)n * sizeof(uint32_t)) != 0;
+        }
+        radius_mismatches += bad;
+    }
+    uint32_t* radius_indices = (uint32_t*)malloc((size_t)KD_CHECK_QUERIES * KD_CHECK_MAX_RADIUS_COUNT * sizeof(uint32_t));
+    int32_t radius_batch_mismatches = 0;
+    if (!radius_indices) {
+        return EXIT_FAILURE;
+    }
+    kd_tree_radius_batch(&tree, queries, KD_CHECK_QUERIES, KD_CHECK_RADIUS, radius_indices, KD_CHECK_MAX_RADIUS_COUNT,
+                         counts);
+    for (int32_t q = 0; q < KD_CHECK_QUERIES; ++q) {
+        int32_t m = kd_tree_radius(&tree, queries[q], KD_CHECK_RADIUS, found, KD_CHECK_MAX_RADIUS_COUNT);
+        radius_batch_mismatches += m != counts[q] ||
+                                   memcmp(found, radius_indices + (size_t)q * KD_CHECK_MAX_RADIUS_COUNT,
+                                          (size_t)(m < KD_CHECK_MAX_RADIUS_COUNT ? m : KD_CHECK_MAX_RADIUS_COUNT) *
+                                              sizeof(uint32_t)) != 0;
+    }
+    free(radius_indices);
+
+    printf("%s, %d points, depth %d, build %.1f ms, %d threads\n", backend, KD_CHECK_POINTS, tree.depth, build_ms,
+           par_worker_count());
+    printf("  mismatches over %d queries: knn %d, knn batch %d, radius %d (%.1f points per query), radius batch %d\n",
+           KD_CHECK_QUERIES, knn_mismatches, knn_batch_mismatches, radius_mismatches,
+           (double)radius_total / KD_CHECK_QUERIES, radius_batch_mismatches);
+
+    // Throughput
+    uint32_t sink = 0;
+    start = now_seconds();
+    for (int32_t q = 0; q < KD_CHECK_TIMED; ++q) {
+        uint32_t got_index[KD_CHECK_K];
+        sink += (uint32_t)kd_tree_knn(&tree, queries[q], KD_CHECK_K, got_index, NULL) + got_index[0];
+    }
+    double knn_single = KD_CHECK_TIMED / (now_seconds() - start);
+    start = now_seconds();
+    kd_tree_knn_batch(&tree, queries, KD_CHECK_TIMED, KD_CHECK_K, indices, dist_sq);
+    double knn_batch = KD_CHECK_TIMED / (now_seconds() - start);
+    start = now_seconds();
+    for (int32_t q = 0; q < KD_CHECK_TIMED; ++q) {
+        sink += (uint32_t)kd_tree_radius(&tree, queries[q], KD_CHECK_RADIUS, found, KD_CHECK_MAX_RADIUS_COUNT);
+    }
+    double radius_single = KD_CHECK_TIMED / (now_seconds() - start);
+    start = now_seconds();
+    kd_tree_radius_batch(&tree, queries, KD_CHECK_TIMED, KD_CHECK_RADIUS, indices, KD_CHECK_K, counts);
+    double radius_batch = KD_CHECK_TIMED / (now_seconds() - start);
+    start = now_seconds();
+    for (int32_t q = 0; q < KD_CHECK_QUERIES / 10; ++q) {
+        float reference[KD_CHECK_K];
+        sink += (uint32_t)brute_knn(vertices, KD_CHECK_POINTS, queries[q], KD_CHECK_K, reference);
+    }
+    double knn_brute = (KD_CHECK_QUERIES / 10) / (now_seconds() - start);
+
+    printf("queries per second        single       batch        brute force\n");
+    printf("  knn k=%-2d           %11.0f %11.0f %11.0f\n", KD_CHECK_K, knn_single, knn_batch, knn_brute);
+    printf("  radius %.2f        %11.0f %11.0f\n", KD_CHECK_RADIUS, radius_single, radius_batch);
+    printf("  (checksum %u)\n", sink);
+
+    kd_tree_free(&tree);
+    par_shutdown();
+    free(vertices);
+    free(queries);
+    free(indices);
+    free(dist_sq);
+    free(counts);
+    free(found);
+    free(expected);
+    if (knn_mismatches || knn_batch_mismatches || radius_mismatches || radius_batch_mismatches) {
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,4 @@
+gcc kd_tree_check.c -Wall -std=c11 -O2 -march=native -o kd_tree_check.out -lm -lrt -lpthread
+gcc kd_tree_check.c -Wall -std=c11 -O2 -march=native -DMESH_NO_SIMD -o kd_tree_check_scalar.out -lm -lrt -lpthread
+
+./kd_tree_check_scalar.out && ./kd_tree_check.out
@@ -0,0 +1,129 @@
+#ifndef _AO_BAKE_H_
+#define _AO_BAKE_H_
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Expects vec_math.h, mesh.h, parallel.h and bvh.h to be included first.
+
+typedef struct AoBakeParams {
+  int32_t ray_count;  // hemisphere rays per vertex
+  float max_distance; // occluders farther away do not count
+  float bias;         // ray origins are pushed this far along the normal
+} AoBakeParams;
+
+// Per-vertex ambient occlusion: cosine distributed any-hit rays around the
+// vertex normal against the mesh BVH, vertices split across the worker pool.
+// Writes 1 - (occluded rays / ray_count) per vertex, 1.0 meaning fully open.
+// Every vertex rotates the same stratified pattern by its own hashed angle,
+// which trades banding for noise that interpolation across triangles hides.
+int32_t ao_bake(const MeshData *mesh, const Bvh *bvh,
+                const AoBakeParams *params, float *out_ao);
+
+// Appends `ao` as one float attribute at the end of every vertex and records
+// it in `ao_size` / `ao_offset` of the mesh layout.
+int32_t mesh_append_ao(MeshData *mesh, const float *ao);
+
+#endif /* _AO_BAKE_H_ */
+
+#ifdef _AO_BAKE_IMPLEMENTATION_
+
+typedef struct ao__job {
+  const MeshData *mesh;
+  const Bvh *bvh;
+  const AoBakeParams *params;
+  float *out_ao;
+} ao__job;
+
+static uint32_t ao__hash(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+static void ao__bake_range(void *user, int32_t begin, int32_t end,
+                           int32_t worker) {
+  ao__job *job = (ao__job *)user;
+  const MeshData *mesh = job->mesh;
+  const AoBakeParams *params = job->params;
+  const float golden = 0.61803398875f;
+  (void)worker;
+  for (int32_t v = begin; v < end; ++v) {
+    const float *vertex =
+        (const float *)((const char *)mesh->vertex_data + (size_t)v * mesh->vertex_size);
+    const float *p = vertex + mesh->positions_offset / sizeof(float);
+    const float *n = vertex + mesh->normals_offset / sizeof(float);
+    vec3_t normal = vec3(n[0], n[1], n[2]);
+    if (vec3_norm_sq(normal) <= 0.0f) {
+      job->out_ao[v] = 1.0f;
+      continue;
+    }
+    normal = vec3_normalize(normal);
+
+    // Orthonormal basis around the normal (Duff et al.)
+    float sign = normal.z >= 0.0f ? 1.0f : -1.0f;
+    float a = -1.0f / (sign + normal.z);
+    float b = normal.x * normal.y * a;
+    vec3_t tangent = vec3(1.0f + sign * normal.x * normal.x * a, sign * b,
+                          -sign * normal.x);
+    vec3_t bitangent = vec3(b, sign + normal.y * normal.y * a, -normal.y);
+    vec3_t origin = vec3_add(vec3(p[0], p[1], p[2]),
+                             vec3_scalar_mul(normal, params->bias));
+
+    float rotation = (float)ao__hash((uint32_t)v) * (1.0f / 4294967296.0f);
+    int32_t occluded = 0;
+    for (int32_t r = 0; r < params->ray_count; ++r) {
+      // Stratified in cos^2, golden ratio sequence in azimuth
+      float u1 = ((float)r + 0.5f) / (float)params->ray_count;
+      float u2 = (float)r * golden + rotation;
+      u2 -= floorf(u2);
+      float radius = sqrtf(u1);
+      float phi = 2.0f * (float)PI * u2;
+      float x = radius * cosf(phi);
+      float y = radius * sinf(phi);
+      float z = sqrtf(fmaxf(0.0f, 1.0f - u1));
+      vec3_t dir = vec3_add(vec3_add(vec3_scalar_mul(tangent, x),
+                                     vec3_scalar_mul(bitangent, y)),
+                            vec3_scalar_mul(normal, z));
+      occluded += bvh_occluded(job->bvh, origin, dir, params->max_distance);
+    }
+    job->out_ao[v] = 1.0f - (float)occluded / (float)params->ray_count;
+  }
+}
+
+int32_t ao_bake(const MeshData *mesh, const Bvh *bvh,
+                const AoBakeParams *params, float *out_ao) {
+  if (params->ray_count <= 0) {
+    return EXIT_FAILURE;
+  }
+  ao__job job = {mesh, bvh, params, out_ao};
+  par_for(mesh->vertex_count, 256, ao__bake_range, &job);
+  return 0;
+}
+
+int32_t mesh_append_ao(MeshData *mesh, const float *ao) {
+  const int32_t old_size = mesh->vertex_size;
+  const int32_t new_size = old_size + (int32_t)sizeof(float);
+  char *data = (char *)malloc((size_t)mesh->vertex_count * new_size);
+  if (!data) {
+    return EXIT_FAILURE;
+  }
+  const char *src = (const char *)mesh->vertex_data;
+  for (int32_t v = 0; v < mesh->vertex_count; ++v) {
+    memcpy(data + (size_t)v * new_size, src + (size_t)v * old_size, old_size);
+    memcpy(data + (size_t)v * new_size + old_size, &ao[v], sizeof(float));
+  }
+  free(mesh->vertex_data);
+  mesh->vertex_data = (float *)data;
+  mesh->vertex_size = new_size;
+  mesh->ao_size = sizeof(float);
+  mesh->ao_offset = old_size;
+  return 0;
+}
+
+#endif /* _AO_BAKE_IMPLEMENTATION_ */
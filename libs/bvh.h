@@ -0,0 +1,765 @@
+#ifndef _BVH_H_
+#define _BVH_H_
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Expects vec_math.h, mesh.h and parallel.h to be included first.
+
+#ifndef BVH_LEAF_SIZE
+#define BVH_LEAF_SIZE 4
+#endif
+#define BVH_BIN_COUNT 12
+// Traversal stack entries. A traversal holds at most one entry per tree level
+// plus one, so nodes deeper than BVH_STACK_SIZE / 2 halve their range instead
+// of taking the SAH plane: at most 31 more levels for 2^31 triangles keep the
+// depth below BVH_STACK_SIZE however degenerate the input.
+#define BVH_STACK_SIZE 64
+
+// 32 byte node. Inner nodes store their left child right after themselves and
+// the right child in `first`; leaves store a range of `order`.
+typedef struct BvhNode {
+  float min[3];
+  int32_t first;
+  float max[3];
+  int32_t count; // triangles in the leaf, 0 for inner nodes
+} BvhNode;
+
+// Triangle BVH built with binned SAH. The subtree over leaf entries [b, e)
+// owns the node slots [S, S + 2 (e - b) - 1) below its root slot S, so
+// subtrees fill disjoint parts of `nodes` and build in parallel without any
+// shared allocator. Slots left over by multi-triangle leaves stay unused.
+typedef struct Bvh {
+  int32_t node_capacity;
+  BvhNode *nodes;
+  int32_t *parent; // per node slot, -1 for the root and unused slots
+  int32_t triangle_count;
+  uint32_t *order;  // mesh triangle of every leaf entry
+  float *positions; // 9 floats per leaf entry, corners in leaf order
+  int32_t *leaf;    // node slot of the leaf holding every leaf entry
+  int32_t *entry;   // leaf entry of every mesh triangle
+  uint8_t *refit_mark; // per node slot, scratch of bvh_refit
+} Bvh;
+
+typedef struct BvhHit {
+  float t;
+  float u; // barycentrics of corners 1 and 2
+  float v;
+  uint32_t triangle; // mesh triangle index
+} BvhHit;
+
+typedef struct BvhClosest {
+  vec3_t point;
+  float distance_sq;
+  uint32_t triangle; // mesh triangle index
+} BvhClosest;
+
+int32_t bvh_build(const MeshData *mesh, Bvh *out_bvh);
+void bvh_free(Bvh *bvh);
+
+// Refits the tree after the corners of `triangles` moved in `mesh`: copies
+// their positions, then recomputes the bounds of their leaves and of every
+// ancestor bottom-up, so the cost follows the number of dirty nodes rather
+// than the tree size. The topology is kept, rebuild after large deformations.
+int32_t bvh_refit(Bvh *bvh, const MeshData *mesh, const uint32_t *triangles,
+                  int32_t count);
+
+// Closest hit along the ray up to `t_max`, returns 1 on a hit.
+int32_t bvh_intersect(const Bvh *bvh, vec3_t origin, vec3_t direction,
+                      float t_max, BvhHit *out_hit);
+
+// Any hit up to `t_max`, cheaper than bvh_intersect for shadow and AO rays.
+int32_t bvh_occluded(const Bvh *bvh, vec3_t origin, vec3_t direction,
+                     float t_max);
+
+// Closest surface point to `point` no farther than `max_distance`, returns 1
+// when one was found. A tight `max_distance` prunes most of the tree.
+int32_t bvh_closest_point(const Bvh *bvh, vec3_t point, float max_distance,
+                          BvhClosest *out_closest);
+
+// Closest point to `point` on the triangle with `corners` (9 floats, the
+// layout of `positions`).
+vec3_t bvh_closest_on_triangle(const float *corners, vec3_t point);
+
+#endif /* _BVH_H_ */
+
+#ifdef _BVH_IMPLEMENTATION_
+
+typedef struct bvh__prim {
+  float min[3];
+  float max[3];
+  float centroid[3];
+} bvh__prim;
+
+typedef struct bvh__bin {
+  float min[3];
+  float max[3];
+  int32_t count;
+} bvh__bin;
+
+typedef struct bvh__task {
+  int32_t slot;
+  int32_t begin;
+  int32_t end;
+  int32_t parent;
+  int32_t depth;
+} bvh__task;
+
+typedef struct bvh__build_job {
+  const MeshData *mesh;
+  Bvh *bvh;
+  bvh__prim *prims;
+  bvh__task *tasks;
+
+  // Parallel reductions over one large range
+  int32_t begin;
+  int32_t axis;
+  float centroid_min;
+  float bin_scale;
+  bvh__bin bounds[PAR_MAX_WORKERS];
+  bvh__bin centroids[PAR_MAX_WORKERS];
+  bvh__bin bins[PAR_MAX_WORKERS][BVH_BIN_COUNT];
+} bvh__build_job;
+
+static void bvh__bin_reset(bvh__bin *bin) {
+  for (int32_t k = 0; k < 3; ++k) {
+    bin->min[k] = FLT_MAX;
+    bin->max[k] = -FLT_MAX;
+  }
+  bin->count = 0;
+}
+
+static void bvh__bin_grow(bvh__bin *bin, const float *lo, const float *hi) {
+  for (int32_t k = 0; k < 3; ++k) {
+    bin->min[k] = lo[k] < bin->min[k] ? lo[k] : bin->min[k];
+    bin->max[k] = hi[k] > bin->max[k] ? hi[k] : bin->max[k];
+  }
+}
+
+static void bvh__bin_merge(bvh__bin *bin, const bvh__bin *other) {
+  bvh__bin_grow(bin, other->min, other->max);
+  bin->count += other->count;
+}
+
+static float bvh__bin_area(const bvh__bin *bin) {
+  if (bin->count == 0) {
+    return 0.0f;
+  }
+  float dx = bin->max[0] - bin->min[0];
+  float dy = bin->max[1] - bin->min[1];
+  float dz = bin->max[2] - bin->min[2];
+  return dx * dy + dy * dz + dz * dx;
+}
+
+static const float *bvh__corner(const MeshData *mesh, uint32_t vertex) {
+  return (const float *)((const char *)mesh->vertex_data +
+                         (size_t)vertex * mesh->vertex_size +
+                         mesh->positions_offset);
+}
+
+static void bvh__prim_range(void *user, int32_t begin, int32_t end,
+                            int32_t worker) {
+  bvh__build_job *job = (bvh__build_job *)user;
+  const MeshData *mesh = job->mesh;
+  (void)worker;
+  for (int32_t t = begin; t < end; ++t) {
+    bvh__prim *prim = &job->prims[t];
+    const float *a = bvh__corner(mesh, mesh->triangles[3 * t + 0]);
+    const float *b = bvh__corner(mesh, mesh->triangles[3 * t + 1]);
+    const float *c = bvh__corner(mesh, mesh->triangles[3 * t + 2]);
+    for (int32_t k = 0; k < 3; ++k) {
+      prim->min[k] = fminf(a[k], fminf(b[k], c[k]));
+      prim->max[k] = fmaxf(a[k], fmaxf(b[k], c[k]));
+      prim->centroid[k] = 0.5f * (prim->min[k] + prim->max[k]);
+    }
+    job->bvh->order[t] = (uint32_t)t;
+  }
+}
+
+static void bvh__bounds_range(void *user, int32_t begin, int32_t end,
+                              int32_t worker) {
+  bvh__build_job *job = (bvh__build_job *)user;
+  for (int32_t i = job->begin + begin; i < job->begin + end; ++i) {
+    const bvh__prim *prim = &job->prims[job->bvh->order[i]];
+    bvh__bin_grow(&job->bounds[worker], prim->min, prim->max);
+    bvh__bin_grow(&job->centroids[worker], prim->centroid, prim->centroid);
+  }
+}
+
+static int32_t bvh__bin_index(const bvh__build_job *job, const bvh__prim *prim) {
+  int32_t bin = (int32_t)((prim->centroid[job->axis] - job->centroid_min) *
+                          job->bin_scale);
+  return bin < 0 ? 0 : bin >= BVH_BIN_COUNT ? BVH_BIN_COUNT - 1 : bin;
+}
+
+static void bvh__bin_range(void *user, int32_t begin, int32_t end,
+                           int32_t worker) {
+  bvh__build_job *job = (bvh__build_job *)user;
+  for (int32_t i = job->begin + begin; i < job->begin + end; ++i) {
+    const bvh__prim *prim = &job->prims[job->bvh->order[i]];
+    bvh__bin *bin = &job->bins[worker][bvh__bin_index(job, prim)];
+    bvh__bin_grow(bin, prim->min, prim->max);
+    bin->count++;
+  }
+}
+
+// Fills the node in `slot` for entries [begin, end) at `depth` and returns
+// the split point, or -1 when the node became a leaf. Large ranges reduce in
+// parallel.
+static int32_t bvh__split(bvh__build_job *job, int32_t slot, int32_t begin,
+                          int32_t end, int32_t depth, int32_t parallel) {
+  Bvh *bvh = job->bvh;
+  const int32_t count = end - begin;
+  const int32_t workers = parallel ? PAR_MAX_WORKERS : 1;
+  for (int32_t w = 0; w < workers; ++w) {
+    bvh__bin_reset(&job->bounds[w]);
+    bvh__bin_reset(&job->centroids[w]);
+  }
+  job->begin = begin;
+  if (parallel) {
+    par_for(count, 16384, bvh__bounds_range, job);
+  } else {
+    bvh__bounds_range(job, 0, count, 0);
+  }
+  for (int32_t w = 1; w < workers; ++w) {
+    bvh__bin_merge(&job->bounds[0], &job->bounds[w]);
+    bvh__bin_merge(&job->centroids[0], &job->centroids[w]);
+  }
+
+  BvhNode *node = &bvh->nodes[slot];
+  memcpy(node->min, job->bounds[0].min, sizeof(node->min));
+  memcpy(node->max, job->bounds[0].max, sizeof(node->max));
+  if (count <= BVH_LEAF_SIZE) {
+    node->first = begin;
+    node->count = count;
+    return -1;
+  }
+
+  // Bin centroids along the widest centroid extent
+  const bvh__bin *cb = &job->centroids[0];
+  int32_t axis = 0;
+  for (int32_t k = 1; k < 3; ++k) {
+    if (cb->max[k] - cb->min[k] > cb->max[axis] - cb->min[axis]) {
+      axis = k;
+    }
+  }
+  const float extent = cb->max[axis] - cb->min[axis];
+  int32_t mid = begin + count / 2;
+  if (extent > 0.0f && depth < BVH_STACK_SIZE / 2) {
+    job->axis = axis;
+    job->centroid_min = cb->min[axis];
+    job->bin_scale = (float)BVH_BIN_COUNT / extent;
+    for (int32_t w = 0; w < workers; ++w) {
+      for (int32_t b = 0; b < BVH_BIN_COUNT; ++b) {
+        bvh__bin_reset(&job->bins[w][b]);
+      }
+    }
+    if (parallel) {
+      par_for(count, 16384, bvh__bin_range, job);
+    } else {
+      bvh__bin_range(job, 0, count, 0);
+    }
+    bvh__bin *bins = job->bins[0];
+    for (int32_t w = 1; w < workers; ++w) {
+      for (int32_t b = 0; b < BVH_BIN_COUNT; ++b) {
+        bvh__bin_merge(&bins[b], &job->bins[w][b]);
+      }
+    }
+
+    // Sweep for the cheapest plane between bins
+    float right_cost[BVH_BIN_COUNT];
+    bvh__bin acc;
+    bvh__bin_reset(&acc);
+    for (int32_t b = BVH_BIN_COUNT - 1; b > 0; --b) {
+      bvh__bin_merge(&acc, &bins[b]);
+      right_cost[b] = bvh__bin_area(&acc) * (float)acc.count;
+    }
+    bvh__bin_reset(&acc);
+    float best_cost = FLT_MAX;
+    int32_t best_plane = -1;
+    for (int32_t b = 1; b < BVH_BIN_COUNT; ++b) {
+      bvh__bin_merge(&acc, &bins[b - 1]);
+      float cost = bvh__bin_area(&acc) * (float)acc.count + right_cost[b];
+      if (acc.count > 0 && acc.count < count && cost < best_cost) {
+        best_cost = cost;
+        best_plane = b;
+      }
+    }
+
+    if (best_plane > 0) {
+      uint32_t *order = bvh->order;
+      int32_t i = begin;
+      int32_t j = end - 1;
+      while (i <= j) {
+        if (bvh__bin_index(job, &job->prims[order[i]]) < best_plane) {
+          i++;
+        } else {
+          uint32_t swap = order[i];
+          order[i] = order[j];
+          order[j--] = swap;
+        }
+      }
+      mid = i;
+    }
+  }
+  // Identical centroids, no valid plane or a deep node halve the range
+  node->first = slot + 2 * (mid - begin);
+  node->count = 0;
+  return mid;
+}
+
+static void bvh__build_subtree(bvh__build_job *job, int32_t slot,
+                               int32_t begin, int32_t end, int32_t parent,
+                               int32_t depth) {
+  job->bvh->parent[slot] = parent;
+  int32_t mid = bvh__split(job, slot, begin, end, depth, 0);
+  if (mid < 0) {
+    return;
+  }
+  bvh__build_subtree(job, slot + 1, begin, mid, slot, depth + 1);
+  bvh__build_subtree(job, slot + 2 * (mid - begin), mid, end, slot, depth + 1);
+}
+
+typedef struct bvh__subtree_job {
+  const bvh__build_job *shared;
+  bvh__build_job *locals; // one per worker, for the reduction scratch
+} bvh__subtree_job;
+
+static void bvh__subtree_range(void *user, int32_t begin, int32_t end,
+                               int32_t worker) {
+  bvh__subtree_job *job = (bvh__subtree_job *)user;
+  bvh__build_job *local = &job->locals[worker];
+  local->mesh = job->shared->mesh;
+  local->bvh = job->shared->bvh;
+  local->prims = job->shared->prims;
+  for (int32_t i = begin; i < end; ++i) {
+    const bvh__task *task = &job->shared->tasks[i];
+    bvh__build_subtree(local, task->slot, task->begin, task->end, task->parent,
+                       task->depth);
+  }
+}
+
+static void bvh__positions_range(void *user, int32_t begin, int32_t end,
+                                 int32_t worker) {
+  bvh__build_job *job = (bvh__build_job *)user;
+  const MeshData *mesh = job->mesh;
+  (void)worker;
+  for (int32_t i = begin; i < end; ++i) {
+    const uint32_t *tri = &mesh->triangles[3 * job->bvh->order[i]];
+    float *dst = job->bvh->positions + 9 * (size_t)i;
+    for (int32_t c = 0; c < 3; ++c) {
+      memcpy(dst + 3 * c, bvh__corner(mesh, tri[c]), 3 * sizeof(float));
+    }
+    job->bvh->entry[job->bvh->order[i]] = i;
+  }
+}
+
+static void bvh__leaf_map_range(void *user, int32_t begin, int32_t end,
+                                int32_t worker) {
+  Bvh *bvh = (Bvh *)user;
+  (void)worker;
+  for (int32_t slot = begin; slot < end; ++slot) {
+    // Slots left unused by multi-triangle leaves have no parent
+    const BvhNode *node = &bvh->nodes[slot];
+    if ((slot == 0 || bvh->parent[slot] >= 0) && node->count > 0) {
+      for (int32_t i = node->first; i < node->first + node->count; ++i) {
+        bvh->leaf[i] = slot;
+      }
+    }
+  }
+}
+
+int32_t bvh_build(const MeshData *mesh, Bvh *out_bvh) {
+  memset(out_bvh, 0, sizeof(*out_bvh));
+  const int32_t n = mesh->triangle_count;
+  if (n <= 0) {
+    return EXIT_FAILURE;
+  }
+  out_bvh->triangle_count = n;
+  out_bvh->node_capacity = 2 * n - 1;
+  out_bvh->nodes = (BvhNode *)malloc((size_t)out_bvh->node_capacity * sizeof(BvhNode));
+  out_bvh->parent = (int32_t *)malloc((size_t)out_bvh->node_capacity * sizeof(int32_t));
+  out_bvh->order = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+  out_bvh->positions = (float *)malloc((size_t)n * 9 * sizeof(float));
+  out_bvh->leaf = (int32_t *)malloc((size_t)n * sizeof(int32_t));
+  out_bvh->entry = (int32_t *)malloc((size_t)n * sizeof(int32_t));
+  out_bvh->refit_mark = (uint8_t *)calloc((size_t)out_bvh->node_capacity, 1);
+
+  const int32_t workers = par_worker_count();
+  const int32_t max_tasks = 8 * workers;
+  bvh__build_job *job = (bvh__build_job *)calloc(1, sizeof(bvh__build_job));
+  bvh__build_job *locals =
+      (bvh__build_job *)calloc((size_t)workers, sizeof(bvh__build_job));
+  bvh__task *tasks = (bvh__task *)malloc(2 * (size_t)max_tasks * sizeof(bvh__task));
+  bvh__prim *prims = (bvh__prim *)malloc((size_t)n * sizeof(bvh__prim));
+  if (!out_bvh->nodes || !out_bvh->parent || !out_bvh->order ||
+      !out_bvh->positions || !out_bvh->leaf || !out_bvh->entry ||
+      !out_bvh->refit_mark || !job || !locals || !tasks || !prims) {
+    free(job);
+    free(locals);
+    free(tasks);
+    free(prims);
+    bvh_free(out_bvh);
+    return EXIT_FAILURE;
+  }
+  memset(out_bvh->parent, 0xff, (size_t)out_bvh->node_capacity * sizeof(int32_t));
+  job->mesh = mesh;
+  job->bvh = out_bvh;
+  job->prims = prims;
+  job->tasks = tasks;
+  par_for(n, 8192, bvh__prim_range, job);
+
+  // Split the top levels with parallel reductions until there are enough
+  // subtrees to keep every worker busy, then build those independently
+  int32_t task_count = 1;
+  tasks[0].slot = 0;
+  tasks[0].begin = 0;
+  tasks[0].end = n;
+  tasks[0].parent = -1;
+  tasks[0].depth = 0;
+  const int32_t small = n / max_tasks > 4096 ? n / max_tasks : 4096;
+  for (int32_t i = 0; i < task_count; ++i) {
+    while (task_count < max_tasks && tasks[i].end - tasks[i].begin > small) {
+      bvh__task task = tasks[i];
+      out_bvh->parent[task.slot] = task.parent;
+      int32_t mid =
+          bvh__split(job, task.slot, task.begin, task.end, task.depth, 1);
+      if (mid < 0) {
+        break;
+      }
+      tasks[i].slot = task.slot + 1;
+      tasks[i].end = mid;
+      tasks[i].parent = task.slot;
+      tasks[i].depth = task.depth + 1;
+      tasks[task_count].slot = task.slot + 2 * (mid - task.begin);
+      tasks[task_count].begin = mid;
+      tasks[task_count].end = task.end;
+      tasks[task_count].parent = task.slot;
+      tasks[task_count].depth = task.depth + 1;
+      task_count++;
+    }
+  }
+  bvh__subtree_job subtree_job = {job, locals};
+  par_for(task_count, 1, bvh__subtree_range, &subtree_job);
+
+  par_for(n, 8192, bvh__positions_range, job);
+  par_for(out_bvh->node_capacity, 8192, bvh__leaf_map_range, out_bvh);
+  free(job);
+  free(locals);
+  free(tasks);
+  free(prims);
+  return 0;
+}
+
+void bvh_free(Bvh *bvh) {
+  free(bvh->nodes);
+  free(bvh->parent);
+  free(bvh->order);
+  free(bvh->positions);
+  free(bvh->leaf);
+  free(bvh->entry);
+  free(bvh->refit_mark);
+  memset(bvh, 0, sizeof(*bvh));
+}
+
+static int bvh__compare_descending(const void *a, const void *b) {
+  const int32_t x = *(const int32_t *)a;
+  const int32_t y = *(const int32_t *)b;
+  return (x < y) - (x > y);
+}
+
+int32_t bvh_refit(Bvh *bvh, const MeshData *mesh, const uint32_t *triangles,
+                  int32_t count) {
+  int32_t capacity = 64 + 4 * count;
+  int32_t dirty_count = 0;
+  int32_t *dirty = (int32_t *)malloc((size_t)capacity * sizeof(int32_t));
+  if (!dirty) {
+    return EXIT_FAILURE;
+  }
+
+  // New corners, then mark the path to the root until it joins a marked one
+  for (int32_t t = 0; t < count; ++t) {
+    const int32_t entry = bvh->entry[triangles[t]];
+    const uint32_t *tri = &mesh->triangles[3 * (size_t)triangles[t]];
+    float *dst = bvh->positions + 9 * (size_t)entry;
+    for (int32_t c = 0; c < 3; ++c) {
+      memcpy(dst + 3 * c, bvh__corner(mesh, tri[c]), 3 * sizeof(float));
+    }
+    for (int32_t node = bvh->leaf[entry]; node >= 0 && !bvh->refit_mark[node];
+         node = bvh->parent[node]) {
+      if (dirty_count == capacity) {
+        capacity *= 2;
+        int32_t *grown = (int32_t *)realloc(dirty, (size_t)capacity * sizeof(int32_t));
+        if (!grown) {
+          for (int32_t i = 0; i < dirty_count; ++i) {
+            bvh->refit_mark[dirty[i]] = 0;
+          }
+          free(dirty);
+          return EXIT_FAILURE;
+        }
+        dirty = grown;
+      }
+      bvh->refit_mark[node] = 1;
+      dirty[dirty_count++] = node;
+    }
+  }
+
+  // Children always sit in higher slots than their parent
+  qsort(dirty, (size_t)dirty_count, sizeof(int32_t), bvh__compare_descending);
+  for (int32_t i = 0; i < dirty_count; ++i) {
+    const int32_t slot = dirty[i];
+    BvhNode *node = &bvh->nodes[slot];
+    bvh__bin box;
+    bvh__bin_reset(&box);
+    if (node->count > 0) {
+      for (int32_t e = node->first; e < node->first + node->count; ++e) {
+        const float *tri = bvh->positions + 9 * (size_t)e;
+        for (int32_t c = 0; c < 3; ++c) {
+          bvh__bin_grow(&box, tri + 3 * c, tri + 3 * c);
+        }
+      }
+    } else {
+      const BvhNode *left = &bvh->nodes[slot + 1];
+      const BvhNode *right = &bvh->nodes[node->first];
+      bvh__bin_grow(&box, left->min, left->max);
+      bvh__bin_grow(&box, right->min, right->max);
+    }
+    memcpy(node->min, box.min, sizeof(node->min));
+    memcpy(node->max, box.max, sizeof(node->max));
+    bvh->refit_mark[slot] = 0;
+  }
+  free(dirty);
+  return 0;
+}
+
+// Slab test, returns the entry distance or FLT_MAX on a miss.
+static float bvh__ray_box(const BvhNode *node, const float *origin,
+                          const float *inv_dir, float t_max) {
+  float t0 = 0.0f;
+  float t1 = t_max;
+  for (int32_t k = 0; k < 3; ++k) {
+    float a = (node->min[k] - origin[k]) * inv_dir[k];
+    float b = (node->max[k] - origin[k]) * inv_dir[k];
+    t0 = fmaxf(t0, fminf(a, b));
+    t1 = fminf(t1, fmaxf(a, b));
+  }
+  return t0 <= t1 ? t0 : FLT_MAX;
+}
+
+// Moller-Trumbore, returns the hit distance or FLT_MAX.
+static float bvh__ray_triangle(const float *tri, const float *origin,
+                               const float *dir, float *out_u, float *out_v) {
+  const float e1[3] = {tri[3] - tri[0], tri[4] - tri[1], tri[5] - tri[2]};
+  const float e2[3] = {tri[6] - tri[0], tri[7] - tri[1], tri[8] - tri[2]};
+  const float p[3] = {dir[1] * e2[2] - dir[2] * e2[1],
+                      dir[2] * e2[0] - dir[0] * e2[2],
+                      dir[0] * e2[1] - dir[1] * e2[0]};
+  const float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+  if (fabsf(det) < 1e-12f) {
+    return FLT_MAX;
+  }
+  const float inv_det = 1.0f / det;
+  const float s[3] = {origin[0] - tri[0], origin[1] - tri[1], origin[2] - tri[2]};
+  const float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inv_det;
+  if (u < 0.0f || u > 1.0f) {
+    return FLT_MAX;
+  }
+  const float q[3] = {s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2],
+                      s[0] * e1[1] - s[1] * e1[0]};
+  const float v = (dir[0] * q[0] + dir[1] * q[1] + dir[2] * q[2]) * inv_det;
+  if (v < 0.0f || u + v > 1.0f) {
+    return FLT_MAX;
+  }
+  const float t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv_det;
+  *out_u = u;
+  *out_v = v;
+  return t > 0.0f ? t : FLT_MAX;
+}
+
+static int32_t bvh__trace(const Bvh *bvh, vec3_t origin, vec3_t direction,
+                          float t_max, int32_t any_hit, BvhHit *out_hit) {
+  const float o[3] = {origin.x, origin.y, origin.z};
+  const float d[3] = {direction.x, direction.y, direction.z};
+  const float inv[3] = {1.0f / d[0], 1.0f / d[1], 1.0f / d[2]};
+  int32_t stack[BVH_STACK_SIZE];
+  int32_t top = 0;
+  int32_t hit = 0;
+  float closest = t_max;
+
+  if (bvh__ray_box(&bvh->nodes[0], o, inv, closest) == FLT_MAX) {
+    return 0;
+  }
+  stack[top++] = 0;
+  while (top > 0) {
+    const BvhNode *node = &bvh->nodes[stack[--top]];
+    if (node->count > 0) {
+      for (int32_t i = node->first; i < node->first + node->count; ++i) {
+        float u = 0.0f;
+        float v = 0.0f;
+        float t = bvh__ray_triangle(bvh->positions + 9 * (size_t)i, o, d, &u, &v);
+        if (t < closest) {
+          closest = t;
+          hit = 1;
+          if (any_hit) {
+            return 1;
+          }
+          out_hit->t = t;
+          out_hit->u = u;
+          out_hit->v = v;
+          out_hit->triangle = bvh->order[i];
+        }
+      }
+      continue;
+    }
+    // Visit the nearer child first
+    int32_t left = (int32_t)(node - bvh->nodes) + 1;
+    int32_t right = node->first;
+    float t_left = bvh__ray_box(&bvh->nodes[left], o, inv, closest);
+    float t_right = bvh__ray_box(&bvh->nodes[right], o, inv, closest);
+    if (t_left > t_right) {
+      int32_t swap = left;
+      left = right;
+      right = swap;
+      float swap_t = t_left;
+      t_left = t_right;
+      t_right = swap_t;
+    }
+    // The build bounds the depth, so the stack cannot overflow
+    if (t_right != FLT_MAX) {
+      stack[top++] = right;
+    }
+    if (t_left != FLT_MAX) {
+      stack[top++] = left;
+    }
+  }
+  return hit;
+}
+
+int32_t bvh_intersect(const Bvh *bvh, vec3_t origin, vec3_t direction,
+                      float t_max, BvhHit *out_hit) {
+  return bvh__trace(bvh, origin, direction, t_max, 0, out_hit);
+}
+
+int32_t bvh_occluded(const Bvh *bvh, vec3_t origin, vec3_t direction,
+                     float t_max) {
+  return bvh__trace(bvh, origin, direction, t_max, 1, NULL);
+}
+
+// Squared distance from a point to the node box, 0 inside.
+static float bvh__box_distance_sq(const BvhNode *node, const float *p) {
+  float sum = 0.0f;
+  for (int32_t k = 0; k < 3; ++k) {
+    float d = fmaxf(fmaxf(node->min[k] - p[k], p[k] - node->max[k]), 0.0f);
+    sum += d * d;
+  }
+  return sum;
+}
+
+// Voronoi region tests (Ericson, RTCD 5.1.5).
+vec3_t bvh_closest_on_triangle(const float *corners, vec3_t point) {
+  const float p[3] = {point.x, point.y, point.z};
+  const float *a = corners;
+  const float *b = corners + 3;
+  const float *c = corners + 6;
+  const float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+  const float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+  const float ap[3] = {p[0] - a[0], p[1] - a[1], p[2] - a[2]};
+  const float d1 = ab[0] * ap[0] + ab[1] * ap[1] + ab[2] * ap[2];
+  const float d2 = ac[0] * ap[0] + ac[1] * ap[1] + ac[2] * ap[2];
+  float v, w;
+  if (d1 <= 0.0f && d2 <= 0.0f) {
+    v = 0.0f;
+    w = 0.0f;
+  } else {
+    const float bp[3] = {p[0] - b[0], p[1] - b[1], p[2] - b[2]};
+    const float d3 = ab[0] * bp[0] + ab[1] * bp[1] + ab[2] * bp[2];
+    const float d4 = ac[0] * bp[0] + ac[1] * bp[1] + ac[2] * bp[2];
+    const float cp[3] = {p[0] - c[0], p[1] - c[1], p[2] - c[2]};
+    const float d5 = ab[0] * cp[0] + ab[1] * cp[1] + ab[2] * cp[2];
+    const float d6 = ac[0] * cp[0] + ac[1] * cp[1] + ac[2] * cp[2];
+    const float vc = d1 * d4 - d3 * d2;
+    const float vb = d5 * d2 - d1 * d6;
+    const float va = d3 * d6 - d5 * d4;
+    if (d3 >= 0.0f && d4 <= d3) {
+      v = 1.0f;
+      w = 0.0f;
+    } else if (d6 >= 0.0f && d5 <= d6) {
+      v = 0.0f;
+      w = 1.0f;
+    } else if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+      v = d1 / (d1 - d3);
+      w = 0.0f;
+    } else if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+      v = 0.0f;
+      w = d2 / (d2 - d6);
+    } else if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+      w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+      v = 1.0f - w;
+    } else {
+      const float denom = 1.0f / (va + vb + vc);
+      v = vb * denom;
+      w = vc * denom;
+    }
+  }
+  return vec3(a[0] + ab[0] * v + ac[0] * w, a[1] + ab[1] * v + ac[1] * w,
+              a[2] + ab[2] * v + ac[2] * w);
+}
+
+int32_t bvh_closest_point(const Bvh *bvh, vec3_t point, float max_distance,
+                          BvhClosest *out_closest) {
+  const float p[3] = {point.x, point.y, point.z};
+  int32_t stack[BVH_STACK_SIZE];
+  int32_t top = 0;
+  int32_t found = 0;
+  float best = max_distance * max_distance;
+
+  if (bvh__box_distance_sq(&bvh->nodes[0], p) > best) {
+    return 0;
+  }
+  stack[top++] = 0;
+  while (top > 0) {
+    const BvhNode *node = &bvh->nodes[stack[--top]];
+    if (bvh__box_distance_sq(node, p) > best) {
+      continue; // the bound shrank since this node was pushed
+    }
+    if (node->count > 0) {
+      for (int32_t i = node->first; i < node->first + node->count; ++i) {
+        vec3_t q = bvh_closest_on_triangle(bvh->positions + 9 * (size_t)i, point);
+        const float dist_sq = vec3_norm_sq(vec3_sub(q, point));
+        if (dist_sq <= best) {
+          best = dist_sq;
+          found = 1;
+          out_closest->point = q;
+          out_closest->distance_sq = dist_sq;
+          out_closest->triangle = bvh->order[i];
+        }
+      }
+      continue;
+    }
+    // Visit the nearer child first
+    int32_t left = (int32_t)(node - bvh->nodes) + 1;
+    int32_t right = node->first;
+    float d_left = bvh__box_distance_sq(&bvh->nodes[left], p);
+    float d_right = bvh__box_distance_sq(&bvh->nodes[right], p);
+    if (d_left > d_right) {
+      int32_t swap = left;
+      left = right;
+      right = swap;
+      float swap_d = d_left;
+      d_left = d_right;
+      d_right = swap_d;
+    }
+    if (d_right <= best) {
+      stack[top++] = right;
+    }
+    if (d_left <= best) {
+      stack[top++] = left;
+    }
+  }
+  return found;
+}
+
+#endif /* _BVH_IMPLEMENTATION_ */
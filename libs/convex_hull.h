@@ -0,0 +1,861 @@
+#ifndef _CONVEX_HULL_H_
+#define _CONVEX_HULL_H_
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Expects vec_math.h, mesh.h and parallel.h to be included first.
+
+typedef struct ConvexHull {
+  int32_t vertex_count;
+  int32_t triangle_count;
+  vec3_t *vertices;
+  uint32_t *triangles; // 3 x triangle_count, counter-clockwise from outside
+} ConvexHull;
+
+// QuickHull over the mesh positions. The positions are first culled in
+// parallel against the hull of their extreme points along 13 directions
+// (Akl-Toussaint), which typically drops the vast majority of a scan, then the
+// remaining candidates go through the incremental QuickHull with outside sets.
+// Planes are thick: points less than a few float ulps of the input extent
+// above a face count as inside, so no input point ends up farther outside the
+// hull than that. Every hull is checked for convex edges before it is handed
+// out; numerically hard inputs are rebuilt with thicker planes.
+// Returns EXIT_FAILURE for degenerate (flat) inputs.
+int32_t hull_build(const MeshData *mesh, ConvexHull *out_hull);
+void hull_free(ConvexHull *hull);
+
+// Fits an oriented box to the hull: the PCA box of the hull surface competes
+// with boxes aligned to one of the HULL_OBB_MAX_FACES largest hull faces and
+// one of its edges (evaluated in parallel), the smallest volume wins.
+MeshOBB hull_fit_obb(const ConvexHull *hull);
+
+// Builds the hull and caches the OBB and a bounding sphere in the mesh.
+int32_t mesh_compute_bounds(MeshData *mesh);
+
+#ifndef HULL_OBB_MAX_FACES
+#define HULL_OBB_MAX_FACES 256
+#endif
+
+#endif /* _CONVEX_HULL_H_ */
+
+#ifdef _CONVEX_HULL_IMPLEMENTATION_
+
+#define HULL__DIRECTION_COUNT 13
+// Plane thickness in float ulps of the input extent, grown by
+// HULL__THICKNESS_GROWTH for each of the HULL__ATTEMPTS builds
+#define HULL__THICKNESS 3.0
+#define HULL__THICKNESS_GROWTH 16.0
+#define HULL__ATTEMPTS 3
+
+static const float hull__directions[HULL__DIRECTION_COUNT][3] = {
+    {1, 0, 0},  {0, 1, 0},  {0, 0, 1},  {1, 1, 0},  {1, -1, 0},
+    {1, 0, 1},  {1, 0, -1}, {0, 1, 1},  {0, 1, -1}, {1, 1, 1},
+    {1, 1, -1}, {1, -1, 1}, {1, -1, -1}};
+
+typedef struct hull__face {
+  int32_t v[3];
+  int32_t neighbor[3]; // face across edge v[i] -> v[(i + 1) % 3]
+  double normal[3];
+  double offset;
+  int32_t outside; // head of the outside point list, -1 if empty
+  int32_t farthest;
+  double farthest_distance;
+  int32_t alive;
+  int32_t visited;
+} hull__face;
+
+typedef struct hull__context {
+  const vec3_t *points;
+  int32_t point_count;
+  double epsilon;
+  int32_t *next; // outside list links, one per point
+  int32_t *assigned;
+
+  hull__face *faces;
+  int32_t face_count;
+  int32_t face_capacity;
+  int32_t *visible;
+  int32_t visible_count;
+  int32_t visible_capacity;
+  int32_t *horizon; // face * 3 + edge of the visible side
+  int32_t horizon_count;
+  int32_t horizon_capacity;
+} hull__context;
+
+static int32_t hull__grow(void **data, int32_t *capacity, int32_t needed,
+                          size_t element_size) {
+  if (needed <= *capacity) {
+    return 0;
+  }
+  int32_t new_capacity = *capacity ? *capacity : 64;
+  while (new_capacity < needed) {
+    new_capacity *= 2;
+  }
+  void *grown = realloc(*data, (size_t)new_capacity * element_size);
+  if (!grown) {
+    return EXIT_FAILURE;
+  }
+  *data = grown;
+  *capacity = new_capacity;
+  return 0;
+}
+
+static double hull__distance(const hull__context *ctx, const hull__face *face,
+                             int32_t point) {
+  const vec3_t p = ctx->points[point];
+  return face->normal[0] * p.x + face->normal[1] * p.y +
+         face->normal[2] * p.z - face->offset;
+}
+
+static void hull__plane(hull__context *ctx, hull__face *face) {
+  const vec3_t a = ctx->points[face->v[0]];
+  const vec3_t b = ctx->points[face->v[1]];
+  const vec3_t c = ctx->points[face->v[2]];
+  double u[3] = {(double)b.x - a.x, (double)b.y - a.y, (double)b.z - a.z};
+  double w[3] = {(double)c.x - a.x, (double)c.y - a.y, (double)c.z - a.z};
+  double n[3] = {u[1] * w[2] - u[2] * w[1], u[2] * w[0] - u[0] * w[2],
+                 u[0] * w[1] - u[1] * w[0]};
+  double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+  double scale = length > 0.0 ? 1.0 / length : 0.0;
+  face->normal[0] = n[0] * scale;
+  face->normal[1] = n[1] * scale;
+  face->normal[2] = n[2] * scale;
+  face->offset = face->normal[0] * a.x + face->normal[1] * a.y +
+                 face->normal[2] * a.z;
+}
+
+static int32_t hull__add_face(hull__context *ctx, int32_t a, int32_t b,
+                              int32_t c) {
+  if (hull__grow((void **)&ctx->faces, &ctx->face_capacity,
+                 ctx->face_count + 1, sizeof(hull__face))) {
+    return -1;
+  }
+  hull__face *face = &ctx->faces[ctx->face_count];
+  memset(face, 0, sizeof(*face));
+  face->v[0] = a;
+  face->v[1] = b;
+  face->v[2] = c;
+  face->neighbor[0] = face->neighbor[1] = face->neighbor[2] = -1;
+  face->outside = -1;
+  face->farthest = -1;
+  face->alive = 1;
+  hull__plane(ctx, face);
+  return ctx->face_count++;
+}
+
+static void hull__add_outside(hull__context *ctx, int32_t face, int32_t point,
+                              double distance) {
+  hull__face *f = &ctx->faces[face];
+  ctx->next[point] = f->outside;
+  f->outside = point;
+  if (f->farthest < 0 || distance > f->farthest_distance) {
+    f->farthest = point;
+    f->farthest_distance = distance;
+  }
+}
+
+static void hull__assign_range(void *user, int32_t begin, int32_t end,
+                               int32_t worker) {
+  hull__context *ctx = (hull__context *)user;
+  (void)worker;
+  for (int32_t p = begin; p < end; ++p) {
+    ctx->assigned[p] = -1;
+    for (int32_t f = 0; f < ctx->face_count; ++f) {
+      const hull__face *face = &ctx->faces[f];
+      if (p == face->v[0] || p == face->v[1] || p == face->v[2]) {
+        ctx->assigned[p] = -1;
+        break;
+      }
+      if (ctx->assigned[p] < 0 && hull__distance(ctx, face, p) > ctx->epsilon) {
+        ctx->assigned[p] = f;
+      }
+    }
+  }
+}
+
+static int32_t hull__simplex(hull__context *ctx, double thickness) {
+  const vec3_t *pts = ctx->points;
+  int32_t min_index[3] = {0, 0, 0};
+  int32_t max_index[3] = {0, 0, 0};
+  double max_abs[3] = {0.0, 0.0, 0.0};
+  for (int32_t p = 0; p < ctx->point_count; ++p) {
+    for (int32_t k = 0; k < 3; ++k) {
+      if (pts[p].data[k] < pts[min_index[k]].data[k]) {
+        min_index[k] = p;
+      }
+      if (pts[p].data[k] > pts[max_index[k]].data[k]) {
+        max_index[k] = p;
+      }
+      max_abs[k] = fmax(max_abs[k], fabs(pts[p].data[k]));
+    }
+  }
+  ctx->epsilon =
+      thickness * FLT_EPSILON * (max_abs[0] + max_abs[1] + max_abs[2]);
+
+  // Widest axis gives the first edge
+  int32_t axis = 0;
+  for (int32_t k = 1; k < 3; ++k) {
+    if (pts[max_index[k]].data[k] - pts[min_index[k]].data[k] >
+        pts[max_index[axis]].data[axis] - pts[min_index[axis]].data[axis]) {
+      axis = k;
+    }
+  }
+  int32_t i0 = min_index[axis];
+  int32_t i1 = max_index[axis];
+  if (pts[i1].data[axis] - pts[i0].data[axis] <= ctx->epsilon) {
+    return EXIT_FAILURE;
+  }
+
+  // Farthest point from the line, then farthest from the plane
+  vec3_t dir = vec3_normalize(vec3_sub(pts[i1], pts[i0]));
+  int32_t i2 = -1;
+  double best = ctx->epsilon;
+  for (int32_t p = 0; p < ctx->point_count; ++p) {
+    vec3_t d = vec3_sub(pts[p], pts[i0]);
+    double dist = vec3_norm(vec3_cross(d, dir));
+    if (dist > best) {
+      best = dist;
+      i2 = p;
+    }
+  }
+  if (i2 < 0) {
+    return EXIT_FAILURE;
+  }
+
+  hull__face base = {0};
+  base.v[0] = i0;
+  base.v[1] = i1;
+  base.v[2] = i2;
+  hull__plane(ctx, &base);
+  int32_t i3 = -1;
+  best = ctx->epsilon;
+  for (int32_t p = 0; p < ctx->point_count; ++p) {
+    double dist = fabs(hull__distance(ctx, &base, p));
+    if (dist > best) {
+      best = dist;
+      i3 = p;
+    }
+  }
+  if (i3 < 0) {
+    return EXIT_FAILURE;
+  }
+
+  // Orient the base so that the apex lies below it
+  if (hull__distance(ctx, &base, i3) > 0.0) {
+    int32_t swap = i1;
+    i1 = i2;
+    i2 = swap;
+  }
+  int32_t faces[4] = {hull__add_face(ctx, i0, i1, i2),
+                      hull__add_face(ctx, i0, i3, i1),
+                      hull__add_face(ctx, i1, i3, i2),
+                      hull__add_face(ctx, i2, i3, i0)};
+  if (faces[0] < 0 || faces[1] < 0 || faces[2] < 0 || faces[3] < 0) {
+    return EXIT_FAILURE;
+  }
+  for (int32_t f = 0; f < 4; ++f) {
+    for (int32_t e = 0; e < 3; ++e) {
+      int32_t a = ctx->faces[f].v[e];
+      int32_t b = ctx->faces[f].v[(e + 1) % 3];
+      for (int32_t g = 0; g < 4; ++g) {
+        for (int32_t k = 0; k < 3; ++k) {
+          if (ctx->faces[g].v[k] == b && ctx->faces[g].v[(k + 1) % 3] == a) {
+            ctx->faces[f].neighbor[e] = g;
+          }
+        }
+      }
+    }
+  }
+
+  // Initial outside sets, the per-point plane tests run in parallel
+  ctx->assigned = (int32_t *)malloc((size_t)ctx->point_count * sizeof(int32_t));
+  if (!ctx->assigned) {
+    return EXIT_FAILURE;
+  }
+  par_for(ctx->point_count, 8192, hull__assign_range, ctx);
+  for (int32_t p = 0; p < ctx->point_count; ++p) {
+    int32_t f = ctx->assigned[p];
+    if (f >= 0) {
+      hull__add_outside(ctx, f, p, hull__distance(ctx, &ctx->faces[f], p));
+    }
+  }
+  free(ctx->assigned);
+  ctx->assigned = NULL;
+  return 0;
+}
+
+// Depth-first search over the faces visible from `eye`. Entering a face
+// through `entry_edge` and continuing with the following edges collects the
+// horizon as one closed counter-clockwise loop. Visibility is tested against
+// the exact plane rather than the thick one: a face the eye sits barely above
+// would otherwise survive next to the new fan and leave a concave edge, and
+// later horizons over concave edges are no longer simple loops.
+static int32_t hull__horizon(hull__context *ctx, int32_t eye, int32_t face,
+                             int32_t entry_edge) {
+  ctx->faces[face].visited = 1;
+  if (hull__grow((void **)&ctx->visible, &ctx->visible_capacity,
+                 ctx->visible_count + 1, sizeof(int32_t))) {
+    return EXIT_FAILURE;
+  }
+  ctx->visible[ctx->visible_count++] = face;
+
+  int32_t first = entry_edge < 0 ? 0 : (entry_edge + 1) % 3;
+  int32_t steps = entry_edge < 0 ? 3 : 2;
+  for (int32_t s = 0; s < steps; ++s) {
+    int32_t e = (first + s) % 3;
+    int32_t neighbor = ctx->faces[face].neighbor[e];
+    if (ctx->faces[neighbor].visited) {
+      continue;
+    }
+    if (hull__distance(ctx, &ctx->faces[neighbor], eye) > 0.0) {
+      int32_t back = 0;
+      while (back < 2 && ctx->faces[neighbor].neighbor[back] != face) {
+        back++;
+      }
+      if (hull__horizon(ctx, eye, neighbor, back)) {
+        return EXIT_FAILURE;
+      }
+    } else {
+      if (hull__grow((void **)&ctx->horizon, &ctx->horizon_capacity,
+                     ctx->horizon_count + 1, sizeof(int32_t))) {
+        return EXIT_FAILURE;
+      }
+      ctx->horizon[ctx->horizon_count++] = face * 3 + e;
+    }
+  }
+  return 0;
+}
+
+static int32_t hull__expand(hull__context *ctx, int32_t face) {
+  const int32_t eye = ctx->faces[face].farthest;
+  ctx->visible_count = 0;
+  ctx->horizon_count = 0;
+  if (hull__horizon(ctx, eye, face, -1)) {
+    return EXIT_FAILURE;
+  }
+
+  // Fan of new faces from the horizon to the eye point
+  const int32_t first_new = ctx->face_count;
+  const int32_t count = ctx->horizon_count;
+  for (int32_t h = 0; h < count; ++h) {
+    int32_t he = ctx->horizon[h];
+    int32_t a = ctx->faces[he / 3].v[he % 3];
+    int32_t b = ctx->faces[he / 3].v[(he % 3 + 1) % 3];
+    if (hull__add_face(ctx, a, b, eye) < 0) {
+      return EXIT_FAILURE;
+    }
+  }
+  for (int32_t h = 0; h < count; ++h) {
+    int32_t he = ctx->horizon[h];
+    int32_t outer = ctx->faces[he / 3].neighbor[he % 3];
+    hull__face *created = &ctx->faces[first_new + h];
+    created->neighbor[0] = outer;
+    created->neighbor[1] = first_new + (h + 1) % count;
+    created->neighbor[2] = first_new + (h + count - 1) % count;
+    for (int32_t k = 0; k < 3; ++k) {
+      if (ctx->faces[outer].neighbor[k] == he / 3 &&
+          ctx->faces[outer].v[k] == created->v[1]) {
+        ctx->faces[outer].neighbor[k] = first_new + h;
+      }
+    }
+  }
+
+  // Hand the outside points of the removed faces to the new ones
+  for (int32_t i = 0; i < ctx->visible_count; ++i) {
+    hull__face *removed = &ctx->faces[ctx->visible[i]];
+    int32_t p = removed->outside;
+    removed->alive = 0;
+    removed->outside = -1;
+    while (p >= 0) {
+      int32_t next = ctx->next[p];
+      if (p != eye) {
+        for (int32_t h = 0; h < count; ++h) {
+          double d = hull__distance(ctx, &ctx->faces[first_new + h], p);
+          if (d > ctx->epsilon) {
+            hull__add_outside(ctx, first_new + h, p, d);
+            break;
+          }
+        }
+      }
+      p = next;
+    }
+  }
+  return 0;
+}
+
+// Every edge of the finished hull has to be convex within the plane
+// thickness: the far corner of a face lies below the plane of its neighbour.
+static int32_t hull__valid(const hull__context *ctx) {
+  for (int32_t f = 0; f < ctx->face_count; ++f) {
+    const hull__face *face = &ctx->faces[f];
+    if (!face->alive) {
+      continue;
+    }
+    for (int32_t e = 0; e < 3; ++e) {
+      const hull__face *neighbor = &ctx->faces[face->neighbor[e]];
+      if (!neighbor->alive ||
+          hull__distance(ctx, neighbor, face->v[(e + 2) % 3]) > ctx->epsilon) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+static int32_t hull__run(hull__context *ctx, const vec3_t *points,
+                         int32_t point_count, double thickness) {
+  memset(ctx, 0, sizeof(*ctx));
+  ctx->points = points;
+  ctx->point_count = point_count;
+  if (point_count < 4) {
+    return EXIT_FAILURE;
+  }
+  ctx->next = (int32_t *)malloc((size_t)point_count * sizeof(int32_t));
+  if (!ctx->next || hull__simplex(ctx, thickness)) {
+    return EXIT_FAILURE;
+  }
+  // New faces are appended, so one forward sweep reaches every outside set
+  for (int32_t f = 0; f < ctx->face_count; ++f) {
+    if (ctx->faces[f].alive && ctx->faces[f].outside >= 0) {
+      if (hull__expand(ctx, f)) {
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  return hull__valid(ctx) ? 0 : EXIT_FAILURE;
+}
+
+static void hull__release(hull__context *ctx) {
+  free(ctx->next);
+  free(ctx->assigned);
+  free(ctx->faces);
+  free(ctx->visible);
+  free(ctx->horizon);
+  memset(ctx, 0, sizeof(*ctx));
+}
+
+typedef struct hull__filter_job {
+  const MeshData *mesh;
+  vec3_t *points;
+  int32_t *keep;
+  vec3_t *candidates;
+  const hull__context *filter;
+  float extreme_min[PAR_MAX_WORKERS][HULL__DIRECTION_COUNT];
+  float extreme_max[PAR_MAX_WORKERS][HULL__DIRECTION_COUNT];
+  int32_t extreme_min_index[PAR_MAX_WORKERS][HULL__DIRECTION_COUNT];
+  int32_t extreme_max_index[PAR_MAX_WORKERS][HULL__DIRECTION_COUNT];
+} hull__filter_job;
+
+static void hull__gather_range(void *user, int32_t begin, int32_t end,
+                               int32_t worker) {
+  hull__filter_job *job = (hull__filter_job *)user;
+  const MeshData *mesh = job->mesh;
+  float *mn = job->extreme_min[worker];
+  float *mx = job->extreme_max[worker];
+  for (int32_t v = begin; v < end; ++v) {
+    const float *src =
+        (const float *)((const char *)mesh->vertex_data +
+                        (size_t)v * mesh->vertex_size + mesh->positions_offset);
+    vec3_t p = vec3(src[0], src[1], src[2]);
+    job->points[v] = p;
+    for (int32_t d = 0; d < HULL__DIRECTION_COUNT; ++d) {
+      float t = hull__directions[d][0] * p.x + hull__directions[d][1] * p.y +
+                hull__directions[d][2] * p.z;
+      if (t < mn[d]) {
+        mn[d] = t;
+        job->extreme_min_index[worker][d] = v;
+      }
+      if (t > mx[d]) {
+        mx[d] = t;
+        job->extreme_max_index[worker][d] = v;
+      }
+    }
+  }
+}
+
+static void hull__keep_range(void *user, int32_t begin, int32_t end,
+                             int32_t worker) {
+  hull__filter_job *job = (hull__filter_job *)user;
+  const hull__context *filter = job->filter;
+  (void)worker;
+  for (int32_t v = begin; v < end; ++v) {
+    const vec3_t p = job->points[v];
+    int32_t outside = 0;
+    for (int32_t f = 0; f < filter->face_count && !outside; ++f) {
+      const hull__face *face = &filter->faces[f];
+      if (face->alive) {
+        double d = face->normal[0] * p.x + face->normal[1] * p.y +
+                   face->normal[2] * p.z - face->offset;
+        outside = d > filter->epsilon;
+      }
+    }
+    job->keep[v] = job->keep[v] || outside;
+  }
+}
+
+static void hull__compact_range(void *user, int32_t begin, int32_t end,
+                                int32_t worker) {
+  hull__filter_job *job = (hull__filter_job *)user;
+  (void)worker;
+  // `keep` holds exclusive offsets now, a point is kept if the next one differs
+  for (int32_t v = begin; v < end; ++v) {
+    if (job->keep[v + 1] != job->keep[v]) {
+      job->candidates[job->keep[v]] = job->points[v];
+    }
+  }
+}
+
+int32_t hull_build(const MeshData *mesh, ConvexHull *out_hull) {
+  memset(out_hull, 0, sizeof(*out_hull));
+  const int32_t n = mesh->vertex_count;
+  if (n < 4) {
+    return EXIT_FAILURE;
+  }
+
+  hull__filter_job *job = (hull__filter_job *)calloc(1, sizeof(hull__filter_job));
+  vec3_t *points = (vec3_t *)malloc((size_t)n * sizeof(vec3_t));
+  vec3_t *candidates = (vec3_t *)malloc((size_t)n * sizeof(vec3_t));
+  int32_t *keep = (int32_t *)calloc((size_t)n + 1, sizeof(int32_t));
+  if (!job || !points || !candidates || !keep) {
+    free(job);
+    free(points);
+    free(candidates);
+    free(keep);
+    return EXIT_FAILURE;
+  }
+  job->mesh = mesh;
+  job->points = points;
+  job->keep = keep;
+  job->candidates = candidates;
+  for (int32_t w = 0; w < PAR_MAX_WORKERS; ++w) {
+    for (int32_t d = 0; d < HULL__DIRECTION_COUNT; ++d) {
+      job->extreme_min[w][d] = FLT_MAX;
+      job->extreme_max[w][d] = -FLT_MAX;
+      job->extreme_min_index[w][d] = -1;
+      job->extreme_max_index[w][d] = -1;
+    }
+  }
+  par_for(n, 16384, hull__gather_range, job);
+
+  // Reduce the per-worker extremes, they are always kept
+  vec3_t extremes[2 * HULL__DIRECTION_COUNT];
+  int32_t extreme_count = 0;
+  for (int32_t d = 0; d < HULL__DIRECTION_COUNT; ++d) {
+    int32_t lo = -1;
+    int32_t hi = -1;
+    float lo_value = FLT_MAX;
+    float hi_value = -FLT_MAX;
+    for (int32_t w = 0; w < PAR_MAX_WORKERS; ++w) {
+      if (job->extreme_min_index[w][d] >= 0 && job->extreme_min[w][d] < lo_value) {
+        lo_value = job->extreme_min[w][d];
+        lo = job->extreme_min_index[w][d];
+      }
+      if (job->extreme_max_index[w][d] >= 0 && job->extreme_max[w][d] > hi_value) {
+        hi_value = job->extreme_max[w][d];
+        hi = job->extreme_max_index[w][d];
+      }
+    }
+    int32_t pair[2] = {lo, hi};
+    for (int32_t k = 0; k < 2; ++k) {
+      if (!keep[pair[k]]) {
+        keep[pair[k]] = 1;
+        extremes[extreme_count++] = points[pair[k]];
+      }
+    }
+  }
+
+  // Drop everything strictly inside the hull of the extremes
+  hull__context filter;
+  if (hull__run(&filter, extremes, extreme_count, HULL__THICKNESS) == 0) {
+    job->filter = &filter;
+    par_for(n, 16384, hull__keep_range, job);
+  } else {
+    for (int32_t v = 0; v < n; ++v) {
+      keep[v] = 1;
+    }
+  }
+  hull__release(&filter);
+
+  int32_t candidate_count = par_exclusive_scan(keep, n + 1);
+  par_for(n, 16384, hull__compact_range, job);
+  free(keep);
+  free(points);
+  free(job);
+
+  hull__context ctx;
+  double thickness = HULL__THICKNESS;
+  int32_t status = hull__run(&ctx, candidates, candidate_count, thickness);
+  for (int32_t attempt = 1; status && ctx.faces && attempt < HULL__ATTEMPTS;
+       ++attempt) {
+    // Built but not convex, near coplanar points within thicker planes are
+    // dropped as inside
+    hull__release(&ctx);
+    thickness *= HULL__THICKNESS_GROWTH;
+    status = hull__run(&ctx, candidates, candidate_count, thickness);
+  }
+  if (status == 0) {
+    int32_t *remap = (int32_t *)malloc((size_t)candidate_count * sizeof(int32_t));
+    int32_t triangle_count = 0;
+    for (int32_t f = 0; f < ctx.face_count; ++f) {
+      triangle_count += ctx.faces[f].alive;
+    }
+    out_hull->triangles =
+        (uint32_t *)malloc((size_t)triangle_count * 3 * sizeof(uint32_t));
+    out_hull->vertices =
+        (vec3_t *)malloc((size_t)candidate_count * sizeof(vec3_t));
+    if (!remap || !out_hull->triangles || !out_hull->vertices) {
+      free(remap);
+      hull_free(out_hull);
+      hull__release(&ctx);
+      free(candidates);
+      return EXIT_FAILURE;
+    }
+    memset(remap, 0xff, (size_t)candidate_count * sizeof(int32_t));
+    for (int32_t f = 0; f < ctx.face_count; ++f) {
+      if (!ctx.faces[f].alive) {
+        continue;
+      }
+      for (int32_t k = 0; k < 3; ++k) {
+        int32_t v = ctx.faces[f].v[k];
+        if (remap[v] < 0) {
+          remap[v] = out_hull->vertex_count;
+          out_hull->vertices[out_hull->vertex_count++] = candidates[v];
+        }
+        out_hull->triangles[3 * out_hull->triangle_count + k] = (uint32_t)remap[v];
+      }
+      out_hull->triangle_count++;
+    }
+    free(remap);
+  }
+  hull__release(&ctx);
+  free(candidates);
+  return status;
+}
+
+void hull_free(ConvexHull *hull) {
+  free(hull->vertices);
+  free(hull->triangles);
+  memset(hull, 0, sizeof(*hull));
+}
+
+// Box spanned by `axes` around the hull vertices, returns its volume.
+static float hull__box(const ConvexHull *hull, const vec3_t axes[3],
+                       MeshOBB *out_box) {
+  float lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+  float hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+  for (int32_t v = 0; v < hull->vertex_count; ++v) {
+    const float *p = hull->vertices[v].data;
+    for (int32_t k = 0; k < 3; ++k) {
+      const float *axis = axes[k].data;
+      float t = p[0] * axis[0] + p[1] * axis[1] + p[2] * axis[2];
+      lo[k] = t < lo[k] ? t : lo[k];
+      hi[k] = t > hi[k] ? t : hi[k];
+    }
+  }
+  out_box->center = vec3(0.0f, 0.0f, 0.0f);
+  for (int32_t k = 0; k < 3; ++k) {
+    out_box->axes[k] = axes[k];
+    out_box->half_extents.data[k] = 0.5f * (hi[k] - lo[k]);
+    out_box->center = vec3_add(
+        out_box->center, vec3_scalar_mul(axes[k], 0.5f * (hi[k] + lo[k])));
+  }
+  return 8.0f * out_box->half_extents.x * out_box->half_extents.y *
+         out_box->half_extents.z;
+}
+
+// Cyclic Jacobi rotations, eigenvectors end up in the columns of `v`.
+static void hull__eigen_symmetric(double a[3][3], double v[3][3]) {
+  for (int32_t i = 0; i < 3; ++i) {
+    for (int32_t j = 0; j < 3; ++j) {
+      v[i][j] = i == j ? 1.0 : 0.0;
+    }
+  }
+  for (int32_t sweep = 0; sweep < 32; ++sweep) {
+    double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+    if (off < 1e-24) {
+      break;
+    }
+    for (int32_t p = 0; p < 2; ++p) {
+      for (int32_t q = p + 1; q < 3; ++q) {
+        if (fabs(a[p][q]) < 1e-30) {
+          continue;
+        }
+        double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+        double t = (theta >= 0.0 ? 1.0 : -1.0) /
+                   (fabs(theta) + sqrt(theta * theta + 1.0));
+        double c = 1.0 / sqrt(t * t + 1.0);
+        double s = t * c;
+        for (int32_t k = 0; k < 3; ++k) {
+          double akp = a[k][p];
+          double akq = a[k][q];
+          a[k][p] = c * akp - s * akq;
+          a[k][q] = s * akp + c * akq;
+        }
+        for (int32_t k = 0; k < 3; ++k) {
+          double apk = a[p][k];
+          double aqk = a[q][k];
+          a[p][k] = c * apk - s * aqk;
+          a[q][k] = s * apk + c * aqk;
+        }
+        for (int32_t k = 0; k < 3; ++k) {
+          double vkp = v[k][p];
+          double vkq = v[k][q];
+          v[k][p] = c * vkp - s * vkq;
+          v[k][q] = s * vkp + c * vkq;
+        }
+      }
+    }
+  }
+}
+
+typedef struct hull__face_area {
+  float area;
+  int32_t face;
+} hull__face_area;
+
+static int hull__compare_area(const void *a, const void *b) {
+  float area_a = ((const hull__face_area *)a)->area;
+  float area_b = ((const hull__face_area *)b)->area;
+  return (area_a < area_b) - (area_a > area_b);
+}
+
+typedef struct hull__obb_job {
+  const ConvexHull *hull;
+  const hull__face_area *faces;
+  float best_volume[PAR_MAX_WORKERS];
+  MeshOBB best[PAR_MAX_WORKERS];
+} hull__obb_job;
+
+static void hull__obb_range(void *user, int32_t begin, int32_t end,
+                            int32_t worker) {
+  hull__obb_job *job = (hull__obb_job *)user;
+  const ConvexHull *hull = job->hull;
+  for (int32_t i = begin; i < end; ++i) {
+    const uint32_t *tri = &hull->triangles[3 * job->faces[i].face];
+    vec3_t a = hull->vertices[tri[0]];
+    vec3_t b = hull->vertices[tri[1]];
+    vec3_t c = hull->vertices[tri[2]];
+    vec3_t normal = vec3_cross(vec3_sub(b, a), vec3_sub(c, a));
+    if (vec3_norm_sq(normal) <= 0.0f) {
+      continue;
+    }
+    normal = vec3_normalize(normal);
+    const vec3_t edges[3] = {vec3_sub(b, a), vec3_sub(c, b), vec3_sub(a, c)};
+    for (int32_t e = 0; e < 3; ++e) {
+      if (vec3_norm_sq(edges[e]) <= 0.0f) {
+        continue;
+      }
+      vec3_t axes[3];
+      axes[0] = normal;
+      axes[1] = vec3_normalize(edges[e]);
+      axes[2] = vec3_cross(axes[0], axes[1]);
+      MeshOBB box;
+      float volume = hull__box(hull, axes, &box);
+      if (volume < job->best_volume[worker]) {
+        job->best_volume[worker] = volume;
+        job->best[worker] = box;
+      }
+    }
+  }
+}
+
+MeshOBB hull_fit_obb(const ConvexHull *hull) {
+  // Area weighted covariance of the hull surface
+  double area = 0.0;
+  double mean[3] = {0.0, 0.0, 0.0};
+  double second[3][3] = {{0.0}};
+  hull__face_area *faces =
+      (hull__face_area *)malloc((size_t)hull->triangle_count * sizeof(hull__face_area));
+  for (int32_t t = 0; t < hull->triangle_count; ++t) {
+    const uint32_t *tri = &hull->triangles[3 * t];
+    vec3_t p = hull->vertices[tri[0]];
+    vec3_t q = hull->vertices[tri[1]];
+    vec3_t r = hull->vertices[tri[2]];
+    double a = 0.5 * vec3_norm(vec3_cross(vec3_sub(q, p), vec3_sub(r, p)));
+    double m[3];
+    for (int32_t i = 0; i < 3; ++i) {
+      m[i] = (p.data[i] + q.data[i] + r.data[i]) / 3.0;
+      mean[i] += a * m[i];
+    }
+    for (int32_t i = 0; i < 3; ++i) {
+      for (int32_t j = 0; j < 3; ++j) {
+        second[i][j] += a / 12.0 *
+                        (9.0 * m[i] * m[j] + p.data[i] * p.data[j] +
+                         q.data[i] * q.data[j] + r.data[i] * r.data[j]);
+      }
+    }
+    area += a;
+    if (faces) {
+      faces[t].area = (float)a;
+      faces[t].face = t;
+    }
+  }
+  double covariance[3][3];
+  for (int32_t i = 0; i < 3; ++i) {
+    for (int32_t j = 0; j < 3; ++j) {
+      covariance[i][j] = second[i][j] / area - mean[i] * mean[j] / (area * area);
+    }
+  }
+  double eigenvectors[3][3];
+  hull__eigen_symmetric(covariance, eigenvectors);
+
+  vec3_t axes[3];
+  axes[0] = vec3_normalize(vec3((float)eigenvectors[0][0], (float)eigenvectors[1][0],
+                                (float)eigenvectors[2][0]));
+  axes[1] = vec3_normalize(vec3((float)eigenvectors[0][1], (float)eigenvectors[1][1],
+                                (float)eigenvectors[2][1]));
+  axes[2] = vec3_cross(axes[0], axes[1]);
+  MeshOBB result;
+  float result_volume = hull__box(hull, axes, &result);
+
+  // Face and edge aligned candidates, large faces are the likely box sides
+  hull__obb_job *job = (hull__obb_job *)calloc(1, sizeof(hull__obb_job));
+  if (job && faces) {
+    qsort(faces, (size_t)hull->triangle_count, sizeof(hull__face_area),
+          hull__compare_area);
+    job->hull = hull;
+    job->faces = faces;
+    for (int32_t w = 0; w < PAR_MAX_WORKERS; ++w) {
+      job->best_volume[w] = FLT_MAX;
+    }
+    int32_t candidate_count = hull->triangle_count < HULL_OBB_MAX_FACES
+                                  ? hull->triangle_count
+                                  : HULL_OBB_MAX_FACES;
+    par_for(candidate_count, 4, hull__obb_range, job);
+    for (int32_t w = 0; w < PAR_MAX_WORKERS; ++w) {
+      if (job->best_volume[w] < result_volume) {
+        result_volume = job->best_volume[w];
+        result = job->best[w];
+      }
+    }
+  }
+  free(job);
+  free(faces);
+  return result;
+}
+
+int32_t mesh_compute_bounds(MeshData *mesh) {
+  ConvexHull hull;
+  if (hull_build(mesh, &hull)) {
+    return EXIT_FAILURE;
+  }
+  mesh->obb = hull_fit_obb(&hull);
+
+  // Sphere around the box center, only the hull vertices can be farthest
+  float radius_sq = 0.0f;
+  for (int32_t v = 0; v < hull.vertex_count; ++v) {
+    radius_sq = fmaxf(radius_sq,
+                      vec3_norm_sq(vec3_sub(hull.vertices[v], mesh->obb.center)));
+  }
+  mesh->sphere_center = mesh->obb.center;
+  mesh->sphere_radius = sqrtf(radius_sq);
+  mesh->has_bounds = 1;
+  hull_free(&hull);
+  return 0;
+}
+
+#endif /* _CONVEX_HULL_IMPLEMENTATION_ */
@@ -0,0 +1,267 @@
+#ifndef _DEFORM_H_
+#define _DEFORM_H_
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Expects vec_math.h, mesh.h and parallel.h to be included first.
+
+// The kernels run on the float8_t backend of vec_math.h (AVX, SSE2, NEON or
+// plain arrays) with its fast sine, cosine and reciprocal square root,
+// DEFORM_NO_SIMD selects an exact scalar loop over libm instead.
+#if !defined(DEFORM_NO_SIMD)
+#define DEFORM_SIMD 1
+#endif
+
+#define DEFORM_MAX_TARGETS 8
+// Vertices per parallel task, a multiple of MESH_SOA_WIDTH
+#define DEFORM_BLOCK 2048
+// Vertices deformed into a stack tile before they are interleaved, sized to stay in L1
+#define DEFORM_TILE 256
+
+// Procedural displacement along the normal, amplitude * sin(dot(wave_vector, p) + phase).
+typedef struct DeformWave {
+  vec3_t wave_vector; // direction of travel scaled by 2 pi / wavelength
+  float amplitude;    // 0 disables the wave
+  float phase;
+} DeformWave;
+
+// Morph targets and procedural displacement over a SoA copy of the mesh.
+// Targets are stored as position and normal deltas from the base, so only the
+// targets with a non-zero weight are read each frame.
+typedef struct Deformer {
+  const MeshSoA *base;
+  int32_t target_count;
+  MeshSoA targets[DEFORM_MAX_TARGETS];
+  float weights[DEFORM_MAX_TARGETS];
+  DeformWave wave;
+} Deformer;
+
+// `base` is referenced, not copied, and must outlive the deformer.
+void deformer_init(Deformer *deformer, const MeshSoA *base);
+void deformer_destroy(Deformer *deformer);
+
+// Adds `target` (same vertex count as the base) as a morph target with weight
+// 0. Returns its index, or -1 when full or out of memory.
+int32_t deformer_add_target(Deformer *deformer, const MeshSoA *target);
+
+// Blends the weighted targets over the base, applies the wave, renormalizes
+// and writes the result. Runs 8 vertices per iteration across the par_for
+// workers.
+void deform_run_soa(const Deformer *deformer, MeshSoA *out_soa);
+
+// Same, writing interleaved vertices of `vertex_size` bytes with the position
+// and normal at the given byte offsets, typically into a mapped vertex buffer.
+// Writes are sequential and never read back, which suits write-combined memory.
+void deform_run(const Deformer *deformer, void *out_vertices, int32_t vertex_size,
+                int32_t positions_offset, int32_t normals_offset);
+
+#endif /* _DEFORM_H_ */
+
+#ifdef _DEFORM_IMPLEMENTATION_
+
+void deformer_init(Deformer *deformer, const MeshSoA *base) {
+  memset(deformer, 0, sizeof(*deformer));
+  deformer->base = base;
+}
+
+void deformer_destroy(Deformer *deformer) {
+  for (int32_t t = 0; t < deformer->target_count; ++t) {
+    mesh_soa_free(&deformer->targets[t]);
+  }
+  memset(deformer, 0, sizeof(*deformer));
+}
+
+int32_t deformer_add_target(Deformer *deformer, const MeshSoA *target) {
+  const MeshSoA *base = deformer->base;
+  if (deformer->target_count >= DEFORM_MAX_TARGETS || target->vertex_count != base->vertex_count) {
+    return -1;
+  }
+  MeshSoA *delta = &deformer->targets[deformer->target_count];
+  if (mesh_soa_alloc(delta, base->vertex_count)) {
+    return -1;
+  }
+  // Streams are contiguous in both blocks, padding included
+  const size_t count = 6 * (size_t)base->capacity;
+  for (size_t i = 0; i < count; ++i) {
+    delta->x[i] = target->x[i] - base->x[i];
+  }
+  deformer->weights[deformer->target_count] = 0.0f;
+  return deformer->target_count++;
+}
+
+// Targets that contribute this run
+typedef struct deform__active {
+  int32_t count;
+  const MeshSoA *deltas[DEFORM_MAX_TARGETS];
+  float weights[DEFORM_MAX_TARGETS];
+} deform__active;
+
+static void deform__gather_active(const Deformer *deformer, deform__active *out_active) {
+  out_active->count = 0;
+  for (int32_t t = 0; t < deformer->target_count; ++t) {
+    if (deformer->weights[t] != 0.0f) {
+      out_active->deltas[out_active->count] = &deformer->targets[t];
+      out_active->weights[out_active->count] = deformer->weights[t];
+      out_active->count++;
+    }
+  }
+}
+
+// Deforms vertices [begin, begin + count) into the six streams of `out`,
+// indexed from 0. `count` is a multiple of MESH_SOA_WIDTH, padding lanes of
+// the base make that safe at the tail.
+static void deform__kernel(const Deformer *deformer, const deform__active *active,
+                           int32_t begin, int32_t count, float *const out[6]) {
+  const MeshSoA *base = deformer->base;
+  const DeformWave *wave = &deformer->wave;
+  int32_t i = 0;
+
+#if defined(DEFORM_SIMD)
+  const vec3x8_t k = vec3x8_splat(wave->wave_vector);
+  const float8_t amplitude = float8_splat(wave->amplitude);
+  const float8_t phase = float8_splat(wave->phase);
+  for (; i < count; i += 8) {
+    const int32_t v = begin + i;
+    vec3x8_t p = vec3x8_load(base->x + v, base->y + v, base->z + v);
+    vec3x8_t n = vec3x8_load(base->nx + v, base->ny + v, base->nz + v);
+    for (int32_t t = 0; t < active->count; ++t) {
+      const MeshSoA *d = active->deltas[t];
+      const float8_t w = float8_splat(active->weights[t]);
+      p = vec3x8_add(p, vec3x8_scale(vec3x8_load(d->x + v, d->y + v, d->z + v), w));
+      n = vec3x8_add(n, vec3x8_scale(vec3x8_load(d->nx + v, d->ny + v, d->nz + v), w));
+    }
+    n = vec3x8_normalize_fast(n);
+
+    if (wave->amplitude != 0.0f) {
+      // Height h along the normal, tilt the normal against the tangential
+      // part of the height gradient g = amplitude * cos(s) * k
+      float8_t sin_s, cos_s;
+      float8_sincos_fast(float8_add(vec3x8_dot(k, p), phase), &sin_s, &cos_s);
+      const float8_t h = float8_mul(amplitude, sin_s);
+      const vec3x8_t g = vec3x8_scale(k, float8_mul(amplitude, cos_s));
+      p = vec3x8_add(p, vec3x8_scale(n, h));
+      n = vec3x8_sub(n, vec3x8_sub(g, vec3x8_scale(n, vec3x8_dot(g, n))));
+      n = vec3x8_normalize_fast(n);
+    }
+
+    vec3x8_store(out[0] + i, out[1] + i, out[2] + i, p);
+    vec3x8_store(out[3] + i, out[4] + i, out[5] + i, n);
+  }
+#endif
+
+  for (; i < count; ++i) {
+    const int32_t v = begin + i;
+    float p[3] = {base->x[v], base->y[v], base->z[v]};
+    float n[3] = {base->nx[v], base->ny[v], base->nz[v]};
+    for (int32_t t = 0; t < active->count; ++t) {
+      const MeshSoA *d = active->deltas[t];
+      const float w = active->weights[t];
+      p[0] += w * d->x[v];
+      p[1] += w * d->y[v];
+      p[2] += w * d->z[v];
+      n[0] += w * d->nx[v];
+      n[1] += w * d->ny[v];
+      n[2] += w * d->nz[v];
+    }
+    float rl = 1.0f / sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    n[0] *= rl;
+    n[1] *= rl;
+    n[2] *= rl;
+
+    if (wave->amplitude != 0.0f) {
+      const vec3_t k = wave->wave_vector;
+      const float s = k.x * p[0] + k.y * p[1] + k.z * p[2] + wave->phase;
+      const float h = wave->amplitude * sinf(s);
+      const float a = wave->amplitude * cosf(s);
+      const float g[3] = {a * k.x, a * k.y, a * k.z};
+      const float gn = g[0] * n[0] + g[1] * n[1] + g[2] * n[2];
+      for (int32_t c = 0; c < 3; ++c) {
+        p[c] += n[c] * h;
+      }
+      for (int32_t c = 0; c < 3; ++c) {
+        n[c] -= g[c] - gn * n[c];
+      }
+      rl = 1.0f / sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      n[0] *= rl;
+      n[1] *= rl;
+      n[2] *= rl;
+    }
+
+    out[0][i] = p[0];
+    out[1][i] = p[1];
+    out[2][i] = p[2];
+    out[3][i] = n[0];
+    out[4][i] = n[1];
+    out[5][i] = n[2];
+  }
+}
+
+typedef struct deform__job {
+  const Deformer *deformer;
+  deform__active active;
+  MeshSoA *out_soa;
+  char *out_vertices;
+  int32_t vertex_size;
+  int32_t positions_offset;
+  int32_t normals_offset;
+} deform__job;
+
+static void deform__soa_task(void *user, int32_t begin, int32_t end, int32_t worker) {
+  (void)worker;
+  const deform__job *job = (const deform__job *)user;
+  const MeshSoA *base = job->deformer->base;
+  for (int32_t b = begin; b < end; ++b) {
+    const int32_t first = b * DEFORM_BLOCK;
+    const int32_t count = base->capacity - first < DEFORM_BLOCK ? base->capacity - first : DEFORM_BLOCK;
+    MeshSoA *soa = job->out_soa;
+    float *const out[6] = {soa->x + first, soa->y + first, soa->z + first,
+                           soa->nx + first, soa->ny + first, soa->nz + first};
+    deform__kernel(job->deformer, &job->active, first, count, out);
+  }
+}
+
+static void deform__interleaved_task(void *user, int32_t begin, int32_t end, int32_t worker) {
+  (void)worker;
+  const deform__job *job = (const deform__job *)user;
+  const int32_t vertex_count = job->deformer->base->vertex_count;
+  _Alignas(32) float tile[6][DEFORM_TILE];
+  float *const out[6] = {tile[0], tile[1], tile[2], tile[3], tile[4], tile[5]};
+  const float *const in[6] = {tile[0], tile[1], tile[2], tile[3], tile[4], tile[5]};
+  for (int32_t b = begin; b < end; ++b) {
+    const int32_t block_end = (b + 1) * DEFORM_BLOCK < vertex_count ? (b + 1) * DEFORM_BLOCK : vertex_count;
+    for (int32_t first = b * DEFORM_BLOCK; first < block_end; first += DEFORM_TILE) {
+      const int32_t count = block_end - first < DEFORM_TILE ? block_end - first : DEFORM_TILE;
+      const int32_t padded = (count + MESH_SOA_WIDTH - 1) & ~(MESH_SOA_WIDTH - 1);
+      deform__kernel(job->deformer, &job->active, first, padded, out);
+      mesh_interleave(in, count, job->out_vertices + (size_t)first * job->vertex_size,
+                      job->vertex_size, job->positions_offset, job->normals_offset);
+    }
+  }
+}
+
+void deform_run_soa(const Deformer *deformer, MeshSoA *out_soa) {
+  deform__job job = {0};
+  job.deformer = deformer;
+  job.out_soa = out_soa;
+  deform__gather_active(deformer, &job.active);
+  const int32_t blocks = (deformer->base->capacity + DEFORM_BLOCK - 1) / DEFORM_BLOCK;
+  par_for(blocks, 1, deform__soa_task, &job);
+}
+
+void deform_run(const Deformer *deformer, void *out_vertices, int32_t vertex_size,
+                int32_t positions_offset, int32_t normals_offset) {
+  deform__job job = {0};
+  job.deformer = deformer;
+  job.out_vertices = (char *)out_vertices;
+  job.vertex_size = vertex_size;
+  job.positions_offset = positions_offset;
+  job.normals_offset = normals_offset;
+  deform__gather_active(deformer, &job.active);
+  const int32_t blocks = (deformer->base->vertex_count + DEFORM_BLOCK - 1) / DEFORM_BLOCK;
+  par_for(blocks, 1, deform__interleaved_task, &job);
+}
+
+#endif /* _DEFORM_IMPLEMENTATION_ */
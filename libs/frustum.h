@@ -0,0 +1,298 @@
+#ifndef _FRUSTUM_H_
+#define _FRUSTUM_H_
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// Expects vec_math.h and mesh.h to be included first.
+
+// The batch tests run 8 objects per iteration with AVX, 4 with SSE2 and one
+// at a time otherwise. Every path evaluates the same expressions in the same
+// order, so the masks do not depend on the backend.
+#if !defined(FRUSTUM_NO_SIMD)
+#if defined(__AVX__)
+#define FRUSTUM_SIMD_AVX 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define FRUSTUM_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+#endif
+
+enum {
+  FRUSTUM_LEFT,
+  FRUSTUM_RIGHT,
+  FRUSTUM_BOTTOM,
+  FRUSTUM_TOP,
+  FRUSTUM_NEAR,
+  FRUSTUM_FAR,
+  FRUSTUM_PLANE_COUNT
+};
+
+// Planes (n, d) with unit normals pointing inwards: a point p is inside the
+// plane when dot(n, p) + d >= 0.
+typedef struct Frustum {
+  vec4_t planes[FRUSTUM_PLANE_COUNT];
+} Frustum;
+
+// Struct-of-arrays inputs of the batch tests, one float per object in every
+// array. Boxes are given by their center and three half axes, the unit axes
+// scaled by the half extents, so a transformed box keeps its shape.
+typedef struct FrustumSpheres {
+  const float *x, *y, *z, *radius;
+} FrustumSpheres;
+
+typedef struct FrustumAabbs {
+  const float *min[3];
+  const float *max[3];
+} FrustumAabbs;
+
+typedef struct FrustumObbs {
+  const float *center[3];
+  const float *half_axes[3][3]; // [axis][component]
+} FrustumObbs;
+
+// Planes of the clip volume of `view_projection` (-w <= x, y, z <= w), in the
+// space the matrix transforms from (Gribb and Hartmann).
+void frustum_from_matrix(Frustum *frustum, mat4_t view_projection);
+
+// Conservative tests: 0 only when the volume is entirely outside one plane.
+int32_t frustum_test_sphere(const Frustum *frustum, vec3_t center, float radius);
+int32_t frustum_test_aabb(const Frustum *frustum, vec3_t min, vec3_t max);
+int32_t frustum_test_obb(const Frustum *frustum, vec3_t center, const vec3_t half_axes[3]);
+
+// Center and half axes of `box` (typically the cached MeshData::obb) after `model`.
+void frustum_obb_transform(const MeshOBB *box, mat4_t model, vec3_t *out_center,
+                           vec3_t out_half_axes[3]);
+
+// Batch tests: bit (i % 32) of out_mask[i / 32] is set when object i passes.
+// out_mask holds (count + 31) / 32 words and is overwritten.
+void frustum_cull_spheres(const Frustum *frustum, const FrustumSpheres *spheres,
+                          int32_t count, uint32_t *out_mask);
+void frustum_cull_aabbs(const Frustum *frustum, const FrustumAabbs *boxes,
+                        int32_t count, uint32_t *out_mask);
+void frustum_cull_obbs(const Frustum *frustum, const FrustumObbs *boxes,
+                       int32_t count, uint32_t *out_mask);
+
+#define frustum_mask_test(mask, i) (((mask)[(i) >> 5] >> ((i) & 31)) & 1u)
+
+#endif /* _FRUSTUM_H_ */
+
+#ifdef _FRUSTUM_IMPLEMENTATION_
+
+// Lanes of the batch tests. The scalar path is the same code one lane wide.
+#if defined(FRUSTUM_SIMD_AVX)
+#define FRUSTUM__WIDTH 8
+typedef __m256 frustum__v;
+#define frustum__load(p) _mm256_loadu_ps(p)
+#define frustum__splat(s) _mm256_set1_ps(s)
+#define frustum__add(a, b) _mm256_add_ps((a), (b))
+#define frustum__sub(a, b) _mm256_sub_ps((a), (b))
+#define frustum__mul(a, b) _mm256_mul_ps((a), (b))
+#define frustum__abs(a) _mm256_andnot_ps(_mm256_set1_ps(-0.0f), (a))
+// All ones in the lanes where a >= 0
+#define frustum__nonnegative(a) _mm256_cmp_ps((a), _mm256_setzero_ps(), _CMP_GE_OQ)
+#define frustum__and(a, b) _mm256_and_ps((a), (b))
+#define frustum__bits(a) (uint32_t)_mm256_movemask_ps(a)
+#elif defined(FRUSTUM_SIMD_SSE2)
+#define FRUSTUM__WIDTH 4
+typedef __m128 frustum__v;
+#define frustum__load(p) _mm_loadu_ps(p)
+#define frustum__splat(s) _mm_set1_ps(s)
+#define frustum__add(a, b) _mm_add_ps((a), (b))
+#define frustum__sub(a, b) _mm_sub_ps((a), (b))
+#define frustum__mul(a, b) _mm_mul_ps((a), (b))
+#define frustum__abs(a) _mm_andnot_ps(_mm_set1_ps(-0.0f), (a))
+#define frustum__nonnegative(a) _mm_cmpge_ps((a), _mm_setzero_ps())
+#define frustum__and(a, b) _mm_and_ps((a), (b))
+#define frustum__bits(a) (uint32_t)_mm_movemask_ps(a)
+#else
+#define FRUSTUM__WIDTH 1
+typedef float frustum__v;
+#define frustum__load(p) (*(p))
+#define frustum__splat(s) (s)
+#define frustum__add(a, b) ((a) + (b))
+#define frustum__sub(a, b) ((a) - (b))
+#define frustum__mul(a, b) ((a) * (b))
+#define frustum__abs(a) fabsf(a)
+#define frustum__nonnegative(a) ((a) >= 0.0f ? 1.0f : 0.0f)
+#define frustum__and(a, b) ((a) * (b))
+#define frustum__bits(a) ((a) != 0.0f ? 1u : 0u)
+#endif
+
+void frustum_from_matrix(Frustum *frustum, mat4_t view_projection) {
+  // Row r of the matrix is (m[r], m[4 + r], m[8 + r], m[12 + r]); each plane
+  // is the w row plus or minus the x, y or z row
+  const float *m = view_projection.data;
+  for (int32_t p = 0; p < FRUSTUM_PLANE_COUNT; ++p) {
+    const int32_t row = p / 2;
+    const float sign = (p & 1) ? -1.0f : 1.0f;
+    vec4_t plane = vec4(m[3] + sign * m[row], m[7] + sign * m[4 + row],
+                        m[11] + sign * m[8 + row], m[15] + sign * m[12 + row]);
+    const float length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+    frustum->planes[p] = vec4_scalar_mul(plane, 1.0f / length);
+  }
+}
+
+// Signed distance of a center to every plane plus the extent of the volume
+// along its normal, inside when no sum is negative. The batch kernels below
+// evaluate exactly these expressions.
+static float frustum__distance(vec4_t plane, vec3_t c) {
+  return plane.x * c.x + plane.y * c.y + plane.z * c.z + plane.w;
+}
+
+int32_t frustum_test_sphere(const Frustum *frustum, vec3_t center, float radius) {
+  for (int32_t p = 0; p < FRUSTUM_PLANE_COUNT; ++p) {
+    if (!(frustum__distance(frustum->planes[p], center) + radius >= 0.0f)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int32_t frustum_test_aabb(const Frustum *frustum, vec3_t min, vec3_t max) {
+  const vec3_t center = vec3((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f);
+  const vec3_t extent = vec3((max.x - min.x) * 0.5f, (max.y - min.y) * 0.5f, (max.z - min.z) * 0.5f);
+  for (int32_t p = 0; p < FRUSTUM_PLANE_COUNT; ++p) {
+    const vec4_t n = frustum->planes[p];
+    const float r = fabsf(n.x) * extent.x + fabsf(n.y) * extent.y + fabsf(n.z) * extent.z;
+    if (!(frustum__distance(n, center) + r >= 0.0f)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int32_t frustum_test_obb(const Frustum *frustum, vec3_t center, const vec3_t half_axes[3]) {
+  for (int32_t p = 0; p < FRUSTUM_PLANE_COUNT; ++p) {
+    const vec4_t n = frustum->planes[p];
+    float r = 0.0f;
+    for (int32_t k = 0; k < 3; ++k) {
+      r = r + fabsf(n.x * half_axes[k].x + n.y * half_axes[k].y + n.z * half_axes[k].z);
+    }
+    if (!(frustum__distance(n, center) + r >= 0.0f)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+void frustum_obb_transform(const MeshOBB *box, mat4_t model, vec3_t *out_center,
+                           vec3_t out_half_axes[3]) {
+  *out_center = mat4_vec3_mul(model, box->center, 1);
+  for (int32_t k = 0; k < 3; ++k) {
+    out_half_axes[k] = mat4_vec3_mul(model, vec3_scalar_mul(box->axes[k], box->half_extents.data[k]), 0);
+  }
+}
+
+// Adds the lanes of object `i` onwards to the mask. The widths divide 32, so
+// every group lands inside one word.
+static void frustum__store_bits(uint32_t *out_mask, int32_t i, uint32_t bits) {
+  out_mask[i >> 5] |= bits << (i & 31);
+}
+
+static frustum__v frustum__plane_distance(vec4_t plane, frustum__v x, frustum__v y, frustum__v z) {
+  frustum__v d = frustum__mul(frustum__splat(plane.x), x);
+  d = frustum__add(d, frustum__mul(frustum__splat(plane.y), y));
+  d = frustum__add(d, frustum__mul(frustum__splat(plane.z), z));
+  return frustum__add(d, frustum__splat(plane.w));
+}
+
+void frustum_cull_spheres(const Frustum *frustum, const FrustumSpheres *spheres,
+                          int32_t count, uint32_t *out_mask) {
+  memset(out_mask, 0, (size_t)((count + 31) / 32) * sizeof(uint32_t));
+  int32_t i = 0;
+  for (; i + FRUSTUM__WIDTH <= count; i += FRUSTUM__WIDTH) {
+    const frustum__v x = frustum__load(spheres->x + i);
+    const frustum__v y = frustum__load(spheres->y + i);
+    const frustum__v z = frustum__load(spheres->z + i);
+    const frustum__v r = frustum__load(spheres->radius + i);
+    frustum__v inside = frustum__nonnegative(
+        frustum__add(frustum__plane_distance(frustum->planes[0], x, y, z), r));
+    for (int32_t p = 1; p < FRUSTUM_PLANE_COUNT; ++p) {
+      inside = frustum__and(inside, frustum__nonnegative(frustum__add(
+                                        frustum__plane_distance(frustum->planes[p], x, y, z), r)));
+    }
+    frustum__store_bits(out_mask, i, frustum__bits(inside));
+  }
+  for (; i < count; ++i) {
+    const vec3_t c = vec3(spheres->x[i], spheres->y[i], spheres->z[i]);
+    frustum__store_bits(out_mask, i, (uint32_t)frustum_test_sphere(frustum, c, spheres->radius[i]));
+  }
+}
+
+void frustum_cull_aabbs(const Frustum *frustum, const FrustumAabbs *boxes,
+                        int32_t count, uint32_t *out_mask) {
+  memset(out_mask, 0, (size_t)((count + 31) / 32) * sizeof(uint32_t));
+  const frustum__v half = frustum__splat(0.5f);
+  int32_t i = 0;
+  for (; i + FRUSTUM__WIDTH <= count; i += FRUSTUM__WIDTH) {
+    frustum__v c[3], e[3];
+    for (int32_t k = 0; k < 3; ++k) {
+      const frustum__v lo = frustum__load(boxes->min[k] + i);
+      const frustum__v hi = frustum__load(boxes->max[k] + i);
+      c[k] = frustum__mul(frustum__add(lo, hi), half);
+      e[k] = frustum__mul(frustum__sub(hi, lo), half);
+    }
+    frustum__v inside = frustum__splat(0.0f);
+    for (int32_t p = 0; p < FRUSTUM_PLANE_COUNT; ++p) {
+      const vec4_t n = frustum->planes[p];
+      frustum__v r = frustum__mul(frustum__splat(fabsf(n.x)), e[0]);
+      r = frustum__add(r, frustum__mul(frustum__splat(fabsf(n.y)), e[1]));
+      r = frustum__add(r, frustum__mul(frustum__splat(fabsf(n.z)), e[2]));
+      const frustum__v test = frustum__nonnegative(
+          frustum__add(frustum__plane_distance(n, c[0], c[1], c[2]), r));
+      inside = p == 0 ? test : frustum__and(inside, test);
+    }
+    frustum__store_bits(out_mask, i, frustum__bits(inside));
+  }
+  for (; i < count; ++i) {
+    const vec3_t lo = vec3(boxes->min[0][i], boxes->min[1][i], boxes->min[2][i]);
+    const vec3_t hi = vec3(boxes->max[0][i], boxes->max[1][i], boxes->max[2][i]);
+    frustum__store_bits(out_mask, i, (uint32_t)frustum_test_aabb(frustum, lo, hi));
+  }
+}
+
+void frustum_cull_obbs(const Frustum *frustum, const FrustumObbs *boxes,
+                       int32_t count, uint32_t *out_mask) {
+  memset(out_mask, 0, (size_t)((count + 31) / 32) * sizeof(uint32_t));
+  int32_t i = 0;
+  for (; i + FRUSTUM__WIDTH <= count; i += FRUSTUM__WIDTH) {
+    frustum__v c[3], a[3][3];
+    for (int32_t k = 0; k < 3; ++k) {
+      c[k] = frustum__load(boxes->center[k] + i);
+      for (int32_t j = 0; j < 3; ++j) {
+        a[k][j] = frustum__load(boxes->half_axes[k][j] + i);
+      }
+    }
+    frustum__v inside = frustum__splat(0.0f);
+    for (int32_t p = 0; p < FRUSTUM_PLANE_COUNT; ++p) {
+      const vec4_t n = frustum->planes[p];
+      const frustum__v nx = frustum__splat(n.x);
+      const frustum__v ny = frustum__splat(n.y);
+      const frustum__v nz = frustum__splat(n.z);
+      frustum__v r = frustum__splat(0.0f);
+      for (int32_t k = 0; k < 3; ++k) {
+        frustum__v projected = frustum__mul(nx, a[k][0]);
+        projected = frustum__add(projected, frustum__mul(ny, a[k][1]));
+        projected = frustum__add(projected, frustum__mul(nz, a[k][2]));
+        r = frustum__add(r, frustum__abs(projected));
+      }
+      const frustum__v test = frustum__nonnegative(
+          frustum__add(frustum__plane_distance(n, c[0], c[1], c[2]), r));
+      inside = p == 0 ? test : frustum__and(inside, test);
+    }
+    frustum__store_bits(out_mask, i, frustum__bits(inside));
+  }
+  for (; i < count; ++i) {
+    const vec3_t c = vec3(boxes->center[0][i], boxes->center[1][i], boxes->center[2][i]);
+    vec3_t axes[3];
+    for (int32_t k = 0; k < 3; ++k) {
+      axes[k] = vec3(boxes->half_axes[k][0][i], boxes->half_axes[k][1][i], boxes->half_axes[k][2][i]);
+    }
+    frustum__store_bits(out_mask, i, (uint32_t)frustum_test_obb(frustum, c, axes));
+  }
+}
+
+#endif /* _FRUSTUM_IMPLEMENTATION_ */
@@ -14,6 +14,9 @@ int8_t glh_check_program_status(GLuint program_id, bool report_error);
 int8_t glh_check_shader_status(GLuint shader_id, bool report_error);
 GLuint glh_compile_shader_src(GLuint shader_type, const char *shader_src); 
 GLuint glh_link_program(GLuint vertex_shader, GLuint geometry_shader, GLuint fragment_shader);
+GLuint glh_link_program_tess(GLuint vertex_shader, GLuint tess_control_shader,
+                             GLuint tess_evaluation_shader,
+                             GLuint geometry_shader, GLuint fragment_shader);
 #endif /* _GL_HELPERS_H_ */
 
 
@@ -71,31 +74,32 @@ GLuint glh_compile_shader_src(GLuint shader_type, const char *shader_src) {
 
 GLuint glh_link_program(GLuint vertex_shader, GLuint geometry_shader,
                         GLuint fragment_shader) {
+  return glh_link_program_tess(vertex_shader, 0, 0, geometry_shader,
+                               fragment_shader);
+}
+
+GLuint glh_link_program_tess(GLuint vertex_shader, GLuint tess_control_shader,
+                             GLuint tess_evaluation_shader,
+                             GLuint geometry_shader, GLuint fragment_shader) {
   GLuint program = glCreateProgram();
+  const GLuint shaders[] = {vertex_shader, tess_control_shader,
+                            tess_evaluation_shader, geometry_shader,
+                            fragment_shader};
+  const int32_t shader_count = sizeof(shaders) / sizeof(shaders[0]);
 
-  if (vertex_shader) {
-    glAttachShader(program, vertex_shader);
-  }
-  if (geometry_shader) {
-    glAttachShader(program, geometry_shader);
-  }
-  if (fragment_shader) {
-    glAttachShader(program, fragment_shader);
+  for (int32_t i = 0; i < shader_count; ++i) {
+    if (shaders[i]) {
+      glAttachShader(program, shaders[i]);
+    }
   }
 
   glLinkProgram(program);
 
-  if (vertex_shader) {
-    glDetachShader(program, vertex_shader);
-    glDeleteShader(vertex_shader);
-  }
-  if (geometry_shader) {
-    glDetachShader(program, geometry_shader);
-    glDeleteShader(geometry_shader);
-  }
-  if (fragment_shader) {
-    glDetachShader(program, fragment_shader);
-    glDeleteShader(fragment_shader);
+  for (int32_t i = 0; i < shader_count; ++i) {
+    if (shaders[i]) {
+      glDetachShader(program, shaders[i]);
+      glDeleteShader(shaders[i]);
+    }
   }
 
   glh_check_program_status(program, true);
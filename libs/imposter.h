@@ -0,0 +1,192 @@
+#ifndef _IMPOSTER_H_
+#define _IMPOSTER_H_
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Expects vec_math.h and mesh.h to be included first.
+
+// Layout of an octahedral imposter atlas: `grid` x `grid` frames, each an
+// orthographic picture of the mesh bounding sphere seen from one direction.
+// Frame (x, y) looks from the direction that the octahedral map puts at
+// (x, y) / (grid - 1), so the frames on the atlas borders cover the seams and
+// any view direction falls between three neighbouring frames.
+// The GLSL side of the runtime repeats imposter_encode_direction,
+// imposter_decode_direction and imposter_frame_basis, keep them in sync.
+typedef struct ImposterAtlas {
+  int32_t grid;       // frames per atlas side
+  int32_t frame_size; // pixels per frame side
+  vec3_t center;      // bounding sphere of the baked mesh
+  float radius;
+} ImposterAtlas;
+
+// Three frames around a view direction and their barycentric weights.
+typedef struct ImposterBlend {
+  int32_t frames[3][2];
+  float weights[3];
+} ImposterBlend;
+
+// Sphere from the cached mesh bounds when present, the vertex bounds otherwise.
+void imposter_atlas_init(ImposterAtlas *atlas, const MeshData *mesh,
+                         int32_t grid, int32_t frame_size);
+
+// Unit direction <-> octahedral map in [-1, 1]^2.
+vec2_t imposter_encode_direction(vec3_t direction);
+vec3_t imposter_decode_direction(vec2_t p);
+
+// Direction from the sphere center towards the camera of frame (x, y), and
+// the camera's right and up axes (look_at with +y up, +z near the poles).
+vec3_t imposter_frame_direction(const ImposterAtlas *atlas, int32_t x, int32_t y);
+void imposter_frame_basis(vec3_t direction, vec3_t *out_right, vec3_t *out_up);
+
+// Bake camera of frame (x, y): a view two radii out along its direction and
+// an orthographic projection that fits the sphere, depth spanning the
+// sphere from near to far.
+mat4_t imposter_frame_view(const ImposterAtlas *atlas, int32_t x, int32_t y);
+mat4_t imposter_frame_projection(const ImposterAtlas *atlas);
+
+// Frames to blend for a model space direction from the sphere center to the eye.
+void imposter_blend(const ImposterAtlas *atlas, vec3_t direction,
+                    ImposterBlend *out_blend);
+
+// Splits instances at `centers` (3 floats each, radius `radius`) into those
+// covering more than `max_pixels` pixels of radius on screen, drawn as
+// meshes, and the rest, drawn as imposters. `pixels_per_unit` is the
+// on-screen size of a unit length at unit distance. Returns the near count.
+int32_t imposter_split_instances(const float *centers, int32_t count,
+                                 float radius, vec3_t eye,
+                                 float pixels_per_unit, float max_pixels,
+                                 uint32_t *out_near, uint32_t *out_far,
+                                 int32_t *out_far_count);
+
+#endif /* _IMPOSTER_H_ */
+
+#ifdef _IMPOSTER_IMPLEMENTATION_
+
+static float imposter__sign(float x) { return x >= 0.0f ? 1.0f : -1.0f; }
+
+void imposter_atlas_init(ImposterAtlas *atlas, const MeshData *mesh,
+                         int32_t grid, int32_t frame_size) {
+  memset(atlas, 0, sizeof(*atlas));
+  atlas->grid = grid < 2 ? 2 : grid;
+  atlas->frame_size = frame_size;
+  if (mesh->has_bounds) {
+    atlas->center = mesh->sphere_center;
+    atlas->radius = mesh->sphere_radius;
+    return;
+  }
+  float lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+  float hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+  for (int32_t v = 0; v < mesh->vertex_count; ++v) {
+    const float *p = (const float *)((const char *)mesh->vertex_data +
+                                     (size_t)v * mesh->vertex_size +
+                                     mesh->positions_offset);
+    for (int32_t k = 0; k < 3; ++k) {
+      lo[k] = fminf(lo[k], p[k]);
+      hi[k] = fmaxf(hi[k], p[k]);
+    }
+  }
+  atlas->center = vec3(0.5f * (lo[0] + hi[0]), 0.5f * (lo[1] + hi[1]), 0.5f * (lo[2] + hi[2]));
+  atlas->radius = 0.5f * vec3_norm(vec3(hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2]));
+}
+
+vec2_t imposter_encode_direction(vec3_t direction) {
+  const float length = fabsf(direction.x) + fabsf(direction.y) + fabsf(direction.z);
+  vec2_t p = vec2(direction.x / length, direction.y / length);
+  if (direction.z < 0.0f) {
+    p = vec2((1.0f - fabsf(p.y)) * imposter__sign(p.x),
+             (1.0f - fabsf(p.x)) * imposter__sign(p.y));
+  }
+  return p;
+}
+
+vec3_t imposter_decode_direction(vec2_t p) {
+  vec3_t d = vec3(p.x, p.y, 1.0f - fabsf(p.x) - fabsf(p.y));
+  if (d.z < 0.0f) {
+    d = vec3((1.0f - fabsf(p.y)) * imposter__sign(p.x),
+             (1.0f - fabsf(p.x)) * imposter__sign(p.y), d.z);
+  }
+  return vec3_normalize(d);
+}
+
+vec3_t imposter_frame_direction(const ImposterAtlas *atlas, int32_t x, int32_t y) {
+  const float scale = 2.0f / (float)(atlas->grid - 1);
+  return imposter_decode_direction(vec2((float)x * scale - 1.0f, (float)y * scale - 1.0f));
+}
+
+void imposter_frame_basis(vec3_t direction, vec3_t *out_right, vec3_t *out_up) {
+  const vec3_t up = fabsf(direction.y) > 0.999f ? vec3(0.0f, 0.0f, 1.0f) : vec3(0.0f, 1.0f, 0.0f);
+  *out_right = vec3_normalize(vec3_cross(up, direction));
+  *out_up = vec3_cross(direction, *out_right);
+}
+
+mat4_t imposter_frame_view(const ImposterAtlas *atlas, int32_t x, int32_t y) {
+  const vec3_t direction = imposter_frame_direction(atlas, x, y);
+  const vec3_t eye = vec3_add(atlas->center, vec3_scalar_mul(direction, 2.0f * atlas->radius));
+  vec3_t right, up;
+  imposter_frame_basis(direction, &right, &up);
+  return look_at(eye, atlas->center, up);
+}
+
+mat4_t imposter_frame_projection(const ImposterAtlas *atlas) {
+  const float r = atlas->radius;
+  return ortho(-r, r, -r, r, r, 3.0f * r);
+}
+
+void imposter_blend(const ImposterAtlas *atlas, vec3_t direction,
+                    ImposterBlend *out_blend) {
+  const vec2_t p = imposter_encode_direction(direction);
+  const float scale = 0.5f * (float)(atlas->grid - 1);
+  const float gx = (p.x + 1.0f) * scale;
+  const float gy = (p.y + 1.0f) * scale;
+  int32_t x = (int32_t)floorf(gx);
+  int32_t y = (int32_t)floorf(gy);
+  x = x < 0 ? 0 : (x > atlas->grid - 2 ? atlas->grid - 2 : x);
+  y = y < 0 ? 0 : (y > atlas->grid - 2 ? atlas->grid - 2 : y);
+  const float fx = gx - (float)x;
+  const float fy = gy - (float)y;
+
+  // Split the grid cell along its anti-diagonal, barycentrics of the half
+  if (fx + fy < 1.0f) {
+    const int32_t frames[3][2] = {{x, y}, {x + 1, y}, {x, y + 1}};
+    memcpy(out_blend->frames, frames, sizeof(frames));
+    out_blend->weights[0] = 1.0f - fx - fy;
+    out_blend->weights[1] = fx;
+    out_blend->weights[2] = fy;
+  } else {
+    const int32_t frames[3][2] = {{x + 1, y + 1}, {x + 1, y}, {x, y + 1}};
+    memcpy(out_blend->frames, frames, sizeof(frames));
+    out_blend->weights[0] = fx + fy - 1.0f;
+    out_blend->weights[1] = 1.0f - fy;
+    out_blend->weights[2] = 1.0f - fx;
+  }
+}
+
+int32_t imposter_split_instances(const float *centers, int32_t count,
+                                 float radius, vec3_t eye,
+                                 float pixels_per_unit, float max_pixels,
+                                 uint32_t *out_near, uint32_t *out_far,
+                                 int32_t *out_far_count) {
+  // Projected radius radius * pixels_per_unit / distance against max_pixels,
+  // compared squared
+  const float limit = radius * pixels_per_unit / max_pixels;
+  const float limit_sq = limit * limit;
+  int32_t near_count = 0;
+  int32_t far_count = 0;
+  for (int32_t i = 0; i < count; ++i) {
+    const float *c = centers + 3 * (size_t)i;
+    const vec3_t d = vec3(c[0] - eye.x, c[1] - eye.y, c[2] - eye.z);
+    if (vec3_norm_sq(d) < limit_sq) {
+      out_near[near_count++] = (uint32_t)i;
+    } else {
+      out_far[far_count++] = (uint32_t)i;
+    }
+  }
+  *out_far_count = far_count;
+  return near_count;
+}
+
+#endif /* _IMPOSTER_IMPLEMENTATION_ */
@@ -0,0 +1,469 @@
+#ifndef _KD_TREE_H_
+#define _KD_TREE_H_
+
+#include <float.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Expects vec_math.h, mesh.h and parallel.h to be included first.
+
+#ifndef KD_LEAF_SIZE
+#define KD_LEAF_SIZE 16
+#endif
+#define KD_MAX_K 32
+
+// Implicit k-d tree over mesh positions. The tree is complete: `depth` levels
+// of median splits give 2^depth leaf buckets of at most KD_LEAF_SIZE points,
+// node i has children 2i+1 and 2i+2, and the point range of every node follows
+// from halving its parent's range, so only the split plane is stored per node.
+// Points are reordered into leaf order and kept as aligned x/y/z streams for
+// SIMD distance tests; `index` maps them back to mesh vertices.
+typedef struct KdTree {
+  int32_t point_count;
+  int32_t depth;
+  int32_t node_count; // internal nodes, 2^depth - 1
+  float *split;
+  uint8_t *axis;
+  float *x;
+  float *y;
+  float *z;
+  uint32_t *index;
+} KdTree;
+
+// Median splits run level by level, the nodes of a level in parallel.
+int32_t kd_tree_build(const MeshData *mesh, KdTree *out_tree);
+void kd_tree_free(KdTree *tree);
+
+// Up to k (<= KD_MAX_K) nearest vertices sorted by distance, returns how many
+// were found. Squared distances go to `out_dist_sq` when not NULL.
+int32_t kd_tree_knn(const KdTree *tree, vec3_t query, int32_t k,
+                    uint32_t *out_indices, float *out_dist_sq);
+
+// Vertices within `radius`, in no particular order. Writes up to `max_count`
+// and returns the total number found (which may exceed max_count).
+int32_t kd_tree_radius(const KdTree *tree, vec3_t query, float radius,
+                       uint32_t *out_indices, int32_t max_count);
+
+// Batch versions split the queries across the worker pool. Results are laid
+// out k (or max_per_query) entries per query; missing kNN slots are filled
+// with UINT32_MAX / FLT_MAX.
+void kd_tree_knn_batch(const KdTree *tree, const vec3_t *queries,
+                       int32_t query_count, int32_t k, uint32_t *out_indices,
+                       float *out_dist_sq);
+void kd_tree_radius_batch(const KdTree *tree, const vec3_t *queries,
+                          int32_t query_count, float radius,
+                          uint32_t *out_indices, int32_t max_per_query,
+                          int32_t *out_counts);
+
+#endif /* _KD_TREE_H_ */
+
+#ifdef _KD_TREE_IMPLEMENTATION_
+
+typedef struct kd__build_job {
+  const MeshData *mesh;
+  KdTree *tree;
+  int32_t level_first; // first node of the level being split
+} kd__build_job;
+
+typedef struct kd__stack_entry {
+  int32_t node;
+  int32_t begin;
+  int32_t end;
+  float dist_sq; // lower bound for every point below the node
+} kd__stack_entry;
+
+static void kd__gather_range(void *user, int32_t begin, int32_t end,
+                             int32_t worker) {
+  kd__build_job *job = (kd__build_job *)user;
+  const MeshData *mesh = job->mesh;
+  KdTree *tree = job->tree;
+  (void)worker;
+  for (int32_t v = begin; v < end; ++v) {
+    const float *src =
+        (const float *)((const char *)mesh->vertex_data +
+                        (size_t)v * mesh->vertex_size + mesh->positions_offset);
+    tree->x[v] = src[0];
+    tree->y[v] = src[1];
+    tree->z[v] = src[2];
+    tree->index[v] = (uint32_t)v;
+  }
+}
+
+static void kd__swap(KdTree *tree, int32_t a, int32_t b) {
+  float x = tree->x[a], y = tree->y[a], z = tree->z[a];
+  uint32_t index = tree->index[a];
+  tree->x[a] = tree->x[b];
+  tree->y[a] = tree->y[b];
+  tree->z[a] = tree->z[b];
+  tree->index[a] = tree->index[b];
+  tree->x[b] = x;
+  tree->y[b] = y;
+  tree->z[b] = z;
+  tree->index[b] = index;
+}
+
+// Quickselect with a three-way partition (scans often repeat coordinates),
+// afterwards [begin, nth) <= key[nth] <= [nth + 1, end).
+static void kd__select(KdTree *tree, const float *key, int32_t begin,
+                       int32_t end, int32_t nth) {
+  while (end - begin > 1) {
+    // Median of three pivot
+    const float a = key[begin];
+    const float b = key[begin + (end - begin) / 2];
+    const float c = key[end - 1];
+    const float pivot = a < b ? (b < c ? b : (a < c ? c : a))
+                              : (a < c ? a : (b < c ? c : b));
+    int32_t lt = begin;
+    int32_t gt = end - 1;
+    int32_t i = begin;
+    while (i <= gt) {
+      if (key[i] < pivot) {
+        kd__swap(tree, i++, lt++);
+      } else if (key[i] > pivot) {
+        kd__swap(tree, i, gt--);
+      } else {
+        i++;
+      }
+    }
+    if (nth < lt) {
+      end = lt;
+    } else if (nth > gt) {
+      begin = gt + 1;
+    } else {
+      return;
+    }
+  }
+}
+
+static void kd__split_range(void *user, int32_t begin, int32_t end,
+                            int32_t worker) {
+  kd__build_job *job = (kd__build_job *)user;
+  KdTree *tree = job->tree;
+  const int32_t level_size = job->level_first + 1;
+  (void)worker;
+  for (int32_t i = begin; i < end; ++i) {
+    // Range of node i within its level, same arithmetic as the queries use
+    int32_t lo = 0;
+    int32_t hi = tree->point_count;
+    for (int32_t bit = level_size >> 1; bit > 0; bit >>= 1) {
+      int32_t m = lo + (hi - lo) / 2;
+      if (i & bit) {
+        lo = m;
+      } else {
+        hi = m;
+      }
+    }
+
+    // Split along the widest extent of the node's points
+    float mn[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float mx[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (int32_t p = lo; p < hi; ++p) {
+      const float c[3] = {tree->x[p], tree->y[p], tree->z[p]};
+      for (int32_t k = 0; k < 3; ++k) {
+        mn[k] = c[k] < mn[k] ? c[k] : mn[k];
+        mx[k] = c[k] > mx[k] ? c[k] : mx[k];
+      }
+    }
+    uint8_t axis = 0;
+    if (mx[1] - mn[1] > mx[axis] - mn[axis]) {
+      axis = 1;
+    }
+    if (mx[2] - mn[2] > mx[axis] - mn[axis]) {
+      axis = 2;
+    }
+    const float *key = axis == 0 ? tree->x : axis == 1 ? tree->y : tree->z;
+    const int32_t m = lo + (hi - lo) / 2;
+    const int32_t node = job->level_first + i;
+    if (hi - lo > 0) {
+      kd__select(tree, key, lo, hi, m);
+      tree->split[node] = m < hi ? key[m] : key[hi - 1];
+    } else {
+      tree->split[node] = 0.0f;
+    }
+    tree->axis[node] = axis;
+  }
+}
+
+int32_t kd_tree_build(const MeshData *mesh, KdTree *out_tree) {
+  memset(out_tree, 0, sizeof(*out_tree));
+  const int32_t n = mesh->vertex_count;
+  int32_t depth = 0;
+  while (((int64_t)n + ((int64_t)1 << depth) - 1) >> depth > KD_LEAF_SIZE) {
+    depth++;
+  }
+  out_tree->point_count = n;
+  out_tree->depth = depth;
+  out_tree->node_count = (1 << depth) - 1;
+
+  // Streams are padded so leaf tests can always load full SIMD registers
+  size_t padded = (size_t)n + 4;
+  out_tree->x = (float *)mesh_aligned_alloc(padded * sizeof(float));
+  out_tree->y = (float *)mesh_aligned_alloc(padded * sizeof(float));
+  out_tree->z = (float *)mesh_aligned_alloc(padded * sizeof(float));
+  out_tree->index = (uint32_t *)malloc(padded * sizeof(uint32_t));
+  out_tree->split = (float *)malloc(((size_t)out_tree->node_count + 1) * sizeof(float));
+  out_tree->axis = (uint8_t *)malloc((size_t)out_tree->node_count + 1);
+  if (!out_tree->x || !out_tree->y || !out_tree->z || !out_tree->index ||
+      !out_tree->split || !out_tree->axis) {
+    kd_tree_free(out_tree);
+    return EXIT_FAILURE;
+  }
+  memset(out_tree->x + n, 0, 4 * sizeof(float));
+  memset(out_tree->y + n, 0, 4 * sizeof(float));
+  memset(out_tree->z + n, 0, 4 * sizeof(float));
+
+  kd__build_job job = {0};
+  job.mesh = mesh;
+  job.tree = out_tree;
+  par_for(n, 16384, kd__gather_range, &job);
+
+  // Nodes of one level own disjoint ranges, so they split independently
+  for (int32_t level = 0; level < depth; ++level) {
+    job.level_first = (1 << level) - 1;
+    par_for(1 << level, 1, kd__split_range, &job);
+  }
+  return 0;
+}
+
+void kd_tree_free(KdTree *tree) {
+  mesh_aligned_free(tree->x);
+  mesh_aligned_free(tree->y);
+  mesh_aligned_free(tree->z);
+  free(tree->index);
+  free(tree->split);
+  free(tree->axis);
+  memset(tree, 0, sizeof(*tree));
+}
+
+// Squared distances from the query to points [begin, end), rounded up to
+// whole registers. `out` needs KD_LEAF_SIZE + 4 entries.
+static void kd__leaf_distances(const KdTree *tree, vec3_t q, int32_t begin,
+                               int32_t end, float *out) {
+  int32_t i = begin;
+#if defined(MESH_SIMD_SSE2)
+  const __m128 qx = _mm_set1_ps(q.x);
+  const __m128 qy = _mm_set1_ps(q.y);
+  const __m128 qz = _mm_set1_ps(q.z);
+  for (; i < end; i += 4, out += 4) {
+    __m128 dx = _mm_sub_ps(_mm_loadu_ps(tree->x + i), qx);
+    __m128 dy = _mm_sub_ps(_mm_loadu_ps(tree->y + i), qy);
+    __m128 dz = _mm_sub_ps(_mm_loadu_ps(tree->z + i), qz);
+    __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                          _mm_mul_ps(dz, dz));
+    _mm_storeu_ps(out, d);
+  }
+#elif defined(MESH_SIMD_NEON)
+  const float32x4_t qx = vdupq_n_f32(q.x);
+  const float32x4_t qy = vdupq_n_f32(q.y);
+  const float32x4_t qz = vdupq_n_f32(q.z);
+  for (; i < end; i += 4, out += 4) {
+    float32x4_t dx = vsubq_f32(vld1q_f32(tree->x + i), qx);
+    float32x4_t dy = vsubq_f32(vld1q_f32(tree->y + i), qy);
+    float32x4_t dz = vsubq_f32(vld1q_f32(tree->z + i), qz);
+    float32x4_t d = vmlaq_f32(vmlaq_f32(vmulq_f32(dx, dx), dy, dy), dz, dz);
+    vst1q_f32(out, d);
+  }
+#else
+  for (; i < end; ++i, ++out) {
+    float dx = tree->x[i] - q.x;
+    float dy = tree->y[i] - q.y;
+    float dz = tree->z[i] - q.z;
+    *out = dx * dx + dy * dy + dz * dz;
+  }
+#endif
+}
+
+typedef struct kd__search {
+  vec3_t query;
+  float prune_sq; // squared radius, or the current k-th distance
+  int32_t k;      // 0 for radius queries
+  int32_t found;
+  float best_dist[KD_MAX_K];
+  uint32_t best_index[KD_MAX_K];
+  uint32_t *out_indices;
+  int32_t max_count;
+} kd__search;
+
+static void kd__visit_leaf(const KdTree *tree, kd__search *search,
+                           int32_t begin, int32_t end) {
+  float dist[KD_LEAF_SIZE + 4];
+  kd__leaf_distances(tree, search->query, begin, end, dist);
+  if (search->k == 0) {
+    for (int32_t i = 0; i < end - begin; ++i) {
+      if (dist[i] <= search->prune_sq) {
+        if (search->found < search->max_count) {
+          search->out_indices[search->found] = tree->index[begin + i];
+        }
+        search->found++;
+      }
+    }
+    return;
+  }
+  const int32_t k = search->k;
+  for (int32_t i = 0; i < end - begin; ++i) {
+    const float d = dist[i];
+    if (search->found == k && d >= search->prune_sq) {
+      continue;
+    }
+    // Insertion into the sorted candidate list
+    int32_t slot = search->found < k ? search->found++ : k - 1;
+    while (slot > 0 && search->best_dist[slot - 1] > d) {
+      search->best_dist[slot] = search->best_dist[slot - 1];
+      search->best_index[slot] = search->best_index[slot - 1];
+      slot--;
+    }
+    search->best_dist[slot] = d;
+    search->best_index[slot] = tree->index[begin + i];
+    if (search->found == k) {
+      search->prune_sq = search->best_dist[k - 1];
+    }
+  }
+}
+
+// Walks the tree nearest child first, subtrees whose distance bound exceeds
+// the pruning distance are skipped.
+static void kd__search_tree(const KdTree *tree, kd__search *search) {
+  kd__stack_entry stack[64];
+  int32_t top = 0;
+  if (tree->point_count == 0) {
+    return;
+  }
+  stack[top].node = 0;
+  stack[top].begin = 0;
+  stack[top].end = tree->point_count;
+  stack[top].dist_sq = 0.0f;
+  top++;
+  while (top > 0) {
+    kd__stack_entry entry = stack[--top];
+    if (entry.dist_sq > search->prune_sq) {
+      continue;
+    }
+    int32_t node = entry.node;
+    int32_t lo = entry.begin;
+    int32_t hi = entry.end;
+    while (node < tree->node_count) {
+      int32_t m = lo + (hi - lo) / 2;
+      float diff = search->query.data[tree->axis[node]] - tree->split[node];
+      kd__stack_entry far;
+      far.dist_sq = diff * diff;
+      if (diff < 0.0f) {
+        far.node = 2 * node + 2;
+        far.begin = m;
+        far.end = hi;
+        node = 2 * node + 1;
+        hi = m;
+      } else {
+        far.node = 2 * node + 1;
+        far.begin = lo;
+        far.end = m;
+        node = 2 * node + 2;
+        lo = m;
+      }
+      if (far.dist_sq <= search->prune_sq) {
+        stack[top++] = far;
+      }
+    }
+    kd__visit_leaf(tree, search, lo, hi);
+  }
+}
+
+int32_t kd_tree_knn(const KdTree *tree, vec3_t query, int32_t k,
+                    uint32_t *out_indices, float *out_dist_sq) {
+  kd__search search;
+  search.query = query;
+  search.prune_sq = FLT_MAX;
+  search.k = k < KD_MAX_K ? k : KD_MAX_K;
+  search.found = 0;
+  if (search.k <= 0) {
+    return 0;
+  }
+  kd__search_tree(tree, &search);
+  for (int32_t i = 0; i < search.found; ++i) {
+    out_indices[i] = search.best_index[i];
+    if (out_dist_sq) {
+      out_dist_sq[i] = search.best_dist[i];
+    }
+  }
+  return search.found;
+}
+
+int32_t kd_tree_radius(const KdTree *tree, vec3_t query, float radius,
+                       uint32_t *out_indices, int32_t max_count) {
+  kd__search search;
+  search.query = query;
+  search.prune_sq = radius * radius;
+  search.k = 0;
+  search.found = 0;
+  search.out_indices = out_indices;
+  search.max_count = max_count;
+  kd__search_tree(tree, &search);
+  return search.found;
+}
+
+typedef struct kd__query_job {
+  const KdTree *tree;
+  const vec3_t *queries;
+  int32_t k;
+  float radius;
+  uint32_t *out_indices;
+  float *out_dist_sq;
+  int32_t *out_counts;
+} kd__query_job;
+
+static void kd__knn_range(void *user, int32_t begin, int32_t end,
+                          int32_t worker) {
+  kd__query_job *job = (kd__query_job *)user;
+  const int32_t k = job->k;
+  (void)worker;
+  for (int32_t q = begin; q < end; ++q) {
+    uint32_t *indices = job->out_indices + (size_t)q * k;
+    float *dist_sq = job->out_dist_sq ? job->out_dist_sq + (size_t)q * k : NULL;
+    int32_t found = kd_tree_knn(job->tree, job->queries[q], k, indices, dist_sq);
+    for (int32_t i = found; i < k; ++i) {
+      indices[i] = UINT32_MAX;
+      if (dist_sq) {
+        dist_sq[i] = FLT_MAX;
+      }
+    }
+  }
+}
+
+static void kd__radius_range(void *user, int32_t begin, int32_t end,
+                             int32_t worker) {
+  kd__query_job *job = (kd__query_job *)user;
+  (void)worker;
+  for (int32_t q = begin; q < end; ++q) {
+    job->out_counts[q] =
+        kd_tree_radius(job->tree, job->queries[q], job->radius,
+                       job->out_indices + (size_t)q * job->k, job->k);
+  }
+}
+
+void kd_tree_knn_batch(const KdTree *tree, const vec3_t *queries,
+                       int32_t query_count, int32_t k, uint32_t *out_indices,
+                       float *out_dist_sq) {
+  kd__query_job job = {0};
+  job.tree = tree;
+  job.queries = queries;
+  job.k = k;
+  job.out_indices = out_indices;
+  job.out_dist_sq = out_dist_sq;
+  par_for(query_count, 1024, kd__knn_range, &job);
+}
+
+void kd_tree_radius_batch(const KdTree *tree, const vec3_t *queries,
+                          int32_t query_count, float radius,
+                          uint32_t *out_indices, int32_t max_per_query,
+                          int32_t *out_counts) {
+  kd__query_job job = {0};
+  job.tree = tree;
+  job.queries = queries;
+  job.k = max_per_query;
+  job.radius = radius;
+  job.out_indices = out_indices;
+  job.out_counts = out_counts;
+  par_for(query_count, 1024, kd__radius_range, &job);
+}
+
+#endif /* _KD_TREE_IMPLEMENTATION_ */
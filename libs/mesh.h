@@ -0,0 +1,367 @@
+#ifndef _MESH_H_
+#define _MESH_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Expects vec_math.h to be included first.
+
+#if !defined(MESH_NO_SIMD)
+#if defined(__AVX__)
+#define MESH_SIMD_AVX 1
+#define MESH_SIMD_SSE2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESH_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define MESH_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
+#define MESH_SOA_ALIGNMENT 32
+#define MESH_SOA_WIDTH 8
+
+// Oriented bounding box, `axes` are orthonormal.
+typedef struct MeshOBB {
+  vec3_t center;
+  vec3_t axes[3];
+  vec3_t half_extents;
+} MeshOBB;
+
+typedef struct MeshData {
+  int32_t vertex_count;
+  int32_t triangle_count;
+  float *vertex_data;  // position (3 floats), normals (3 floats), optional AO (1 float)
+  uint32_t *triangles; // 3 x triangle_count
+
+  // Vertex Layout info
+  int32_t vertex_size;
+  int32_t positions_size;
+  int32_t positions_offset;
+  int32_t normals_size;
+  int32_t normals_offset;
+  int32_t ao_size; // 0 until ambient occlusion is baked (ao_bake.h)
+  int32_t ao_offset;
+
+  // Cached bounding volumes, filled by mesh_compute_bounds (convex_hull.h)
+  int32_t has_bounds;
+  MeshOBB obb;
+  vec3_t sphere_center;
+  float sphere_radius;
+} MeshData;
+
+// Struct-of-arrays copy of the mesh positions and normals for CPU kernels.
+// All six streams live in one MESH_SOA_ALIGNMENT aligned block and are padded
+// to a multiple of MESH_SOA_WIDTH floats, so loops can always run full 8-wide
+// iterations. Padding lanes repeat the last vertex, which keeps min/max style
+// reductions correct without masking.
+typedef struct MeshSoA {
+  int32_t vertex_count;
+  int32_t capacity;
+  float *x;
+  float *y;
+  float *z;
+  float *nx;
+  float *ny;
+  float *nz;
+} MeshSoA;
+
+void *mesh_aligned_alloc(size_t size);
+void mesh_aligned_free(void *ptr);
+
+int32_t mesh_soa_alloc(MeshSoA *soa, int32_t vertex_count);
+void mesh_soa_free(MeshSoA *soa);
+
+// Interleaved -> SoA conversion. The SIMD path (8 vertices per iteration with
+// AVX, 4 with SSE2 or NEON) is used for the tightly packed position/normal
+// layout produced by `load_mesh_data`, any other layout falls back to a
+// strided scalar copy driven by the MeshData layout info.
+int32_t mesh_soa_from_mesh(const MeshData *mesh, MeshSoA *out_soa);
+
+// SoA -> interleaved conversion of `count` vertices from six streams (x, y, z,
+// nx, ny, nz) aligned to MESH_SOA_ALIGNMENT into vertices of `vertex_size`
+// bytes with the position and normal at the given byte offsets. Mirrors
+// mesh_soa_from_mesh: the packed layout runs 8 vertices per iteration with AVX
+// and 4 with SSE2 or NEON, other layouts a strided scalar copy. Bytes outside
+// the position and normal are left untouched.
+void mesh_interleave(const float *const streams[6], int32_t count, void *out_vertices,
+                     int32_t vertex_size, int32_t positions_offset, int32_t normals_offset);
+// Writes the positions and normals of `soa` back into `mesh`.
+void mesh_soa_to_mesh(const MeshSoA *soa, MeshData *mesh);
+
+// Tightly packed copy (3 floats per vertex) of the positions of `count`
+// vertices starting at `first`, the vertex stream of depth-only passes that
+// have no use for normals or AO.
+void mesh_pack_positions(const MeshData *mesh, int32_t first, int32_t count,
+                         float *out_positions);
+
+#endif /* _MESH_H_ */
+
+#ifdef _MESH_IMPLEMENTATION_
+
+void *mesh_aligned_alloc(size_t size) {
+  size = (size + MESH_SOA_ALIGNMENT - 1) & ~(size_t)(MESH_SOA_ALIGNMENT - 1);
+#if defined(_MSC_VER)
+  return _aligned_malloc(size, MESH_SOA_ALIGNMENT);
+#else
+  return aligned_alloc(MESH_SOA_ALIGNMENT, size);
+#endif
+}
+
+void mesh_aligned_free(void *ptr) {
+#if defined(_MSC_VER)
+  _aligned_free(ptr);
+#else
+  free(ptr);
+#endif
+}
+
+int32_t mesh_soa_alloc(MeshSoA *soa, int32_t vertex_count) {
+  int32_t capacity = (vertex_count + MESH_SOA_WIDTH - 1) & ~(MESH_SOA_WIDTH - 1);
+  if (capacity == 0) {
+    capacity = MESH_SOA_WIDTH;
+  }
+  float *block = (float *)mesh_aligned_alloc(6 * (size_t)capacity * sizeof(float));
+  if (!block) {
+    return EXIT_FAILURE;
+  }
+  soa->vertex_count = vertex_count;
+  soa->capacity = capacity;
+  soa->x = block;
+  soa->y = block + 1 * capacity;
+  soa->z = block + 2 * capacity;
+  soa->nx = block + 3 * capacity;
+  soa->ny = block + 4 * capacity;
+  soa->nz = block + 5 * capacity;
+  return 0;
+}
+
+void mesh_soa_free(MeshSoA *soa) {
+  mesh_aligned_free(soa->x);
+  memset(soa, 0, sizeof(*soa));
+}
+
+static void mesh__soa_fill_padding(MeshSoA *soa) {
+  float *streams[6] = {soa->x, soa->y, soa->z, soa->nx, soa->ny, soa->nz};
+  int32_t last = soa->vertex_count - 1;
+  for (int32_t s = 0; s < 6; ++s) {
+    float value = last >= 0 ? streams[s][last] : 0.0f;
+    for (int32_t i = soa->vertex_count; i < soa->capacity; ++i) {
+      streams[s][i] = value;
+    }
+  }
+}
+
+#if defined(MESH_SIMD_SSE2) || defined(MESH_SIMD_NEON)
+static int32_t mesh__is_packed_layout(const MeshData *mesh) {
+  return mesh->vertex_size == 6 * sizeof(float) && mesh->positions_offset == 0 &&
+         mesh->normals_offset == 3 * sizeof(float);
+}
+#endif
+
+int32_t mesh_soa_from_mesh(const MeshData *mesh, MeshSoA *out_soa) {
+  if (mesh_soa_alloc(out_soa, mesh->vertex_count)) {
+    return EXIT_FAILURE;
+  }
+  const int32_t count = mesh->vertex_count;
+  int32_t i = 0;
+
+#if defined(MESH_SIMD_SSE2) || defined(MESH_SIMD_NEON)
+  if (mesh__is_packed_layout(mesh)) {
+    const float *src = mesh->vertex_data;
+#if defined(MESH_SIMD_SSE2)
+#if defined(MESH_SIMD_AVX)
+    // The 4 vertex shuffles below in both 128-bit lanes, vertices 0-3 in the
+    // low lane and 4-7 in the high one, so every stream is stored in order
+    for (; i + 8 <= count; i += 8, src += 48) {
+      __m256 a[6];
+      for (int32_t k = 0; k < 6; ++k) {
+        a[k] = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src + 4 * k)),
+                                    _mm_loadu_ps(src + 24 + 4 * k), 1);
+      }
+
+      __m256 xy01 = _mm256_shuffle_ps(a[0], a[1], _MM_SHUFFLE(3, 2, 1, 0));
+      __m256 xy23 = _mm256_shuffle_ps(a[3], a[4], _MM_SHUFFLE(3, 2, 1, 0));
+      __m256 zn01 = _mm256_shuffle_ps(a[0], a[2], _MM_SHUFFLE(1, 0, 3, 2));
+      __m256 zn23 = _mm256_shuffle_ps(a[3], a[5], _MM_SHUFFLE(1, 0, 3, 2));
+      __m256 nn01 = _mm256_shuffle_ps(a[1], a[2], _MM_SHUFFLE(3, 2, 1, 0));
+      __m256 nn23 = _mm256_shuffle_ps(a[4], a[5], _MM_SHUFFLE(3, 2, 1, 0));
+
+      _mm256_store_ps(out_soa->x + i, _mm256_shuffle_ps(xy01, xy23, _MM_SHUFFLE(2, 0, 2, 0)));
+      _mm256_store_ps(out_soa->y + i, _mm256_shuffle_ps(xy01, xy23, _MM_SHUFFLE(3, 1, 3, 1)));
+      _mm256_store_ps(out_soa->z + i, _mm256_shuffle_ps(zn01, zn23, _MM_SHUFFLE(2, 0, 2, 0)));
+      _mm256_store_ps(out_soa->nx + i, _mm256_shuffle_ps(zn01, zn23, _MM_SHUFFLE(3, 1, 3, 1)));
+      _mm256_store_ps(out_soa->ny + i, _mm256_shuffle_ps(nn01, nn23, _MM_SHUFFLE(2, 0, 2, 0)));
+      _mm256_store_ps(out_soa->nz + i, _mm256_shuffle_ps(nn01, nn23, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#endif
+    // 4 vertices = 6 registers. Pair up the halves of the two vertex pairs
+    // and split them with one more shuffle per output stream.
+    for (; i + 4 <= count; i += 4, src += 24) {
+      __m128 a0 = _mm_loadu_ps(src + 0);  // x0 y0 z0 X0
+      __m128 a1 = _mm_loadu_ps(src + 4);  // Y0 Z0 x1 y1
+      __m128 a2 = _mm_loadu_ps(src + 8);  // z1 X1 Y1 Z1
+      __m128 a3 = _mm_loadu_ps(src + 12); // x2 y2 z2 X2
+      __m128 a4 = _mm_loadu_ps(src + 16); // Y2 Z2 x3 y3
+      __m128 a5 = _mm_loadu_ps(src + 20); // z3 X3 Y3 Z3
+
+      __m128 xy01 = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 2, 1, 0));
+      __m128 xy23 = _mm_shuffle_ps(a3, a4, _MM_SHUFFLE(3, 2, 1, 0));
+      __m128 zn01 = _mm_shuffle_ps(a0, a2, _MM_SHUFFLE(1, 0, 3, 2));
+      __m128 zn23 = _mm_shuffle_ps(a3, a5, _MM_SHUFFLE(1, 0, 3, 2));
+      __m128 nn01 = _mm_shuffle_ps(a1, a2, _MM_SHUFFLE(3, 2, 1, 0));
+      __m128 nn23 = _mm_shuffle_ps(a4, a5, _MM_SHUFFLE(3, 2, 1, 0));
+
+      _mm_store_ps(out_soa->x + i, _mm_shuffle_ps(xy01, xy23, _MM_SHUFFLE(2, 0, 2, 0)));
+      _mm_store_ps(out_soa->y + i, _mm_shuffle_ps(xy01, xy23, _MM_SHUFFLE(3, 1, 3, 1)));
+      _mm_store_ps(out_soa->z + i, _mm_shuffle_ps(zn01, zn23, _MM_SHUFFLE(2, 0, 2, 0)));
+      _mm_store_ps(out_soa->nx + i, _mm_shuffle_ps(zn01, zn23, _MM_SHUFFLE(3, 1, 3, 1)));
+      _mm_store_ps(out_soa->ny + i, _mm_shuffle_ps(nn01, nn23, _MM_SHUFFLE(2, 0, 2, 0)));
+      _mm_store_ps(out_soa->nz + i, _mm_shuffle_ps(nn01, nn23, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#elif defined(MESH_SIMD_NEON)
+    // vld3q splits the stream into (x,nx), (y,ny), (z,nz) pairs, vuzpq
+    // separates positions from normals.
+    for (; i + 4 <= count; i += 4, src += 24) {
+      float32x4x3_t lo = vld3q_f32(src);
+      float32x4x3_t hi = vld3q_f32(src + 12);
+      float32x4x2_t x = vuzpq_f32(lo.val[0], hi.val[0]);
+      float32x4x2_t y = vuzpq_f32(lo.val[1], hi.val[1]);
+      float32x4x2_t z = vuzpq_f32(lo.val[2], hi.val[2]);
+      vst1q_f32(out_soa->x + i, x.val[0]);
+      vst1q_f32(out_soa->nx + i, x.val[1]);
+      vst1q_f32(out_soa->y + i, y.val[0]);
+      vst1q_f32(out_soa->ny + i, y.val[1]);
+      vst1q_f32(out_soa->z + i, z.val[0]);
+      vst1q_f32(out_soa->nz + i, z.val[1]);
+    }
+#endif
+  }
+#endif
+
+  const int32_t stride = mesh->vertex_size / sizeof(float);
+  const float *pos = mesh->vertex_data + mesh->positions_offset / sizeof(float);
+  const float *nrm = mesh->vertex_data + mesh->normals_offset / sizeof(float);
+  for (; i < count; ++i) {
+    out_soa->x[i] = pos[i * stride + 0];
+    out_soa->y[i] = pos[i * stride + 1];
+    out_soa->z[i] = pos[i * stride + 2];
+    out_soa->nx[i] = nrm[i * stride + 0];
+    out_soa->ny[i] = nrm[i * stride + 1];
+    out_soa->nz[i] = nrm[i * stride + 2];
+  }
+
+  mesh__soa_fill_padding(out_soa);
+  return 0;
+}
+
+void mesh_interleave(const float *const streams[6], int32_t count, void *out_vertices,
+                     int32_t vertex_size, int32_t positions_offset, int32_t normals_offset) {
+  const float *x = streams[0], *y = streams[1], *z = streams[2];
+  const float *nx = streams[3], *ny = streams[4], *nz = streams[5];
+  char *dst = (char *)out_vertices;
+  int32_t i = 0;
+
+#if defined(MESH_SIMD_SSE2) || defined(MESH_SIMD_NEON)
+  if (vertex_size == 6 * sizeof(float) && positions_offset == 0 &&
+      normals_offset == 3 * sizeof(float)) {
+    float *out = (float *)dst;
+#if defined(MESH_SIMD_SSE2)
+#if defined(MESH_SIMD_AVX)
+    // The 4 vertex shuffles below in both 128-bit lanes, then the low lanes
+    // (vertices 0-3) and the high lanes (vertices 4-7) are paired up so every
+    // store writes 8 consecutive floats
+    for (; i + 8 <= count; i += 8, out += 48) {
+      __m256 r[6];
+      for (int32_t k = 0; k < 6; ++k) {
+        r[k] = _mm256_load_ps(streams[k] + i);
+      }
+
+      __m256 xy01 = _mm256_unpacklo_ps(r[0], r[1]);
+      __m256 xy23 = _mm256_unpackhi_ps(r[0], r[1]);
+      __m256 zn01 = _mm256_unpacklo_ps(r[2], r[3]);
+      __m256 zn23 = _mm256_unpackhi_ps(r[2], r[3]);
+      __m256 nn01 = _mm256_unpacklo_ps(r[4], r[5]);
+      __m256 nn23 = _mm256_unpackhi_ps(r[4], r[5]);
+
+      __m256 a = _mm256_shuffle_ps(xy01, zn01, _MM_SHUFFLE(1, 0, 1, 0));
+      __m256 b = _mm256_shuffle_ps(nn01, xy01, _MM_SHUFFLE(3, 2, 1, 0));
+      __m256 c = _mm256_shuffle_ps(zn01, nn01, _MM_SHUFFLE(3, 2, 3, 2));
+      __m256 d = _mm256_shuffle_ps(xy23, zn23, _MM_SHUFFLE(1, 0, 1, 0));
+      __m256 e = _mm256_shuffle_ps(nn23, xy23, _MM_SHUFFLE(3, 2, 1, 0));
+      __m256 f = _mm256_shuffle_ps(zn23, nn23, _MM_SHUFFLE(3, 2, 3, 2));
+
+      _mm256_storeu_ps(out + 0, _mm256_permute2f128_ps(a, b, 0x20));
+      _mm256_storeu_ps(out + 8, _mm256_permute2f128_ps(c, d, 0x20));
+      _mm256_storeu_ps(out + 16, _mm256_permute2f128_ps(e, f, 0x20));
+      _mm256_storeu_ps(out + 24, _mm256_permute2f128_ps(a, b, 0x31));
+      _mm256_storeu_ps(out + 32, _mm256_permute2f128_ps(c, d, 0x31));
+      _mm256_storeu_ps(out + 40, _mm256_permute2f128_ps(e, f, 0x31));
+    }
+#endif
+    // 4 vertices = 6 registers. Interleave the stream pairs, then every
+    // register holds half of one vertex and half of its neighbour.
+    for (; i + 4 <= count; i += 4, out += 24) {
+      __m128 r[6];
+      for (int32_t k = 0; k < 6; ++k) {
+        r[k] = _mm_load_ps(streams[k] + i);
+      }
+
+      __m128 xy01 = _mm_unpacklo_ps(r[0], r[1]);
+      __m128 xy23 = _mm_unpackhi_ps(r[0], r[1]);
+      __m128 zn01 = _mm_unpacklo_ps(r[2], r[3]);
+      __m128 zn23 = _mm_unpackhi_ps(r[2], r[3]);
+      __m128 nn01 = _mm_unpacklo_ps(r[4], r[5]);
+      __m128 nn23 = _mm_unpackhi_ps(r[4], r[5]);
+
+      _mm_storeu_ps(out + 0, _mm_movelh_ps(xy01, zn01));
+      _mm_storeu_ps(out + 4, _mm_shuffle_ps(nn01, xy01, _MM_SHUFFLE(3, 2, 1, 0)));
+      _mm_storeu_ps(out + 8, _mm_movehl_ps(nn01, zn01));
+      _mm_storeu_ps(out + 12, _mm_movelh_ps(xy23, zn23));
+      _mm_storeu_ps(out + 16, _mm_shuffle_ps(nn23, xy23, _MM_SHUFFLE(3, 2, 1, 0)));
+      _mm_storeu_ps(out + 20, _mm_movehl_ps(nn23, zn23));
+    }
+#elif defined(MESH_SIMD_NEON)
+    // Zip positions with normals per axis, vst3q interleaves the three axes
+    for (; i + 4 <= count; i += 4, out += 24) {
+      float32x4x2_t px = vzipq_f32(vld1q_f32(x + i), vld1q_f32(nx + i));
+      float32x4x2_t py = vzipq_f32(vld1q_f32(y + i), vld1q_f32(ny + i));
+      float32x4x2_t pz = vzipq_f32(vld1q_f32(z + i), vld1q_f32(nz + i));
+      float32x4x3_t lo = {{px.val[0], py.val[0], pz.val[0]}};
+      float32x4x3_t hi = {{px.val[1], py.val[1], pz.val[1]}};
+      vst3q_f32(out, lo);
+      vst3q_f32(out + 12, hi);
+    }
+#endif
+    dst = (char *)out;
+  }
+#endif
+
+  for (; i < count; ++i, dst += vertex_size) {
+    const float position[3] = {x[i], y[i], z[i]};
+    const float normal[3] = {nx[i], ny[i], nz[i]};
+    memcpy(dst + positions_offset, position, sizeof(position));
+    memcpy(dst + normals_offset, normal, sizeof(normal));
+  }
+}
+
+void mesh_soa_to_mesh(const MeshSoA *soa, MeshData *mesh) {
+  const float *const streams[6] = {soa->x, soa->y, soa->z, soa->nx, soa->ny, soa->nz};
+  const int32_t count = soa->vertex_count < mesh->vertex_count ? soa->vertex_count : mesh->vertex_count;
+  mesh_interleave(streams, count, mesh->vertex_data, mesh->vertex_size, mesh->positions_offset,
+                  mesh->normals_offset);
+}
+
+void mesh_pack_positions(const MeshData *mesh, int32_t first, int32_t count,
+                         float *out_positions) {
+  const char *src = (const char *)mesh->vertex_data +
+                    (size_t)first * mesh->vertex_size + mesh->positions_offset;
+  for (int32_t i = 0; i < count; ++i, src += mesh->vertex_size) {
+    memcpy(out_positions + 3 * (size_t)i, src, 3 * sizeof(float));
+  }
+}
+
+#endif /* _MESH_IMPLEMENTATION_ */
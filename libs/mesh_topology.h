@@ -0,0 +1,362 @@
+#ifndef _MESH_TOPOLOGY_H_
+#define _MESH_TOPOLOGY_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Expects mesh.h and parallel.h to be included first.
+
+// Implicit half-edge structure over an indexed triangle list. Half-edge `he`
+// belongs to face `he / 3` and runs from triangles[he] to the next corner of the
+// same face, so next/prev/face/origin need no storage. Only the twin links and
+// one outgoing half-edge per vertex are stored: 3 ints per triangle plus 1 per
+// vertex.
+typedef struct MeshTopology {
+  int32_t vertex_count;
+  int32_t triangle_count;
+  const uint32_t *triangles; // not owned, 3 x triangle_count
+  int32_t *twin;             // 3 x triangle_count, -1 on boundary edges
+  int32_t *vertex_halfedge;  // vertex_count, -1 for unreferenced vertices
+
+  int32_t boundary_edge_count;
+  int32_t nonmanifold_edge_count;
+} MeshTopology;
+
+// Twins are matched by sorting undirected edge keys with par_sort_u64 and
+// pairing opposite half-edges inside every run of equal keys. Non-manifold
+// edges pair up as far as orientation allows, the rest is left as boundary.
+int32_t mesh_topology_build(const MeshData *mesh, MeshTopology *out_topology);
+void mesh_topology_free(MeshTopology *topology);
+
+// Every buffer of a topology build for meshes of up to `max_vertices` and
+// `max_triangles`, for rebuilding the topology of a changing mesh (one per
+// subdivision level) without allocating.
+typedef struct MeshTopologyScratch {
+  int32_t max_vertices;
+  int32_t max_triangles;
+  int32_t *twin;
+  int32_t *vertex_halfedge;
+  uint64_t *keys;      // 2 x 3 x max_triangles, sort ping-pong in the back half
+  uint32_t *halfedges; // 2 x 3 x max_triangles
+} MeshTopologyScratch;
+
+int32_t mesh_topology_scratch_create(MeshTopologyScratch *scratch,
+                                     int32_t max_vertices,
+                                     int32_t max_triangles);
+void mesh_topology_scratch_destroy(MeshTopologyScratch *scratch);
+
+// mesh_topology_build into `scratch`. The topology stays valid until the next
+// build with the same scratch and is not passed to mesh_topology_free. Fails
+// for meshes larger than the scratch.
+int32_t mesh_topology_build_scratch(const MeshData *mesh,
+                                    MeshTopologyScratch *scratch,
+                                    MeshTopology *out_topology);
+
+int32_t mesh_he_next(int32_t he);
+int32_t mesh_he_prev(int32_t he);
+int32_t mesh_he_face(int32_t he);
+int32_t mesh_he_twin(const MeshTopology *topology, int32_t he);
+uint32_t mesh_he_origin(const MeshTopology *topology, int32_t he);
+uint32_t mesh_he_target(const MeshTopology *topology, int32_t he);
+
+// Face across edge `edge` (0..2, edge i starts at corner i), -1 on boundary.
+int32_t mesh_face_neighbor(const MeshTopology *topology, int32_t face,
+                           int32_t edge);
+
+// Next outgoing half-edge counter-clockwise around the origin vertex, -1 once
+// a boundary is reached. Boundary vertices store their outgoing boundary
+// half-edge, so iterating from vertex_halfedge visits the whole fan.
+int32_t mesh_he_rotate_ccw(const MeshTopology *topology, int32_t he);
+int32_t mesh_vertex_is_boundary(const MeshTopology *topology, uint32_t vertex);
+
+// Writes up to `max_count` one-ring neighbours of `vertex` in counter-clockwise
+// order and returns the valence (which may exceed max_count).
+int32_t mesh_vertex_one_ring(const MeshTopology *topology, uint32_t vertex,
+                             uint32_t *out_ring, int32_t max_count);
+
+// Fills 6 x triangle_count indices for GL_TRIANGLES_ADJACENCY: every corner is
+// followed by the vertex opposite the edge it starts. Boundary edges reuse the
+// triangle's own third vertex, as the GL spec suggests for missing neighbours.
+void mesh_topology_adjacency_indices(const MeshTopology *topology,
+                                     uint32_t *out_indices);
+
+#endif /* _MESH_TOPOLOGY_H_ */
+
+#ifdef _MESH_TOPOLOGY_IMPLEMENTATION_
+
+int32_t mesh_he_next(int32_t he) { return he % 3 == 2 ? he - 2 : he + 1; }
+
+int32_t mesh_he_prev(int32_t he) { return he % 3 == 0 ? he + 2 : he - 1; }
+
+int32_t mesh_he_face(int32_t he) { return he / 3; }
+
+int32_t mesh_he_twin(const MeshTopology *topology, int32_t he) {
+  return topology->twin[he];
+}
+
+uint32_t mesh_he_origin(const MeshTopology *topology, int32_t he) {
+  return topology->triangles[he];
+}
+
+uint32_t mesh_he_target(const MeshTopology *topology, int32_t he) {
+  return topology->triangles[mesh_he_next(he)];
+}
+
+int32_t mesh_face_neighbor(const MeshTopology *topology, int32_t face,
+                           int32_t edge) {
+  int32_t twin = topology->twin[3 * face + edge];
+  return twin < 0 ? -1 : twin / 3;
+}
+
+int32_t mesh_he_rotate_ccw(const MeshTopology *topology, int32_t he) {
+  return topology->twin[mesh_he_prev(he)];
+}
+
+int32_t mesh_vertex_is_boundary(const MeshTopology *topology, uint32_t vertex) {
+  int32_t he = topology->vertex_halfedge[vertex];
+  return he >= 0 && topology->twin[he] < 0;
+}
+
+int32_t mesh_vertex_one_ring(const MeshTopology *topology, uint32_t vertex,
+                             uint32_t *out_ring, int32_t max_count) {
+  int32_t start = topology->vertex_halfedge[vertex];
+  if (start < 0) {
+    return 0;
+  }
+  int32_t count = 0;
+  int32_t he = start;
+  do {
+    if (count < max_count) {
+      out_ring[count] = mesh_he_target(topology, he);
+    }
+    count++;
+    int32_t next = mesh_he_rotate_ccw(topology, he);
+    if (next < 0) {
+      // Open fan, the last neighbour is only reachable through the prev edge
+      if (count < max_count) {
+        out_ring[count] = mesh_he_origin(topology, mesh_he_prev(he));
+      }
+      count++;
+      break;
+    }
+    he = next;
+  } while (he != start && count <= topology->triangle_count);
+  return count;
+}
+
+typedef struct mesh__topology_job {
+  const uint32_t *triangles;
+  uint32_t vertex_count;
+  uint64_t *keys;
+  uint32_t *halfedges;
+  int32_t halfedge_count;
+  int32_t *twin;
+  int32_t boundary[PAR_MAX_WORKERS];
+  int32_t nonmanifold[PAR_MAX_WORKERS];
+  uint32_t *adjacency;
+} mesh__topology_job;
+
+static void mesh__topology_keys(void *user, int32_t begin, int32_t end,
+                                int32_t worker) {
+  mesh__topology_job *job = (mesh__topology_job *)user;
+  (void)worker;
+  for (int32_t he = begin; he < end; ++he) {
+    uint64_t a = job->triangles[he];
+    uint64_t b = job->triangles[mesh_he_next(he)];
+    job->keys[he] = a < b ? a * job->vertex_count + b : b * job->vertex_count + a;
+    job->halfedges[he] = (uint32_t)he;
+  }
+}
+
+static void mesh__topology_match(void *user, int32_t begin, int32_t end,
+                                 int32_t worker) {
+  mesh__topology_job *job = (mesh__topology_job *)user;
+  const uint64_t *keys = job->keys;
+  for (int32_t i = begin; i < end; ++i) {
+    // Every run of equal keys is owned by the range containing its first entry
+    if (i > 0 && keys[i] == keys[i - 1]) {
+      continue;
+    }
+    int32_t run_end = i + 1;
+    while (run_end < job->halfedge_count && keys[run_end] == keys[i]) {
+      run_end++;
+    }
+    if (run_end - i > 2) {
+      job->nonmanifold[worker]++;
+    }
+    for (int32_t a = i; a < run_end; ++a) {
+      int32_t ha = (int32_t)job->halfedges[a];
+      if (job->twin[ha] >= 0) {
+        continue;
+      }
+      uint32_t origin = job->triangles[ha];
+      for (int32_t b = a + 1; b < run_end; ++b) {
+        int32_t hb = (int32_t)job->halfedges[b];
+        if (job->twin[hb] < 0 && job->triangles[hb] != origin) {
+          job->twin[ha] = hb;
+          job->twin[hb] = ha;
+          break;
+        }
+      }
+      if (job->twin[ha] < 0) {
+        job->boundary[worker]++;
+      }
+    }
+  }
+}
+
+static void mesh__topology_adjacency(void *user, int32_t begin, int32_t end,
+                                     int32_t worker) {
+  mesh__topology_job *job = (mesh__topology_job *)user;
+  (void)worker;
+  for (int32_t face = begin; face < end; ++face) {
+    for (int32_t corner = 0; corner < 3; ++corner) {
+      int32_t he = 3 * face + corner;
+      int32_t twin = job->twin[he];
+      uint32_t opposite = twin >= 0 ? job->triangles[mesh_he_prev(twin)]
+                                    : job->triangles[mesh_he_prev(he)];
+      job->adjacency[6 * face + 2 * corner + 0] = job->triangles[he];
+      job->adjacency[6 * face + 2 * corner + 1] = opposite;
+    }
+  }
+}
+
+// Fills the preallocated twin and vertex_halfedge arrays of `topology`.
+// `keys` and `halfedges` hold 3 x triangle_count entries, `sort_keys` and
+// `sort_values` the same for the radix sort, NULL to let it allocate.
+static int32_t mesh__topology_fill(const MeshData *mesh, MeshTopology *topology,
+                                   uint64_t *keys, uint32_t *halfedges,
+                                   uint64_t *sort_keys, uint32_t *sort_values) {
+  const int32_t halfedge_count = 3 * mesh->triangle_count;
+  topology->vertex_count = mesh->vertex_count;
+  topology->triangle_count = mesh->triangle_count;
+  topology->triangles = mesh->triangles;
+  topology->boundary_edge_count = 0;
+  topology->nonmanifold_edge_count = 0;
+
+  mesh__topology_job job = {0};
+  job.triangles = mesh->triangles;
+  job.vertex_count = (uint32_t)mesh->vertex_count;
+  job.halfedge_count = halfedge_count;
+  job.twin = topology->twin;
+  job.keys = keys;
+  job.halfedges = halfedges;
+
+  par_for(halfedge_count, 16384, mesh__topology_keys, &job);
+
+  int32_t key_bits = 1;
+  while (key_bits < 64 &&
+         ((uint64_t)1 << key_bits) < (uint64_t)mesh->vertex_count * mesh->vertex_count) {
+    key_bits++;
+  }
+  int32_t sorted =
+      sort_keys ? par_sort_u64_scratch(keys, halfedges, halfedge_count,
+                                       key_bits, sort_keys, sort_values)
+                : par_sort_u64(keys, halfedges, halfedge_count, key_bits);
+  if (sorted) {
+    return EXIT_FAILURE;
+  }
+
+  memset(topology->twin, 0xff, (size_t)halfedge_count * sizeof(int32_t));
+  par_for(halfedge_count, 16384, mesh__topology_match, &job);
+  for (int32_t w = 0; w < PAR_MAX_WORKERS; ++w) {
+    topology->boundary_edge_count += job.boundary[w];
+    topology->nonmanifold_edge_count += job.nonmanifold[w];
+  }
+
+  // Prefer boundary half-edges so that ccw rotation starts at the open end
+  memset(topology->vertex_halfedge, 0xff,
+         (size_t)mesh->vertex_count * sizeof(int32_t));
+  for (int32_t he = 0; he < halfedge_count; ++he) {
+    uint32_t v = mesh->triangles[he];
+    if (topology->vertex_halfedge[v] < 0 || topology->twin[he] < 0) {
+      topology->vertex_halfedge[v] = he;
+    }
+  }
+  return 0;
+}
+
+int32_t mesh_topology_build(const MeshData *mesh, MeshTopology *out_topology) {
+  memset(out_topology, 0, sizeof(*out_topology));
+  const int32_t halfedge_count = 3 * mesh->triangle_count;
+  out_topology->twin = (int32_t *)malloc((size_t)halfedge_count * sizeof(int32_t));
+  out_topology->vertex_halfedge =
+      (int32_t *)malloc((size_t)mesh->vertex_count * sizeof(int32_t));
+  uint64_t *keys = (uint64_t *)malloc((size_t)halfedge_count * sizeof(uint64_t));
+  uint32_t *halfedges =
+      (uint32_t *)malloc((size_t)halfedge_count * sizeof(uint32_t));
+
+  int32_t status = EXIT_FAILURE;
+  if (out_topology->twin && out_topology->vertex_halfedge && keys && halfedges) {
+    status = mesh__topology_fill(mesh, out_topology, keys, halfedges, NULL, NULL);
+  }
+  free(keys);
+  free(halfedges);
+  if (status) {
+    mesh_topology_free(out_topology);
+  }
+  return status;
+}
+
+int32_t mesh_topology_scratch_create(MeshTopologyScratch *scratch,
+                                     int32_t max_vertices,
+                                     int32_t max_triangles) {
+  memset(scratch, 0, sizeof(*scratch));
+  const size_t halfedge_count = (size_t)max_triangles * 3;
+  scratch->max_vertices = max_vertices;
+  scratch->max_triangles = max_triangles;
+  scratch->twin = (int32_t *)malloc(halfedge_count * sizeof(int32_t));
+  scratch->vertex_halfedge =
+      (int32_t *)malloc((size_t)max_vertices * sizeof(int32_t));
+  scratch->keys = (uint64_t *)malloc(2 * halfedge_count * sizeof(uint64_t));
+  scratch->halfedges = (uint32_t *)malloc(2 * halfedge_count * sizeof(uint32_t));
+  if (!scratch->twin || !scratch->vertex_halfedge || !scratch->keys ||
+      !scratch->halfedges) {
+    mesh_topology_scratch_destroy(scratch);
+    return EXIT_FAILURE;
+  }
+  return 0;
+}
+
+void mesh_topology_scratch_destroy(MeshTopologyScratch *scratch) {
+  free(scratch->twin);
+  free(scratch->vertex_halfedge);
+  free(scratch->keys);
+  free(scratch->halfedges);
+  memset(scratch, 0, sizeof(*scratch));
+}
+
+int32_t mesh_topology_build_scratch(const MeshData *mesh,
+                                    MeshTopologyScratch *scratch,
+                                    MeshTopology *out_topology) {
+  memset(out_topology, 0, sizeof(*out_topology));
+  if (mesh->vertex_count > scratch->max_vertices ||
+      mesh->triangle_count > scratch->max_triangles) {
+    return EXIT_FAILURE;
+  }
+  const size_t halfedge_count = (size_t)mesh->triangle_count * 3;
+  out_topology->twin = scratch->twin;
+  out_topology->vertex_halfedge = scratch->vertex_halfedge;
+  return mesh__topology_fill(mesh, out_topology, scratch->keys,
+                             scratch->halfedges, scratch->keys + halfedge_count,
+                             scratch->halfedges + halfedge_count);
+}
+
+void mesh_topology_free(MeshTopology *topology) {
+  free(topology->twin);
+  free(topology->vertex_halfedge);
+  topology->twin = NULL;
+  topology->vertex_halfedge = NULL;
+}
+
+void mesh_topology_adjacency_indices(const MeshTopology *topology,
+                                     uint32_t *out_indices) {
+  mesh__topology_job job = {0};
+  job.triangles = topology->triangles;
+  job.twin = topology->twin;
+  job.adjacency = out_indices;
+  par_for(topology->triangle_count, 8192, mesh__topology_adjacency, &job);
+}
+
+#endif /* _MESH_TOPOLOGY_IMPLEMENTATION_ */
@@ -0,0 +1,456 @@
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <stdint.h>
+
+#define PAR_MAX_WORKERS 64
+
+// Called with a half open range [begin, end) of the iteration space. `worker`
+// is in [0, par_worker_count()) and is stable for the duration of the call, so
+// it can index per-thread scratch memory.
+typedef void (*par_range_fn)(void *user, int32_t begin, int32_t end,
+                             int32_t worker);
+
+// Number of threads participating in par_for, including the caller. Defaults
+// to the number of online cores, PAR_NUM_THREADS in the environment overrides.
+int32_t par_worker_count(void);
+
+// Splits [0, count) into chunks of `grain` iterations and runs them on the
+// worker pool. Blocks until every chunk is done. Nested calls from inside a
+// worker run serially on that worker.
+void par_for(int32_t count, int32_t grain, par_range_fn fn, void *user);
+
+// Joins the worker threads. The pool is recreated on the next par_for.
+void par_shutdown(void);
+
+// In-place exclusive prefix sum, returns the total.
+int32_t par_exclusive_scan(int32_t *values, int32_t count);
+
+// Stable parallel LSD radix sort of `keys` carrying `values` along. Only the
+// low `key_bits` bits of each key are considered, so short keys skip passes.
+int32_t par_sort_u64(uint64_t *keys, uint32_t *values, int32_t count,
+                     int32_t key_bits);
+
+// par_sort_u64 ping-ponging through caller owned `tmp_keys` and `tmp_values`
+// of `count` entries, for callers that sort repeatedly.
+int32_t par_sort_u64_scratch(uint64_t *keys, uint32_t *values, int32_t count,
+                             int32_t key_bits, uint64_t *tmp_keys,
+                             uint32_t *tmp_values);
+
+#endif /* _PARALLEL_H_ */
+
+#ifdef _PARALLEL_IMPLEMENTATION_
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+typedef HANDLE par__thread_t;
+typedef CRITICAL_SECTION par__mutex_t;
+typedef CONDITION_VARIABLE par__cond_t;
+#define par__mutex_init(m) InitializeCriticalSection(m)
+#define par__mutex_destroy(m) DeleteCriticalSection(m)
+#define par__mutex_lock(m) EnterCriticalSection(m)
+#define par__mutex_unlock(m) LeaveCriticalSection(m)
+#define par__cond_init(c) InitializeConditionVariable(c)
+#define par__cond_destroy(c)
+#define par__cond_wait(c, m) SleepConditionVariableCS(c, m, INFINITE)
+#define par__cond_broadcast(c) WakeAllConditionVariable(c)
+#define par__atomic_fetch_add(p, v) InterlockedExchangeAdd((volatile LONG *)(p), (v))
+#else
+#include <pthread.h>
+#include <unistd.h>
+typedef pthread_t par__thread_t;
+typedef pthread_mutex_t par__mutex_t;
+typedef pthread_cond_t par__cond_t;
+#define par__mutex_init(m) pthread_mutex_init(m, NULL)
+#define par__mutex_destroy(m) pthread_mutex_destroy(m)
+#define par__mutex_lock(m) pthread_mutex_lock(m)
+#define par__mutex_unlock(m) pthread_mutex_unlock(m)
+#define par__cond_init(c) pthread_cond_init(c, NULL)
+#define par__cond_destroy(c) pthread_cond_destroy(c)
+#define par__cond_wait(c, m) pthread_cond_wait(c, m)
+#define par__cond_broadcast(c) pthread_cond_broadcast(c)
+#define par__atomic_fetch_add(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#endif
+
+#if defined(_MSC_VER)
+#define PAR_THREAD_LOCAL __declspec(thread)
+#else
+#define PAR_THREAD_LOCAL _Thread_local
+#endif
+
+typedef struct par__pool {
+  int32_t initialized;
+  int32_t worker_count;
+  par__thread_t threads[PAR_MAX_WORKERS];
+  par__mutex_t submit_lock;
+  par__mutex_t lock;
+  par__cond_t wake;
+  par__cond_t done;
+  uint32_t generation;
+  int32_t active;
+  int32_t shutdown;
+
+  // Current job, published under `lock`
+  par_range_fn fn;
+  void *user;
+  int32_t count;
+  int32_t grain;
+  int32_t chunk_count;
+  int32_t next_chunk;
+} par__pool;
+
+static par__pool par__g;
+static PAR_THREAD_LOCAL int32_t par__inside_job = 0;
+
+static void par__run_chunks(int32_t worker) {
+  par__inside_job = 1;
+  for (;;) {
+    int32_t chunk = par__atomic_fetch_add(&par__g.next_chunk, 1);
+    if (chunk >= par__g.chunk_count) {
+      break;
+    }
+    int32_t begin = chunk * par__g.grain;
+    int32_t end = begin + par__g.grain;
+    end = end > par__g.count ? par__g.count : end;
+    par__g.fn(par__g.user, begin, end, worker);
+  }
+  par__inside_job = 0;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI par__worker_main(LPVOID arg) {
+#else
+static void *par__worker_main(void *arg) {
+#endif
+  int32_t worker = (int32_t)(intptr_t)arg;
+  uint32_t seen = 0;
+  par__mutex_lock(&par__g.lock);
+  for (;;) {
+    while (!par__g.shutdown && par__g.generation == seen) {
+      par__cond_wait(&par__g.wake, &par__g.lock);
+    }
+    if (par__g.shutdown) {
+      break;
+    }
+    seen = par__g.generation;
+    par__mutex_unlock(&par__g.lock);
+
+    par__run_chunks(worker);
+
+    par__mutex_lock(&par__g.lock);
+    if (--par__g.active == 0) {
+      par__cond_broadcast(&par__g.done);
+    }
+  }
+  par__mutex_unlock(&par__g.lock);
+  return 0;
+}
+
+static int32_t par__detect_cores(void) {
+  const char *env = getenv("PAR_NUM_THREADS");
+  int32_t count = env ? atoi(env) : 0;
+  if (count <= 0) {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    count = (int32_t)info.dwNumberOfProcessors;
+#else
+    count = (int32_t)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  }
+  if (count < 1) {
+    count = 1;
+  }
+  return count > PAR_MAX_WORKERS ? PAR_MAX_WORKERS : count;
+}
+
+static void par__init(void) {
+  if (par__g.initialized) {
+    return;
+  }
+  const int32_t requested = par__detect_cores();
+  par__mutex_init(&par__g.submit_lock);
+  par__mutex_init(&par__g.lock);
+  par__cond_init(&par__g.wake);
+  par__cond_init(&par__g.done);
+  par__g.generation = 0;
+  par__g.shutdown = 0;
+  // Worker ids stay contiguous: stop at the first thread that cannot be
+  // created and count only the ones that run. With none, par_for runs inline.
+  int32_t created = 1;
+  for (; created < requested; ++created) {
+#if defined(_WIN32)
+    par__g.threads[created] = CreateThread(NULL, 0, par__worker_main,
+                                           (LPVOID)(intptr_t)created, 0, NULL);
+    if (!par__g.threads[created]) {
+      break;
+    }
+#else
+    if (pthread_create(&par__g.threads[created], NULL, par__worker_main,
+                       (void *)(intptr_t)created) != 0) {
+      break;
+    }
+#endif
+  }
+  par__g.worker_count = created;
+  par__g.initialized = 1;
+}
+
+int32_t par_worker_count(void) {
+  par__init();
+  return par__g.worker_count;
+}
+
+void par_for(int32_t count, int32_t grain, par_range_fn fn, void *user) {
+  if (count <= 0) {
+    return;
+  }
+  grain = grain < 1 ? 1 : grain;
+  par__init();
+  int32_t chunk_count = (count + grain - 1) / grain;
+  if (par__inside_job || chunk_count == 1 || par__g.worker_count == 1) {
+    fn(user, 0, count, 0);
+    return;
+  }
+
+  par__mutex_lock(&par__g.submit_lock);
+  par__mutex_lock(&par__g.lock);
+  par__g.fn = fn;
+  par__g.user = user;
+  par__g.count = count;
+  par__g.grain = grain;
+  par__g.chunk_count = chunk_count;
+  par__g.next_chunk = 0;
+  par__g.active = par__g.worker_count - 1;
+  par__g.generation++;
+  par__cond_broadcast(&par__g.wake);
+  par__mutex_unlock(&par__g.lock);
+
+  par__run_chunks(0);
+
+  par__mutex_lock(&par__g.lock);
+  while (par__g.active > 0) {
+    par__cond_wait(&par__g.done, &par__g.lock);
+  }
+  par__mutex_unlock(&par__g.lock);
+  par__mutex_unlock(&par__g.submit_lock);
+}
+
+void par_shutdown(void) {
+  if (!par__g.initialized) {
+    return;
+  }
+  par__mutex_lock(&par__g.lock);
+  par__g.shutdown = 1;
+  par__cond_broadcast(&par__g.wake);
+  par__mutex_unlock(&par__g.lock);
+  for (int32_t i = 1; i < par__g.worker_count; ++i) {
+#if defined(_WIN32)
+    WaitForSingleObject(par__g.threads[i], INFINITE);
+    CloseHandle(par__g.threads[i]);
+#else
+    pthread_join(par__g.threads[i], NULL);
+#endif
+  }
+  par__cond_destroy(&par__g.done);
+  par__cond_destroy(&par__g.wake);
+  par__mutex_destroy(&par__g.lock);
+  par__mutex_destroy(&par__g.submit_lock);
+  par__g.initialized = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//       SCAN
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct par__scan_job {
+  int32_t *values;
+  int32_t count;
+  int32_t block_count;
+  int32_t *block_sums;
+} par__scan_job;
+
+static void par__scan_sum(void *user, int32_t begin, int32_t end,
+                          int32_t worker) {
+  par__scan_job *job = (par__scan_job *)user;
+  (void)worker;
+  for (int32_t block = begin; block < end; ++block) {
+    int32_t i0 = (int32_t)((int64_t)job->count * block / job->block_count);
+    int32_t i1 = (int32_t)((int64_t)job->count * (block + 1) / job->block_count);
+    int32_t sum = 0;
+    for (int32_t i = i0; i < i1; ++i) {
+      sum += job->values[i];
+    }
+    job->block_sums[block] = sum;
+  }
+}
+
+static void par__scan_apply(void *user, int32_t begin, int32_t end,
+                            int32_t worker) {
+  par__scan_job *job = (par__scan_job *)user;
+  (void)worker;
+  for (int32_t block = begin; block < end; ++block) {
+    int32_t i0 = (int32_t)((int64_t)job->count * block / job->block_count);
+    int32_t i1 = (int32_t)((int64_t)job->count * (block + 1) / job->block_count);
+    int32_t running = job->block_sums[block];
+    for (int32_t i = i0; i < i1; ++i) {
+      int32_t n = job->values[i];
+      job->values[i] = running;
+      running += n;
+    }
+  }
+}
+
+int32_t par_exclusive_scan(int32_t *values, int32_t count) {
+  int32_t block_sums[4 * PAR_MAX_WORKERS];
+  par__scan_job job;
+  job.values = values;
+  job.count = count;
+  job.block_count = 4 * par_worker_count();
+  job.block_sums = block_sums;
+  if (count < 4096) {
+    job.block_count = 1;
+  }
+  par_for(job.block_count, 1, par__scan_sum, &job);
+  int32_t total = 0;
+  for (int32_t block = 0; block < job.block_count; ++block) {
+    int32_t n = block_sums[block];
+    block_sums[block] = total;
+    total += n;
+  }
+  par_for(job.block_count, 1, par__scan_apply, &job);
+  return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//       RADIX SORT
+////////////////////////////////////////////////////////////////////////////////
+
+#define PAR__RADIX_BITS 8
+#define PAR__RADIX_SIZE (1 << PAR__RADIX_BITS)
+
+typedef struct par__sort_pass {
+  const uint64_t *src_keys;
+  const uint32_t *src_values;
+  uint64_t *dst_keys;
+  uint32_t *dst_values;
+  int32_t count;
+  int32_t block_count;
+  int32_t shift;
+  int32_t (*offsets)[PAR__RADIX_SIZE];
+} par__sort_pass;
+
+static void par__sort_block_range(const par__sort_pass *pass, int32_t block,
+                                  int32_t *begin, int32_t *end) {
+  *begin = (int32_t)((int64_t)pass->count * block / pass->block_count);
+  *end = (int32_t)((int64_t)pass->count * (block + 1) / pass->block_count);
+}
+
+static void par__sort_histogram(void *user, int32_t begin, int32_t end,
+                                int32_t worker) {
+  par__sort_pass *pass = (par__sort_pass *)user;
+  (void)worker;
+  for (int32_t block = begin; block < end; ++block) {
+    int32_t *hist = pass->offsets[block];
+    memset(hist, 0, PAR__RADIX_SIZE * sizeof(int32_t));
+    int32_t i0, i1;
+    par__sort_block_range(pass, block, &i0, &i1);
+    for (int32_t i = i0; i < i1; ++i) {
+      hist[(pass->src_keys[i] >> pass->shift) & (PAR__RADIX_SIZE - 1)]++;
+    }
+  }
+}
+
+static void par__sort_scatter(void *user, int32_t begin, int32_t end,
+                              int32_t worker) {
+  par__sort_pass *pass = (par__sort_pass *)user;
+  (void)worker;
+  for (int32_t block = begin; block < end; ++block) {
+    int32_t *offset = pass->offsets[block];
+    int32_t i0, i1;
+    par__sort_block_range(pass, block, &i0, &i1);
+    for (int32_t i = i0; i < i1; ++i) {
+      uint64_t key = pass->src_keys[i];
+      int32_t dst = offset[(key >> pass->shift) & (PAR__RADIX_SIZE - 1)]++;
+      pass->dst_keys[dst] = key;
+      pass->dst_values[dst] = pass->src_values[i];
+    }
+  }
+}
+
+int32_t par_sort_u64_scratch(uint64_t *keys, uint32_t *values, int32_t count,
+                             int32_t key_bits, uint64_t *tmp_keys,
+                             uint32_t *tmp_values) {
+  if (count <= 1 || key_bits <= 0) {
+    return 0;
+  }
+  int32_t block_count = par_worker_count() * 4;
+  int32_t(*offsets)[PAR__RADIX_SIZE] = (int32_t(*)[PAR__RADIX_SIZE])malloc(
+      (size_t)block_count * sizeof(*offsets));
+  if (!offsets) {
+    return EXIT_FAILURE;
+  }
+
+  par__sort_pass pass;
+  pass.count = count;
+  pass.block_count = block_count;
+  pass.offsets = offsets;
+  pass.src_keys = keys;
+  pass.src_values = values;
+  pass.dst_keys = tmp_keys;
+  pass.dst_values = tmp_values;
+
+  int32_t pass_count = (key_bits + PAR__RADIX_BITS - 1) / PAR__RADIX_BITS;
+  for (int32_t p = 0; p < pass_count; ++p) {
+    pass.shift = p * PAR__RADIX_BITS;
+    par_for(block_count, 1, par__sort_histogram, &pass);
+
+    // Exclusive scan, digit-major then block-major, keeps the sort stable
+    int32_t running = 0;
+    for (int32_t digit = 0; digit < PAR__RADIX_SIZE; ++digit) {
+      for (int32_t block = 0; block < block_count; ++block) {
+        int32_t n = offsets[block][digit];
+        offsets[block][digit] = running;
+        running += n;
+      }
+    }
+
+    par_for(block_count, 1, par__sort_scatter, &pass);
+
+    const uint64_t *next_keys = pass.dst_keys;
+    const uint32_t *next_values = pass.dst_values;
+    pass.dst_keys = (uint64_t *)pass.src_keys;
+    pass.dst_values = (uint32_t *)pass.src_values;
+    pass.src_keys = next_keys;
+    pass.src_values = next_values;
+  }
+
+  if (pass.src_keys != keys) {
+    memcpy(keys, pass.src_keys, (size_t)count * sizeof(uint64_t));
+    memcpy(values, pass.src_values, (size_t)count * sizeof(uint32_t));
+  }
+  free(offsets);
+  return 0;
+}
+
+int32_t par_sort_u64(uint64_t *keys, uint32_t *values, int32_t count,
+                     int32_t key_bits) {
+  if (count <= 1 || key_bits <= 0) {
+    return 0;
+  }
+  uint64_t *tmp_keys = (uint64_t *)malloc((size_t)count * sizeof(uint64_t));
+  uint32_t *tmp_values = (uint32_t *)malloc((size_t)count * sizeof(uint32_t));
+  int32_t status = EXIT_FAILURE;
+  if (tmp_keys && tmp_values) {
+    status = par_sort_u64_scratch(keys, values, count, key_bits, tmp_keys,
+                                  tmp_values);
+  }
+  free(tmp_keys);
+  free(tmp_values);
+  return status;
+}
+
+#endif /* _PARALLEL_IMPLEMENTATION_ */
@@ -0,0 +1,459 @@
+#ifndef _POINT_LOD_H_
+#define _POINT_LOD_H_
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Expects vec_math.h, mesh.h and parallel.h to be included first.
+
+#define POINT_LOD_MAX_DEPTH 10
+#define POINT_LOD_MAX_LEVELS (POINT_LOD_MAX_DEPTH + 2)
+#define POINT_LOD_CHUNK_LEVEL 4
+// Floats per point: position, normal, splat radius
+#define POINT_LOD_STRIDE 7
+// Splat radii are scaled up by this much so neighbouring splats overlap
+#define POINT_LOD_COVERAGE 1.5f
+
+typedef struct PointLodLevel {
+  int32_t first; // first point of the level in `points`
+  int32_t count;
+  float spacing; // typical distance between neighbouring points
+} PointLodLevel;
+
+// Layered point hierarchy over the vertices of a mesh or scan. Level l < depth
+// + 1 holds one averaged point per occupied cell of a (1 << l)^3 grid and the
+// last level holds the input points themselves, all levels stored coarse to
+// fine in one array so a single vertex buffer serves every level.
+// Points are in Morton order within a level, which makes the points of one
+// chunk (a cell of level POINT_LOD_CHUNK_LEVEL) a contiguous range on every
+// finer level, so chunks pick their level independently.
+typedef struct PointLod {
+  int32_t depth;
+  vec3_t min;       // corner of the cubic grid
+  float size;       // edge length of the grid
+  int32_t level_count;
+  PointLodLevel levels[POINT_LOD_MAX_LEVELS];
+  int32_t point_count;
+  float *points; // POINT_LOD_STRIDE floats per point, only needed until uploaded
+
+  int32_t chunk_level; // min(POINT_LOD_CHUNK_LEVEL, depth)
+  int32_t chunk_count;
+  float *chunk_centers;  // 3 floats per chunk
+  int32_t *chunk_ranges; // per chunk, first and count on every level from chunk_level on
+} PointLod;
+
+// Builds the hierarchy from the vertex positions (and normals when the mesh
+// has them), ignoring the triangles. Keys are computed and sorted with the
+// parallel radix sort, then every level is reduced from the one below it.
+// Splat radii follow the local density: a point covers its share of the
+// parent cell's surface, so sparse regions get larger splats.
+int32_t point_lod_build(const MeshData *mesh, int32_t depth, PointLod *out_lod);
+void point_lod_free(PointLod *lod);
+
+// Picks a level per chunk so neighbouring points are at most `max_spacing`
+// pixels apart, `pixels_per_unit` being the on-screen size of a unit length
+// at unit distance and `eye` in model space. Writes one (first, count) draw
+// per chunk, ready for glMultiDrawArrays, or a single draw of a coarse level
+// when the whole object is small. Returns the draw count, at most
+// `chunk_count`.
+int32_t point_lod_select(const PointLod *lod, vec3_t eye, float pixels_per_unit,
+                         float max_spacing, int32_t *out_first,
+                         int32_t *out_count);
+
+#endif /* _POINT_LOD_H_ */
+
+#ifdef _POINT_LOD_IMPLEMENTATION_
+
+typedef struct point_lod__job {
+  const MeshData *mesh;
+  PointLod *lod;
+  int32_t resolution;
+  float lo[3][PAR_MAX_WORKERS];
+  float hi[3][PAR_MAX_WORKERS];
+  uint64_t *keys;   // leaf cell per input point, sorted
+  uint32_t *values; // input point per key
+  int32_t *flags;   // 1 where a parent run starts, then its index
+  int32_t *starts;  // first child of every run
+  // Points, cell codes and input point counts per level, finest first
+  float *points[POINT_LOD_MAX_LEVELS];
+  uint64_t *codes[POINT_LOD_MAX_LEVELS];
+  int32_t *weights[POINT_LOD_MAX_LEVELS];
+  int32_t counts[POINT_LOD_MAX_LEVELS];
+  int32_t level; // level being reduced, counted from the root
+  int32_t child_level;
+} point_lod__job;
+
+static uint64_t point_lod__spread_bits(uint64_t x) {
+  x &= 0x1fffff;
+  x = (x | x << 32) & 0x1f00000000ffffull;
+  x = (x | x << 16) & 0x1f0000ff0000ffull;
+  x = (x | x << 8) & 0x100f00f00f00f00full;
+  x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+  x = (x | x << 2) & 0x1249249249249249ull;
+  return x;
+}
+
+static const float *point_lod__position(const MeshData *mesh, uint32_t vertex) {
+  return (const float *)((const char *)mesh->vertex_data +
+                         (size_t)vertex * mesh->vertex_size +
+                         mesh->positions_offset);
+}
+
+// Cell edge length on `level`, the input points count as one level finer.
+static float point_lod__cell_size(const PointLod *lod, int32_t level) {
+  return ldexpf(lod->size, -(level < lod->depth ? level : lod->depth));
+}
+
+static void point_lod__bounds_range(void *user, int32_t begin, int32_t end,
+                                    int32_t worker) {
+  point_lod__job *job = (point_lod__job *)user;
+  for (int32_t v = begin; v < end; ++v) {
+    const float *p = point_lod__position(job->mesh, (uint32_t)v);
+    for (int32_t k = 0; k < 3; ++k) {
+      job->lo[k][worker] = fminf(job->lo[k][worker], p[k]);
+      job->hi[k][worker] = fmaxf(job->hi[k][worker], p[k]);
+    }
+  }
+}
+
+static void point_lod__key_range(void *user, int32_t begin, int32_t end,
+                                 int32_t worker) {
+  point_lod__job *job = (point_lod__job *)user;
+  const PointLod *lod = job->lod;
+  const float scale = (float)job->resolution / lod->size;
+  const float origin[3] = {lod->min.x, lod->min.y, lod->min.z};
+  (void)worker;
+  for (int32_t v = begin; v < end; ++v) {
+    const float *p = point_lod__position(job->mesh, (uint32_t)v);
+    uint64_t key = 0;
+    for (int32_t k = 0; k < 3; ++k) {
+      int32_t cell = (int32_t)((p[k] - origin[k]) * scale);
+      cell = cell < 0 ? 0 : (cell >= job->resolution ? job->resolution - 1 : cell);
+      key |= point_lod__spread_bits((uint64_t)cell) << k;
+    }
+    job->keys[v] = key;
+    job->values[v] = (uint32_t)v;
+  }
+}
+
+// The input points in key order, radius filled in by the reduction above.
+static void point_lod__input_range(void *user, int32_t begin, int32_t end,
+                                   int32_t worker) {
+  point_lod__job *job = (point_lod__job *)user;
+  const MeshData *mesh = job->mesh;
+  const int32_t l = job->lod->depth + 1;
+  (void)worker;
+  for (int32_t i = begin; i < end; ++i) {
+    const char *vertex = (const char *)mesh->vertex_data + (size_t)job->values[i] * mesh->vertex_size;
+    float *point = job->points[l] + POINT_LOD_STRIDE * (size_t)i;
+    memcpy(point, vertex + mesh->positions_offset, 3 * sizeof(float));
+    if (mesh->normals_size) {
+      memcpy(point + 3, vertex + mesh->normals_offset, 3 * sizeof(float));
+    } else {
+      point[3] = point[4] = point[5] = 0.0f;
+    }
+    point[6] = 0.0f;
+    job->codes[l][i] = job->keys[i];
+    job->weights[l][i] = 1;
+  }
+}
+
+// Marks the first child of every parent cell. The input points share their
+// leaf cell code, every other level drops three bits per step.
+static void point_lod__flag_range(void *user, int32_t begin, int32_t end,
+                                  int32_t worker) {
+  point_lod__job *job = (point_lod__job *)user;
+  const uint64_t *codes = job->codes[job->child_level];
+  const int32_t shift = job->child_level > job->lod->depth ? 0 : 3;
+  (void)worker;
+  for (int32_t i = begin; i < end; ++i) {
+    job->flags[i] = i == 0 || (codes[i] >> shift) != (codes[i - 1] >> shift);
+  }
+}
+
+static void point_lod__start_range(void *user, int32_t begin, int32_t end,
+                                   int32_t worker) {
+  point_lod__job *job = (point_lod__job *)user;
+  (void)worker;
+  for (int32_t i = begin; i < end; ++i) {
+    if (job->flags[i + 1] != job->flags[i]) {
+      job->starts[job->flags[i]] = i;
+    }
+  }
+}
+
+// Weighted average of the children of every cell on `job->level`, and the
+// density based radius of those children.
+static void point_lod__reduce_range(void *user, int32_t begin, int32_t end,
+                                    int32_t worker) {
+  point_lod__job *job = (point_lod__job *)user;
+  const int32_t l = job->level;
+  const int32_t c = job->child_level;
+  const int32_t shift = c > job->lod->depth ? 0 : 3;
+  const float cell = point_lod__cell_size(job->lod, l);
+  (void)worker;
+  for (int32_t node = begin; node < end; ++node) {
+    const int32_t first = job->starts[node];
+    const int32_t last = node + 1 < job->counts[l] ? job->starts[node + 1] : job->counts[c];
+    // A roughly flat surface crossing the cell is shared by its children
+    const float radius = POINT_LOD_COVERAGE * cell / sqrtf((float)PI * (float)(last - first));
+    float sum[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    int32_t weight = 0;
+    for (int32_t i = first; i < last; ++i) {
+      float *child = job->points[c] + POINT_LOD_STRIDE * (size_t)i;
+      const float w = (float)job->weights[c][i];
+      for (int32_t k = 0; k < 6; ++k) {
+        sum[k] += child[k] * w;
+      }
+      weight += job->weights[c][i];
+      child[6] = radius;
+    }
+    float *point = job->points[l] + POINT_LOD_STRIDE * (size_t)node;
+    for (int32_t k = 0; k < 3; ++k) {
+      point[k] = sum[k] / (float)weight;
+    }
+    const float length = sqrtf(sum[3] * sum[3] + sum[4] * sum[4] + sum[5] * sum[5]);
+    for (int32_t k = 3; k < 6; ++k) {
+      point[k] = length > 0.0f ? sum[k] / length : 0.0f;
+    }
+    job->codes[l][node] = job->codes[c][first] >> shift;
+    job->weights[l][node] = weight;
+  }
+}
+
+// Ranges of every chunk on the levels at and below the chunk level, found by
+// binary search in each level's sorted codes.
+static void point_lod__chunk_range(void *user, int32_t begin, int32_t end,
+                                   int32_t worker) {
+  point_lod__job *job = (point_lod__job *)user;
+  PointLod *lod = job->lod;
+  const int32_t levels = lod->level_count - lod->chunk_level;
+  const float cell = point_lod__cell_size(lod, lod->chunk_level);
+  (void)worker;
+  for (int32_t chunk = begin; chunk < end; ++chunk) {
+    const uint64_t code = job->codes[lod->chunk_level][chunk];
+    float *center = lod->chunk_centers + 3 * (size_t)chunk;
+    const float origin[3] = {lod->min.x, lod->min.y, lod->min.z};
+    for (int32_t k = 0; k < 3; ++k) {
+      uint32_t cell_index = 0;
+      for (int32_t bit = 0; bit < lod->chunk_level; ++bit) {
+        cell_index |= (uint32_t)((code >> (3 * bit + k)) & 1) << bit;
+      }
+      center[k] = origin[k] + ((float)cell_index + 0.5f) * cell;
+    }
+    for (int32_t l = lod->chunk_level; l < lod->level_count; ++l) {
+      const int32_t shift = 3 * ((l < lod->depth ? l : lod->depth) - lod->chunk_level);
+      const uint64_t *codes = job->codes[l];
+      int32_t lo = 0;
+      int32_t hi = job->counts[l];
+      while (lo < hi) {
+        const int32_t mid = lo + (hi - lo) / 2;
+        if ((codes[mid] >> shift) < code) {
+          lo = mid + 1;
+        } else {
+          hi = mid;
+        }
+      }
+      int32_t last = lo;
+      hi = job->counts[l];
+      while (last < hi) {
+        const int32_t mid = last + (hi - last) / 2;
+        if ((codes[mid] >> shift) <= code) {
+          last = mid + 1;
+        } else {
+          hi = mid;
+        }
+      }
+      int32_t *range = lod->chunk_ranges + 2 * ((size_t)chunk * levels + (l - lod->chunk_level));
+      range[0] = lod->levels[l].first + lo;
+      range[1] = last - lo;
+    }
+  }
+}
+
+static int32_t point_lod__build(point_lod__job *job) {
+  const MeshData *mesh = job->mesh;
+  PointLod *lod = job->lod;
+  const int32_t depth = lod->depth;
+  const int32_t n = mesh->vertex_count;
+
+  // Cubic grid around the points, nudged so none lands on the far faces
+  for (int32_t w = 0; w < PAR_MAX_WORKERS; ++w) {
+    for (int32_t k = 0; k < 3; ++k) {
+      job->lo[k][w] = FLT_MAX;
+      job->hi[k][w] = -FLT_MAX;
+    }
+  }
+  par_for(n, 4096, point_lod__bounds_range, job);
+  float lo[3];
+  float extent = 0.0f;
+  for (int32_t k = 0; k < 3; ++k) {
+    float hi = -FLT_MAX;
+    lo[k] = FLT_MAX;
+    for (int32_t w = 0; w < PAR_MAX_WORKERS; ++w) {
+      lo[k] = fminf(lo[k], job->lo[k][w]);
+      hi = fmaxf(hi, job->hi[k][w]);
+    }
+    extent = fmaxf(extent, hi - lo[k]);
+  }
+  lod->min = vec3(lo[0], lo[1], lo[2]);
+  lod->size = fmaxf(extent * 1.0001f, FLT_MIN);
+
+  // Input points sorted by leaf cell
+  job->keys = (uint64_t *)malloc((size_t)n * sizeof(uint64_t));
+  job->values = (uint32_t *)malloc((size_t)n * sizeof(uint32_t));
+  job->flags = (int32_t *)malloc(((size_t)n + 1) * sizeof(int32_t));
+  job->starts = (int32_t *)malloc((size_t)n * sizeof(int32_t));
+  if (!job->keys || !job->values || !job->flags || !job->starts) {
+    return EXIT_FAILURE;
+  }
+  par_for(n, 4096, point_lod__key_range, job);
+  if (par_sort_u64(job->keys, job->values, n, 3 * depth)) {
+    return EXIT_FAILURE;
+  }
+  const int32_t input = depth + 1;
+  job->counts[input] = n;
+  job->points[input] = (float *)malloc((size_t)n * POINT_LOD_STRIDE * sizeof(float));
+  job->codes[input] = (uint64_t *)malloc((size_t)n * sizeof(uint64_t));
+  job->weights[input] = (int32_t *)malloc((size_t)n * sizeof(int32_t));
+  if (!job->points[input] || !job->codes[input] || !job->weights[input]) {
+    return EXIT_FAILURE;
+  }
+  par_for(n, 4096, point_lod__input_range, job);
+  free(job->keys);
+  free(job->values);
+  job->keys = NULL;
+  job->values = NULL;
+
+  // Every level averages the runs of siblings on the level below
+  for (job->level = depth; job->level >= 0; --job->level) {
+    const int32_t l = job->level;
+    job->child_level = l + 1;
+    const int32_t child_count = job->counts[l + 1];
+    par_for(child_count, 4096, point_lod__flag_range, job);
+    job->flags[child_count] = 0;
+    const int32_t count = par_exclusive_scan(job->flags, child_count + 1);
+    job->counts[l] = count;
+    job->points[l] = (float *)malloc((size_t)count * POINT_LOD_STRIDE * sizeof(float));
+    job->codes[l] = (uint64_t *)malloc((size_t)count * sizeof(uint64_t));
+    job->weights[l] = (int32_t *)malloc((size_t)count * sizeof(int32_t));
+    if (!job->points[l] || !job->codes[l] || !job->weights[l]) {
+      return EXIT_FAILURE;
+    }
+    par_for(child_count, 4096, point_lod__start_range, job);
+    par_for(count, 1024, point_lod__reduce_range, job);
+  }
+  // The root covers the whole grid
+  job->points[0][6] = 0.5f * sqrtf(3.0f) * lod->size;
+
+  // Concatenate coarse to fine
+  lod->level_count = depth + 2;
+  for (int32_t l = 0; l < lod->level_count; ++l) {
+    lod->levels[l].first = lod->point_count;
+    lod->levels[l].count = job->counts[l];
+    lod->levels[l].spacing = point_lod__cell_size(lod, l);
+    lod->point_count += job->counts[l];
+  }
+  // Input points are spread over the occupied leaf cells
+  lod->levels[input].spacing = point_lod__cell_size(lod, depth) *
+                               sqrtf((float)job->counts[depth] / (float)n);
+  lod->points = (float *)malloc((size_t)lod->point_count * POINT_LOD_STRIDE * sizeof(float));
+  if (!lod->points) {
+    return EXIT_FAILURE;
+  }
+  for (int32_t l = 0; l < lod->level_count; ++l) {
+    memcpy(lod->points + POINT_LOD_STRIDE * (size_t)lod->levels[l].first, job->points[l],
+           (size_t)job->counts[l] * POINT_LOD_STRIDE * sizeof(float));
+  }
+
+  lod->chunk_level = depth < POINT_LOD_CHUNK_LEVEL ? depth : POINT_LOD_CHUNK_LEVEL;
+  lod->chunk_count = job->counts[lod->chunk_level];
+  lod->chunk_centers = (float *)malloc((size_t)lod->chunk_count * 3 * sizeof(float));
+  lod->chunk_ranges = (int32_t *)malloc((size_t)lod->chunk_count *
+                                        (lod->level_count - lod->chunk_level) * 2 * sizeof(int32_t));
+  if (!lod->chunk_centers || !lod->chunk_ranges) {
+    return EXIT_FAILURE;
+  }
+  par_for(lod->chunk_count, 64, point_lod__chunk_range, job);
+  return 0;
+}
+
+int32_t point_lod_build(const MeshData *mesh, int32_t depth, PointLod *out_lod) {
+  memset(out_lod, 0, sizeof(*out_lod));
+  if (depth < 1 || depth > POINT_LOD_MAX_DEPTH || mesh->vertex_count <= 0) {
+    return EXIT_FAILURE;
+  }
+  point_lod__job *job = (point_lod__job *)calloc(1, sizeof(point_lod__job));
+  if (!job) {
+    return EXIT_FAILURE;
+  }
+  job->mesh = mesh;
+  job->lod = out_lod;
+  job->resolution = 1 << depth;
+  out_lod->depth = depth;
+
+  int32_t status = point_lod__build(job);
+  free(job->keys);
+  free(job->values);
+  free(job->flags);
+  free(job->starts);
+  for (int32_t l = 0; l < POINT_LOD_MAX_LEVELS; ++l) {
+    free(job->points[l]);
+    free(job->codes[l]);
+    free(job->weights[l]);
+  }
+  free(job);
+  if (status) {
+    point_lod_free(out_lod);
+  }
+  return status;
+}
+
+void point_lod_free(PointLod *lod) {
+  free(lod->points);
+  free(lod->chunk_centers);
+  free(lod->chunk_ranges);
+  memset(lod, 0, sizeof(*lod));
+}
+
+// Coarsest level whose spacing stays below `max_spacing` pixels at `distance`.
+static int32_t point_lod__level_for(const PointLod *lod, float distance,
+                                    float pixels_per_unit, float max_spacing) {
+  const float limit = max_spacing * fmaxf(distance, FLT_MIN) / pixels_per_unit;
+  for (int32_t l = 0; l < lod->level_count; ++l) {
+    if (lod->levels[l].spacing <= limit) {
+      return l;
+    }
+  }
+  return lod->level_count - 1;
+}
+
+int32_t point_lod_select(const PointLod *lod, vec3_t eye, float pixels_per_unit,
+                         float max_spacing, int32_t *out_first,
+                         int32_t *out_count) {
+  const int32_t levels = lod->level_count - lod->chunk_level;
+  const float reach = 0.5f * sqrtf(3.0f) * point_lod__cell_size(lod, lod->chunk_level);
+  int32_t finest = 0;
+  for (int32_t chunk = 0; chunk < lod->chunk_count; ++chunk) {
+    const float *c = lod->chunk_centers + 3 * (size_t)chunk;
+    const float distance = fmaxf(vec3_norm(vec3_sub(vec3(c[0], c[1], c[2]), eye)) - reach, 0.0f);
+    int32_t l = point_lod__level_for(lod, distance, pixels_per_unit, max_spacing);
+    finest = l > finest ? l : finest;
+    l = l > lod->chunk_level ? l : lod->chunk_level;
+    const int32_t *range = lod->chunk_ranges + 2 * ((size_t)chunk * levels + (l - lod->chunk_level));
+    out_first[chunk] = range[0];
+    out_count[chunk] = range[1];
+  }
+  // Small on screen: one draw of a level coarser than the chunks
+  if (finest < lod->chunk_level) {
+    out_first[0] = lod->levels[finest].first;
+    out_count[0] = lod->levels[finest].count;
+    return 1;
+  }
+  return lod->chunk_count;
+}
+
+#endif /* _POINT_LOD_IMPLEMENTATION_ */
@@ -0,0 +1,206 @@
+#ifndef _SCREEN_SPACE_H_
+#define _SCREEN_SPACE_H_
+
+#include <stdint.h>
+
+// Expects vec_math.h and parallel.h to be included first.
+
+// Screen space queries over many points a frame: label placement, picking
+// rays and pixel bounds of objects. The camera matrix and its inverse are
+// built once per frame, the arrays are split across the par_for workers and
+// every chunk runs the 4 wide project_batch and unproject_batch of vec_math.h,
+// so results do not depend on the thread count.
+
+// Points per parallel task
+#define SCREEN_SPACE_GRAIN 4096
+// Boxes per parallel task, 8 corners each
+#define SCREEN_SPACE_BOX_GRAIN 512
+// Elements staged on the stack between the batch calls of a task
+#define SCREEN_SPACE_TILE 256
+
+// `mvp` is projection * view (* model for points in model space), `viewport`
+// is x, y, width and height in pixels as for project().
+typedef struct ScreenCamera {
+  mat4_t mvp;
+  mat4_t inverse_mvp;
+  vec4_t viewport;
+} ScreenCamera;
+
+ScreenCamera screen_camera(mat4_t mvp, vec4_t viewport);
+
+// out[i] = project(points[i]), window x and y in pixels and depth in [0, 1].
+// `out` may be `points`.
+void screen_project_points(const ScreenCamera *camera, const vec3_t *points,
+                           vec3_t *out, int32_t count);
+
+// out[i] = unproject(win[i]). `out` may be `win`.
+void screen_unproject_points(const ScreenCamera *camera, const vec3_t *win,
+                             vec3_t *out, int32_t count);
+
+// Rays through pixel positions, starting on the near plane with unit
+// directions towards the far plane.
+void screen_pick_rays(const ScreenCamera *camera, const vec2_t *pixels,
+                      vec3_t *origins, vec3_t *directions, int32_t count);
+
+// Pixel rectangles (min x, min y, max x, max y) around the projections of the
+// boxes [mins[i], maxs[i]], not clipped to the viewport. A box with a corner at
+// or behind the eye plane has no finite projection and gets the whole viewport.
+void screen_bounds_aabbs(const ScreenCamera *camera, const vec3_t *mins,
+                         const vec3_t *maxs, vec4_t *out, int32_t count);
+
+#endif /* _SCREEN_SPACE_H_ */
+
+#ifdef _SCREEN_SPACE_IMPLEMENTATION_
+
+#include <math.h>
+
+typedef struct screen_space__job {
+  const ScreenCamera *camera;
+  const vec3_t *in;
+  const vec3_t *maxs;
+  const vec2_t *pixels;
+  vec3_t *out;
+  vec3_t *directions;
+  vec4_t *rects;
+} screen_space__job;
+
+ScreenCamera screen_camera(mat4_t mvp, vec4_t viewport) {
+  ScreenCamera camera;
+  camera.mvp = mvp;
+  camera.inverse_mvp = mat4_inverse(mvp);
+  camera.viewport = viewport;
+  return camera;
+}
+
+static void screen_space__project_range(void *user, int32_t begin, int32_t end,
+                                        int32_t worker) {
+  (void)worker;
+  const screen_space__job *job = (const screen_space__job *)user;
+  project_batch(job->camera->mvp, job->camera->viewport, job->in + begin,
+                job->out + begin, end - begin);
+}
+
+static void screen_space__unproject_range(void *user, int32_t begin,
+                                          int32_t end, int32_t worker) {
+  (void)worker;
+  const screen_space__job *job = (const screen_space__job *)user;
+  unproject_batch(job->camera->inverse_mvp, job->camera->viewport,
+                  job->in + begin, job->out + begin, end - begin);
+}
+
+static void screen_space__ray_range(void *user, int32_t begin, int32_t end,
+                                    int32_t worker) {
+  (void)worker;
+  const screen_space__job *job = (const screen_space__job *)user;
+  vec3_t near_win[SCREEN_SPACE_TILE];
+  vec3_t far_win[SCREEN_SPACE_TILE];
+  for (int32_t first = begin; first < end; first += SCREEN_SPACE_TILE) {
+    const int32_t count =
+        end - first < SCREEN_SPACE_TILE ? end - first : SCREEN_SPACE_TILE;
+    for (int32_t i = 0; i < count; ++i) {
+      const vec2_t p = job->pixels[first + i];
+      near_win[i] = vec3(p.x, p.y, 0.0f);
+      far_win[i] = vec3(p.x, p.y, 1.0f);
+    }
+    unproject_batch(job->camera->inverse_mvp, job->camera->viewport, near_win,
+                    near_win, count);
+    unproject_batch(job->camera->inverse_mvp, job->camera->viewport, far_win,
+                    far_win, count);
+    for (int32_t i = 0; i < count; ++i) {
+      job->out[first + i] = near_win[i];
+      far_win[i] = vec3_sub(far_win[i], near_win[i]);
+    }
+    vec3_normalize_batch(far_win, job->directions + first, count);
+  }
+}
+
+static void screen_space__bounds_range(void *user, int32_t begin, int32_t end,
+                                       int32_t worker) {
+  (void)worker;
+  const screen_space__job *job = (const screen_space__job *)user;
+  const mat4_t m = job->camera->mvp;
+  const vec4_t viewport = job->camera->viewport;
+  const vec4_t whole = vec4(viewport.x, viewport.y, viewport.x + viewport.z,
+                            viewport.y + viewport.w);
+  vec3_t corners[SCREEN_SPACE_TILE];
+  for (int32_t first = begin; first < end; first += SCREEN_SPACE_TILE / 8) {
+    const int32_t count = end - first < SCREEN_SPACE_TILE / 8
+                              ? end - first
+                              : SCREEN_SPACE_TILE / 8;
+    for (int32_t i = 0; i < count; ++i) {
+      const vec3_t lo = job->in[first + i];
+      const vec3_t hi = job->maxs[first + i];
+      for (int32_t c = 0; c < 8; ++c) {
+        corners[8 * i + c] =
+            vec3(c & 1 ? hi.x : lo.x, c & 2 ? hi.y : lo.y, c & 4 ? hi.z : lo.z);
+      }
+    }
+    project_batch(m, viewport, corners, corners, 8 * count);
+    for (int32_t i = 0; i < count; ++i) {
+      const vec3_t lo = job->in[first + i];
+      const vec3_t hi = job->maxs[first + i];
+      // The clip w of the corners, the projection of one at or behind the eye
+      // plane is mirrored and the rectangle of the rest would be too small
+      int32_t behind = 0;
+      for (int32_t c = 0; c < 8; ++c) {
+        const float w = m.data[3] * (c & 1 ? hi.x : lo.x) +
+                        m.data[7] * (c & 2 ? hi.y : lo.y) +
+                        m.data[11] * (c & 4 ? hi.z : lo.z) + m.data[15];
+        behind |= !(w > 0.0f);
+      }
+      if (behind) {
+        job->rects[first + i] = whole;
+        continue;
+      }
+      vec4_t rect = vec4(INFINITY, INFINITY, -INFINITY, -INFINITY);
+      for (int32_t c = 0; c < 8; ++c) {
+        const vec3_t p = corners[8 * i + c];
+        rect.x = p.x < rect.x ? p.x : rect.x;
+        rect.y = p.y < rect.y ? p.y : rect.y;
+        rect.z = p.x > rect.z ? p.x : rect.z;
+        rect.w = p.y > rect.w ? p.y : rect.w;
+      }
+      job->rects[first + i] = rect;
+    }
+  }
+}
+
+void screen_project_points(const ScreenCamera *camera, const vec3_t *points,
+                           vec3_t *out, int32_t count) {
+  screen_space__job job = {0};
+  job.camera = camera;
+  job.in = points;
+  job.out = out;
+  par_for(count, SCREEN_SPACE_GRAIN, screen_space__project_range, &job);
+}
+
+void screen_unproject_points(const ScreenCamera *camera, const vec3_t *win,
+                             vec3_t *out, int32_t count) {
+  screen_space__job job = {0};
+  job.camera = camera;
+  job.in = win;
+  job.out = out;
+  par_for(count, SCREEN_SPACE_GRAIN, screen_space__unproject_range, &job);
+}
+
+void screen_pick_rays(const ScreenCamera *camera, const vec2_t *pixels,
+                      vec3_t *origins, vec3_t *directions, int32_t count) {
+  screen_space__job job = {0};
+  job.camera = camera;
+  job.pixels = pixels;
+  job.out = origins;
+  job.directions = directions;
+  par_for(count, SCREEN_SPACE_GRAIN, screen_space__ray_range, &job);
+}
+
+void screen_bounds_aabbs(const ScreenCamera *camera, const vec3_t *mins,
+                         const vec3_t *maxs, vec4_t *out, int32_t count) {
+  screen_space__job job = {0};
+  job.camera = camera;
+  job.in = mins;
+  job.maxs = maxs;
+  job.rects = out;
+  par_for(count, SCREEN_SPACE_BOX_GRAIN, screen_space__bounds_range, &job);
+}
+
+#endif /* _SCREEN_SPACE_IMPLEMENTATION_ */
@@ -0,0 +1,234 @@
+#ifndef _SCULPT_H_
+#define _SCULPT_H_
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Expects vec_math.h, mesh.h, parallel.h, mesh_topology.h and bvh.h to be
+// included first.
+
+#define SCULPT_MAX_VALENCE 64
+// Dirty vertex runs closer than this many vertices merge into one upload
+#define SCULPT_RANGE_GAP 32
+
+typedef struct SculptBrush {
+  float radius;   // model units
+  float strength; // displacement at the brush center per dab, negative carves
+} SculptBrush;
+
+// Scratch and results of the last dab. Every list is sized for the whole mesh
+// once, so a dab never allocates and only touches what the brush reaches.
+typedef struct Sculptor {
+  uint32_t *moved;     // vertices displaced by the last dab
+  uint32_t *triangles; // triangles around them, refit in the BVH
+  uint32_t *shaded;    // vertices of those triangles, normals recomputed
+  int32_t moved_count;
+  int32_t triangle_count;
+  int32_t shaded_count;
+
+  // Vertex ranges [begin, end) covering `shaded`, sorted and merged, ready
+  // to be uploaded with glBufferSubData
+  int32_t (*ranges)[2];
+  int32_t range_count;
+
+  uint32_t *vertex_mark; // per vertex and triangle stamps of the current pass
+  uint32_t *triangle_mark;
+  uint32_t stamp;
+} Sculptor;
+
+int32_t sculptor_create(Sculptor *sculptor, const MeshData *mesh);
+void sculptor_destroy(Sculptor *sculptor);
+
+// One brush dab at `center` on `triangle` (usually a BVH hit). Walks the
+// connected vertices within the brush radius, pushes them along their
+// average normal with a smooth falloff, recomputes the normals of the
+// vertices around them and refits the BVH over the triangles they touch.
+// Returns the number of moved vertices.
+int32_t sculpt_dab(Sculptor *sculptor, MeshData *mesh,
+                   const MeshTopology *topology, Bvh *bvh, vec3_t center,
+                   uint32_t triangle, const SculptBrush *brush);
+
+#endif /* _SCULPT_H_ */
+
+#ifdef _SCULPT_IMPLEMENTATION_
+
+static float *sculpt__position(MeshData *mesh, uint32_t vertex) {
+  return (float *)((char *)mesh->vertex_data + (size_t)vertex * mesh->vertex_size +
+                   mesh->positions_offset);
+}
+
+static float *sculpt__normal(MeshData *mesh, uint32_t vertex) {
+  return (float *)((char *)mesh->vertex_data + (size_t)vertex * mesh->vertex_size +
+                   mesh->normals_offset);
+}
+
+// Fresh stamp, clearing the marks once the counter wraps.
+static uint32_t sculpt__next_stamp(Sculptor *sculptor, const MeshData *mesh) {
+  if (++sculptor->stamp == 0) {
+    memset(sculptor->vertex_mark, 0, (size_t)mesh->vertex_count * sizeof(uint32_t));
+    memset(sculptor->triangle_mark, 0, (size_t)mesh->triangle_count * sizeof(uint32_t));
+    sculptor->stamp = 1;
+  }
+  return sculptor->stamp;
+}
+
+static int sculpt__compare_u32(const void *a, const void *b) {
+  const uint32_t x = *(const uint32_t *)a;
+  const uint32_t y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+int32_t sculptor_create(Sculptor *sculptor, const MeshData *mesh) {
+  memset(sculptor, 0, sizeof(*sculptor));
+  const size_t v = (size_t)mesh->vertex_count;
+  const size_t t = (size_t)mesh->triangle_count;
+  sculptor->moved = (uint32_t *)malloc(v * sizeof(uint32_t));
+  sculptor->shaded = (uint32_t *)malloc(v * sizeof(uint32_t));
+  sculptor->triangles = (uint32_t *)malloc(t * sizeof(uint32_t));
+  sculptor->ranges = (int32_t(*)[2])malloc(v * sizeof(*sculptor->ranges));
+  sculptor->vertex_mark = (uint32_t *)calloc(v, sizeof(uint32_t));
+  sculptor->triangle_mark = (uint32_t *)calloc(t, sizeof(uint32_t));
+  if (!sculptor->moved || !sculptor->shaded || !sculptor->triangles ||
+      !sculptor->ranges || !sculptor->vertex_mark || !sculptor->triangle_mark) {
+    sculptor_destroy(sculptor);
+    return EXIT_FAILURE;
+  }
+  return 0;
+}
+
+void sculptor_destroy(Sculptor *sculptor) {
+  free(sculptor->moved);
+  free(sculptor->shaded);
+  free(sculptor->triangles);
+  free(sculptor->ranges);
+  free(sculptor->vertex_mark);
+  free(sculptor->triangle_mark);
+  memset(sculptor, 0, sizeof(*sculptor));
+}
+
+int32_t sculpt_dab(Sculptor *sculptor, MeshData *mesh,
+                   const MeshTopology *topology, Bvh *bvh, vec3_t center,
+                   uint32_t triangle, const SculptBrush *brush) {
+  const float radius_sq = brush->radius * brush->radius;
+  uint32_t ring[SCULPT_MAX_VALENCE];
+  sculptor->moved_count = 0;
+  sculptor->triangle_count = 0;
+  sculptor->shaded_count = 0;
+  sculptor->range_count = 0;
+
+  // Flood the brush region from the hit triangle over one-rings, so parts of
+  // the mesh that are close in space but not connected stay untouched
+  uint32_t stamp = sculpt__next_stamp(sculptor, mesh);
+  for (int32_t c = 0; c < 3; ++c) {
+    const uint32_t vertex = mesh->triangles[3 * (size_t)triangle + c];
+    if (sculptor->vertex_mark[vertex] != stamp) {
+      sculptor->vertex_mark[vertex] = stamp;
+      sculptor->moved[sculptor->moved_count++] = vertex;
+    }
+  }
+  vec3_t direction = vec3(0.0f, 0.0f, 0.0f);
+  for (int32_t i = 0; i < sculptor->moved_count; ++i) {
+    const uint32_t vertex = sculptor->moved[i];
+    const float *n = sculpt__normal(mesh, vertex);
+    direction = vec3_add(direction, vec3(n[0], n[1], n[2]));
+    int32_t valence = mesh_vertex_one_ring(topology, vertex, ring, SCULPT_MAX_VALENCE);
+    valence = valence < SCULPT_MAX_VALENCE ? valence : SCULPT_MAX_VALENCE;
+    for (int32_t r = 0; r < valence; ++r) {
+      const float *p = sculpt__position(mesh, ring[r]);
+      if (sculptor->vertex_mark[ring[r]] != stamp &&
+          vec3_norm_sq(vec3_sub(vec3(p[0], p[1], p[2]), center)) <= radius_sq) {
+        sculptor->vertex_mark[ring[r]] = stamp;
+        sculptor->moved[sculptor->moved_count++] = ring[r];
+      }
+    }
+  }
+  if (vec3_norm_sq(direction) <= 0.0f) {
+    return 0;
+  }
+  direction = vec3_normalize(direction);
+
+  // Displace with a smooth (1 - d^2 / r^2)^2 falloff
+  for (int32_t i = 0; i < sculptor->moved_count; ++i) {
+    float *p = sculpt__position(mesh, sculptor->moved[i]);
+    float d_sq = vec3_norm_sq(vec3_sub(vec3(p[0], p[1], p[2]), center));
+    float falloff = fmaxf(0.0f, 1.0f - d_sq / radius_sq);
+    float offset = brush->strength * falloff * falloff;
+    p[0] += direction.x * offset;
+    p[1] += direction.y * offset;
+    p[2] += direction.z * offset;
+  }
+
+  // Triangles around the moved vertices, and every vertex of those
+  const uint32_t triangle_stamp = sculpt__next_stamp(sculptor, mesh);
+  for (int32_t i = 0; i < sculptor->moved_count; ++i) {
+    const int32_t start = topology->vertex_halfedge[sculptor->moved[i]];
+    int32_t he = start;
+    while (he >= 0) {
+      const int32_t face = mesh_he_face(he);
+      if (sculptor->triangle_mark[face] != triangle_stamp) {
+        sculptor->triangle_mark[face] = triangle_stamp;
+        sculptor->triangles[sculptor->triangle_count++] = (uint32_t)face;
+        for (int32_t c = 0; c < 3; ++c) {
+          const uint32_t vertex = mesh->triangles[3 * (size_t)face + c];
+          if (sculptor->vertex_mark[vertex] != triangle_stamp) {
+            sculptor->vertex_mark[vertex] = triangle_stamp;
+            sculptor->shaded[sculptor->shaded_count++] = vertex;
+          }
+        }
+      }
+      he = mesh_he_rotate_ccw(topology, he);
+      if (he == start) {
+        break;
+      }
+    }
+  }
+
+  // Area weighted face normals over each full fan
+  for (int32_t i = 0; i < sculptor->shaded_count; ++i) {
+    const uint32_t vertex = sculptor->shaded[i];
+    const int32_t start = topology->vertex_halfedge[vertex];
+    vec3_t sum = vec3(0.0f, 0.0f, 0.0f);
+    int32_t he = start;
+    while (he >= 0) {
+      const uint32_t *tri = &mesh->triangles[3 * (size_t)mesh_he_face(he)];
+      const float *a = sculpt__position(mesh, tri[0]);
+      const float *b = sculpt__position(mesh, tri[1]);
+      const float *c = sculpt__position(mesh, tri[2]);
+      sum = vec3_add(sum, vec3_cross(vec3(b[0] - a[0], b[1] - a[1], b[2] - a[2]),
+                                     vec3(c[0] - a[0], c[1] - a[1], c[2] - a[2])));
+      he = mesh_he_rotate_ccw(topology, he);
+      if (he == start) {
+        break;
+      }
+    }
+    if (vec3_norm_sq(sum) > 0.0f) {
+      sum = vec3_normalize(sum);
+      float *n = sculpt__normal(mesh, vertex);
+      n[0] = sum.x;
+      n[1] = sum.y;
+      n[2] = sum.z;
+    }
+  }
+
+  bvh_refit(bvh, mesh, sculptor->triangles, sculptor->triangle_count);
+
+  // Sorted shaded vertices, merged into runs where the gaps are small
+  qsort(sculptor->shaded, (size_t)sculptor->shaded_count, sizeof(uint32_t),
+        sculpt__compare_u32);
+  for (int32_t i = 0; i < sculptor->shaded_count; ++i) {
+    const int32_t vertex = (int32_t)sculptor->shaded[i];
+    int32_t(*last)[2] = sculptor->ranges + sculptor->range_count - 1;
+    if (sculptor->range_count > 0 && vertex - (*last)[1] <= SCULPT_RANGE_GAP) {
+      (*last)[1] = vertex + 1;
+    } else {
+      sculptor->ranges[sculptor->range_count][0] = vertex;
+      sculptor->ranges[sculptor->range_count][1] = vertex + 1;
+      sculptor->range_count++;
+    }
+  }
+  return sculptor->moved_count;
+}
+
+#endif /* _SCULPT_IMPLEMENTATION_ */
@@ -0,0 +1,458 @@
+#ifndef _SUBDIVISION_H_
+#define _SUBDIVISION_H_
+
+#include <stdint.h>
+
+// Expects vec_math.h, mesh.h, parallel.h and mesh_topology.h to be included
+// first.
+
+typedef struct LoopSubdivParams {
+  mat4_t mvp;             // model space -> clip space of the close-up view
+  vec2_t viewport;        // viewport size in pixels
+  float max_edge_pixels;  // refine if the longest projected edge is longer
+  float max_normal_angle; // refine if vertex normals diverge more (radians)
+  float min_edge_pixels;  // never refine triangles smaller than this
+  int32_t max_levels;
+} LoopSubdivParams;
+
+// Adaptive Loop subdivision. Every level marks triangles by projected edge
+// length or normal deviation, closes the marking red-green style (faces with two
+// or more split edges are split fully, faces with one are bisected) so the
+// result stays watertight, and applies the Loop masks to new edge vertices and
+// to old vertices touching a split edge. Marking, closure, scans, vertex rules
+// and triangle emission all run with par_for over contiguous face and vertex
+// ranges.
+//
+// Positions, normals and baked AO (when the mesh has it) all go through the
+// same Loop weights, normals are renormalized.
+//
+// Output goes into two ping-pong meshes allocated up front for `max_vertices`
+// and `max_triangles` in the vertex layout of the mesh passed to
+// loop_subdiv_create, which refined meshes must share. The topology of every intermediate level into one
+// scratch of the same size. A level splits every triangle at most into four,
+// so base counts times 4^max_levels always fit. A level that would exceed
+// smaller buffers is not applied and sets `capacity_reached`.
+typedef struct LoopSubdivider {
+  int32_t max_vertices;
+  int32_t max_triangles;
+  MeshData buffers[2];
+  const MeshData *result; // base mesh or one of `buffers`
+  int32_t levels_applied;
+  int32_t capacity_reached;
+  MeshTopologyScratch topology;
+
+  // Scratch sized for max_triangles
+  uint8_t *face_refine;
+  uint8_t *edge_split;
+  int32_t *edge_vertex; // per half-edge, new vertex index of the split edge
+  int32_t *face_offset; // per face, first output triangle
+} LoopSubdivider;
+
+int32_t loop_subdiv_create(LoopSubdivider *subdiv, const MeshData *layout,
+                           int32_t max_vertices, int32_t max_triangles);
+void loop_subdiv_destroy(LoopSubdivider *subdiv);
+
+// Refines `base` and returns the number of levels applied. The refined mesh is
+// `subdiv->result` and stays valid until the next call.
+int32_t loop_subdiv_refine(LoopSubdivider *subdiv, const MeshData *base,
+                           const MeshTopology *base_topology,
+                           const LoopSubdivParams *params);
+
+#endif /* _SUBDIVISION_H_ */
+
+#ifdef _SUBDIVISION_IMPLEMENTATION_
+
+typedef struct loop__job {
+  LoopSubdivider *subdiv;
+  const LoopSubdivParams *params;
+  const MeshData *src;
+  const MeshTopology *topology;
+  MeshData *dst;
+  int32_t changed[PAR_MAX_WORKERS];
+} loop__job;
+
+// The interpolated attributes of one vertex, `ao` stays 0 without baked AO
+typedef struct loop__vertex {
+  vec3_t p;
+  vec3_t n;
+  float ao;
+} loop__vertex;
+
+static vec3_t loop__position(const MeshData *mesh, uint32_t v) {
+  const float *p = mesh->vertex_data +
+                   (v * mesh->vertex_size + mesh->positions_offset) / sizeof(float);
+  return vec3(p[0], p[1], p[2]);
+}
+
+static vec3_t loop__normal(const MeshData *mesh, uint32_t v) {
+  const float *n = mesh->vertex_data +
+                   (v * mesh->vertex_size + mesh->normals_offset) / sizeof(float);
+  return vec3(n[0], n[1], n[2]);
+}
+
+static loop__vertex loop__load(const MeshData *mesh, uint32_t v) {
+  loop__vertex out;
+  out.p = loop__position(mesh, v);
+  out.n = loop__normal(mesh, v);
+  out.ao = mesh->ao_size
+               ? mesh->vertex_data[(v * mesh->vertex_size + mesh->ao_offset) / sizeof(float)]
+               : 0.0f;
+  return out;
+}
+
+static loop__vertex loop__add(loop__vertex a, loop__vertex b) {
+  a.p = vec3_add(a.p, b.p);
+  a.n = vec3_add(a.n, b.n);
+  a.ao += b.ao;
+  return a;
+}
+
+static loop__vertex loop__scale(loop__vertex a, float s) {
+  a.p = vec3_scalar_mul(a.p, s);
+  a.n = vec3_scalar_mul(a.n, s);
+  a.ao *= s;
+  return a;
+}
+
+static void loop__store(MeshData *mesh, uint32_t v, loop__vertex vertex) {
+  float *p = mesh->vertex_data + (v * mesh->vertex_size + mesh->positions_offset) / sizeof(float);
+  float *n = mesh->vertex_data + (v * mesh->vertex_size + mesh->normals_offset) / sizeof(float);
+  float len = vec3_norm(vertex.n);
+  float inv = len > 0.0f ? 1.0f / len : 0.0f;
+  p[0] = vertex.p.x;
+  p[1] = vertex.p.y;
+  p[2] = vertex.p.z;
+  n[0] = vertex.n.x * inv;
+  n[1] = vertex.n.y * inv;
+  n[2] = vertex.n.z * inv;
+  if (mesh->ao_size) {
+    mesh->vertex_data[(v * mesh->vertex_size + mesh->ao_offset) / sizeof(float)] = vertex.ao;
+  }
+}
+
+static int32_t loop__canonical(const MeshTopology *topology, int32_t he) {
+  int32_t twin = topology->twin[he];
+  return (twin < 0 || he < twin) ? he : twin;
+}
+
+static void loop__mark(void *user, int32_t begin, int32_t end, int32_t worker) {
+  loop__job *job = (loop__job *)user;
+  const LoopSubdivParams *params = job->params;
+  (void)worker;
+  for (int32_t face = begin; face < end; ++face) {
+    vec2_t screen[3];
+    vec3_t normal[3];
+    int32_t visible = 1;
+    for (int32_t c = 0; c < 3; ++c) {
+      uint32_t v = job->src->triangles[3 * face + c];
+      vec3_t p = loop__position(job->src, v);
+      vec4_t clip = mat4_vec4_mul(params->mvp, vec3_to_vec4(p, 1.0f));
+      if (clip.w <= 0.0f) {
+        visible = 0;
+        break;
+      }
+      screen[c] = vec2(clip.x / clip.w * 0.5f * params->viewport.x,
+                       clip.y / clip.w * 0.5f * params->viewport.y);
+      normal[c] = loop__normal(job->src, v);
+    }
+    uint8_t refine = 0;
+    if (visible) {
+      float edge = 0.0f;
+      float cos_min = 1.0f;
+      for (int32_t c = 0; c < 3; ++c) {
+        float len = vec2_norm(vec2_sub(screen[c], screen[(c + 1) % 3]));
+        edge = len > edge ? len : edge;
+        float cos_angle = vec3_dot(normal[c], normal[(c + 1) % 3]);
+        cos_min = cos_angle < cos_min ? cos_angle : cos_min;
+      }
+      if (edge >= params->min_edge_pixels) {
+        refine = (params->max_edge_pixels > 0.0f && edge > params->max_edge_pixels) ||
+                 (params->max_normal_angle > 0.0f &&
+                  cos_min < cosf(params->max_normal_angle));
+      }
+    }
+    job->subdiv->face_refine[face] = refine;
+  }
+}
+
+static void loop__split_edges(void *user, int32_t begin, int32_t end,
+                              int32_t worker) {
+  loop__job *job = (loop__job *)user;
+  const MeshTopology *topology = job->topology;
+  (void)worker;
+  for (int32_t he = begin; he < end; ++he) {
+    int32_t twin = topology->twin[he];
+    uint8_t split = 0;
+    if (twin < 0 || he < twin) {
+      split = job->subdiv->face_refine[he / 3] ||
+              (twin >= 0 && job->subdiv->face_refine[twin / 3]);
+    }
+    job->subdiv->edge_split[he] = split;
+    job->subdiv->edge_vertex[he] = split;
+  }
+}
+
+static void loop__close(void *user, int32_t begin, int32_t end, int32_t worker) {
+  loop__job *job = (loop__job *)user;
+  for (int32_t face = begin; face < end; ++face) {
+    if (job->subdiv->face_refine[face]) {
+      continue;
+    }
+    int32_t split = 0;
+    for (int32_t c = 0; c < 3; ++c) {
+      split += job->subdiv->edge_split[loop__canonical(job->topology, 3 * face + c)];
+    }
+    if (split >= 2) {
+      job->subdiv->face_refine[face] = 1;
+      job->changed[worker]++;
+    }
+  }
+}
+
+static void loop__count(void *user, int32_t begin, int32_t end, int32_t worker) {
+  loop__job *job = (loop__job *)user;
+  (void)worker;
+  for (int32_t face = begin; face < end; ++face) {
+    int32_t split = 0;
+    for (int32_t c = 0; c < 3; ++c) {
+      split += job->subdiv->edge_split[loop__canonical(job->topology, 3 * face + c)];
+    }
+    // 0 -> untouched, 1 -> green bisection, 3 -> red 1:4 split
+    job->subdiv->face_offset[face] = split == 0 ? 1 : (split == 1 ? 2 : 4);
+  }
+}
+
+static void loop__edge_vertices(void *user, int32_t begin, int32_t end,
+                                int32_t worker) {
+  loop__job *job = (loop__job *)user;
+  const MeshTopology *topology = job->topology;
+  const MeshData *src = job->src;
+  (void)worker;
+  for (int32_t he = begin; he < end; ++he) {
+    if (!job->subdiv->edge_split[he]) {
+      continue;
+    }
+    uint32_t a = mesh_he_origin(topology, he);
+    uint32_t b = mesh_he_target(topology, he);
+    loop__vertex ab = loop__add(loop__load(src, a), loop__load(src, b));
+    int32_t twin = topology->twin[he];
+    if (twin >= 0) {
+      uint32_t c = mesh_he_origin(topology, mesh_he_prev(he));
+      uint32_t d = mesh_he_origin(topology, mesh_he_prev(twin));
+      loop__vertex cd = loop__add(loop__load(src, c), loop__load(src, d));
+      ab = loop__add(loop__scale(ab, 0.375f), loop__scale(cd, 0.125f));
+    } else {
+      ab = loop__scale(ab, 0.5f);
+    }
+    loop__store(job->dst, (uint32_t)(src->vertex_count + job->subdiv->edge_vertex[he]), ab);
+  }
+}
+
+static void loop__old_vertices(void *user, int32_t begin, int32_t end,
+                               int32_t worker) {
+  loop__job *job = (loop__job *)user;
+  const MeshTopology *topology = job->topology;
+  const MeshData *src = job->src;
+  (void)worker;
+  for (int32_t v = begin; v < end; ++v) {
+    loop__vertex self = loop__load(src, v);
+    int32_t start = topology->vertex_halfedge[v];
+    if (start < 0) {
+      loop__store(job->dst, v, self);
+      continue;
+    }
+
+    // Walk the fan once: valence, neighbour sums and whether any incident
+    // edge was split (only those vertices move).
+    loop__vertex sum = {0}, boundary_sum = {0};
+    int32_t valence = 0, touched = 0, boundary = 0;
+    int32_t he = start;
+    do {
+      loop__vertex u = loop__load(src, mesh_he_target(topology, he));
+      sum = loop__add(sum, u);
+      touched |= job->subdiv->edge_split[loop__canonical(topology, he)];
+      valence++;
+      if (he == start && topology->twin[he] < 0) {
+        boundary_sum = u;
+      }
+      int32_t next = mesh_he_rotate_ccw(topology, he);
+      if (next < 0) {
+        int32_t prev = mesh_he_prev(he);
+        uint32_t w = mesh_he_origin(topology, prev);
+        touched |= job->subdiv->edge_split[loop__canonical(topology, prev)];
+        boundary_sum = loop__add(boundary_sum, loop__load(src, w));
+        boundary = 1;
+        break;
+      }
+      he = next;
+    } while (he != start && valence <= topology->triangle_count);
+
+    if (!touched) {
+      loop__store(job->dst, v, self);
+    } else if (boundary) {
+      loop__store(job->dst, v,
+                  loop__add(loop__scale(self, 0.75f), loop__scale(boundary_sum, 0.125f)));
+    } else {
+      float beta = valence == 3 ? 3.0f / 16.0f : 3.0f / (8.0f * valence);
+      loop__store(job->dst, v,
+                  loop__add(loop__scale(self, 1.0f - valence * beta), loop__scale(sum, beta)));
+    }
+  }
+}
+
+static void loop__emit(void *user, int32_t begin, int32_t end, int32_t worker) {
+  loop__job *job = (loop__job *)user;
+  const MeshTopology *topology = job->topology;
+  const uint32_t base = (uint32_t)job->src->vertex_count;
+  (void)worker;
+  for (int32_t face = begin; face < end; ++face) {
+    uint32_t *out = job->dst->triangles + 3 * job->subdiv->face_offset[face];
+    uint32_t v[3];
+    int32_t mid[3];
+    int32_t split = 0, split_corner = 0;
+    for (int32_t c = 0; c < 3; ++c) {
+      int32_t edge = loop__canonical(topology, 3 * face + c);
+      v[c] = job->src->triangles[3 * face + c];
+      mid[c] = job->subdiv->edge_split[edge] ? (int32_t)(base + job->subdiv->edge_vertex[edge]) : -1;
+      if (mid[c] >= 0) {
+        split++;
+        split_corner = c;
+      }
+    }
+    if (split == 0) {
+      memcpy(out, v, sizeof(v));
+    } else if (split == 1) {
+      uint32_t a = v[split_corner];
+      uint32_t b = v[(split_corner + 1) % 3];
+      uint32_t c = v[(split_corner + 2) % 3];
+      uint32_t m = (uint32_t)mid[split_corner];
+      const uint32_t tris[6] = {a, m, c, m, b, c};
+      memcpy(out, tris, sizeof(tris));
+    } else {
+      uint32_t m0 = (uint32_t)mid[0];
+      uint32_t m1 = (uint32_t)mid[1];
+      uint32_t m2 = (uint32_t)mid[2];
+      const uint32_t tris[12] = {v[0], m0, m2, m0, v[1], m1,
+                                 m2,   m1, v[2], m0, m1, m2};
+      memcpy(out, tris, sizeof(tris));
+    }
+  }
+}
+
+int32_t loop_subdiv_create(LoopSubdivider *subdiv, const MeshData *layout,
+                           int32_t max_vertices, int32_t max_triangles) {
+  memset(subdiv, 0, sizeof(*subdiv));
+  subdiv->max_vertices = max_vertices;
+  subdiv->max_triangles = max_triangles;
+  for (int32_t i = 0; i < 2; ++i) {
+    MeshData *buffer = &subdiv->buffers[i];
+    buffer->vertex_size = layout->vertex_size;
+    buffer->positions_size = layout->positions_size;
+    buffer->positions_offset = layout->positions_offset;
+    buffer->normals_size = layout->normals_size;
+    buffer->normals_offset = layout->normals_offset;
+    buffer->ao_size = layout->ao_size;
+    buffer->ao_offset = layout->ao_offset;
+    buffer->vertex_data = (float *)malloc((size_t)max_vertices * buffer->vertex_size);
+    buffer->triangles = (uint32_t *)malloc((size_t)max_triangles * 3 * sizeof(uint32_t));
+  }
+  subdiv->face_refine = (uint8_t *)malloc((size_t)max_triangles);
+  subdiv->edge_split = (uint8_t *)malloc((size_t)max_triangles * 3);
+  subdiv->edge_vertex = (int32_t *)malloc((size_t)max_triangles * 3 * sizeof(int32_t));
+  subdiv->face_offset = (int32_t *)malloc((size_t)max_triangles * sizeof(int32_t));
+  int32_t topology_failed =
+      mesh_topology_scratch_create(&subdiv->topology, max_vertices, max_triangles);
+  if (!subdiv->buffers[0].vertex_data || !subdiv->buffers[0].triangles ||
+      !subdiv->buffers[1].vertex_data || !subdiv->buffers[1].triangles ||
+      !subdiv->face_refine || !subdiv->edge_split || !subdiv->edge_vertex ||
+      !subdiv->face_offset || topology_failed) {
+    loop_subdiv_destroy(subdiv);
+    return EXIT_FAILURE;
+  }
+  return 0;
+}
+
+void loop_subdiv_destroy(LoopSubdivider *subdiv) {
+  for (int32_t i = 0; i < 2; ++i) {
+    free(subdiv->buffers[i].vertex_data);
+    free(subdiv->buffers[i].triangles);
+  }
+  free(subdiv->face_refine);
+  free(subdiv->edge_split);
+  free(subdiv->edge_vertex);
+  free(subdiv->face_offset);
+  mesh_topology_scratch_destroy(&subdiv->topology);
+  memset(subdiv, 0, sizeof(*subdiv));
+}
+
+int32_t loop_subdiv_refine(LoopSubdivider *subdiv, const MeshData *base,
+                           const MeshTopology *base_topology,
+                           const LoopSubdivParams *params) {
+  subdiv->result = base;
+  subdiv->levels_applied = 0;
+  subdiv->capacity_reached = 0;
+
+  const MeshData *src = base;
+  const MeshTopology *topology = base_topology;
+  MeshTopology level_topology = {0};
+
+  for (int32_t level = 0; level < params->max_levels; ++level) {
+    if (src->triangle_count > subdiv->max_triangles) {
+      subdiv->capacity_reached = 1;
+      break;
+    }
+    loop__job job = {0};
+    job.subdiv = subdiv;
+    job.params = params;
+    job.src = src;
+    job.topology = topology;
+    job.dst = &subdiv->buffers[level & 1];
+
+    const int32_t face_count = src->triangle_count;
+    const int32_t halfedge_count = 3 * face_count;
+    par_for(face_count, 4096, loop__mark, &job);
+
+    int32_t changed = 0;
+    do {
+      par_for(halfedge_count, 8192, loop__split_edges, &job);
+      memset(job.changed, 0, sizeof(job.changed));
+      par_for(face_count, 4096, loop__close, &job);
+      changed = 0;
+      for (int32_t w = 0; w < PAR_MAX_WORKERS; ++w) {
+        changed += job.changed[w];
+      }
+    } while (changed);
+
+    int32_t new_vertices = par_exclusive_scan(subdiv->edge_vertex, halfedge_count);
+    if (new_vertices == 0) {
+      break;
+    }
+    par_for(face_count, 4096, loop__count, &job);
+    int32_t new_triangles = par_exclusive_scan(subdiv->face_offset, face_count);
+    if (src->vertex_count + new_vertices > subdiv->max_vertices ||
+        new_triangles > subdiv->max_triangles) {
+      subdiv->capacity_reached = 1;
+      break;
+    }
+
+    job.dst->vertex_count = src->vertex_count + new_vertices;
+    job.dst->triangle_count = new_triangles;
+    par_for(halfedge_count, 8192, loop__edge_vertices, &job);
+    par_for(src->vertex_count, 4096, loop__old_vertices, &job);
+    par_for(face_count, 4096, loop__emit, &job);
+
+    src = job.dst;
+    subdiv->result = src;
+    subdiv->levels_applied++;
+
+    if (level + 1 < params->max_levels) {
+      if (mesh_topology_build_scratch(src, &subdiv->topology, &level_topology)) {
+        break;
+      }
+      topology = &level_topology;
+    }
+  }
+  return subdiv->levels_applied;
+}
+
+#endif /* _SUBDIVISION_IMPLEMENTATION_ */
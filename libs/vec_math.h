@@ -1,6 +1,28 @@
 #ifndef _VEC_MATH_H_
 #define _VEC_MATH_H_
 
+// SIMD backend of the mat4 and vec4 kernels, picked at compile time from the
+// target: AVX (mat4_mul_batch two columns at a time, SSE2 for the rest),
+// SSE2, or NEON. VEC_MATH_NO_SIMD forces the scalar code. The SIMD paths keep
+// the scalar operation order and never fuse multiply-adds, so everything
+// except mat4_inverse matches the scalar path bit for bit. mat4_inverse uses a
+// different cofactor expansion: usually within 1-2 ULP of the scalar result,
+// a few hundred ULP of the largest column element at worst for projective
+// matrices (see vec_math_check.c).
+#if !defined(VEC_MATH_NO_SIMD)
+#if defined(__AVX__)
+#define VEC_MATH_SIMD_AVX 1
+#define VEC_MATH_SIMD_SSE2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VEC_MATH_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define VEC_MATH_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -66,6 +88,148 @@ typedef union mat4 {
   vec4_t col[4];
 } mat4_t;
 
+////////////////////////////////////////////////////////////////////////////////
+//       SIMD HELPERS
+////////////////////////////////////////////////////////////////////////////////
+// One 4-wide register type and the handful of operations the kernels need,
+// so the mat4 and vec4 code is written once for SSE2 and NEON. Part of the
+// header because the pointer variants below are static inline.
+#if defined(VEC_MATH_SIMD_SSE2)
+#define VEC_MATH__SIMD4 1
+typedef __m128 vec_math__v4;
+#define vec_math__load(p) _mm_loadu_ps(p)
+#define vec_math__store(p, v) _mm_storeu_ps((p), (v))
+#define vec_math__splat(s) _mm_set1_ps(s)
+#define vec_math__add(a, b) _mm_add_ps((a), (b))
+#define vec_math__sub(a, b) _mm_sub_ps((a), (b))
+#define vec_math__mul(a, b) _mm_mul_ps((a), (b))
+#define vec_math__div(a, b) _mm_div_ps((a), (b))
+#define vec_math__sqrt(a) _mm_sqrt_ps(a)
+#define vec_math__less(a, b) _mm_cmplt_ps((a), (b))
+#define vec_math__and(a, b) _mm_and_ps((a), (b))
+#define vec_math__bits(a) _mm_movemask_ps(a) // sign bit of lane i in bit i
+
+// Lanes of a where the mask is set, of b elsewhere
+static inline vec_math__v4 vec_math__select(vec_math__v4 mask, vec_math__v4 a,
+                                            vec_math__v4 b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// (y, z, x, w) lane order
+static inline vec_math__v4 vec_math__yzxw(vec_math__v4 a) {
+  return _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+// Sum of the four lanes in every lane
+static inline vec_math__v4 vec_math__hsum(vec_math__v4 a) {
+  a = _mm_add_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_add_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+static inline void vec_math__transpose4(vec_math__v4 r[4]) {
+  _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+}
+
+// Four packed vec3 (12 floats) to and from x, y and z registers
+static inline void vec_math__load3x4(const float *p, vec_math__v4 *x,
+                                     vec_math__v4 *y, vec_math__v4 *z) {
+  const __m128 a0 = _mm_loadu_ps(p);     // x0 y0 z0 x1
+  const __m128 a1 = _mm_loadu_ps(p + 4); // y1 z1 x2 y2
+  const __m128 a2 = _mm_loadu_ps(p + 8); // z2 x3 y3 z3
+  const __m128 x23 = _mm_shuffle_ps(a1, a2, _MM_SHUFFLE(1, 1, 2, 2));
+  const __m128 y01 = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(0, 0, 1, 1));
+  const __m128 y23 = _mm_shuffle_ps(a1, a2, _MM_SHUFFLE(2, 2, 3, 3));
+  const __m128 z01 = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(1, 1, 2, 2));
+  *x = _mm_shuffle_ps(a0, x23, _MM_SHUFFLE(2, 0, 3, 0));
+  *y = _mm_shuffle_ps(y01, y23, _MM_SHUFFLE(2, 0, 2, 0));
+  *z = _mm_shuffle_ps(z01, a2, _MM_SHUFFLE(3, 0, 2, 0));
+}
+
+static inline void vec_math__store3x4(float *p, vec_math__v4 x, vec_math__v4 y,
+                                      vec_math__v4 z) {
+  const __m128 xy0 = _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0));
+  const __m128 zx1 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+  const __m128 yz1 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+  const __m128 xy2 = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2));
+  const __m128 zx3 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));
+  const __m128 yz3 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));
+  _mm_storeu_ps(p, _mm_shuffle_ps(xy0, zx1, _MM_SHUFFLE(2, 0, 2, 0)));
+  _mm_storeu_ps(p + 4, _mm_shuffle_ps(yz1, xy2, _MM_SHUFFLE(2, 0, 2, 0)));
+  _mm_storeu_ps(p + 8, _mm_shuffle_ps(zx3, yz3, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+#elif defined(VEC_MATH_SIMD_NEON)
+#define VEC_MATH__SIMD4 1
+typedef float32x4_t vec_math__v4;
+#define vec_math__load(p) vld1q_f32(p)
+#define vec_math__store(p, v) vst1q_f32((p), (v))
+#define vec_math__splat(s) vdupq_n_f32(s)
+#define vec_math__add(a, b) vaddq_f32((a), (b))
+#define vec_math__sub(a, b) vsubq_f32((a), (b))
+#define vec_math__mul(a, b) vmulq_f32((a), (b))
+#define vec_math__div(a, b) vdivq_f32((a), (b))
+#define vec_math__sqrt(a) vsqrtq_f32(a)
+#define vec_math__less(a, b) vreinterpretq_f32_u32(vcltq_f32((a), (b)))
+#define vec_math__and(a, b)                                                    \
+  vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)))
+
+static inline int vec_math__bits(vec_math__v4 a) {
+  static const int32_t shifts[4] = {0, 1, 2, 3};
+  const uint32x4_t sign = vshrq_n_u32(vreinterpretq_u32_f32(a), 31);
+  return (int)vaddvq_u32(vshlq_u32(sign, vld1q_s32(shifts)));
+}
+
+static inline vec_math__v4 vec_math__select(vec_math__v4 mask, vec_math__v4 a,
+                                            vec_math__v4 b) {
+  return vbslq_f32(vreinterpretq_u32_f32(mask), a, b);
+}
+
+static inline vec_math__v4 vec_math__yzxw(vec_math__v4 a) {
+  vec_math__v4 t = vextq_f32(a, a, 1); // y z w x
+  t = vsetq_lane_f32(vgetq_lane_f32(a, 0), t, 2);
+  return vsetq_lane_f32(vgetq_lane_f32(a, 3), t, 3);
+}
+
+static inline vec_math__v4 vec_math__hsum(vec_math__v4 a) {
+  return vdupq_n_f32(vaddvq_f32(a));
+}
+
+static inline void vec_math__transpose4(vec_math__v4 r[4]) {
+  float32x4x2_t t01 = vtrnq_f32(r[0], r[1]); // (a0 b0 a2 b2) (a1 b1 a3 b3)
+  float32x4x2_t t23 = vtrnq_f32(r[2], r[3]);
+  r[0] = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+  r[1] = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+  r[2] = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+  r[3] = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+static inline void vec_math__load3x4(const float *p, vec_math__v4 *x,
+                                     vec_math__v4 *y, vec_math__v4 *z) {
+  const float32x4x3_t t = vld3q_f32(p);
+  *x = t.val[0];
+  *y = t.val[1];
+  *z = t.val[2];
+}
+
+static inline void vec_math__store3x4(float *p, vec_math__v4 x, vec_math__v4 y,
+                                      vec_math__v4 z) {
+  float32x4x3_t t;
+  t.val[0] = x;
+  t.val[1] = y;
+  t.val[2] = z;
+  vst3q_f32(p, t);
+}
+#endif
+
+#if defined(VEC_MATH__SIMD4)
+// Cross product of the xyz lanes. The w lane is a.w * b.w - a.w * b.w, which
+// is exactly 0 for finite inputs.
+static inline vec_math__v4 vec_math__cross(vec_math__v4 a, vec_math__v4 b) {
+  vec_math__v4 c = vec_math__sub(vec_math__mul(a, vec_math__yzxw(b)),
+                                 vec_math__mul(vec_math__yzxw(a), b));
+  return vec_math__yzxw(c);
+}
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 //       HELPERS
 ////////////////////////////////////////////////////////////////////////////////
@@ -316,6 +480,284 @@ int mat2_equal(mat2_t a, mat2_t b);
 int mat3_equal(mat3_t a, mat3_t b);
 int mat4_equal(mat4_t a, mat4_t b);
 
+// Scalar reference versions of the SIMD kernels, always compiled in. The
+// functions above fall back to them when no SIMD backend is selected.
+mat4_t mat4_mul_scalar(mat4_t a, mat4_t b);
+vec3_t mat4_vec3_mul_scalar(mat4_t m, vec3_t v, int32_t is_point);
+vec4_t mat4_vec4_mul_scalar(mat4_t m, vec4_t v);
+mat4_t mat4_inverse_scalar(mat4_t m);
+mat4_t mat4_transpose_scalar(mat4_t m);
+
+////////////////////////////////////////////////////////////////////////////////
+//       BATCHES
+////////////////////////////////////////////////////////////////////////////////
+// Array versions of the per element functions, for culling, skinning and
+// bounds over many points at once. The matrix is splatted once and the SIMD
+// backend works on 4 elements per step, results match a loop over the single
+// element functions bit for bit. Nothing is kept between calls and `out` may
+// be the input array, so disjoint ranges can go to different threads.
+
+// out[i] = mat4_vec3_mul(m, v[i], is_point)
+void mat4_vec3_mul_batch(mat4_t m, const vec3_t *v, vec3_t *out, int32_t count,
+                         int32_t is_point);
+// out[i] = mat4_vec4_mul(m, v[i])
+void mat4_vec4_mul_batch(mat4_t m, const vec4_t *v, vec4_t *out, int32_t count);
+// Normals through the inverse transpose of the upper 3x3 of m, renormalized
+void mat4_normal_mul_batch(mat4_t m, const vec3_t *normals, vec3_t *out,
+                           int32_t count);
+// out[i] = mat4_mul(a, b[i])
+void mat4_mul_batch(mat4_t a, const mat4_t *b, mat4_t *out, int32_t count);
+// out[i] = mat4_mul(a[i], b)
+void mat4_batch_mul(const mat4_t *a, mat4_t b, mat4_t *out, int32_t count);
+void vec3_normalize_batch(const vec3_t *v, vec3_t *out, int32_t count);
+void vec4_normalize_batch(const vec4_t *v, vec4_t *out, int32_t count);
+// Screen space versions of project() and unproject() for labels, picking rays
+// and screen bounds of many objects. They take projection * modelview, and
+// its inverse for unproject, computed once by the caller instead of on every
+// call, and give the same results as the single functions with the two
+// matrices. Points are taken with w = 1.
+void project_batch(mat4_t mvp, vec4_t viewport, const vec3_t *points,
+                   vec3_t *out, int32_t count);
+void unproject_batch(mat4_t inverse_mvp, vec4_t viewport, const vec3_t *win,
+                     vec3_t *out, int32_t count);
+
+////////////////////////////////////////////////////////////////////////////////
+//       POINTER VARIANTS
+////////////////////////////////////////////////////////////////////////////////
+// The mat4 kernels on pointers, defined static inline right here so every
+// translation unit can inline them whether or not it holds the
+// implementation. The by-value functions copy two or three 64-byte unions
+// through the stack per call unless they inline, these keep a chain of
+// products in registers (see vec_math_codegen.c). They are the kernels the
+// by-value functions run, so results are identical. Arguments are restrict:
+// `out` must not overlap an input, use mat4_premul / mat4_postmul to update
+// a matrix in place.
+#if defined(__cplusplus)
+#define VEC_MATH_RESTRICT __restrict
+#else
+#define VEC_MATH_RESTRICT restrict
+#endif
+
+// Scalar kernels: the fallbacks of the pointer variants without a SIMD
+// backend and the bodies of the *_scalar reference functions, so a scalar
+// build runs exactly the reference code. They take the float arrays: given
+// the address of a by-value union argument gcc copies the whole union first.
+static inline void vec_math__mat4_mul_ref(const float *VEC_MATH_RESTRICT a,
+                                          const float *VEC_MATH_RESTRICT b,
+                                          float *VEC_MATH_RESTRICT out) {
+  for (int c = 0; c < 4; ++c) {
+    const float *bc = b + 4 * c;
+    for (int r = 0; r < 4; ++r) {
+      out[4 * c + r] = bc[0] * a[r] + bc[1] * a[4 + r] + bc[2] * a[8 + r] +
+                       bc[3] * a[12 + r];
+    }
+  }
+}
+
+static inline void vec_math__mat4_vec4_mul_ref(const float *VEC_MATH_RESTRICT m,
+                                               const float *VEC_MATH_RESTRICT v,
+                                               float *VEC_MATH_RESTRICT out) {
+  for (int r = 0; r < 4; ++r) {
+    out[r] = m[r] * v[0] + m[4 + r] * v[1] + m[8 + r] * v[2] + m[12 + r] * v[3];
+  }
+}
+
+static inline void vec_math__mat4_vec3_mul_ref(const float *VEC_MATH_RESTRICT m,
+                                               const float *VEC_MATH_RESTRICT v,
+                                               int32_t is_point,
+                                               float *VEC_MATH_RESTRICT out) {
+  for (int r = 0; r < 3; ++r) {
+    out[r] = m[r] * v[0] + m[4 + r] * v[1] + m[8 + r] * v[2] +
+             (float)is_point * m[12 + r];
+  }
+}
+
+// *out = a * b
+static inline void mat4_mul_ptr(const mat4_t *VEC_MATH_RESTRICT a,
+                                const mat4_t *VEC_MATH_RESTRICT b,
+                                mat4_t *VEC_MATH_RESTRICT out) {
+#if defined(VEC_MATH__SIMD4)
+  // Column c of the product is a * b.col[c], summed in the scalar order. AVX
+  // uses these 128-bit columns too: computing two columns per 256-bit step
+  // measured no faster and its insert and shuffles lengthen the latency of a
+  // chain of products (math_bench.c)
+  const vec_math__v4 a0 = vec_math__load(a->col[0].data);
+  const vec_math__v4 a1 = vec_math__load(a->col[1].data);
+  const vec_math__v4 a2 = vec_math__load(a->col[2].data);
+  const vec_math__v4 a3 = vec_math__load(a->col[3].data);
+  for (int c = 0; c < 4; ++c) {
+    const float *bc = b->col[c].data;
+    vec_math__v4 sum = vec_math__mul(a0, vec_math__splat(bc[0]));
+    sum = vec_math__add(sum, vec_math__mul(a1, vec_math__splat(bc[1])));
+    sum = vec_math__add(sum, vec_math__mul(a2, vec_math__splat(bc[2])));
+    sum = vec_math__add(sum, vec_math__mul(a3, vec_math__splat(bc[3])));
+    vec_math__store(out->col[c].data, sum);
+  }
+#else
+  vec_math__mat4_mul_ref(a->data, b->data, out->data);
+#endif
+}
+
+// *m = a * *m and *m = *m * b
+static inline void mat4_premul(const mat4_t *a, mat4_t *m) {
+  const mat4_t b = *m;
+  mat4_mul_ptr(a, &b, m);
+}
+
+static inline void mat4_postmul(mat4_t *m, const mat4_t *b) {
+  const mat4_t a = *m;
+  mat4_mul_ptr(&a, b, m);
+}
+
+static inline void mat4_vec4_mul_ptr(const mat4_t *VEC_MATH_RESTRICT m,
+                                     const vec4_t *VEC_MATH_RESTRICT v,
+                                     vec4_t *VEC_MATH_RESTRICT out) {
+#if defined(VEC_MATH__SIMD4)
+  vec_math__v4 sum = vec_math__mul(vec_math__load(m->col[0].data), vec_math__splat(v->x));
+  sum = vec_math__add(sum, vec_math__mul(vec_math__load(m->col[1].data), vec_math__splat(v->y)));
+  sum = vec_math__add(sum, vec_math__mul(vec_math__load(m->col[2].data), vec_math__splat(v->z)));
+  sum = vec_math__add(sum, vec_math__mul(vec_math__load(m->col[3].data), vec_math__splat(v->w)));
+  vec_math__store(out->data, sum);
+#else
+  vec_math__mat4_vec4_mul_ref(m->data, v->data, out->data);
+#endif
+}
+
+static inline void mat4_vec3_mul_ptr(const mat4_t *VEC_MATH_RESTRICT m,
+                                     const vec3_t *VEC_MATH_RESTRICT v,
+                                     int32_t is_point,
+                                     vec3_t *VEC_MATH_RESTRICT out) {
+#if defined(VEC_MATH__SIMD4)
+  vec_math__v4 sum = vec_math__mul(vec_math__load(m->col[0].data), vec_math__splat(v->x));
+  sum = vec_math__add(sum, vec_math__mul(vec_math__load(m->col[1].data), vec_math__splat(v->y)));
+  sum = vec_math__add(sum, vec_math__mul(vec_math__load(m->col[2].data), vec_math__splat(v->z)));
+  sum = vec_math__add(sum, vec_math__mul(vec_math__load(m->col[3].data),
+                                         vec_math__splat((float)is_point)));
+  float o[4];
+  vec_math__store(o, sum);
+  out->x = o[0];
+  out->y = o[1];
+  out->z = o[2];
+#else
+  vec_math__mat4_vec3_mul_ref(m->data, v->data, is_point, out->data);
+#endif
+}
+
+static inline void mat4_inverse_ptr(const mat4_t *VEC_MATH_RESTRICT m,
+                                    mat4_t *VEC_MATH_RESTRICT out) {
+#if defined(VEC_MATH__SIMD4)
+  /* Cofactors from cross products of the columns (Lengyel, Foundations of
+     Game Engine Development vol. 1). Columns a b c d carry the bottom row
+     x y z w in their w lanes, every product below cancels it out of the
+     w lanes of s t u v exactly, so 4-wide dot products are 3D ones. */
+  const vec_math__v4 a = vec_math__load(m->col[0].data);
+  const vec_math__v4 b = vec_math__load(m->col[1].data);
+  const vec_math__v4 c = vec_math__load(m->col[2].data);
+  const vec_math__v4 d = vec_math__load(m->col[3].data);
+  const vec_math__v4 x = vec_math__splat(m->data[3]);
+  const vec_math__v4 y = vec_math__splat(m->data[7]);
+  const vec_math__v4 z = vec_math__splat(m->data[11]);
+  const vec_math__v4 w = vec_math__splat(m->data[15]);
+
+  vec_math__v4 s = vec_math__cross(a, b);
+  vec_math__v4 t = vec_math__cross(c, d);
+  vec_math__v4 u = vec_math__sub(vec_math__mul(a, y), vec_math__mul(b, x));
+  vec_math__v4 v = vec_math__sub(vec_math__mul(c, w), vec_math__mul(d, z));
+  const vec_math__v4 det = vec_math__hsum(
+      vec_math__add(vec_math__mul(s, v), vec_math__mul(t, u)));
+  const vec_math__v4 denom = vec_math__div(vec_math__splat(1.0f), det);
+
+  /* Rows of the inverse, transposed into columns. The last column is
+     (-b.t, a.t, -d.s, c.s), the dot products summed across a transpose. */
+  vec_math__v4 rows[4];
+  rows[0] = vec_math__add(vec_math__cross(b, v), vec_math__mul(t, y));
+  rows[1] = vec_math__sub(vec_math__cross(v, a), vec_math__mul(t, x));
+  rows[2] = vec_math__add(vec_math__cross(d, u), vec_math__mul(s, w));
+  rows[3] = vec_math__sub(vec_math__cross(u, c), vec_math__mul(s, z));
+  vec_math__v4 dots[4];
+  dots[0] = vec_math__mul(b, t);
+  dots[1] = vec_math__mul(a, t);
+  dots[2] = vec_math__mul(d, s);
+  dots[3] = vec_math__mul(c, s);
+  vec_math__transpose4(rows);
+  vec_math__transpose4(dots);
+  const float signs[4] = {-1.0f, 1.0f, -1.0f, 1.0f};
+  rows[3] = vec_math__mul(vec_math__add(vec_math__add(dots[0], dots[1]),
+                                        vec_math__add(dots[2], dots[3])),
+                          vec_math__load(signs));
+
+  for (int col = 0; col < 4; ++col) {
+    vec_math__store(out->col[col].data, vec_math__mul(rows[col], denom));
+  }
+#else
+  *out = mat4_inverse_scalar(*m);
+#endif
+}
+
+static inline void mat4_transpose_ptr(const mat4_t *VEC_MATH_RESTRICT m,
+                                      mat4_t *VEC_MATH_RESTRICT out) {
+#if defined(VEC_MATH__SIMD4)
+  vec_math__v4 cols[4];
+  for (int c = 0; c < 4; ++c) {
+    cols[c] = vec_math__load(m->col[c].data);
+  }
+  vec_math__transpose4(cols);
+  for (int c = 0; c < 4; ++c) {
+    vec_math__store(out->col[c].data, cols[c]);
+  }
+#else
+  for (int c = 0; c < 4; ++c) {
+    for (int r = 0; r < 4; ++r) {
+      out->data[4 * c + r] = m->data[4 * r + c];
+    }
+  }
+#endif
+}
+
+static inline void mat4_add_ptr(const mat4_t *VEC_MATH_RESTRICT a,
+                                const mat4_t *VEC_MATH_RESTRICT b,
+                                mat4_t *VEC_MATH_RESTRICT out) {
+#if defined(VEC_MATH__SIMD4)
+  for (int c = 0; c < 4; ++c) {
+    vec_math__store(out->col[c].data, vec_math__add(vec_math__load(a->col[c].data),
+                                                     vec_math__load(b->col[c].data)));
+  }
+#else
+  for (int k = 0; k < 16; ++k) {
+    out->data[k] = a->data[k] + b->data[k];
+  }
+#endif
+}
+
+static inline void mat4_sub_ptr(const mat4_t *VEC_MATH_RESTRICT a,
+                                const mat4_t *VEC_MATH_RESTRICT b,
+                                mat4_t *VEC_MATH_RESTRICT out) {
+#if defined(VEC_MATH__SIMD4)
+  for (int c = 0; c < 4; ++c) {
+    vec_math__store(out->col[c].data, vec_math__sub(vec_math__load(a->col[c].data),
+                                                     vec_math__load(b->col[c].data)));
+  }
+#else
+  for (int k = 0; k < 16; ++k) {
+    out->data[k] = a->data[k] - b->data[k];
+  }
+#endif
+}
+
+static inline void mat4_scalar_mul_ptr(const mat4_t *VEC_MATH_RESTRICT m, float s,
+                                       mat4_t *VEC_MATH_RESTRICT out) {
+#if defined(VEC_MATH__SIMD4)
+  const vec_math__v4 vs = vec_math__splat(s);
+  for (int c = 0; c < 4; ++c) {
+    vec_math__store(out->col[c].data, vec_math__mul(vec_math__load(m->col[c].data), vs));
+  }
+#else
+  for (int k = 0; k < 16; ++k) {
+    out->data[k] = m->data[k] * s;
+  }
+#endif
+}
+
 void mat2_fprint(mat2_t v, FILE *stream);
 void mat3_fprint(mat3_t v, FILE *stream);
 void mat4_fprint(mat4_t v, FILE *stream);
@@ -323,6 +765,599 @@ void mat2_print(mat2_t v);
 void mat3_print(mat3_t v);
 void mat4_print(mat4_t v);
 
+////////////////////////////////////////////////////////////////////////////////
+//       QUATERNIONS
+////////////////////////////////////////////////////////////////////////////////
+// Unit quaternions for orientations: 16 bytes instead of a 64-byte matrix,
+// composed with quat_mul and blended with nlerp/slerp, converted to a matrix
+// once when drawn. (x, y, z) is the vector part and w the scalar part;
+// quat_mul(a, b) rotates by b, then by a, like mat4_mul. Matrices follow the
+// convention of mat4_make_rotation.
+typedef union quat {
+  struct {
+    float x;
+    float y;
+    float z;
+    float w;
+  };
+  float data[4];
+} quat_t;
+
+#define quat_identity() INIT_CAST(quat_t){{0, 0, 0, 1}}
+#define quat(x, y, z, w)  INIT_CAST(quat_t){{x, y, z, w}}
+
+quat_t quat_from_axis_angle(vec3_t axis, float angle);
+// Unit axis and angle in [0, 2 PI], +x for the identity
+void quat_to_axis_angle(quat_t q, vec3_t *out_axis, float *out_angle);
+quat_t quat_from_mat3(mat3_t m); // m has to be a rotation
+mat3_t quat_to_mat3(quat_t q);
+mat4_t quat_to_mat4(quat_t q);
+
+quat_t quat_mul(quat_t a, quat_t b);
+quat_t quat_conjugate(quat_t q);
+quat_t quat_inverse(quat_t q);
+quat_t quat_normalize(quat_t q);
+float quat_dot(quat_t a, quat_t b);
+vec3_t quat_rotate(quat_t q, vec3_t v);
+
+// Both take the shorter arc. nlerp is normalized linear interpolation, exact
+// at the ends and cheap; slerp keeps a constant angular speed.
+quat_t quat_nlerp(quat_t a, quat_t b, float t);
+quat_t quat_slerp(quat_t a, quat_t b, float t);
+
+// Batches, 4 quaternions per SIMD step and bit for bit equal to loops over
+// the functions above, `out` may be an input array.
+// out[i] = quat_mul(a, b[i])
+void quat_mul_batch(quat_t a, const quat_t *b, quat_t *out, int32_t count);
+// out[i] = quat_nlerp(a[i], b[i], t)
+void quat_nlerp_batch(const quat_t *a, const quat_t *b, float t, quat_t *out,
+                      int32_t count);
+void quat_normalize_batch(const quat_t *q, quat_t *out, int32_t count);
+void quat_to_mat4_batch(const quat_t *q, mat4_t *out, int32_t count);
+
+void quat_fprint(quat_t q, FILE *stream);
+void quat_print(quat_t q);
+
+////////////////////////////////////////////////////////////////////////////////
+//       AFFINE TRANSFORMS
+////////////////////////////////////////////////////////////////////////////////
+// Rotation, scale, shear and translation without the projective bottom row of
+// a mat4, which is always (0 0 0 1) for model transforms: col[0..2] is the
+// linear part, col[3] the translation, column major like mat4_t. Products
+// take 36 multiplies instead of 64 and the inverse is three cross products
+// and a division instead of a full cofactor expansion.
+typedef union affine {
+  float data[12];
+  vec3_t col[4];
+} affine_t;
+
+#define affine_identity() INIT_CAST(affine_t){{1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0}}
+
+affine_t affine_from_mat4(mat4_t m); // drops the bottom row
+mat4_t affine_to_mat4(affine_t a);
+affine_t affine_mul(affine_t a, affine_t b);
+affine_t affine_inverse(affine_t a);
+vec3_t affine_point_mul(affine_t a, vec3_t p);
+vec3_t affine_vector_mul(affine_t a, vec3_t v);
+
+// Matrix taking normals through the transform: the cofactor matrix of the
+// linear part, which is the inverse transpose scaled by the determinant. Its
+// sign is flipped for mirroring transforms so normals keep their side, the
+// scale is left in, normalize after transforming.
+mat3_t affine_normal_matrix(affine_t a);
+mat3_t mat4_normal_matrix(mat4_t m); // upper 3x3 of m
+
+////////////////////////////////////////////////////////////////////////////////
+//       WIDE VECTORS
+////////////////////////////////////////////////////////////////////////////////
+// Eight values per variable for data-parallel kernels (culling, ray casts,
+// shading on the CPU): float8_t is one AVX register, two SSE2/NEON registers
+// or a plain array, vec3x8_t holds eight vec3 as three float8_t, x, y and z.
+// A kernel written with these runs one loop iteration per eight elements on
+// every backend. Lanes are computed with the operations of the vec3_t
+// functions in the same order, so lane i of vec3x8_normalize(v) equals
+// vec3_normalize of lane i bit for bit.
+//
+// Comparisons return masks, all bits set in the lanes where they hold;
+// combine them with float8_and, blend with the select functions and read
+// them with float8_bits (bit i set when lane i is). Everything is static
+// inline and passed by value, the compiler keeps it in registers.
+typedef union float8 {
+  float data[8];
+  uint32_t bits[8];
+#if defined(VEC_MATH_SIMD_AVX)
+  __m256 v;
+#elif defined(VEC_MATH__SIMD4)
+  vec_math__v4 v[2];
+#endif
+} float8_t;
+
+typedef struct vec3x8 {
+  float8_t x, y, z;
+} vec3x8_t;
+
+// Element-wise float8_t operations in the three backends
+#if defined(VEC_MATH_SIMD_AVX)
+#define VEC_MATH__FLOAT8_BINARY(name, avx, simd4, op)                          \
+  static inline float8_t name(float8_t a, float8_t b) {                        \
+    float8_t o;                                                                \
+    o.v = avx(a.v, b.v);                                                       \
+    return o;                                                                  \
+  }
+#elif defined(VEC_MATH__SIMD4)
+#define VEC_MATH__FLOAT8_BINARY(name, avx, simd4, op)                          \
+  static inline float8_t name(float8_t a, float8_t b) {                        \
+    float8_t o;                                                                \
+    o.v[0] = simd4(a.v[0], b.v[0]);                                            \
+    o.v[1] = simd4(a.v[1], b.v[1]);                                            \
+    return o;                                                                  \
+  }
+#else
+#define VEC_MATH__FLOAT8_BINARY(name, avx, simd4, op)                          \
+  static inline float8_t name(float8_t a, float8_t b) {                        \
+    float8_t o;                                                                \
+    for (int i = 0; i < 8; ++i) {                                              \
+      o.data[i] = a.data[i] op b.data[i];                                      \
+    }                                                                          \
+    return o;                                                                  \
+  }
+#endif
+
+VEC_MATH__FLOAT8_BINARY(float8_add, _mm256_add_ps, vec_math__add, +)
+VEC_MATH__FLOAT8_BINARY(float8_sub, _mm256_sub_ps, vec_math__sub, -)
+VEC_MATH__FLOAT8_BINARY(float8_mul, _mm256_mul_ps, vec_math__mul, *)
+VEC_MATH__FLOAT8_BINARY(float8_div, _mm256_div_ps, vec_math__div, /)
+
+static inline float8_t float8_splat(float s) {
+  float8_t o;
+#if defined(VEC_MATH_SIMD_AVX)
+  o.v = _mm256_set1_ps(s);
+#elif defined(VEC_MATH__SIMD4)
+  o.v[0] = o.v[1] = vec_math__splat(s);
+#else
+  for (int i = 0; i < 8; ++i) {
+    o.data[i] = s;
+  }
+#endif
+  return o;
+}
+
+// Eight consecutive floats, no alignment required
+static inline float8_t float8_load(const float *p) {
+  float8_t o;
+#if defined(VEC_MATH_SIMD_AVX)
+  o.v = _mm256_loadu_ps(p);
+#elif defined(VEC_MATH__SIMD4)
+  o.v[0] = vec_math__load(p);
+  o.v[1] = vec_math__load(p + 4);
+#else
+  for (int i = 0; i < 8; ++i) {
+    o.data[i] = p[i];
+  }
+#endif
+  return o;
+}
+
+static inline void float8_store(float *p, float8_t a) {
+#if defined(VEC_MATH_SIMD_AVX)
+  _mm256_storeu_ps(p, a.v);
+#elif defined(VEC_MATH__SIMD4)
+  vec_math__store(p, a.v[0]);
+  vec_math__store(p + 4, a.v[1]);
+#else
+  for (int i = 0; i < 8; ++i) {
+    p[i] = a.data[i];
+  }
+#endif
+}
+
+static inline float8_t float8_sqrt(float8_t a) {
+#if defined(VEC_MATH_SIMD_AVX)
+  a.v = _mm256_sqrt_ps(a.v);
+#elif defined(VEC_MATH__SIMD4)
+  a.v[0] = vec_math__sqrt(a.v[0]);
+  a.v[1] = vec_math__sqrt(a.v[1]);
+#else
+  for (int i = 0; i < 8; ++i) {
+    a.data[i] = sqrtf(a.data[i]);
+  }
+#endif
+  return a;
+}
+
+// Mask of the lanes where a < b
+static inline float8_t float8_less(float8_t a, float8_t b) {
+  float8_t o;
+#if defined(VEC_MATH_SIMD_AVX)
+  o.v = _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ);
+#elif defined(VEC_MATH__SIMD4)
+  o.v[0] = vec_math__less(a.v[0], b.v[0]);
+  o.v[1] = vec_math__less(a.v[1], b.v[1]);
+#else
+  for (int i = 0; i < 8; ++i) {
+    o.bits[i] = a.data[i] < b.data[i] ? 0xffffffffu : 0u;
+  }
+#endif
+  return o;
+}
+
+static inline float8_t float8_and(float8_t a, float8_t b) {
+#if defined(VEC_MATH_SIMD_AVX)
+  a.v = _mm256_and_ps(a.v, b.v);
+#elif defined(VEC_MATH__SIMD4)
+  a.v[0] = vec_math__and(a.v[0], b.v[0]);
+  a.v[1] = vec_math__and(a.v[1], b.v[1]);
+#else
+  for (int i = 0; i < 8; ++i) {
+    a.bits[i] &= b.bits[i];
+  }
+#endif
+  return a;
+}
+
+// Lanes of a where the mask is set, of b elsewhere
+static inline float8_t float8_select(float8_t mask, float8_t a, float8_t b) {
+#if defined(VEC_MATH_SIMD_AVX)
+  a.v = _mm256_blendv_ps(b.v, a.v, mask.v);
+#elif defined(VEC_MATH__SIMD4)
+  a.v[0] = vec_math__select(mask.v[0], a.v[0], b.v[0]);
+  a.v[1] = vec_math__select(mask.v[1], a.v[1], b.v[1]);
+#else
+  for (int i = 0; i < 8; ++i) {
+    a.bits[i] = (mask.bits[i] & a.bits[i]) | (~mask.bits[i] & b.bits[i]);
+  }
+#endif
+  return a;
+}
+
+// Bit i set when lane i of the mask is
+static inline int float8_bits(float8_t mask) {
+#if defined(VEC_MATH_SIMD_AVX)
+  return _mm256_movemask_ps(mask.v);
+#elif defined(VEC_MATH__SIMD4)
+  return vec_math__bits(mask.v[0]) | (vec_math__bits(mask.v[1]) << 4);
+#else
+  int bits = 0;
+  for (int i = 0; i < 8; ++i) {
+    bits |= (int)(mask.bits[i] >> 31) << i;
+  }
+  return bits;
+#endif
+}
+
+static inline vec3x8_t vec3x8_splat(vec3_t v) {
+  vec3x8_t o;
+  o.x = float8_splat(v.x);
+  o.y = float8_splat(v.y);
+  o.z = float8_splat(v.z);
+  return o;
+}
+
+// Eight vectors from three arrays of coordinates
+static inline vec3x8_t vec3x8_load(const float *x, const float *y, const float *z) {
+  vec3x8_t o;
+  o.x = float8_load(x);
+  o.y = float8_load(y);
+  o.z = float8_load(z);
+  return o;
+}
+
+static inline void vec3x8_store(float *x, float *y, float *z, vec3x8_t v) {
+  float8_store(x, v.x);
+  float8_store(y, v.y);
+  float8_store(z, v.z);
+}
+
+// Eight consecutive vec3_t (24 packed floats), transposed on the way in and out
+static inline vec3x8_t vec3x8_load_aos(const vec3_t *p) {
+  vec3x8_t o;
+#if defined(VEC_MATH_SIMD_AVX)
+  __m128 x[2], y[2], z[2];
+  vec_math__load3x4(p[0].data, &x[0], &y[0], &z[0]);
+  vec_math__load3x4(p[4].data, &x[1], &y[1], &z[1]);
+  o.x.v = _mm256_insertf128_ps(_mm256_castps128_ps256(x[0]), x[1], 1);
+  o.y.v = _mm256_insertf128_ps(_mm256_castps128_ps256(y[0]), y[1], 1);
+  o.z.v = _mm256_insertf128_ps(_mm256_castps128_ps256(z[0]), z[1], 1);
+#elif defined(VEC_MATH__SIMD4)
+  vec_math__load3x4(p[0].data, &o.x.v[0], &o.y.v[0], &o.z.v[0]);
+  vec_math__load3x4(p[4].data, &o.x.v[1], &o.y.v[1], &o.z.v[1]);
+#else
+  for (int i = 0; i < 8; ++i) {
+    o.x.data[i] = p[i].x;
+    o.y.data[i] = p[i].y;
+    o.z.data[i] = p[i].z;
+  }
+#endif
+  return o;
+}
+
+static inline void vec3x8_store_aos(vec3_t *p, vec3x8_t v) {
+#if defined(VEC_MATH_SIMD_AVX)
+  vec_math__store3x4(p[0].data, _mm256_castps256_ps128(v.x.v), _mm256_castps256_ps128(v.y.v),
+                     _mm256_castps256_ps128(v.z.v));
+  vec_math__store3x4(p[4].data, _mm256_extractf128_ps(v.x.v, 1), _mm256_extractf128_ps(v.y.v, 1),
+                     _mm256_extractf128_ps(v.z.v, 1));
+#elif defined(VEC_MATH__SIMD4)
+  vec_math__store3x4(p[0].data, v.x.v[0], v.y.v[0], v.z.v[0]);
+  vec_math__store3x4(p[4].data, v.x.v[1], v.y.v[1], v.z.v[1]);
+#else
+  for (int i = 0; i < 8; ++i) {
+    p[i] = vec3(v.x.data[i], v.y.data[i], v.z.data[i]);
+  }
+#endif
+}
+
+static inline vec3_t vec3x8_lane(vec3x8_t v, int i) {
+  return vec3(v.x.data[i], v.y.data[i], v.z.data[i]);
+}
+
+static inline vec3x8_t vec3x8_add(vec3x8_t a, vec3x8_t b) {
+  a.x = float8_add(a.x, b.x);
+  a.y = float8_add(a.y, b.y);
+  a.z = float8_add(a.z, b.z);
+  return a;
+}
+
+static inline vec3x8_t vec3x8_sub(vec3x8_t a, vec3x8_t b) {
+  a.x = float8_sub(a.x, b.x);
+  a.y = float8_sub(a.y, b.y);
+  a.z = float8_sub(a.z, b.z);
+  return a;
+}
+
+static inline vec3x8_t vec3x8_mul(vec3x8_t a, vec3x8_t b) {
+  a.x = float8_mul(a.x, b.x);
+  a.y = float8_mul(a.y, b.y);
+  a.z = float8_mul(a.z, b.z);
+  return a;
+}
+
+// Every vector times its own lane of s
+static inline vec3x8_t vec3x8_scale(vec3x8_t v, float8_t s) {
+  v.x = float8_mul(v.x, s);
+  v.y = float8_mul(v.y, s);
+  v.z = float8_mul(v.z, s);
+  return v;
+}
+
+static inline float8_t vec3x8_dot(vec3x8_t a, vec3x8_t b) {
+  float8_t d = float8_mul(a.x, b.x);
+  d = float8_add(d, float8_mul(a.y, b.y));
+  return float8_add(d, float8_mul(a.z, b.z));
+}
+
+static inline vec3x8_t vec3x8_cross(vec3x8_t a, vec3x8_t b) {
+  vec3x8_t o;
+  o.x = float8_sub(float8_mul(a.y, b.z), float8_mul(a.z, b.y));
+  o.y = float8_sub(float8_mul(a.z, b.x), float8_mul(a.x, b.z));
+  o.z = float8_sub(float8_mul(a.x, b.y), float8_mul(a.y, b.x));
+  return o;
+}
+
+static inline vec3x8_t vec3x8_normalize(vec3x8_t v) {
+  return vec3x8_scale(v, float8_div(float8_splat(1.0f), float8_sqrt(vec3x8_dot(v, v))));
+}
+
+static inline vec3x8_t vec3x8_select(float8_t mask, vec3x8_t a, vec3x8_t b) {
+  a.x = float8_select(mask, a.x, b.x);
+  a.y = float8_select(mask, a.y, b.y);
+  a.z = float8_select(mask, a.z, b.z);
+  return a;
+}
+
+// One matrix applied to eight points (is_point 1) or directions (0), lanes
+// as mat4_vec3_mul
+static inline vec3x8_t mat4_vec3x8_mul(const mat4_t *m, vec3x8_t v, int32_t is_point) {
+  vec3x8_t o;
+  float8_t *out[3] = {&o.x, &o.y, &o.z};
+  for (int r = 0; r < 3; ++r) {
+    float8_t sum = float8_mul(float8_splat(m->data[r]), v.x);
+    sum = float8_add(sum, float8_mul(float8_splat(m->data[4 + r]), v.y));
+    sum = float8_add(sum, float8_mul(float8_splat(m->data[8 + r]), v.z));
+    *out[r] = float8_add(sum, float8_splat((float)is_point * m->data[12 + r]));
+  }
+  return o;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//       FAST APPROXIMATIONS
+////////////////////////////////////////////////////////////////////////////////
+// Opt-in replacements for hot CPU paths that can give up a few ULP: the
+// reciprocal square root is the SSE/NEON estimate refined by Newton steps
+// (1 / sqrtf without SIMD), sine and cosine come together from one range
+// reduction and two short polynomials instead of separate libm calls. The
+// batches equal loops over the single functions bit for bit, the single
+// functions run the SIMD code on one lane.
+//
+// Largest errors against double precision over 2^24 random inputs, and
+// nanoseconds per element, from vec_math_fast_bench.c on SSE2 (AVX runs the
+// same code):
+//   scalar_rsqrt_fast     x in [1e-30, 1e30]     4 ULP
+//   scalar_sincos_fast    |x| <= 8192            7.8e-8 absolute
+//   vec3_normalize_fast   |v| in [1e-3, 1e3]     6 ULP, length off by 3.3e-7
+//
+//                         libm   fast   fast batch
+//   sine and cosine        9.8    8.9    2.2
+//   vec3_normalize         2.3    2.5    1.2
+//   perspective           16.1   12.4
+// The sincos error is absolute: relative errors grow near the zeros. The
+// reduction subtracts pi/2 in three exact parts, past |x| = 8192 the error
+// grows with |x|. On recent x86 the exact vec3_normalize_batch (1.1 ns) is
+// as fast as the fast one, the estimate pays off where square roots and
+// divisions are slow.
+float scalar_rsqrt_fast(float x);
+void scalar_sincos_fast(float x, float *out_sin, float *out_cos);
+void scalar_sincos_batch_fast(const float *x, float *out_sin, float *out_cos,
+                              int32_t count);
+
+vec3_t vec3_normalize_fast(vec3_t v);
+vec4_t vec4_normalize_fast(vec4_t v);
+void vec3_normalize_batch_fast(const vec3_t *v, vec3_t *out, int32_t count);
+
+// mat4_make_rotation, perspective and quat_from_axis_angle through the
+// functions above
+mat4_t mat4_make_rotation_fast(vec3_t axis, float angle);
+mat4_t perspective_fast(float fovy, float aspect, float z_near, float z_far);
+quat_t quat_from_axis_angle_fast(vec3_t axis, float angle);
+
+// The 4 lane kernels of the single and batch functions, in the header for the
+// wide versions below
+#define VEC_MATH__2_OVER_PI 0.636619772367581343f
+// pi / 2 in three parts with few enough bits that j * part is exact for the
+// quadrants j of |x| <= 8192 (Cephes)
+#define VEC_MATH__PI_2_A 1.5703125f
+#define VEC_MATH__PI_2_B 4.837512969970703125e-4f
+#define VEC_MATH__PI_2_C 7.54978995489188216e-8f
+// Minimax polynomials of sin and cos on [-pi/4, pi/4] (Cephes sinf, cosf)
+#define VEC_MATH__SIN_1 -1.6666654611e-1f
+#define VEC_MATH__SIN_2 8.3321608736e-3f
+#define VEC_MATH__SIN_3 -1.9515295891e-4f
+#define VEC_MATH__COS_1 4.166664568298827e-2f
+#define VEC_MATH__COS_2 -1.388731625493765e-3f
+#define VEC_MATH__COS_3 2.443315711809948e-5f
+
+#if defined(VEC_MATH__SIMD4)
+static inline vec_math__v4 vec_math__rsqrt4(vec_math__v4 x) {
+#if defined(VEC_MATH_SIMD_SSE2)
+  // 12-bit estimate, one Newton step
+  vec_math__v4 y = _mm_rsqrt_ps(x);
+  const int steps = 1;
+#else
+  // 8-bit estimate, two Newton steps
+  vec_math__v4 y = vrsqrteq_f32(x);
+  const int steps = 2;
+#endif
+  const vec_math__v4 half_x = vec_math__mul(x, vec_math__splat(0.5f));
+  for (int i = 0; i < steps; ++i) {
+    y = vec_math__mul(y, vec_math__sub(vec_math__splat(1.5f),
+                                       vec_math__mul(vec_math__mul(half_x, y), y)));
+  }
+  return y;
+}
+
+// x = j pi / 2 + r with |r| <= pi / 4, the polynomials on r, then the
+// quadrant j mod 4 swaps sine and cosine and flips their signs
+static inline void vec_math__sincos4(vec_math__v4 x, vec_math__v4 *out_sin,
+                                     vec_math__v4 *out_cos) {
+#if defined(VEC_MATH_SIMD_SSE2)
+  const __m128i q = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(VEC_MATH__2_OVER_PI)));
+  const vec_math__v4 j = _mm_cvtepi32_ps(q);
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i two = _mm_set1_epi32(2);
+  const vec_math__v4 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+  const __m128i sin_sign = _mm_slli_epi32(_mm_and_si128(q, two), 30);
+  const __m128i cos_sign = _mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), 30);
+#else
+  const int32x4_t q = vcvtnq_s32_f32(vmulq_f32(x, vdupq_n_f32(VEC_MATH__2_OVER_PI)));
+  const vec_math__v4 j = vcvtq_f32_s32(q);
+  const vec_math__v4 swap = vreinterpretq_f32_u32(vtstq_s32(q, vdupq_n_s32(1)));
+  const uint32x4_t sin_sign = vreinterpretq_u32_s32(vshlq_n_s32(vandq_s32(q, vdupq_n_s32(2)), 30));
+  const uint32x4_t cos_sign = vreinterpretq_u32_s32(
+      vshlq_n_s32(vandq_s32(vaddq_s32(q, vdupq_n_s32(1)), vdupq_n_s32(2)), 30));
+#endif
+  vec_math__v4 r = vec_math__sub(x, vec_math__mul(j, vec_math__splat(VEC_MATH__PI_2_A)));
+  r = vec_math__sub(r, vec_math__mul(j, vec_math__splat(VEC_MATH__PI_2_B)));
+  r = vec_math__sub(r, vec_math__mul(j, vec_math__splat(VEC_MATH__PI_2_C)));
+  const vec_math__v4 z = vec_math__mul(r, r);
+
+  vec_math__v4 ps = vec_math__add(vec_math__mul(vec_math__splat(VEC_MATH__SIN_3), z),
+                                  vec_math__splat(VEC_MATH__SIN_2));
+  ps = vec_math__add(vec_math__mul(ps, z), vec_math__splat(VEC_MATH__SIN_1));
+  ps = vec_math__add(vec_math__mul(vec_math__mul(ps, z), r), r);
+  vec_math__v4 pc = vec_math__add(vec_math__mul(vec_math__splat(VEC_MATH__COS_3), z),
+                                  vec_math__splat(VEC_MATH__COS_2));
+  pc = vec_math__add(vec_math__mul(pc, z), vec_math__splat(VEC_MATH__COS_1));
+  pc = vec_math__mul(vec_math__mul(pc, z), z);
+  pc = vec_math__sub(pc, vec_math__mul(vec_math__splat(0.5f), z));
+  pc = vec_math__add(pc, vec_math__splat(1.0f));
+
+  const vec_math__v4 s = vec_math__select(swap, pc, ps);
+  const vec_math__v4 c = vec_math__select(swap, ps, pc);
+#if defined(VEC_MATH_SIMD_SSE2)
+  *out_sin = _mm_xor_ps(s, _mm_castsi128_ps(sin_sign));
+  *out_cos = _mm_xor_ps(c, _mm_castsi128_ps(cos_sign));
+#else
+  *out_sin = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(s), sin_sign));
+  *out_cos = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(c), cos_sign));
+#endif
+}
+#endif
+
+#if defined(VEC_MATH_SIMD_AVX) && defined(__AVX2__)
+// vec_math__sincos4 on 8 lanes, the quadrant logic needs the AVX2 integer ops
+static inline void vec_math__sincos8(__m256 x, __m256 *out_sin, __m256 *out_cos) {
+  const __m256i q = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(VEC_MATH__2_OVER_PI)));
+  const __m256 j = _mm256_cvtepi32_ps(q);
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i two = _mm256_set1_epi32(2);
+  const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, one), one));
+  const __m256i sin_sign = _mm256_slli_epi32(_mm256_and_si256(q, two), 30);
+  const __m256i cos_sign = _mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(q, one), two), 30);
+  __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(j, _mm256_set1_ps(VEC_MATH__PI_2_A)));
+  r = _mm256_sub_ps(r, _mm256_mul_ps(j, _mm256_set1_ps(VEC_MATH__PI_2_B)));
+  r = _mm256_sub_ps(r, _mm256_mul_ps(j, _mm256_set1_ps(VEC_MATH__PI_2_C)));
+  const __m256 z = _mm256_mul_ps(r, r);
+
+  __m256 ps = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(VEC_MATH__SIN_3), z),
+                            _mm256_set1_ps(VEC_MATH__SIN_2));
+  ps = _mm256_add_ps(_mm256_mul_ps(ps, z), _mm256_set1_ps(VEC_MATH__SIN_1));
+  ps = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(ps, z), r), r);
+  __m256 pc = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(VEC_MATH__COS_3), z),
+                            _mm256_set1_ps(VEC_MATH__COS_2));
+  pc = _mm256_add_ps(_mm256_mul_ps(pc, z), _mm256_set1_ps(VEC_MATH__COS_1));
+  pc = _mm256_mul_ps(_mm256_mul_ps(pc, z), z);
+  pc = _mm256_sub_ps(pc, _mm256_mul_ps(_mm256_set1_ps(0.5f), z));
+  pc = _mm256_add_ps(pc, _mm256_set1_ps(1.0f));
+
+  *out_sin = _mm256_xor_ps(_mm256_blendv_ps(ps, pc, swap), _mm256_castsi256_ps(sin_sign));
+  *out_cos = _mm256_xor_ps(_mm256_blendv_ps(pc, ps, swap), _mm256_castsi256_ps(cos_sign));
+}
+#endif
+
+// The fast approximations on the lanes of a float8_t, lane i equals the single
+// function on lane i bit for bit
+static inline float8_t float8_rsqrt_fast(float8_t x) {
+#if defined(VEC_MATH_SIMD_AVX)
+  // The estimate of _mm_rsqrt_ps and its Newton step
+  const __m256 half_x = _mm256_mul_ps(x.v, _mm256_set1_ps(0.5f));
+  __m256 y = _mm256_rsqrt_ps(x.v);
+  y = _mm256_mul_ps(y, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(_mm256_mul_ps(half_x, y), y)));
+  x.v = y;
+#elif defined(VEC_MATH__SIMD4)
+  x.v[0] = vec_math__rsqrt4(x.v[0]);
+  x.v[1] = vec_math__rsqrt4(x.v[1]);
+#else
+  for (int i = 0; i < 8; ++i) {
+    x.data[i] = scalar_rsqrt_fast(x.data[i]);
+  }
+#endif
+  return x;
+}
+
+static inline void float8_sincos_fast(float8_t x, float8_t *out_sin,
+                                      float8_t *out_cos) {
+#if defined(VEC_MATH_SIMD_AVX) && defined(__AVX2__)
+  vec_math__sincos8(x.v, &out_sin->v, &out_cos->v);
+#elif defined(VEC_MATH_SIMD_AVX)
+  __m128 s[2], c[2];
+  vec_math__sincos4(_mm256_castps256_ps128(x.v), &s[0], &c[0]);
+  vec_math__sincos4(_mm256_extractf128_ps(x.v, 1), &s[1], &c[1]);
+  out_sin->v = _mm256_insertf128_ps(_mm256_castps128_ps256(s[0]), s[1], 1);
+  out_cos->v = _mm256_insertf128_ps(_mm256_castps128_ps256(c[0]), c[1], 1);
+#elif defined(VEC_MATH__SIMD4)
+  vec_math__sincos4(x.v[0], &out_sin->v[0], &out_cos->v[0]);
+  vec_math__sincos4(x.v[1], &out_sin->v[1], &out_cos->v[1]);
+#else
+  for (int i = 0; i < 8; ++i) {
+    scalar_sincos_fast(x.data[i], &out_sin->data[i], &out_cos->data[i]);
+  }
+#endif
+}
+
+static inline vec3x8_t vec3x8_normalize_fast(vec3x8_t v) {
+  return vec3x8_scale(v, float8_rsqrt_fast(vec3x8_dot(v, v)));
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -341,6 +1376,7 @@ float deg2rad(float degrees) {
 float rad2deg(float radians) {
     return radians * (180.0f / PI);
 }
+
 ////////////////////////////////////////////////////////////////////////////////
 //       VECTOR IMPLEMENTATION
 ////////////////////////////////////////////////////////////////////////////////
@@ -354,7 +1390,13 @@ vec3_t vec3_add(vec3_t a, vec3_t b) {
 }
 
 vec4_t vec4_add(vec4_t a, vec4_t b) {
+#if defined(VEC_MATH__SIMD4)
+  vec4_t o;
+  vec_math__store(o.data, vec_math__add(vec_math__load(a.data), vec_math__load(b.data)));
+  return o;
+#else
   return INIT_CAST(vec4_t){{a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w}};
+#endif
 }
 
 vec2_t vec2_scalar_add(vec2_t v, float s) {
@@ -366,7 +1408,13 @@ vec3_t vec3_scalar_add(vec3_t v, float s) {
 }
 
 vec4_t vec4_scalar_add(vec4_t v, float s) {
+#if defined(VEC_MATH__SIMD4)
+  vec4_t o;
+  vec_math__store(o.data, vec_math__add(vec_math__load(v.data), vec_math__splat(s)));
+  return o;
+#else
   return INIT_CAST(vec4_t){{v.x + s, v.y + s, v.z + s, v.w + s}};
+#endif
 }
 
 vec2_t vec2_sub(vec2_t a, vec2_t b) {
@@ -378,7 +1426,13 @@ vec3_t vec3_sub(vec3_t a, vec3_t b) {
 }
 
 vec4_t vec4_sub(vec4_t a, vec4_t b) {
+#if defined(VEC_MATH__SIMD4)
+  vec4_t o;
+  vec_math__store(o.data, vec_math__sub(vec_math__load(a.data), vec_math__load(b.data)));
+  return o;
+#else
   return INIT_CAST(vec4_t){{a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w}};
+#endif
 }
 
 vec2_t vec2_scalar_sub(vec2_t v, float s) {
@@ -390,7 +1444,13 @@ vec3_t vec3_scalar_sub(vec3_t v, float s) {
 }
 
 vec4_t vec4_scalar_sub(vec4_t v, float s) {
+#if defined(VEC_MATH__SIMD4)
+  vec4_t o;
+  vec_math__store(o.data, vec_math__sub(vec_math__load(v.data), vec_math__splat(s)));
+  return o;
+#else
   return INIT_CAST(vec4_t){{v.x - s, v.y - s, v.z - s, v.w - s}};
+#endif
 }
 
 vec2_t vec2_mul(vec2_t a, vec2_t b) {
@@ -402,7 +1462,13 @@ vec3_t vec3_mul(vec3_t a, vec3_t b) {
 }
 
 vec4_t vec4_mul(vec4_t a, vec4_t b) {
+#if defined(VEC_MATH__SIMD4)
+  vec4_t o;
+  vec_math__store(o.data, vec_math__mul(vec_math__load(a.data), vec_math__load(b.data)));
+  return o;
+#else
   return INIT_CAST(vec4_t){{a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w}};
+#endif
 }
 
 vec2_t vec2_scalar_mul(vec2_t v, float s) {
@@ -414,7 +1480,13 @@ vec3_t vec3_scalar_mul(vec3_t v, float s) {
 }
 
 vec4_t vec4_scalar_mul(vec4_t v, float s) {
+#if defined(VEC_MATH__SIMD4)
+  vec4_t o;
+  vec_math__store(o.data, vec_math__mul(vec_math__load(v.data), vec_math__splat(s)));
+  return o;
+#else
   return INIT_CAST(vec4_t){{v.x * s, v.y * s, v.z * s, v.w * s}};
+#endif
 }
 
 vec2_t vec2_div(vec2_t a, vec2_t b) {
@@ -426,7 +1498,13 @@ vec3_t vec3_div(vec3_t a, vec3_t b) {
 }
 
 vec4_t vec4_div(vec4_t a, vec4_t b) {
+#if defined(VEC_MATH__SIMD4)
+  vec4_t o;
+  vec_math__store(o.data, vec_math__div(vec_math__load(a.data), vec_math__load(b.data)));
+  return o;
+#else
   return INIT_CAST(vec4_t){{a.x / b.x, a.y / b.y, a.z / b.z, a.w / b.w}};
+#endif
 }
 
 vec2_t vec2_scalar_div(vec2_t v, float s) {
@@ -440,9 +1518,15 @@ vec3_t vec3_scalar_div(vec3_t v, float s) {
 }
 
 vec4_t vec4_scalar_div(vec4_t v, float s) {
+#if defined(VEC_MATH__SIMD4)
+  vec4_t o;
+  vec_math__store(o.data, vec_math__mul(vec_math__load(v.data), vec_math__splat(1.0f / s)));
+  return o;
+#else
   float denom = 1.0f / s;
   return INIT_CAST(vec4_t){
       {v.x * denom, v.y * denom, v.z * denom, v.w * denom}};
+#endif
 }
 
 vec2_t vec2_abs(vec2_t v) {
@@ -790,6 +1874,11 @@ mat3_t mat3_add(mat3_t a, mat3_t b) {
 }
 
 mat4_t mat4_add(mat4_t a, mat4_t b) {
+#if defined(VEC_MATH__SIMD4)
+  mat4_t o;
+  mat4_add_ptr(&a, &b, &o);
+  return o;
+#else
   mat4_t o;
   o.data[0] = a.data[0] + b.data[0];
   o.data[1] = a.data[1] + b.data[1];
@@ -808,6 +1897,7 @@ mat4_t mat4_add(mat4_t a, mat4_t b) {
   o.data[14] = a.data[14] + b.data[14];
   o.data[15] = a.data[15] + b.data[15];
   return o;
+#endif
 }
 
 mat2_t mat2_scalar_add(mat2_t m, float s) {
@@ -878,6 +1968,11 @@ mat3_t mat3_sub(mat3_t a, mat3_t b) {
 }
 
 mat4_t mat4_sub(mat4_t a, mat4_t b) {
+#if defined(VEC_MATH__SIMD4)
+  mat4_t o;
+  mat4_sub_ptr(&a, &b, &o);
+  return o;
+#else
   mat4_t o;
   o.data[0] = a.data[0] - b.data[0];
   o.data[1] = a.data[1] - b.data[1];
@@ -896,6 +1991,7 @@ mat4_t mat4_sub(mat4_t a, mat4_t b) {
   o.data[14] = a.data[14] - b.data[14];
   o.data[15] = a.data[15] - b.data[15];
   return o;
+#endif
 }
 
 mat2_t mat2_scalar_sub(mat2_t m, float s) {
@@ -977,43 +2073,9 @@ mat3_t mat3_mul(mat3_t a, mat3_t b) {
   return o;
 }
 
-mat4_t mat4_mul(mat4_t a, mat4_t b) {
+mat4_t mat4_mul_scalar(mat4_t a, mat4_t b) {
   mat4_t o;
-  o.data[0] = b.data[0] * a.data[0] + b.data[1] * a.data[4] +
-              b.data[2] * a.data[8] + b.data[3] * a.data[12];
-  o.data[1] = b.data[0] * a.data[1] + b.data[1] * a.data[5] +
-              b.data[2] * a.data[9] + b.data[3] * a.data[13];
-  o.data[2] = b.data[0] * a.data[2] + b.data[1] * a.data[6] +
-              b.data[2] * a.data[10] + b.data[3] * a.data[14];
-  o.data[3] = b.data[0] * a.data[3] + b.data[1] * a.data[7] +
-              b.data[2] * a.data[11] + b.data[3] * a.data[15];
-
-  o.data[4] = b.data[4] * a.data[0] + b.data[5] * a.data[4] +
-              b.data[6] * a.data[8] + b.data[7] * a.data[12];
-  o.data[5] = b.data[4] * a.data[1] + b.data[5] * a.data[5] +
-              b.data[6] * a.data[9] + b.data[7] * a.data[13];
-  o.data[6] = b.data[4] * a.data[2] + b.data[5] * a.data[6] +
-              b.data[6] * a.data[10] + b.data[7] * a.data[14];
-  o.data[7] = b.data[4] * a.data[3] + b.data[5] * a.data[7] +
-              b.data[6] * a.data[11] + b.data[7] * a.data[15];
-
-  o.data[8] = b.data[8] * a.data[0] + b.data[9] * a.data[4] +
-              b.data[10] * a.data[8] + b.data[11] * a.data[12];
-  o.data[9] = b.data[8] * a.data[1] + b.data[9] * a.data[5] +
-              b.data[10] * a.data[9] + b.data[11] * a.data[13];
-  o.data[10] = b.data[8] * a.data[2] + b.data[9] * a.data[6] +
-               b.data[10] * a.data[10] + b.data[11] * a.data[14];
-  o.data[11] = b.data[8] * a.data[3] + b.data[9] * a.data[7] +
-               b.data[10] * a.data[11] + b.data[11] * a.data[15];
-
-  o.data[12] = b.data[12] * a.data[0] + b.data[13] * a.data[4] +
-               b.data[14] * a.data[8] + b.data[15] * a.data[12];
-  o.data[13] = b.data[12] * a.data[1] + b.data[13] * a.data[5] +
-               b.data[14] * a.data[9] + b.data[15] * a.data[13];
-  o.data[14] = b.data[12] * a.data[2] + b.data[13] * a.data[6] +
-               b.data[14] * a.data[10] + b.data[15] * a.data[14];
-  o.data[15] = b.data[12] * a.data[3] + b.data[13] * a.data[7] +
-               b.data[14] * a.data[11] + b.data[15] * a.data[15];
+  vec_math__mat4_mul_ref(a.data, b.data, o.data);
   return o;
 }
 
@@ -1041,6 +2103,11 @@ mat3_t mat3_scalar_mul(mat3_t m, float s) {
 }
 
 mat4_t mat4_scalar_mul(mat4_t m, float s) {
+#if defined(VEC_MATH__SIMD4)
+  mat4_t o;
+  mat4_scalar_mul_ptr(&m, s, &o);
+  return o;
+#else
   mat4_t o;
   o.data[0] = m.data[0] * s;
   o.data[1] = m.data[1] * s;
@@ -1059,6 +2126,7 @@ mat4_t mat4_scalar_mul(mat4_t m, float s) {
   o.data[14] = m.data[14] * s;
   o.data[15] = m.data[15] * s;
   return o;
+#endif
 }
 
 vec2_t mat2_vec2_mul(mat2_t m, vec2_t v) {
@@ -1076,23 +2144,15 @@ vec3_t mat3_vec3_mul(mat3_t m, vec3_t v) {
   return o;
 }
 
-vec3_t mat4_vec3_mul(mat4_t m, vec3_t v, int32_t is_point) {
+vec3_t mat4_vec3_mul_scalar(mat4_t m, vec3_t v, int32_t is_point) {
   vec3_t o;
-  o.x = m.data[0] * v.x + m.data[4] * v.y + m.data[8] * v.z +
-        (float)is_point * m.data[12];
-  o.y = m.data[1] * v.x + m.data[5] * v.y + m.data[9] * v.z +
-        (float)is_point * m.data[13];
-  o.z = m.data[2] * v.x + m.data[6] * v.y + m.data[10] * v.z +
-        (float)is_point * m.data[14];
+  vec_math__mat4_vec3_mul_ref(m.data, v.data, is_point, o.data);
   return o;
 }
 
-vec4_t mat4_vec4_mul(mat4_t m, vec4_t v) {
+vec4_t mat4_vec4_mul_scalar(mat4_t m, vec4_t v) {
   vec4_t o;
-  o.x = m.data[0] * v.x + m.data[4] * v.y + m.data[8] * v.z + m.data[12] * v.w;
-  o.y = m.data[1] * v.x + m.data[5] * v.y + m.data[9] * v.z + m.data[13] * v.w;
-  o.z = m.data[2] * v.x + m.data[6] * v.y + m.data[10] * v.z + m.data[14] * v.w;
-  o.w = m.data[3] * v.x + m.data[7] * v.y + m.data[11] * v.z + m.data[15] * v.w;
+  vec_math__mat4_vec4_mul_ref(m.data, v.data, o.data);
   return o;
 }
 
@@ -1284,7 +2344,7 @@ mat4_t mat4_se3_inverse(mat4_t m) {
   return m;
 }
 
-mat4_t mat4_inverse(mat4_t m) {
+mat4_t mat4_inverse_scalar(mat4_t m) {
   /* Inverse using cramers rule
           1. Transpose  M
           2. Calculate cofactor matrix C
@@ -1413,7 +2473,7 @@ mat3_t mat3_transpose(mat3_t m) {
   return mt;
 }
 
-mat4_t mat4_transpose(mat4_t m) {
+mat4_t mat4_transpose_scalar(mat4_t m) {
   mat4_t mt;
   mt.data[0] = m.data[0];
   mt.data[1] = m.data[4];
@@ -1434,6 +2494,253 @@ mat4_t mat4_transpose(mat4_t m) {
   return mt;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//       SIMD MATRIX KERNELS
+////////////////////////////////////////////////////////////////////////////////
+
+mat4_t mat4_mul(mat4_t a, mat4_t b) {
+  mat4_t o;
+  mat4_mul_ptr(&a, &b, &o);
+  return o;
+}
+
+vec3_t mat4_vec3_mul(mat4_t m, vec3_t v, int32_t is_point) {
+  vec3_t o;
+  mat4_vec3_mul_ptr(&m, &v, is_point, &o);
+  return o;
+}
+
+vec4_t mat4_vec4_mul(mat4_t m, vec4_t v) {
+  vec4_t o;
+  mat4_vec4_mul_ptr(&m, &v, &o);
+  return o;
+}
+
+mat4_t mat4_inverse(mat4_t m) {
+  mat4_t mi;
+  mat4_inverse_ptr(&m, &mi);
+  return mi;
+}
+
+mat4_t mat4_transpose(mat4_t m) {
+  mat4_t mt;
+  mat4_transpose_ptr(&m, &mt);
+  return mt;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//       BATCH IMPLEMENTATION
+////////////////////////////////////////////////////////////////////////////////
+
+void mat4_vec3_mul_batch(mat4_t m, const vec3_t *v, vec3_t *out, int32_t count,
+                         int32_t is_point) {
+  int32_t i = 0;
+#if defined(VEC_MATH__SIMD4)
+  // Four vec3 per step as x, y and z registers, one splatted element of m
+  // per product, the translation term is the scalar is_point * m[12 + r]
+  vec_math__v4 e[12];
+  for (int k = 0; k < 12; ++k) {
+    e[k] = vec_math__splat(m.data[(k / 3) * 4 + k % 3]);
+  }
+  const vec_math__v4 tx = vec_math__splat((float)is_point * m.data[12]);
+  const vec_math__v4 ty = vec_math__splat((float)is_point * m.data[13]);
+  const vec_math__v4 tz = vec_math__splat((float)is_point * m.data[14]);
+  for (; i + 4 <= count; i += 4) {
+    vec_math__v4 x, y, z;
+    vec_math__load3x4(v[i].data, &x, &y, &z);
+    vec_math__v4 ox = vec_math__mul(e[0], x);
+    vec_math__v4 oy = vec_math__mul(e[1], x);
+    vec_math__v4 oz = vec_math__mul(e[2], x);
+    ox = vec_math__add(ox, vec_math__mul(e[3], y));
+    oy = vec_math__add(oy, vec_math__mul(e[4], y));
+    oz = vec_math__add(oz, vec_math__mul(e[5], y));
+    ox = vec_math__add(ox, vec_math__mul(e[6], z));
+    oy = vec_math__add(oy, vec_math__mul(e[7], z));
+    oz = vec_math__add(oz, vec_math__mul(e[8], z));
+    vec_math__store3x4(out[i].data, vec_math__add(ox, tx), vec_math__add(oy, ty),
+                       vec_math__add(oz, tz));
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = mat4_vec3_mul_scalar(m, v[i], is_point);
+  }
+}
+
+void mat4_vec4_mul_batch(mat4_t m, const vec4_t *v, vec4_t *out, int32_t count) {
+  int32_t i = 0;
+#if defined(VEC_MATH__SIMD4)
+  const vec_math__v4 c0 = vec_math__load(m.col[0].data);
+  const vec_math__v4 c1 = vec_math__load(m.col[1].data);
+  const vec_math__v4 c2 = vec_math__load(m.col[2].data);
+  const vec_math__v4 c3 = vec_math__load(m.col[3].data);
+  for (; i < count; ++i) {
+    const float *p = v[i].data;
+    vec_math__v4 sum = vec_math__mul(c0, vec_math__splat(p[0]));
+    sum = vec_math__add(sum, vec_math__mul(c1, vec_math__splat(p[1])));
+    sum = vec_math__add(sum, vec_math__mul(c2, vec_math__splat(p[2])));
+    sum = vec_math__add(sum, vec_math__mul(c3, vec_math__splat(p[3])));
+    vec_math__store(out[i].data, sum);
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = mat4_vec4_mul_scalar(m, v[i]);
+  }
+}
+
+void mat4_normal_mul_batch(mat4_t m, const vec3_t *normals, vec3_t *out,
+                           int32_t count) {
+  const mat3_t nm = mat3_transpose(mat3_inverse(mat4_to_mat3(m)));
+  int32_t i = 0;
+#if defined(VEC_MATH__SIMD4)
+  vec_math__v4 e[9];
+  for (int k = 0; k < 9; ++k) {
+    e[k] = vec_math__splat(nm.data[k]);
+  }
+  const vec_math__v4 one = vec_math__splat(1.0f);
+  for (; i + 4 <= count; i += 4) {
+    vec_math__v4 x, y, z;
+    vec_math__load3x4(normals[i].data, &x, &y, &z);
+    vec_math__v4 ox = vec_math__mul(e[0], x);
+    vec_math__v4 oy = vec_math__mul(e[1], x);
+    vec_math__v4 oz = vec_math__mul(e[2], x);
+    ox = vec_math__add(ox, vec_math__mul(e[3], y));
+    oy = vec_math__add(oy, vec_math__mul(e[4], y));
+    oz = vec_math__add(oz, vec_math__mul(e[5], y));
+    ox = vec_math__add(ox, vec_math__mul(e[6], z));
+    oy = vec_math__add(oy, vec_math__mul(e[7], z));
+    oz = vec_math__add(oz, vec_math__mul(e[8], z));
+    vec_math__v4 len_sq = vec_math__mul(ox, ox);
+    len_sq = vec_math__add(len_sq, vec_math__mul(oy, oy));
+    len_sq = vec_math__add(len_sq, vec_math__mul(oz, oz));
+    const vec_math__v4 denom = vec_math__div(one, vec_math__sqrt(len_sq));
+    vec_math__store3x4(out[i].data, vec_math__mul(ox, denom),
+                       vec_math__mul(oy, denom), vec_math__mul(oz, denom));
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = vec3_normalize(mat3_vec3_mul(nm, normals[i]));
+  }
+}
+
+void mat4_mul_batch(mat4_t a, const mat4_t *b, mat4_t *out, int32_t count) {
+  int32_t i = 0;
+#if defined(VEC_MATH_SIMD_AVX)
+  // Two output columns per step: the columns of b come straight from the
+  // array so they load 256 bits at a time, each 128-bit half broadcasts the
+  // coefficients of its own column
+  const __m256 a0 = _mm256_broadcast_ps((const __m128 *)a.col[0].data);
+  const __m256 a1 = _mm256_broadcast_ps((const __m128 *)a.col[1].data);
+  const __m256 a2 = _mm256_broadcast_ps((const __m128 *)a.col[2].data);
+  const __m256 a3 = _mm256_broadcast_ps((const __m128 *)a.col[3].data);
+  for (; i < count; ++i) {
+    for (int c = 0; c < 4; c += 2) {
+      const __m256 bc = _mm256_loadu_ps(b[i].col[c].data);
+      __m256 sum = _mm256_mul_ps(a0, _mm256_shuffle_ps(bc, bc, 0x00));
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(a1, _mm256_shuffle_ps(bc, bc, 0x55)));
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(a2, _mm256_shuffle_ps(bc, bc, 0xAA)));
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(a3, _mm256_shuffle_ps(bc, bc, 0xFF)));
+      _mm256_storeu_ps(out[i].col[c].data, sum);
+    }
+  }
+#elif defined(VEC_MATH__SIMD4)
+  const vec_math__v4 a0 = vec_math__load(a.col[0].data);
+  const vec_math__v4 a1 = vec_math__load(a.col[1].data);
+  const vec_math__v4 a2 = vec_math__load(a.col[2].data);
+  const vec_math__v4 a3 = vec_math__load(a.col[3].data);
+  for (; i < count; ++i) {
+    for (int c = 0; c < 4; ++c) {
+      const float *bc = b[i].col[c].data;
+      vec_math__v4 sum = vec_math__mul(a0, vec_math__splat(bc[0]));
+      sum = vec_math__add(sum, vec_math__mul(a1, vec_math__splat(bc[1])));
+      sum = vec_math__add(sum, vec_math__mul(a2, vec_math__splat(bc[2])));
+      sum = vec_math__add(sum, vec_math__mul(a3, vec_math__splat(bc[3])));
+      vec_math__store(out[i].col[c].data, sum);
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = mat4_mul_scalar(a, b[i]);
+  }
+}
+
+void mat4_batch_mul(const mat4_t *a, mat4_t b, mat4_t *out, int32_t count) {
+  int32_t i = 0;
+#if defined(VEC_MATH__SIMD4)
+  // The coefficients of b are splatted once, every product is then four
+  // column loads of a[i] and 16 multiply-adds
+  vec_math__v4 e[16];
+  for (int k = 0; k < 16; ++k) {
+    e[k] = vec_math__splat(b.data[k]);
+  }
+  for (; i < count; ++i) {
+    const vec_math__v4 a0 = vec_math__load(a[i].col[0].data);
+    const vec_math__v4 a1 = vec_math__load(a[i].col[1].data);
+    const vec_math__v4 a2 = vec_math__load(a[i].col[2].data);
+    const vec_math__v4 a3 = vec_math__load(a[i].col[3].data);
+    for (int c = 0; c < 4; ++c) {
+      vec_math__v4 sum = vec_math__mul(a0, e[4 * c]);
+      sum = vec_math__add(sum, vec_math__mul(a1, e[4 * c + 1]));
+      sum = vec_math__add(sum, vec_math__mul(a2, e[4 * c + 2]));
+      sum = vec_math__add(sum, vec_math__mul(a3, e[4 * c + 3]));
+      vec_math__store(out[i].col[c].data, sum);
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = mat4_mul_scalar(a[i], b);
+  }
+}
+
+void vec3_normalize_batch(const vec3_t *v, vec3_t *out, int32_t count) {
+  int32_t i = 0;
+#if defined(VEC_MATH__SIMD4)
+  const vec_math__v4 one = vec_math__splat(1.0f);
+  for (; i + 4 <= count; i += 4) {
+    vec_math__v4 x, y, z;
+    vec_math__load3x4(v[i].data, &x, &y, &z);
+    vec_math__v4 len_sq = vec_math__mul(x, x);
+    len_sq = vec_math__add(len_sq, vec_math__mul(y, y));
+    len_sq = vec_math__add(len_sq, vec_math__mul(z, z));
+    const vec_math__v4 denom = vec_math__div(one, vec_math__sqrt(len_sq));
+    vec_math__store3x4(out[i].data, vec_math__mul(x, denom),
+                       vec_math__mul(y, denom), vec_math__mul(z, denom));
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = vec3_normalize(v[i]);
+  }
+}
+
+void vec4_normalize_batch(const vec4_t *v, vec4_t *out, int32_t count) {
+  int32_t i = 0;
+#if defined(VEC_MATH__SIMD4)
+  // Transposed four at a time, so the squares are summed in the scalar order
+  const vec_math__v4 one = vec_math__splat(1.0f);
+  for (; i + 4 <= count; i += 4) {
+    vec_math__v4 r[4];
+    for (int k = 0; k < 4; ++k) {
+      r[k] = vec_math__load(v[i + k].data);
+    }
+    vec_math__transpose4(r);
+    vec_math__v4 len_sq = vec_math__mul(r[0], r[0]);
+    len_sq = vec_math__add(len_sq, vec_math__mul(r[1], r[1]));
+    len_sq = vec_math__add(len_sq, vec_math__mul(r[2], r[2]));
+    len_sq = vec_math__add(len_sq, vec_math__mul(r[3], r[3]));
+    const vec_math__v4 denom = vec_math__div(one, vec_math__sqrt(len_sq));
+    for (int k = 0; k < 4; ++k) {
+      r[k] = vec_math__mul(r[k], denom);
+    }
+    vec_math__transpose4(r);
+    for (int k = 0; k < 4; ++k) {
+      vec_math__store(out[i + k].data, r[k]);
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = vec4_normalize(v[i]);
+  }
+}
+
 mat4_t look_at(vec3_t eye, vec3_t center, vec3_t up) {
   vec3_t z = vec3_normalize(vec3_sub(eye, center));
   vec3_t x = vec3_normalize(vec3_cross(up, z));
@@ -1486,8 +2793,8 @@ mat4_t ortho(float left, float right, float bottom, float top, float z_near,
   return o;
 }
 
-vec3_t project(vec4_t obj, mat4_t modelview, mat4_t project, vec4_t viewport) {
-  vec4_t tmp = mat4_vec4_mul(mat4_mul(project, modelview), obj);
+static vec3_t vec_math__project(mat4_t mvp, vec4_t obj, vec4_t viewport) {
+  vec4_t tmp = mat4_vec4_mul(mvp, obj);
   tmp = vec4_scalar_div(tmp, tmp.w);
 
   vec3_t win;
@@ -1498,9 +2805,7 @@ vec3_t project(vec4_t obj, mat4_t modelview, mat4_t project, vec4_t viewport) {
   return win;
 }
 
-vec4_t unproject(vec3_t win, mat4_t modelview, mat4_t project,
-                 vec4_t viewport) {
-  mat4_t inv_pm = mat4_inverse(mat4_mul(project, modelview));
+static vec4_t vec_math__unproject(mat4_t inv_pm, vec3_t win, vec4_t viewport) {
   vec4_t tmp;
   tmp.x = (2.0f * (win.x - viewport.x)) / viewport.z - 1.0f;
   tmp.y = (2.0f * (win.y - viewport.y)) / viewport.w - 1.0f;
@@ -1512,6 +2817,96 @@ vec4_t unproject(vec3_t win, mat4_t modelview, mat4_t project,
   return obj;
 }
 
+vec3_t project(vec4_t obj, mat4_t modelview, mat4_t project, vec4_t viewport) {
+  return vec_math__project(mat4_mul(project, modelview), obj, viewport);
+}
+
+vec4_t unproject(vec3_t win, mat4_t modelview, mat4_t project,
+                 vec4_t viewport) {
+  return vec_math__unproject(mat4_inverse(mat4_mul(project, modelview)), win,
+                             viewport);
+}
+
+#if defined(VEC_MATH__SIMD4)
+// Four points through m as x, y and z registers with w = 1, in the order of
+// mat4_vec4_mul, then divided by their w like vec4_scalar_div
+static inline void vec_math__transform_divide4(const vec_math__v4 e[16],
+                                               vec_math__v4 *x,
+                                               vec_math__v4 *y,
+                                               vec_math__v4 *z) {
+  vec_math__v4 o[4];
+  for (int r = 0; r < 4; ++r) {
+    o[r] = vec_math__mul(e[r], *x);
+    o[r] = vec_math__add(o[r], vec_math__mul(e[4 + r], *y));
+    o[r] = vec_math__add(o[r], vec_math__mul(e[8 + r], *z));
+    o[r] = vec_math__add(o[r], e[12 + r]);
+  }
+  const vec_math__v4 denom = vec_math__div(vec_math__splat(1.0f), o[3]);
+  *x = vec_math__mul(o[0], denom);
+  *y = vec_math__mul(o[1], denom);
+  *z = vec_math__mul(o[2], denom);
+}
+#endif
+
+void project_batch(mat4_t mvp, vec4_t viewport, const vec3_t *points,
+                   vec3_t *out, int32_t count) {
+  int32_t i = 0;
+#if defined(VEC_MATH__SIMD4)
+  vec_math__v4 e[16];
+  for (int k = 0; k < 16; ++k) {
+    e[k] = vec_math__splat(mvp.data[k]);
+  }
+  const vec_math__v4 one = vec_math__splat(1.0f);
+  const vec_math__v4 two = vec_math__splat(2.0f);
+  const vec_math__v4 vx = vec_math__splat(viewport.x);
+  const vec_math__v4 vy = vec_math__splat(viewport.y);
+  const vec_math__v4 vw = vec_math__splat(viewport.z);
+  const vec_math__v4 vh = vec_math__splat(viewport.w);
+  for (; i + 4 <= count; i += 4) {
+    vec_math__v4 x, y, z;
+    vec_math__load3x4(points[i].data, &x, &y, &z);
+    vec_math__transform_divide4(e, &x, &y, &z);
+    x = vec_math__add(vx, vec_math__div(vec_math__mul(vw, vec_math__add(x, one)), two));
+    y = vec_math__add(vy, vec_math__div(vec_math__mul(vh, vec_math__add(y, one)), two));
+    z = vec_math__div(vec_math__add(z, one), two);
+    vec_math__store3x4(out[i].data, x, y, z);
+  }
+#endif
+  for (; i < count; ++i) {
+    const vec3_t p = points[i];
+    out[i] = vec_math__project(mvp, vec4(p.x, p.y, p.z, 1.0f), viewport);
+  }
+}
+
+void unproject_batch(mat4_t inverse_mvp, vec4_t viewport, const vec3_t *win,
+                     vec3_t *out, int32_t count) {
+  int32_t i = 0;
+#if defined(VEC_MATH__SIMD4)
+  vec_math__v4 e[16];
+  for (int k = 0; k < 16; ++k) {
+    e[k] = vec_math__splat(inverse_mvp.data[k]);
+  }
+  const vec_math__v4 one = vec_math__splat(1.0f);
+  const vec_math__v4 two = vec_math__splat(2.0f);
+  const vec_math__v4 vx = vec_math__splat(viewport.x);
+  const vec_math__v4 vy = vec_math__splat(viewport.y);
+  const vec_math__v4 vw = vec_math__splat(viewport.z);
+  const vec_math__v4 vh = vec_math__splat(viewport.w);
+  for (; i + 4 <= count; i += 4) {
+    vec_math__v4 x, y, z;
+    vec_math__load3x4(win[i].data, &x, &y, &z);
+    x = vec_math__sub(vec_math__div(vec_math__mul(two, vec_math__sub(x, vx)), vw), one);
+    y = vec_math__sub(vec_math__div(vec_math__mul(two, vec_math__sub(y, vy)), vh), one);
+    z = vec_math__sub(vec_math__mul(two, z), one);
+    vec_math__transform_divide4(e, &x, &y, &z);
+    vec_math__store3x4(out[i].data, x, y, z);
+  }
+#endif
+  for (; i < count; ++i) {
+    const vec4_t obj = vec_math__unproject(inverse_mvp, win[i], viewport);
+    out[i] = vec3(obj.x, obj.y, obj.z);
+  }
+}
 
 mat4_t mat4_make_translation(vec3_t t) {
   mat4_t m = mat4_identity();
@@ -1524,13 +2919,10 @@ mat4_t mat4_make_translation(vec3_t t) {
 /* derivation :
  * http://www.euclideanspace.com/matrixhs/geometry/rotations/conversions/angleToMatrix/
  */
-mat4_t mat4_make_rotation(vec3_t v, float angle) {
-  float c = cosf(angle);
-  float s = sinf(angle);
+// Rotation about a unit axis by the angle of cosine c and sine s
+static mat4_t vec_math__rotation(vec3_t axis, float c, float s) {
   float t = 1.0f - c;
 
-  vec3_t axis = vec3_normalize(v);
-
   mat4_t rotate = mat4_identity();
   rotate.data[0] = c + axis.x * axis.x * t;
   rotate.data[5] = c + axis.y * axis.y * t;
@@ -1557,6 +2949,10 @@ mat4_t mat4_make_rotation(vec3_t v, float angle) {
   return rotate;
 }
 
+mat4_t mat4_make_rotation(vec3_t v, float angle) {
+  return vec_math__rotation(vec3_normalize(v), cosf(angle), sinf(angle));
+}
+
 // Euler angles decoded as yaw, pitch, roll
 // from https://www.geometrictools.com/Documentation/EulerAngles.pdf
 vec3_t mat3_to_euler(mat3_t m) {
@@ -1692,4 +3088,464 @@ void mat3_print(mat3_t m) { mat3_fprint(m, stdout); }
 
 void mat4_print(mat4_t m) { mat4_fprint(m, stdout); }
 
+////////////////////////////////////////////////////////////////////////////////
+//       QUATERNION IMPLEMENTATION
+////////////////////////////////////////////////////////////////////////////////
+// The batches evaluate the same expressions on x, y, z and w registers holding
+// four quaternions, so every expression below keeps one operation order.
+
+quat_t quat_from_axis_angle(vec3_t axis, float angle) {
+  const vec3_t n = vec3_normalize(axis);
+  const float s = sinf(0.5f * angle);
+  return INIT_CAST(quat_t){{n.x * s, n.y * s, n.z * s, cosf(0.5f * angle)}};
+}
+
+void quat_to_axis_angle(quat_t q, vec3_t *out_axis, float *out_angle) {
+  const float w = q.w > 1.0f ? 1.0f : (q.w < -1.0f ? -1.0f : q.w);
+  const float s = sqrtf(1.0f - w * w);
+  *out_angle = 2.0f * acosf(w);
+  *out_axis = s < 1e-6f ? vec3(1.0f, 0.0f, 0.0f) : vec3(q.x / s, q.y / s, q.z / s);
+}
+
+quat_t quat_from_mat3(mat3_t m) {
+  // Shepperd: start from the largest of w, x, y, z to stay away from 0 / 0
+  const float *d = m.data;
+  const float trace = d[0] + d[4] + d[8];
+  quat_t q;
+  if (trace > 0.0f) {
+    const float s = 0.5f / sqrtf(trace + 1.0f);
+    q = quat((d[5] - d[7]) * s, (d[6] - d[2]) * s, (d[1] - d[3]) * s, 0.25f / s);
+  } else if (d[0] > d[4] && d[0] > d[8]) {
+    const float s = 0.5f / sqrtf(1.0f + d[0] - d[4] - d[8]);
+    q = quat(0.25f / s, (d[3] + d[1]) * s, (d[6] + d[2]) * s, (d[5] - d[7]) * s);
+  } else if (d[4] > d[8]) {
+    const float s = 0.5f / sqrtf(1.0f + d[4] - d[0] - d[8]);
+    q = quat((d[3] + d[1]) * s, 0.25f / s, (d[7] + d[5]) * s, (d[6] - d[2]) * s);
+  } else {
+    const float s = 0.5f / sqrtf(1.0f + d[8] - d[0] - d[4]);
+    q = quat((d[6] + d[2]) * s, (d[7] + d[5]) * s, 0.25f / s, (d[1] - d[3]) * s);
+  }
+  return quat_normalize(q);
+}
+
+mat3_t quat_to_mat3(quat_t q) {
+  const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+  const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+  const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+  mat3_t m;
+  m.data[0] = 1.0f - 2.0f * (yy + zz);
+  m.data[1] = 2.0f * (xy + wz);
+  m.data[2] = 2.0f * (xz - wy);
+  m.data[3] = 2.0f * (xy - wz);
+  m.data[4] = 1.0f - 2.0f * (xx + zz);
+  m.data[5] = 2.0f * (yz + wx);
+  m.data[6] = 2.0f * (xz + wy);
+  m.data[7] = 2.0f * (yz - wx);
+  m.data[8] = 1.0f - 2.0f * (xx + yy);
+  return m;
+}
+
+mat4_t quat_to_mat4(quat_t q) {
+  const mat3_t r = quat_to_mat3(q);
+  mat4_t m = mat4_identity();
+  for (int c = 0; c < 3; ++c) {
+    m.col[c] = vec3_to_vec4(r.col[c], 0.0f);
+  }
+  return m;
+}
+
+quat_t quat_mul(quat_t a, quat_t b) {
+  quat_t o;
+#if defined(VEC_MATH__SIMD4)
+  // Lane-wise the sums below, a subtraction being the addition of the negated
+  // product. Also keeps gcc from fusing the scalar form into fmsubadd.
+  const float s1[4] = {b.w, -b.z, b.y, -b.x};
+  const float s2[4] = {b.z, b.w, -b.x, -b.y};
+  const float s3[4] = {-b.y, b.x, b.w, -b.z};
+  vec_math__v4 sum = vec_math__mul(vec_math__splat(a.w), vec_math__load(b.data));
+  sum = vec_math__add(sum, vec_math__mul(vec_math__splat(a.x), vec_math__load(s1)));
+  sum = vec_math__add(sum, vec_math__mul(vec_math__splat(a.y), vec_math__load(s2)));
+  sum = vec_math__add(sum, vec_math__mul(vec_math__splat(a.z), vec_math__load(s3)));
+  vec_math__store(o.data, sum);
+#else
+  o.x = a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y;
+  o.y = a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x;
+  o.z = a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w;
+  o.w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z;
+#endif
+  return o;
+}
+
+quat_t quat_conjugate(quat_t q) { return quat(-q.x, -q.y, -q.z, q.w); }
+
+quat_t quat_inverse(quat_t q) {
+  const float denom = 1.0f / quat_dot(q, q);
+  return quat(-q.x * denom, -q.y * denom, -q.z * denom, q.w * denom);
+}
+
+quat_t quat_normalize(quat_t q) {
+  const float denom = 1.0f / sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+  return quat(q.x * denom, q.y * denom, q.z * denom, q.w * denom);
+}
+
+float quat_dot(quat_t a, quat_t b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+vec3_t quat_rotate(quat_t q, vec3_t v) {
+  // v + w t + u x t with t = 2 u x v, u the vector part
+  const vec3_t u = vec3(q.x, q.y, q.z);
+  const vec3_t t = vec3_scalar_mul(vec3_cross(u, v), 2.0f);
+  return vec3_add(vec3_add(v, vec3_scalar_mul(t, q.w)), vec3_cross(u, t));
+}
+
+quat_t quat_nlerp(quat_t a, quat_t b, float t) {
+  const float tb = quat_dot(a, b) < 0.0f ? -t : t;
+  const float ta = 1.0f - t;
+  return quat_normalize(quat(a.x * ta + b.x * tb, a.y * ta + b.y * tb,
+                             a.z * ta + b.z * tb, a.w * ta + b.w * tb));
+}
+
+quat_t quat_slerp(quat_t a, quat_t b, float t) {
+  float d = quat_dot(a, b);
+  const float sign = d < 0.0f ? -1.0f : 1.0f;
+  d *= sign;
+  // Nearly parallel, sin(theta) vanishes and nlerp is as accurate
+  if (d > 0.9995f) {
+    return quat_nlerp(a, b, t);
+  }
+  const float theta = acosf(d);
+  const float denom = 1.0f / sinf(theta);
+  const float ta = sinf((1.0f - t) * theta) * denom;
+  const float tb = sinf(t * theta) * denom * sign;
+  return quat(a.x * ta + b.x * tb, a.y * ta + b.y * tb, a.z * ta + b.z * tb,
+              a.w * ta + b.w * tb);
+}
+
+#if defined(VEC_MATH__SIMD4)
+// Four quaternions to and from x, y, z, w registers
+static inline void vec_math__quat_load4(const quat_t *q, vec_math__v4 r[4]) {
+  for (int k = 0; k < 4; ++k) {
+    r[k] = vec_math__load(q[k].data);
+  }
+  vec_math__transpose4(r);
+}
+
+static inline void vec_math__quat_store4(quat_t *q, vec_math__v4 r[4]) {
+  vec_math__transpose4(r);
+  for (int k = 0; k < 4; ++k) {
+    vec_math__store(q[k].data, r[k]);
+  }
+}
+
+static inline void vec_math__quat_normalize4(vec_math__v4 r[4]) {
+  vec_math__v4 len_sq = vec_math__mul(r[0], r[0]);
+  len_sq = vec_math__add(len_sq, vec_math__mul(r[1], r[1]));
+  len_sq = vec_math__add(len_sq, vec_math__mul(r[2], r[2]));
+  len_sq = vec_math__add(len_sq, vec_math__mul(r[3], r[3]));
+  const vec_math__v4 denom = vec_math__div(vec_math__splat(1.0f), vec_math__sqrt(len_sq));
+  for (int k = 0; k < 4; ++k) {
+    r[k] = vec_math__mul(r[k], denom);
+  }
+}
+#endif
+
+void quat_mul_batch(quat_t a, const quat_t *b, quat_t *out, int32_t count) {
+  int32_t i = 0;
+#if defined(VEC_MATH__SIMD4)
+  const vec_math__v4 ax = vec_math__splat(a.x), ay = vec_math__splat(a.y);
+  const vec_math__v4 az = vec_math__splat(a.z), aw = vec_math__splat(a.w);
+  for (; i + 4 <= count; i += 4) {
+    vec_math__v4 r[4];
+    vec_math__quat_load4(b + i, r);
+    const vec_math__v4 bx = r[0], by = r[1], bz = r[2], bw = r[3];
+    r[0] = vec_math__sub(vec_math__add(vec_math__add(vec_math__mul(aw, bx), vec_math__mul(ax, bw)),
+                                       vec_math__mul(ay, bz)), vec_math__mul(az, by));
+    r[1] = vec_math__add(vec_math__add(vec_math__sub(vec_math__mul(aw, by), vec_math__mul(ax, bz)),
+                                       vec_math__mul(ay, bw)), vec_math__mul(az, bx));
+    r[2] = vec_math__add(vec_math__sub(vec_math__add(vec_math__mul(aw, bz), vec_math__mul(ax, by)),
+                                       vec_math__mul(ay, bx)), vec_math__mul(az, bw));
+    r[3] = vec_math__sub(vec_math__sub(vec_math__sub(vec_math__mul(aw, bw), vec_math__mul(ax, bx)),
+                                       vec_math__mul(ay, by)), vec_math__mul(az, bz));
+    vec_math__quat_store4(out + i, r);
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = quat_mul(a, b[i]);
+  }
+}
+
+void quat_nlerp_batch(const quat_t *a, const quat_t *b, float t, quat_t *out,
+                      int32_t count) {
+  int32_t i = 0;
+#if defined(VEC_MATH__SIMD4)
+  const vec_math__v4 ta = vec_math__splat(1.0f - t);
+  const vec_math__v4 tp = vec_math__splat(t);
+  const vec_math__v4 tn = vec_math__splat(-t);
+  const vec_math__v4 zero = vec_math__splat(0.0f);
+  for (; i + 4 <= count; i += 4) {
+    vec_math__v4 ra[4], rb[4];
+    vec_math__quat_load4(a + i, ra);
+    vec_math__quat_load4(b + i, rb);
+    vec_math__v4 d = vec_math__mul(ra[0], rb[0]);
+    for (int k = 1; k < 4; ++k) {
+      d = vec_math__add(d, vec_math__mul(ra[k], rb[k]));
+    }
+    const vec_math__v4 tb = vec_math__select(vec_math__less(d, zero), tn, tp);
+    for (int k = 0; k < 4; ++k) {
+      ra[k] = vec_math__add(vec_math__mul(ra[k], ta), vec_math__mul(rb[k], tb));
+    }
+    vec_math__quat_normalize4(ra);
+    vec_math__quat_store4(out + i, ra);
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = quat_nlerp(a[i], b[i], t);
+  }
+}
+
+void quat_normalize_batch(const quat_t *q, quat_t *out, int32_t count) {
+  int32_t i = 0;
+#if defined(VEC_MATH__SIMD4)
+  for (; i + 4 <= count; i += 4) {
+    vec_math__v4 r[4];
+    vec_math__quat_load4(q + i, r);
+    vec_math__quat_normalize4(r);
+    vec_math__quat_store4(out + i, r);
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = quat_normalize(q[i]);
+  }
+}
+
+void quat_to_mat4_batch(const quat_t *q, mat4_t *out, int32_t count) {
+  int32_t i = 0;
+#if defined(VEC_MATH__SIMD4)
+  const vec_math__v4 one = vec_math__splat(1.0f);
+  const vec_math__v4 two = vec_math__splat(2.0f);
+  const float last[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+  const vec_math__v4 col3 = vec_math__load(last);
+  for (; i + 4 <= count; i += 4) {
+    vec_math__v4 r[4];
+    vec_math__quat_load4(q + i, r);
+    const vec_math__v4 xx = vec_math__mul(r[0], r[0]), yy = vec_math__mul(r[1], r[1]);
+    const vec_math__v4 zz = vec_math__mul(r[2], r[2]), xy = vec_math__mul(r[0], r[1]);
+    const vec_math__v4 xz = vec_math__mul(r[0], r[2]), yz = vec_math__mul(r[1], r[2]);
+    const vec_math__v4 wx = vec_math__mul(r[3], r[0]), wy = vec_math__mul(r[3], r[1]);
+    const vec_math__v4 wz = vec_math__mul(r[3], r[2]);
+    // The three rotation columns of the four matrices, zero w lanes, each
+    // transposed from element registers into per matrix columns
+    vec_math__v4 cols[3][4];
+    cols[0][0] = vec_math__sub(one, vec_math__mul(two, vec_math__add(yy, zz)));
+    cols[0][1] = vec_math__mul(two, vec_math__add(xy, wz));
+    cols[0][2] = vec_math__mul(two, vec_math__sub(xz, wy));
+    cols[1][0] = vec_math__mul(two, vec_math__sub(xy, wz));
+    cols[1][1] = vec_math__sub(one, vec_math__mul(two, vec_math__add(xx, zz)));
+    cols[1][2] = vec_math__mul(two, vec_math__add(yz, wx));
+    cols[2][0] = vec_math__mul(two, vec_math__add(xz, wy));
+    cols[2][1] = vec_math__mul(two, vec_math__sub(yz, wx));
+    cols[2][2] = vec_math__sub(one, vec_math__mul(two, vec_math__add(xx, yy)));
+    for (int c = 0; c < 3; ++c) {
+      cols[c][3] = vec_math__splat(0.0f);
+      vec_math__transpose4(cols[c]);
+    }
+    for (int k = 0; k < 4; ++k) {
+      for (int c = 0; c < 3; ++c) {
+        vec_math__store(out[i + k].col[c].data, cols[c][k]);
+      }
+      vec_math__store(out[i + k].col[3].data, col3);
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = quat_to_mat4(q[i]);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//       AFFINE IMPLEMENTATION
+////////////////////////////////////////////////////////////////////////////////
+
+affine_t affine_from_mat4(mat4_t m) {
+  affine_t a;
+  for (int c = 0; c < 4; ++c) {
+    a.col[c] = vec4_to_vec3(m.col[c]);
+  }
+  return a;
+}
+
+mat4_t affine_to_mat4(affine_t a) {
+  mat4_t m;
+  for (int c = 0; c < 4; ++c) {
+    m.col[c] = vec3_to_vec4(a.col[c], c == 3 ? 1.0f : 0.0f);
+  }
+  return m;
+}
+
+vec3_t affine_vector_mul(affine_t a, vec3_t v) {
+  vec3_t o;
+  o.x = a.data[0] * v.x + a.data[3] * v.y + a.data[6] * v.z;
+  o.y = a.data[1] * v.x + a.data[4] * v.y + a.data[7] * v.z;
+  o.z = a.data[2] * v.x + a.data[5] * v.y + a.data[8] * v.z;
+  return o;
+}
+
+vec3_t affine_point_mul(affine_t a, vec3_t p) {
+  return vec3_add(affine_vector_mul(a, p), a.col[3]);
+}
+
+affine_t affine_mul(affine_t a, affine_t b) {
+  affine_t o;
+  for (int c = 0; c < 3; ++c) {
+    o.col[c] = affine_vector_mul(a, b.col[c]);
+  }
+  o.col[3] = affine_point_mul(a, b.col[3]);
+  return o;
+}
+
+affine_t affine_inverse(affine_t a) {
+  // Rows of the inverse linear part are the cross products of the columns
+  // over the determinant, the translation goes back through it negated
+  const vec3_t r0 = vec3_cross(a.col[1], a.col[2]);
+  const vec3_t r1 = vec3_cross(a.col[2], a.col[0]);
+  const vec3_t r2 = vec3_cross(a.col[0], a.col[1]);
+  const float denom = 1.0f / vec3_dot(a.col[0], r0);
+  affine_t o;
+  for (int c = 0; c < 3; ++c) {
+    o.col[c] = vec3(r0.data[c] * denom, r1.data[c] * denom, r2.data[c] * denom);
+  }
+  const vec3_t t = affine_vector_mul(o, a.col[3]);
+  o.col[3] = vec3(-t.x, -t.y, -t.z);
+  return o;
+}
+
+mat3_t affine_normal_matrix(affine_t a) {
+  // Transposed rows of affine_inverse before the division
+  const vec3_t r0 = vec3_cross(a.col[1], a.col[2]);
+  const float sign = vec3_dot(a.col[0], r0) < 0.0f ? -1.0f : 1.0f;
+  mat3_t n;
+  n.col[0] = vec3_scalar_mul(r0, sign);
+  n.col[1] = vec3_scalar_mul(vec3_cross(a.col[2], a.col[0]), sign);
+  n.col[2] = vec3_scalar_mul(vec3_cross(a.col[0], a.col[1]), sign);
+  return n;
+}
+
+mat3_t mat4_normal_matrix(mat4_t m) {
+  return affine_normal_matrix(affine_from_mat4(m));
+}
+
+void quat_fprint(quat_t q, FILE *stream) {
+  fprintf(stream, "%12.7f %12.7f %12.7f %12.7f\n", q.x, q.y, q.z, q.w);
+}
+
+void quat_print(quat_t q) { quat_fprint(q, stdout); }
+
+////////////////////////////////////////////////////////////////////////////////
+//       FAST APPROXIMATION IMPLEMENTATION
+////////////////////////////////////////////////////////////////////////////////
+#if defined(VEC_MATH_SIMD_SSE2)
+#define vec_math__lane0(v) _mm_cvtss_f32(v)
+#elif defined(VEC_MATH_SIMD_NEON)
+#define vec_math__lane0(v) vgetq_lane_f32((v), 0)
+#endif
+
+float scalar_rsqrt_fast(float x) {
+#if defined(VEC_MATH__SIMD4)
+  return vec_math__lane0(vec_math__rsqrt4(vec_math__splat(x)));
+#else
+  // Hardware square root and division beat the bit trick and its three
+  // Newton steps (vec_math_fast_bench.c)
+  return 1.0f / sqrtf(x);
+#endif
+}
+
+void scalar_sincos_fast(float x, float *out_sin, float *out_cos) {
+#if defined(VEC_MATH__SIMD4)
+  vec_math__v4 s, c;
+  vec_math__sincos4(vec_math__splat(x), &s, &c);
+  *out_sin = vec_math__lane0(s);
+  *out_cos = vec_math__lane0(c);
+#else
+  const float j = rintf(x * VEC_MATH__2_OVER_PI);
+  const int32_t q = (int32_t)j;
+  float r = x - j * VEC_MATH__PI_2_A;
+  r = r - j * VEC_MATH__PI_2_B;
+  r = r - j * VEC_MATH__PI_2_C;
+  const float z = r * r;
+  const float ps = ((VEC_MATH__SIN_3 * z + VEC_MATH__SIN_2) * z + VEC_MATH__SIN_1) * z * r + r;
+  const float pc = ((VEC_MATH__COS_3 * z + VEC_MATH__COS_2) * z + VEC_MATH__COS_1) * z * z -
+                   0.5f * z + 1.0f;
+  const float s = (q & 1) ? pc : ps;
+  const float c = (q & 1) ? ps : pc;
+  *out_sin = (q & 2) ? -s : s;
+  *out_cos = ((q + 1) & 2) ? -c : c;
+#endif
+}
+
+void scalar_sincos_batch_fast(const float *x, float *out_sin, float *out_cos,
+                              int32_t count) {
+  int32_t i = 0;
+#if defined(VEC_MATH__SIMD4)
+  for (; i + 4 <= count; i += 4) {
+    vec_math__v4 s, c;
+    vec_math__sincos4(vec_math__load(x + i), &s, &c);
+    vec_math__store(out_sin + i, s);
+    vec_math__store(out_cos + i, c);
+  }
+#endif
+  for (; i < count; ++i) {
+    scalar_sincos_fast(x[i], &out_sin[i], &out_cos[i]);
+  }
+}
+
+vec3_t vec3_normalize_fast(vec3_t v) {
+  const float s = scalar_rsqrt_fast(v.x * v.x + v.y * v.y + v.z * v.z);
+  return INIT_CAST(vec3_t){{v.x * s, v.y * s, v.z * s}};
+}
+
+vec4_t vec4_normalize_fast(vec4_t v) {
+  const float s = scalar_rsqrt_fast(v.x * v.x + v.y * v.y + v.z * v.z + v.w * v.w);
+  return INIT_CAST(vec4_t){{v.x * s, v.y * s, v.z * s, v.w * s}};
+}
+
+void vec3_normalize_batch_fast(const vec3_t *v, vec3_t *out, int32_t count) {
+  int32_t i = 0;
+#if defined(VEC_MATH__SIMD4)
+  for (; i + 4 <= count; i += 4) {
+    vec_math__v4 x, y, z;
+    vec_math__load3x4(v[i].data, &x, &y, &z);
+    vec_math__v4 sum = vec_math__mul(x, x);
+    sum = vec_math__add(sum, vec_math__mul(y, y));
+    sum = vec_math__add(sum, vec_math__mul(z, z));
+    const vec_math__v4 s = vec_math__rsqrt4(sum);
+    vec_math__store3x4(out[i].data, vec_math__mul(x, s), vec_math__mul(y, s),
+                       vec_math__mul(z, s));
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = vec3_normalize_fast(v[i]);
+  }
+}
+
+mat4_t mat4_make_rotation_fast(vec3_t axis, float angle) {
+  float s, c;
+  scalar_sincos_fast(angle, &s, &c);
+  return vec_math__rotation(vec3_normalize_fast(axis), c, s);
+}
+
+mat4_t perspective_fast(float fovy, float aspect, float z_near, float z_far) {
+  float s, c;
+  scalar_sincos_fast(fovy * 0.5f, &s, &c);
+  const float ymax = z_near * (s / c);
+  return frustum(-ymax * aspect, ymax * aspect, -ymax, ymax, z_near, z_far);
+}
+
+quat_t quat_from_axis_angle_fast(vec3_t axis, float angle) {
+  const vec3_t n = vec3_normalize_fast(axis);
+  float s, c;
+  scalar_sincos_fast(0.5f * angle, &s, &c);
+  return INIT_CAST(quat_t){{n.x * s, n.y * s, n.z * s, c}};
+}
+
 #endif /*_VEC_MATH_IMPLEMENTATION_*/
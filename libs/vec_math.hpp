@@ -0,0 +1,353 @@
+#ifndef _VEC_MATH_HPP_
+#define _VEC_MATH_HPP_
+
+// Expects vec_math.h to be included first.
+
+// C++ operators over the vec_math.h types. `a * s + b` does not build a
+// vector per operator: every operator returns a small expression node that
+// holds references to its operands, and assigning the expression to a
+// vector or matrix runs one loop over the elements that evaluates the whole
+// tree, unrolled, four elements per SIMD operation for vec4 and mat4 when
+// vec_math.h has a SIMD backend. Element-wise expressions evaluate the same
+// operations in the same order as the C functions, the products, inverse and
+// transpose call the vec_math.h pointer kernels, so results match the C API.
+//
+// vec_math::vec2/vec3/vec4/mat4 wrap vec2_t/vec3_t/vec4_t/mat4_t with the
+// same size and layout. They convert to and from the C unions implicitly,
+// and vec_math::wrap views an existing union as its wrapper without a copy:
+//
+//   vec_math::wrap(vertex.color) = 0.5f * (a + b); // writes the vec4_t in place
+//   mesh->sphere_center = vec_math::normalize(u - v); // converts back
+//
+// The vec2/vec3/vec4 constructor macros of vec_math.h shadow the wrapper
+// names followed by `(`: write `vec_math::vec3 v = vec3(x, y, z);`.
+//
+// Nodes reference their operands until the end of the full expression:
+// assign an expression to a wrapper, do not keep it in an `auto` variable.
+//
+// `*` between two vectors is element-wise (as vec3_mul), between two
+// matrices or a matrix and a vec4 it is the product. Matrix products are
+// evaluated into a temporary when they appear inside a larger expression and
+// straight into the destination when assigned, `m = m * b` included.
+
+namespace vec_math {
+
+namespace detail {
+
+// Shape of the C types: `size` floats in `cols` columns of `size / cols`
+template <class T> struct traits;
+template <> struct traits<vec2_t> { enum { size = 2, cols = 1 }; };
+template <> struct traits<vec3_t> { enum { size = 3, cols = 1 }; };
+template <> struct traits<vec4_t> { enum { size = 4, cols = 1 }; };
+template <> struct traits<mat4_t> { enum { size = 16, cols = 4 }; };
+
+} // namespace detail
+
+// Base of every expression, `E` is the node type
+template <class E> struct expr {
+  const E &self() const { return static_cast<const E &>(*this); }
+};
+
+// A vector or matrix with the layout of its C type `T`
+template <class T> struct value : expr<value<T> > {
+  typedef T c_type;
+  enum { size = detail::traits<T>::size, cols = detail::traits<T>::cols };
+
+  T c;
+
+  value() {}
+  value(const T &v) : c(v) {}
+  template <class E> value(const expr<E> &e) { e.self().eval_to(&c); }
+  template <class E> value &operator=(const expr<E> &e) {
+    e.self().eval_to(&c);
+    return *this;
+  }
+  template <class E> value &operator+=(const expr<E> &e) { return *this = *this + e; }
+  template <class E> value &operator-=(const expr<E> &e) { return *this = *this - e; }
+  value &operator*=(float s) { return *this = *this * s; }
+  value &operator/=(float s) { return *this = *this / s; }
+
+  operator T &() { return c; }
+  operator const T &() const { return c; }
+  float &operator[](int i) { return c.data[i]; }
+  float operator[](int i) const { return c.data[i]; }
+
+#if defined(VEC_MATH__SIMD4)
+  vec_math__v4 packet(int i) const { return vec_math__load(c.data + i); }
+#endif
+  void eval_to(T *out) const { *out = c; }
+};
+
+typedef value<vec2_t> vec2;
+typedef value<vec3_t> vec3;
+typedef value<vec4_t> vec4;
+typedef value<mat4_t> mat4;
+
+// The wrapper is its C union: same size, the union at offset zero
+template <class T> value<T> &wrap(T &v) { return reinterpret_cast<value<T> &>(v); }
+template <class T> const value<T> &wrap(const T &v) { return reinterpret_cast<const value<T> &>(v); }
+
+namespace detail {
+
+// How a node keeps an operand: values by reference, element-wise nodes by
+// copy (a few references and floats), products by their evaluated result
+template <class E> struct operand { typedef E type; };
+template <class T> struct operand<value<T> > { typedef const value<T> &type; };
+
+// Pointer to the evaluated operand, only copying when it is not a value yet
+template <class E> struct evaluated {
+  value<typename E::c_type> v;
+  explicit evaluated(const E &e) : v(e) {}
+  const typename E::c_type *get() const { return &v.c; }
+};
+template <class T> struct evaluated<value<T> > {
+  const T *p;
+  explicit evaluated(const value<T> &e) : p(&e.c) {}
+  const T *get() const { return p; }
+};
+
+// The loop of an element-wise assignment, in packets of four when every
+// element belongs to one
+template <bool Packets> struct loop {
+  template <class E> static void run(float *out, const E &e) {
+    for (int i = 0; i < E::size; ++i) {
+      out[i] = e[i];
+    }
+  }
+};
+#if defined(VEC_MATH__SIMD4)
+template <> struct loop<true> {
+  template <class E> static void run(float *out, const E &e) {
+    for (int i = 0; i < E::size; i += 4) {
+      vec_math__store(out + i, e.packet(i));
+    }
+  }
+};
+#endif
+
+// Base of the element-wise nodes: element i only reads element i of the
+// operands, so the destination may be an operand
+template <class E, class T> struct elementwise : expr<E> {
+  typedef T c_type;
+  enum { size = traits<T>::size, cols = traits<T>::cols };
+  void eval_to(T *out) const {
+    loop<size % 4 == 0>::run(out->data, static_cast<const E &>(*this));
+  }
+};
+
+struct op_add {
+  static float apply(float a, float b) { return a + b; }
+#if defined(VEC_MATH__SIMD4)
+  static vec_math__v4 apply(vec_math__v4 a, vec_math__v4 b) { return vec_math__add(a, b); }
+#endif
+};
+struct op_sub {
+  static float apply(float a, float b) { return a - b; }
+#if defined(VEC_MATH__SIMD4)
+  static vec_math__v4 apply(vec_math__v4 a, vec_math__v4 b) { return vec_math__sub(a, b); }
+#endif
+};
+struct op_mul {
+  static float apply(float a, float b) { return a * b; }
+#if defined(VEC_MATH__SIMD4)
+  static vec_math__v4 apply(vec_math__v4 a, vec_math__v4 b) { return vec_math__mul(a, b); }
+#endif
+};
+struct op_div {
+  static float apply(float a, float b) { return a / b; }
+#if defined(VEC_MATH__SIMD4)
+  static vec_math__v4 apply(vec_math__v4 a, vec_math__v4 b) { return vec_math__div(a, b); }
+#endif
+};
+
+template <class A, class B, class Op>
+struct binary : elementwise<binary<A, B, Op>, typename A::c_type> {
+  static_assert((int)A::size == (int)B::size && (int)A::cols == (int)B::cols,
+                "element-wise operands of different shapes");
+  typename operand<A>::type a;
+  typename operand<B>::type b;
+  binary(const A &a_, const B &b_) : a(a_), b(b_) {}
+  float operator[](int i) const { return Op::apply(a[i], b[i]); }
+#if defined(VEC_MATH__SIMD4)
+  vec_math__v4 packet(int i) const { return Op::apply(a.packet(i), b.packet(i)); }
+#endif
+};
+
+// Expression times a float. Division by s multiplies by 1 / s, as the
+// vec_math.h scalar_div functions do.
+template <class A>
+struct scaled : elementwise<scaled<A>, typename A::c_type> {
+  typename operand<A>::type a;
+  float s;
+  scaled(const A &a_, float s_) : a(a_), s(s_) {}
+  float operator[](int i) const { return a[i] * s; }
+#if defined(VEC_MATH__SIMD4)
+  vec_math__v4 packet(int i) const { return vec_math__mul(a.packet(i), vec_math__splat(s)); }
+#endif
+};
+
+template <class A>
+struct negated : elementwise<negated<A>, typename A::c_type> {
+  typename operand<A>::type a;
+  explicit negated(const A &a_) : a(a_) {}
+  float operator[](int i) const { return -a[i]; }
+#if defined(VEC_MATH__SIMD4)
+  vec_math__v4 packet(int i) const { return vec_math__mul(a.packet(i), vec_math__splat(-1.0f)); }
+#endif
+};
+
+// Matrix products, kept as their operands until assigned
+template <class A, class B> struct mat4_product : expr<mat4_product<A, B> > {
+  typedef mat4_t c_type;
+  enum { size = 16, cols = 4 };
+  const A &a;
+  const B &b;
+  mat4_product(const A &a_, const B &b_) : a(a_), b(b_) {}
+  void eval_to(mat4_t *out) const {
+    evaluated<A> pa(a);
+    evaluated<B> pb(b);
+    if (out == pa.get() && out == pb.get()) {
+      const mat4_t m = *out;
+      mat4_mul_ptr(&m, &m, out);
+    } else if (out == pa.get()) {
+      mat4_postmul(out, pb.get());
+    } else if (out == pb.get()) {
+      mat4_premul(pa.get(), out);
+    } else {
+      mat4_mul_ptr(pa.get(), pb.get(), out);
+    }
+  }
+};
+
+template <class A, class B> struct mat4_vec4_product : expr<mat4_vec4_product<A, B> > {
+  typedef vec4_t c_type;
+  enum { size = 4, cols = 1 };
+  const A &a;
+  const B &b;
+  mat4_vec4_product(const A &a_, const B &b_) : a(a_), b(b_) {}
+  void eval_to(vec4_t *out) const {
+    evaluated<A> pa(a);
+    evaluated<B> pb(b);
+    if (out == pb.get()) {
+      const vec4_t v = *out;
+      mat4_vec4_mul_ptr(pa.get(), &v, out);
+    } else {
+      mat4_vec4_mul_ptr(pa.get(), pb.get(), out);
+    }
+  }
+};
+
+template <class A, class B> struct operand<mat4_product<A, B> > { typedef mat4 type; };
+template <class A, class B> struct operand<mat4_vec4_product<A, B> > { typedef vec4 type; };
+
+// What `a * b` means for the shapes of a and b
+template <class A, class B, int ColsA = A::cols, int ColsB = B::cols> struct multiply;
+template <class A, class B> struct multiply<A, B, 1, 1> {
+  typedef binary<A, B, op_mul> type;
+};
+template <class A, class B> struct multiply<A, B, 4, 4> {
+  typedef mat4_product<A, B> type;
+};
+template <class A, class B> struct multiply<A, B, 4, 1> {
+  typedef mat4_vec4_product<A, B> type;
+};
+
+} // namespace detail
+
+template <class A, class B>
+detail::binary<A, B, detail::op_add> operator+(const expr<A> &a, const expr<B> &b) {
+  return detail::binary<A, B, detail::op_add>(a.self(), b.self());
+}
+
+template <class A, class B>
+detail::binary<A, B, detail::op_sub> operator-(const expr<A> &a, const expr<B> &b) {
+  return detail::binary<A, B, detail::op_sub>(a.self(), b.self());
+}
+
+template <class A, class B>
+typename detail::multiply<A, B>::type operator*(const expr<A> &a, const expr<B> &b) {
+  return typename detail::multiply<A, B>::type(a.self(), b.self());
+}
+
+template <class A, class B>
+detail::binary<A, B, detail::op_div> operator/(const expr<A> &a, const expr<B> &b) {
+  return detail::binary<A, B, detail::op_div>(a.self(), b.self());
+}
+
+template <class A> detail::scaled<A> operator*(const expr<A> &a, float s) {
+  return detail::scaled<A>(a.self(), s);
+}
+template <class A> detail::scaled<A> operator*(float s, const expr<A> &a) {
+  return detail::scaled<A>(a.self(), s);
+}
+template <class A> detail::scaled<A> operator/(const expr<A> &a, float s) {
+  return detail::scaled<A>(a.self(), 1.0f / s);
+}
+template <class A> detail::negated<A> operator-(const expr<A> &a) {
+  return detail::negated<A>(a.self());
+}
+
+// Reductions and the operations that need the whole operand, evaluated on
+// the spot. dot sums in element order like vec*_dot.
+template <class A, class B> float dot(const expr<A> &a, const expr<B> &b) {
+  detail::evaluated<A> pa(a.self());
+  detail::evaluated<B> pb(b.self());
+  float sum = pa.get()->data[0] * pb.get()->data[0];
+  for (int i = 1; i < A::size; ++i) {
+    sum = sum + pa.get()->data[i] * pb.get()->data[i];
+  }
+  return sum;
+}
+
+template <class A> float norm_sq(const expr<A> &a) { return dot(a, a); }
+template <class A> float norm(const expr<A> &a) { return sqrtf(dot(a, a)); }
+
+template <class A> value<typename A::c_type> normalize(const expr<A> &a) {
+  value<typename A::c_type> v(a);
+  return v * (1.0f / norm(v));
+}
+
+template <class A, class B> vec3 cross(const expr<A> &a, const expr<B> &b) {
+  detail::evaluated<A> pa(a.self());
+  detail::evaluated<B> pb(b.self());
+  return vec3_cross(*pa.get(), *pb.get());
+}
+
+template <class A> mat4 transpose(const expr<A> &a) {
+  detail::evaluated<A> pa(a.self());
+  mat4 m;
+  mat4_transpose_ptr(pa.get(), &m.c);
+  return m;
+}
+
+template <class A> mat4 inverse(const expr<A> &a) {
+  detail::evaluated<A> pa(a.self());
+  mat4 m;
+  mat4_inverse_ptr(pa.get(), &m.c);
+  return m;
+}
+
+// Points and directions through a mat4, as mat4_vec3_mul with is_point 1 and 0
+template <class A, class B> vec3 transform_point(const expr<A> &m, const expr<B> &v) {
+  detail::evaluated<A> pm(m.self());
+  detail::evaluated<B> pv(v.self());
+  vec3 out;
+  mat4_vec3_mul_ptr(pm.get(), pv.get(), 1, &out.c);
+  return out;
+}
+
+template <class A, class B> vec3 transform_vector(const expr<A> &m, const expr<B> &v) {
+  detail::evaluated<A> pm(m.self());
+  detail::evaluated<B> pv(v.self());
+  vec3 out;
+  mat4_vec3_mul_ptr(pm.get(), pv.get(), 0, &out.c);
+  return out;
+}
+
+template <class A> value<typename A::c_type> eval(const expr<A> &a) {
+  return value<typename A::c_type>(a);
+}
+
+} // namespace vec_math
+
+#endif /* _VEC_MATH_HPP_ */
@@ -0,0 +1,618 @@
+#ifndef _VOXEL_OCTREE_H_
+#define _VOXEL_OCTREE_H_
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Expects vec_math.h, mesh.h and parallel.h to be included first.
+
+#define SVO_MAX_DEPTH 10
+
+// One level of the octree, nodes in Morton order. Children of a node follow
+// the children of every earlier node on the next level, in octant order, so
+// a child is found by counting set mask bits instead of storing pointers.
+// `child_rank` caches that count for every group of 8 nodes and the rest is
+// one popcount over the group's masks read as a 64 bit word.
+typedef struct SvoLevel {
+  int32_t node_count;
+  uint8_t *child_masks; // bit o set when octant o has a child, NULL on the leaf level
+  int32_t *child_rank;  // children of nodes [0, 8 g) for group g, NULL on the leaf level
+  float *occupancy;     // fraction of the node volume in occupied leaves, NULL on the leaf level
+  uint32_t *normals;    // average surface normal, octahedral with 16 bits per component
+} SvoLevel;
+
+// Sparse voxel octree over a cubic grid of (1 << depth)^3 voxels. Level 0 is
+// the root, level `depth` holds the occupied voxels.
+typedef struct VoxelOctree {
+  int32_t depth;
+  vec3_t min;       // corner of voxel (0, 0, 0)
+  float voxel_size; // leaf edge length
+  SvoLevel levels[SVO_MAX_DEPTH + 1];
+} VoxelOctree;
+
+// Conservative voxelization: every voxel a triangle touches is occupied,
+// found with the plane and projected edge tests of Schwarz and Seidel
+// ("Fast parallel surface and solid voxelization on GPUs", 2010).
+// Triangles are spread over the worker pool, voxel keys sorted with the
+// parallel radix sort and every octree level reduced from the one below.
+int32_t svo_build(const MeshData *mesh, int32_t depth, VoxelOctree *out_octree);
+void svo_free(VoxelOctree *octree);
+
+// Index of the child of `node` in `octant` (x | y << 1 | z << 2) on the next
+// level, or -1 when the octant is empty.
+int32_t svo_child(const VoxelOctree *octree, int32_t level, int32_t node,
+                  int32_t octant);
+
+// Node on `level` covering the cell (x, y, z) of that level's (1 << level)^3
+// grid, or -1 when the cell is empty.
+int32_t svo_find(const VoxelOctree *octree, int32_t level, int32_t x, int32_t y,
+                 int32_t z);
+
+// Center of the cell (x, y, z) on `level` and the cell edge length.
+vec3_t svo_cell_center(const VoxelOctree *octree, int32_t level, int32_t x,
+                       int32_t y, int32_t z);
+float svo_cell_size(const VoxelOctree *octree, int32_t level);
+
+// Area weighted average normal of the triangles in a node, normalized after
+// decoding. Zero only when they cancel exactly, so check `occupancy` and the
+// level before trusting it on large, curved nodes.
+vec3_t svo_node_normal(const VoxelOctree *octree, int32_t level, int32_t node);
+
+// Occupied fraction of a node's volume, 1 for leaves.
+float svo_node_occupancy(const VoxelOctree *octree, int32_t level, int32_t node);
+
+// Bytes held by the octree levels.
+size_t svo_memory_size(const VoxelOctree *octree);
+
+#endif /* _VOXEL_OCTREE_H_ */
+
+#ifdef _VOXEL_OCTREE_IMPLEMENTATION_
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define svo__popcount64(x) ((int32_t)__popcnt64(x))
+#else
+#define svo__popcount64(x) __builtin_popcountll(x)
+#endif
+
+// Triangle setup of the Schwarz-Seidel overlap test for voxels of size h.
+typedef struct svo__triangle {
+  float normal[3];
+  float d1;
+  float d2;
+  float edge_normal[3][3][2]; // projection plane xy / yz / zx, edge, 2D normal
+  float edge_offset[3][3];
+  int32_t lo[3]; // voxel range covered by the triangle bounds
+  int32_t hi[3];
+} svo__triangle;
+
+typedef struct svo__job {
+  const MeshData *mesh;
+  VoxelOctree *octree;
+  int32_t resolution;
+  int32_t *counts;  // per triangle voxel count, then its first key
+  uint64_t *keys;   // Morton code per triangle and voxel pair
+  uint32_t *values; // triangle per key
+  int32_t *flags;   // per key or node, 1 where a parent run starts, then its index
+  int32_t *starts;  // first key or child of every run
+  // Morton codes, normal sums and leaf counts of the level being reduced
+  // and of its parents, swapped after every level
+  uint64_t *codes;
+  uint64_t *parent_codes;
+  float *normal_sums;
+  float *parent_sums;
+  int32_t *leaf_counts;
+  int32_t *parent_counts;
+  int32_t level;
+  float lo[3][PAR_MAX_WORKERS];
+  float hi[3][PAR_MAX_WORKERS];
+} svo__job;
+
+// Spreads the low 21 bits of x to every third bit.
+static uint64_t svo__spread_bits(uint64_t x) {
+  x &= 0x1fffff;
+  x = (x | x << 32) & 0x1f00000000ffffull;
+  x = (x | x << 16) & 0x1f0000ff0000ffull;
+  x = (x | x << 8) & 0x100f00f00f00f00full;
+  x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+  x = (x | x << 2) & 0x1249249249249249ull;
+  return x;
+}
+
+static uint64_t svo__morton(int32_t x, int32_t y, int32_t z) {
+  return svo__spread_bits((uint64_t)x) | svo__spread_bits((uint64_t)y) << 1 |
+         svo__spread_bits((uint64_t)z) << 2;
+}
+
+static const float *svo__position(const MeshData *mesh, uint32_t vertex) {
+  return (const float *)((const char *)mesh->vertex_data +
+                         (size_t)vertex * mesh->vertex_size +
+                         mesh->positions_offset);
+}
+
+// Octahedral encoding, the unit sphere folded onto a square.
+static uint32_t svo__encode_normal(const float *n) {
+  float length = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+  if (length <= 0.0f) {
+    return 0x80008000u; // decodes to zero
+  }
+  float x = n[0] / length;
+  float y = n[1] / length;
+  if (n[2] < 0.0f) {
+    float fx = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+    float fy = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+    x = fx;
+    y = fy;
+  }
+  uint32_t qx = (uint32_t)lroundf((x * 0.5f + 0.5f) * 65534.0f) + 1;
+  uint32_t qy = (uint32_t)lroundf((y * 0.5f + 0.5f) * 65534.0f) + 1;
+  return qx | qy << 16;
+}
+
+static int32_t svo__triangle_setup(const svo__job *job, uint32_t triangle,
+                                   svo__triangle *out) {
+  const VoxelOctree *octree = job->octree;
+  const uint32_t *corners = job->mesh->triangles + 3 * (size_t)triangle;
+  const float h = octree->voxel_size;
+  const float origin[3] = {octree->min.x, octree->min.y, octree->min.z};
+  float v[3][3];
+  for (int32_t c = 0; c < 3; ++c) {
+    const float *p = svo__position(job->mesh, corners[c]);
+    for (int32_t k = 0; k < 3; ++k) {
+      v[c][k] = p[k] - origin[k]; // grid space, voxel (i, j, k) starts at h (i, j, k)
+    }
+  }
+  const float e[3][3] = {{v[1][0] - v[0][0], v[1][1] - v[0][1], v[1][2] - v[0][2]},
+                         {v[2][0] - v[1][0], v[2][1] - v[1][1], v[2][2] - v[1][2]},
+                         {v[0][0] - v[2][0], v[0][1] - v[2][1], v[0][2] - v[2][2]}};
+  float *n = out->normal;
+  n[0] = e[0][1] * e[1][2] - e[0][2] * e[1][1];
+  n[1] = e[0][2] * e[1][0] - e[0][0] * e[1][2];
+  n[2] = e[0][0] * e[1][1] - e[0][1] * e[1][0];
+  if (n[0] == 0.0f && n[1] == 0.0f && n[2] == 0.0f) {
+    return 0; // degenerate, covers no area
+  }
+
+  // Plane overlap: the box corners nearest and farthest along the normal
+  float d1 = 0.0f;
+  float d2 = 0.0f;
+  for (int32_t k = 0; k < 3; ++k) {
+    float c = n[k] > 0.0f ? h : 0.0f;
+    d1 += n[k] * (c - v[0][k]);
+    d2 += n[k] * ((h - c) - v[0][k]);
+  }
+  out->d1 = d1;
+  out->d2 = d2;
+
+  // Edge functions of the triangle projected to xy, yz and zx, pushed out so
+  // they accept any box corner inside the projection
+  for (int32_t plane = 0; plane < 3; ++plane) {
+    const int32_t a = plane;           // first projected axis
+    const int32_t b = (plane + 1) % 3; // second projected axis
+    const int32_t c = (plane + 2) % 3; // projection direction
+    const float sign = n[c] < 0.0f ? -1.0f : 1.0f;
+    for (int32_t i = 0; i < 3; ++i) {
+      const float nx = -e[i][b] * sign;
+      const float ny = e[i][a] * sign;
+      out->edge_normal[plane][i][0] = nx;
+      out->edge_normal[plane][i][1] = ny;
+      out->edge_offset[plane][i] = -(nx * v[i][a] + ny * v[i][b]) +
+                                   fmaxf(0.0f, h * nx) + fmaxf(0.0f, h * ny);
+    }
+  }
+
+  for (int32_t k = 0; k < 3; ++k) {
+    const float lo = fminf(fminf(v[0][k], v[1][k]), v[2][k]) / h;
+    const float hi = fmaxf(fmaxf(v[0][k], v[1][k]), v[2][k]) / h;
+    out->lo[k] = (int32_t)floorf(lo);
+    out->hi[k] = (int32_t)floorf(hi);
+    out->lo[k] = out->lo[k] < 0 ? 0 : out->lo[k];
+    out->hi[k] = out->hi[k] >= job->resolution ? job->resolution - 1 : out->hi[k];
+  }
+  return 1;
+}
+
+static int32_t svo__overlaps(const svo__triangle *t, float h, int32_t x,
+                             int32_t y, int32_t z) {
+  const float p[3] = {(float)x * h, (float)y * h, (float)z * h};
+  const float np = t->normal[0] * p[0] + t->normal[1] * p[1] + t->normal[2] * p[2];
+  if ((np + t->d1) * (np + t->d2) > 0.0f) {
+    return 0;
+  }
+  for (int32_t plane = 0; plane < 3; ++plane) {
+    const float pa = p[plane];
+    const float pb = p[(plane + 1) % 3];
+    for (int32_t i = 0; i < 3; ++i) {
+      const float *en = t->edge_normal[plane][i];
+      if (en[0] * pa + en[1] * pb + t->edge_offset[plane][i] < 0.0f) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+// Counts (values == NULL) or emits the voxels of every triangle.
+static void svo__voxelize_range(void *user, int32_t begin, int32_t end,
+                                int32_t worker) {
+  svo__job *job = (svo__job *)user;
+  const float h = job->octree->voxel_size;
+  (void)worker;
+  for (int32_t triangle = begin; triangle < end; ++triangle) {
+    svo__triangle t;
+    int32_t count = 0;
+    if (svo__triangle_setup(job, (uint32_t)triangle, &t)) {
+      uint64_t *keys = job->values ? job->keys + job->counts[triangle] : NULL;
+      for (int32_t z = t.lo[2]; z <= t.hi[2]; ++z) {
+        for (int32_t y = t.lo[1]; y <= t.hi[1]; ++y) {
+          for (int32_t x = t.lo[0]; x <= t.hi[0]; ++x) {
+            if (!svo__overlaps(&t, h, x, y, z)) {
+              continue;
+            }
+            if (keys) {
+              keys[count] = svo__morton(x, y, z);
+              job->values[job->counts[triangle] + count] = (uint32_t)triangle;
+            }
+            ++count;
+          }
+        }
+      }
+    }
+    if (!job->values) {
+      job->counts[triangle] = count;
+    }
+  }
+}
+
+static void svo__bounds_range(void *user, int32_t begin, int32_t end,
+                              int32_t worker) {
+  svo__job *job = (svo__job *)user;
+  for (int32_t v = begin; v < end; ++v) {
+    const float *p = svo__position(job->mesh, (uint32_t)v);
+    for (int32_t k = 0; k < 3; ++k) {
+      job->lo[k][worker] = fminf(job->lo[k][worker], p[k]);
+      job->hi[k][worker] = fmaxf(job->hi[k][worker], p[k]);
+    }
+  }
+}
+
+// Marks the first key of every leaf voxel.
+static void svo__leaf_flag_range(void *user, int32_t begin, int32_t end,
+                                 int32_t worker) {
+  svo__job *job = (svo__job *)user;
+  (void)worker;
+  for (int32_t i = begin; i < end; ++i) {
+    job->flags[i] = i == 0 || job->keys[i] != job->keys[i - 1];
+  }
+}
+
+// Leaf codes and area weighted normal sums over each run of equal keys.
+static void svo__leaf_range(void *user, int32_t begin, int32_t end,
+                            int32_t worker) {
+  svo__job *job = (svo__job *)user;
+  SvoLevel *leaves = &job->octree->levels[job->octree->depth];
+  const int32_t key_count = job->counts[job->mesh->triangle_count];
+  (void)worker;
+  for (int32_t leaf = begin; leaf < end; ++leaf) {
+    const int32_t first = job->starts[leaf];
+    const int32_t last = leaf + 1 < leaves->node_count ? job->starts[leaf + 1] : key_count;
+    float sum[3] = {0.0f, 0.0f, 0.0f};
+    for (int32_t i = first; i < last; ++i) {
+      const uint32_t *corners = job->mesh->triangles + 3 * (size_t)job->values[i];
+      const float *a = svo__position(job->mesh, corners[0]);
+      const float *b = svo__position(job->mesh, corners[1]);
+      const float *c = svo__position(job->mesh, corners[2]);
+      const float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+      const float e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+      sum[0] += e1[1] * e2[2] - e1[2] * e2[1];
+      sum[1] += e1[2] * e2[0] - e1[0] * e2[2];
+      sum[2] += e1[0] * e2[1] - e1[1] * e2[0];
+    }
+    leaves->normals[leaf] = svo__encode_normal(sum);
+    job->codes[leaf] = job->keys[first];
+    memcpy(job->normal_sums + 3 * (size_t)leaf, sum, sizeof(sum));
+    job->leaf_counts[leaf] = 1;
+  }
+}
+
+// Marks the first child of every parent node on the level below `job->level`.
+static void svo__node_flag_range(void *user, int32_t begin, int32_t end,
+                                 int32_t worker) {
+  svo__job *job = (svo__job *)user;
+  (void)worker;
+  for (int32_t i = begin; i < end; ++i) {
+    job->flags[i] = i == 0 || (job->codes[i] >> 3) != (job->codes[i - 1] >> 3);
+  }
+}
+
+// Records where every run starts from the scanned flags.
+static void svo__start_range(void *user, int32_t begin, int32_t end,
+                             int32_t worker) {
+  svo__job *job = (svo__job *)user;
+  (void)worker;
+  for (int32_t i = begin; i < end; ++i) {
+    if (job->flags[i + 1] != job->flags[i]) {
+      job->starts[job->flags[i]] = i;
+    }
+  }
+}
+
+// Reduces the children of every node on `job->level`.
+static void svo__node_range(void *user, int32_t begin, int32_t end,
+                            int32_t worker) {
+  svo__job *job = (svo__job *)user;
+  VoxelOctree *octree = job->octree;
+  SvoLevel *level = &octree->levels[job->level];
+  const SvoLevel *below = &octree->levels[job->level + 1];
+  const float volume = ldexpf(1.0f, 3 * (octree->depth - job->level));
+  (void)worker;
+  for (int32_t node = begin; node < end; ++node) {
+    const int32_t first = job->starts[node];
+    const int32_t last = node + 1 < level->node_count ? job->starts[node + 1] : below->node_count;
+    float sum[3] = {0.0f, 0.0f, 0.0f};
+    int32_t leaves = 0;
+    uint8_t mask = 0;
+    for (int32_t child = first; child < last; ++child) {
+      mask |= (uint8_t)(1u << (job->codes[child] & 7));
+      for (int32_t k = 0; k < 3; ++k) {
+        sum[k] += job->normal_sums[3 * (size_t)child + k];
+      }
+      leaves += job->leaf_counts[child];
+    }
+    level->child_masks[node] = mask;
+    level->normals[node] = svo__encode_normal(sum);
+    level->occupancy[node] = (float)leaves / volume;
+    job->parent_codes[node] = job->codes[first] >> 3;
+    memcpy(job->parent_sums + 3 * (size_t)node, sum, sizeof(sum));
+    job->parent_counts[node] = leaves;
+    if ((node & 7) == 0) {
+      level->child_rank[node >> 3] = first;
+    }
+  }
+}
+
+static int32_t svo__alloc_level(SvoLevel *level, int32_t node_count,
+                                int32_t inner) {
+  level->node_count = node_count;
+  level->normals = (uint32_t *)malloc((size_t)node_count * sizeof(uint32_t));
+  if (!level->normals) {
+    return EXIT_FAILURE;
+  }
+  if (inner) {
+    // Masks padded to whole groups of 8 so svo_child can read them as words
+    const size_t groups = ((size_t)node_count + 7) / 8;
+    level->child_masks = (uint8_t *)calloc(groups * 8, 1);
+    level->child_rank = (int32_t *)malloc(groups * sizeof(int32_t));
+    level->occupancy = (float *)malloc((size_t)node_count * sizeof(float));
+    if (!level->child_masks || !level->child_rank || !level->occupancy) {
+      return EXIT_FAILURE;
+    }
+  }
+  return 0;
+}
+
+static int32_t svo__build(svo__job *job) {
+  const MeshData *mesh = job->mesh;
+  VoxelOctree *octree = job->octree;
+  const int32_t depth = octree->depth;
+
+  // Cubic grid around the mesh bounds, nudged so no vertex lands on the far faces
+  for (int32_t w = 0; w < PAR_MAX_WORKERS; ++w) {
+    for (int32_t k = 0; k < 3; ++k) {
+      job->lo[k][w] = FLT_MAX;
+      job->hi[k][w] = -FLT_MAX;
+    }
+  }
+  par_for(mesh->vertex_count, 4096, svo__bounds_range, job);
+  float lo[3];
+  float extent = 0.0f;
+  for (int32_t k = 0; k < 3; ++k) {
+    float hi = -FLT_MAX;
+    lo[k] = FLT_MAX;
+    for (int32_t w = 0; w < PAR_MAX_WORKERS; ++w) {
+      lo[k] = fminf(lo[k], job->lo[k][w]);
+      hi = fmaxf(hi, job->hi[k][w]);
+    }
+    extent = fmaxf(extent, hi - lo[k]);
+  }
+  extent = fmaxf(extent * 1.0001f, FLT_MIN);
+  octree->min = vec3(lo[0], lo[1], lo[2]);
+  octree->voxel_size = extent / (float)job->resolution;
+
+  // Count the voxels of every triangle, then emit them at scanned offsets
+  job->counts = (int32_t *)malloc(((size_t)mesh->triangle_count + 1) * sizeof(int32_t));
+  if (!job->counts) {
+    return EXIT_FAILURE;
+  }
+  par_for(mesh->triangle_count, 256, svo__voxelize_range, job);
+  job->counts[mesh->triangle_count] = 0;
+  const int32_t key_count = par_exclusive_scan(job->counts, mesh->triangle_count + 1);
+  job->counts[mesh->triangle_count] = key_count;
+  if (key_count == 0) {
+    return EXIT_FAILURE;
+  }
+  job->keys = (uint64_t *)malloc((size_t)key_count * sizeof(uint64_t));
+  job->values = (uint32_t *)malloc((size_t)key_count * sizeof(uint32_t));
+  job->flags = (int32_t *)malloc(((size_t)key_count + 1) * sizeof(int32_t));
+  if (!job->keys || !job->values || !job->flags) {
+    return EXIT_FAILURE;
+  }
+  par_for(mesh->triangle_count, 256, svo__voxelize_range, job);
+  if (par_sort_u64(job->keys, job->values, key_count, 3 * depth)) {
+    return EXIT_FAILURE;
+  }
+
+  // Leaves are the runs of equal keys, found by scanning run start flags
+  par_for(key_count, 4096, svo__leaf_flag_range, job);
+  job->flags[key_count] = 0;
+  const int32_t leaf_count = par_exclusive_scan(job->flags, key_count + 1);
+  job->starts = (int32_t *)malloc((size_t)leaf_count * sizeof(int32_t));
+  job->codes = (uint64_t *)malloc((size_t)leaf_count * sizeof(uint64_t));
+  job->parent_codes = (uint64_t *)malloc((size_t)leaf_count * sizeof(uint64_t));
+  job->normal_sums = (float *)malloc((size_t)leaf_count * 3 * sizeof(float));
+  job->parent_sums = (float *)malloc((size_t)leaf_count * 3 * sizeof(float));
+  job->leaf_counts = (int32_t *)malloc((size_t)leaf_count * sizeof(int32_t));
+  job->parent_counts = (int32_t *)malloc((size_t)leaf_count * sizeof(int32_t));
+  if (!job->starts || !job->codes || !job->parent_codes || !job->normal_sums ||
+      !job->parent_sums || !job->leaf_counts || !job->parent_counts ||
+      svo__alloc_level(&octree->levels[depth], leaf_count, 0)) {
+    return EXIT_FAILURE;
+  }
+  par_for(key_count, 4096, svo__start_range, job);
+  par_for(leaf_count, 1024, svo__leaf_range, job);
+
+  // Every level reduces the runs of siblings on the level below
+  for (job->level = depth - 1; job->level >= 0; --job->level) {
+    const int32_t child_count = octree->levels[job->level + 1].node_count;
+    par_for(child_count, 4096, svo__node_flag_range, job);
+    job->flags[child_count] = 0;
+    const int32_t node_count = par_exclusive_scan(job->flags, child_count + 1);
+    if (svo__alloc_level(&octree->levels[job->level], node_count, 1)) {
+      return EXIT_FAILURE;
+    }
+    par_for(child_count, 4096, svo__start_range, job);
+    par_for(node_count, 1024, svo__node_range, job);
+
+    // The parents are the children of the next level up
+    uint64_t *codes = job->codes;
+    job->codes = job->parent_codes;
+    job->parent_codes = codes;
+    float *sums = job->normal_sums;
+    job->normal_sums = job->parent_sums;
+    job->parent_sums = sums;
+    int32_t *counts = job->leaf_counts;
+    job->leaf_counts = job->parent_counts;
+    job->parent_counts = counts;
+  }
+  return 0;
+}
+
+int32_t svo_build(const MeshData *mesh, int32_t depth, VoxelOctree *out_octree) {
+  memset(out_octree, 0, sizeof(*out_octree));
+  if (depth < 1 || depth > SVO_MAX_DEPTH || mesh->vertex_count <= 0) {
+    return EXIT_FAILURE;
+  }
+  svo__job *job = (svo__job *)calloc(1, sizeof(svo__job));
+  if (!job) {
+    return EXIT_FAILURE;
+  }
+  job->mesh = mesh;
+  job->octree = out_octree;
+  job->resolution = 1 << depth;
+  out_octree->depth = depth;
+
+  int32_t status = svo__build(job);
+  free(job->counts);
+  free(job->keys);
+  free(job->values);
+  free(job->flags);
+  free(job->starts);
+  free(job->codes);
+  free(job->parent_codes);
+  free(job->normal_sums);
+  free(job->parent_sums);
+  free(job->leaf_counts);
+  free(job->parent_counts);
+  free(job);
+  if (status) {
+    svo_free(out_octree);
+  }
+  return status;
+}
+
+void svo_free(VoxelOctree *octree) {
+  for (int32_t l = 0; l <= SVO_MAX_DEPTH; ++l) {
+    SvoLevel *level = &octree->levels[l];
+    free(level->child_masks);
+    free(level->child_rank);
+    free(level->occupancy);
+    free(level->normals);
+  }
+  memset(octree, 0, sizeof(*octree));
+}
+
+int32_t svo_child(const VoxelOctree *octree, int32_t level, int32_t node,
+                  int32_t octant) {
+  if (level >= octree->depth) {
+    return -1;
+  }
+  const SvoLevel *l = &octree->levels[level];
+  const uint32_t mask = l->child_masks[node];
+  if (!(mask & (1u << octant))) {
+    return -1;
+  }
+  // Children of the earlier nodes in the group, then earlier octants of this one
+  const int32_t group = node >> 3;
+  uint64_t word;
+  memcpy(&word, l->child_masks + 8 * (size_t)group, sizeof(word));
+  const int32_t shift = 8 * (node & 7);
+  const uint64_t before = shift ? word & ((1ull << shift) - 1) : 0;
+  return l->child_rank[group] + svo__popcount64(before) +
+         svo__popcount64((uint64_t)(mask & ((1u << octant) - 1)));
+}
+
+int32_t svo_find(const VoxelOctree *octree, int32_t level, int32_t x, int32_t y,
+                 int32_t z) {
+  const int32_t resolution = 1 << level;
+  if (level > octree->depth || x < 0 || y < 0 || z < 0 || x >= resolution ||
+      y >= resolution || z >= resolution || octree->levels[0].node_count == 0) {
+    return -1;
+  }
+  int32_t node = 0;
+  for (int32_t l = 0; l < level && node >= 0; ++l) {
+    const int32_t bit = level - 1 - l;
+    const int32_t octant = ((x >> bit) & 1) | ((y >> bit) & 1) << 1 | ((z >> bit) & 1) << 2;
+    node = svo_child(octree, l, node, octant);
+  }
+  return node;
+}
+
+float svo_cell_size(const VoxelOctree *octree, int32_t level) {
+  return ldexpf(octree->voxel_size, octree->depth - level);
+}
+
+vec3_t svo_cell_center(const VoxelOctree *octree, int32_t level, int32_t x,
+                       int32_t y, int32_t z) {
+  const float size = svo_cell_size(octree, level);
+  return vec3(octree->min.x + ((float)x + 0.5f) * size,
+              octree->min.y + ((float)y + 0.5f) * size,
+              octree->min.z + ((float)z + 0.5f) * size);
+}
+
+vec3_t svo_node_normal(const VoxelOctree *octree, int32_t level, int32_t node) {
+  const uint32_t packed = octree->levels[level].normals[node];
+  float x = ((float)(packed & 0xffff) - 1.0f) / 65534.0f * 2.0f - 1.0f;
+  float y = ((float)(packed >> 16) - 1.0f) / 65534.0f * 2.0f - 1.0f;
+  if (packed == 0x80008000u) {
+    return vec3(0.0f, 0.0f, 0.0f);
+  }
+  float z = 1.0f - fabsf(x) - fabsf(y);
+  if (z < 0.0f) {
+    float fx = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+    float fy = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+    x = fx;
+    y = fy;
+  }
+  return vec3_normalize(vec3(x, y, z));
+}
+
+float svo_node_occupancy(const VoxelOctree *octree, int32_t level, int32_t node) {
+  return level == octree->depth ? 1.0f : octree->levels[level].occupancy[node];
+}
+
+size_t svo_memory_size(const VoxelOctree *octree) {
+  size_t bytes = 0;
+  for (int32_t l = 0; l <= octree->depth; ++l) {
+    const size_t n = (size_t)octree->levels[l].node_count;
+    bytes += n * sizeof(uint32_t);
+    if (l < octree->depth) {
+      bytes += ((n + 7) & ~(size_t)7) + n * sizeof(float) + (n + 7) / 8 * sizeof(int32_t);
+    }
+  }
+  return bytes;
+}
+
+#endif /* _VOXEL_OCTREE_IMPLEMENTATION_ */
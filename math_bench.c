@@ -0,0 +1,325 @@
+// Throughput and latency of the common matrix and vector operations in the math libraries of
+// the repo: vec_math.h (takehome.c) and cglm (rotate_cube.c). Throughput runs the operation on
+// independent inputs, latency feeds every result into the next input, both in nanoseconds per
+// operation (best of BENCH_RUNS). The latency chains of look_at, perspective and rotation add
+// a multiply-add to feed one element of the result back. vec_math.h is built once per backend
+// (see math_bench.sh), every run prints one JSON object with the same keys in the same order:
+//
+//   {"backend": "AVX", "count": 4096, "runs": 200, "results": [
+//     {"library": "vec_math", "op": "mat4_mul", "throughput_ns": 3.105, "latency_ns": 9.870},
+//     ...]}
+//
+// cglm is measured when its headers are found, it picks its own SIMD path from the target.
+#define _POSIX_C_SOURCE 199309L
+#define _VEC_MATH_IMPLEMENTATION_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "libs/vec_math.h"
+
+#if defined(__has_include)
+#if __has_include(<cglm/cglm.h>)
+#define BENCH_CGLM 1
+#include <cglm/cglm.h>
+#endif
+#endif
+
+#define BENCH_COUNT 4096
+#define BENCH_RUNS 200
+
+// Inputs and outputs of every operation, 32-byte aligned so cglm can use aligned loads
+typedef struct BenchData {
+    mat4_t* a;
+    mat4_t* b;
+    mat4_t* out;
+    vec3_t* v;
+    vec3_t* out3;
+    float* angles;
+    float sink;
+} BenchData;
+
+typedef void (*BenchKernel)(BenchData* data, int32_t chain);
+
+typedef struct BenchCase {
+    const char* library;
+    const char* op;
+    BenchKernel kernel;
+} BenchCase;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static float random_range(float lo, float hi) {
+    return lo + (hi - lo) * (float)rand() / (float)RAND_MAX;
+}
+
+// vec_math.h kernels: with `chain` set every result is the next input
+static void vec_math_mul(BenchData* d, int32_t chain) {
+    if (chain) {
+        mat4_t m = d->a[0];
+        for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+            m = mat4_mul(m, d->b[i]);
+        }
+        d->out[0] = m;
+        return;
+    }
+    for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+        d->out[i] = mat4_mul(d->a[i], d->b[i]);
+    }
+}
+
+static void vec_math_inverse(BenchData* d, int32_t chain) {
+    if (chain) {
+        mat4_t m = d->a[0];
+        for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+            m = mat4_inverse(m);
+        }
+        d->out[0] = m;
+        return;
+    }
+    for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+        d->out[i] = mat4_inverse(d->a[i]);
+    }
+}
+
+static void vec_math_look_at(BenchData* d, int32_t chain) {
+    vec3_t center = vec3(0.0f, 0.0f, 0.0f);
+    vec3_t up = vec3(0.0f, 1.0f, 0.0f);
+    if (chain) {
+        vec3_t eye = d->v[0];
+        for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+            mat4_t m = look_at(eye, center, up);
+            eye.x = d->v[0].x + m.data[12] * 1e-3f;
+        }
+        d->sink += eye.x;
+        return;
+    }
+    for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+        d->out[i] = look_at(d->v[i], center, up);
+    }
+}
+
+static void vec_math_perspective(BenchData* d, int32_t chain) {
+    if (chain) {
+        float fovy = d->angles[0];
+        for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+            mat4_t m = perspective(fovy, 4.0f / 3.0f, 0.1f, 100.0f);
+            fovy = d->angles[0] + m.data[0] * 1e-3f;
+        }
+        d->sink += fovy;
+        return;
+    }
+    for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+        d->out[i] = perspective(d->angles[i], 4.0f / 3.0f, 0.1f, 100.0f);
+    }
+}
+
+static void vec_math_rotation(BenchData* d, int32_t chain) {
+    if (chain) {
+        float angle = d->angles[0];
+        for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+            mat4_t m = mat4_make_rotation(d->v[i], angle);
+            angle = d->angles[0] + m.data[1] * 1e-3f;
+        }
+        d->sink += angle;
+        return;
+    }
+    for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+        d->out[i] = mat4_make_rotation(d->v[i], d->angles[i]);
+    }
+}
+
+static void vec_math_normalize(BenchData* d, int32_t chain) {
+    if (chain) {
+        vec3_t v = d->v[0];
+        for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+            v = vec3_normalize(v);
+        }
+        d->out3[0] = v;
+        return;
+    }
+    for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+        d->out3[i] = vec3_normalize(d->v[i]);
+    }
+}
+
+#if defined(BENCH_CGLM)
+// The same kernels through cglm, which works in place on float arrays
+#define BENCH_CGLM_MAT4(m) ((vec4*)(m).data)
+
+static void cglm_mul(BenchData* d, int32_t chain) {
+    if (chain) {
+        d->out[0] = d->a[0];
+        for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+            glm_mat4_mul(BENCH_CGLM_MAT4(d->out[0]), BENCH_CGLM_MAT4(d->b[i]), BENCH_CGLM_MAT4(d->out[0]));
+        }
+        return;
+    }
+    for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+        glm_mat4_mul(BENCH_CGLM_MAT4(d->a[i]), BENCH_CGLM_MAT4(d->b[i]), BENCH_CGLM_MAT4(d->out[i]));
+    }
+}
+
+static void cglm_inverse(BenchData* d, int32_t chain) {
+    if (chain) {
+        d->out[0] = d->a[0];
+        for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+            glm_mat4_inv(BENCH_CGLM_MAT4(d->out[0]), BENCH_CGLM_MAT4(d->out[0]));
+        }
+        return;
+    }
+    for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+        glm_mat4_inv(BENCH_CGLM_MAT4(d->a[i]), BENCH_CGLM_MAT4(d->out[i]));
+    }
+}
+
+static void cglm_look_at(BenchData* d, int32_t chain) {
+    vec3 center = { 0.0f, 0.0f, 0.0f };
+    vec3 up = { 0.0f, 1.0f, 0.0f };
+    if (chain) {
+        vec3 eye = { d->v[0].x, d->v[0].y, d->v[0].z };
+        for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+            glm_lookat(eye, center, up, BENCH_CGLM_MAT4(d->out[0]));
+            eye[0] = d->v[0].x + d->out[0].data[12] * 1e-3f;
+        }
+        d->sink += eye[0];
+        return;
+    }
+    for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+        glm_lookat(d->v[i].data, center, up, BENCH_CGLM_MAT4(d->out[i]));
+    }
+}
+
+static void cglm_perspective(BenchData* d, int32_t chain) {
+    if (chain) {
+        float fovy = d->angles[0];
+        for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+            glm_perspective(fovy, 4.0f / 3.0f, 0.1f, 100.0f, BENCH_CGLM_MAT4(d->out[0]));
+            fovy = d->angles[0] + d->out[0].data[0] * 1e-3f;
+        }
+        d->sink += fovy;
+        return;
+    }
+    for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+        glm_perspective(d->angles[i], 4.0f / 3.0f, 0.1f, 100.0f, BENCH_CGLM_MAT4(d->out[i]));
+    }
+}
+
+static void cglm_rotation(BenchData* d, int32_t chain) {
+    if (chain) {
+        float angle = d->angles[0];
+        for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+            glm_rotate_make(BENCH_CGLM_MAT4(d->out[0]), angle, d->v[i].data);
+            angle = d->angles[0] + d->out[0].data[1] * 1e-3f;
+        }
+        d->sink += angle;
+        return;
+    }
+    for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+        glm_rotate_make(BENCH_CGLM_MAT4(d->out[i]), d->angles[i], d->v[i].data);
+    }
+}
+
+static void cglm_normalize(BenchData* d, int32_t chain) {
+    if (chain) {
+        d->out3[0] = d->v[0];
+        for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+            glm_vec3_normalize(d->out3[0].data);
+        }
+        return;
+    }
+    for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+        glm_vec3_normalize_to(d->v[i].data, d->out3[i].data);
+    }
+}
+#endif
+
+static double bench(BenchKernel kernel, BenchData* data, int32_t chain) {
+    double best = 1e30;
+    for (int32_t run = 0; run < BENCH_RUNS; ++run) {
+        double start = now_seconds();
+        kernel(data, chain);
+        double elapsed = now_seconds() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    return best * 1e9 / BENCH_COUNT;
+}
+
+int main(void) {
+    BenchData data;
+    memset(&data, 0, sizeof(data));
+    data.a = (mat4_t*)aligned_alloc(32, BENCH_COUNT * sizeof(mat4_t));
+    data.b = (mat4_t*)aligned_alloc(32, BENCH_COUNT * sizeof(mat4_t));
+    data.out = (mat4_t*)aligned_alloc(32, BENCH_COUNT * sizeof(mat4_t));
+    data.v = (vec3_t*)malloc(BENCH_COUNT * sizeof(vec3_t));
+    data.out3 = (vec3_t*)malloc(BENCH_COUNT * sizeof(vec3_t));
+    data.angles = (float*)malloc(BENCH_COUNT * sizeof(float));
+    if (!data.a || !data.b || !data.out || !data.v || !data.out3 || !data.angles) {
+        fprintf(stderr, "Failed to allocate the inputs\n");
+        return EXIT_FAILURE;
+    }
+
+    // Rigid transforms with a little scale, so the inverse chains stay finite
+    srand(1);
+    for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+        data.v[i] = vec3_normalize(vec3(random_range(-1.0f, 1.0f), random_range(-1.0f, 1.0f), random_range(0.1f, 1.0f)));
+        data.angles[i] = random_range(0.5f, 1.5f);
+        mat4_t rotation = mat4_make_rotation(data.v[i], data.angles[i]);
+        data.a[i] = mat4_mul(mat4_make_translation(vec3(random_range(-5.0f, 5.0f), 1.0f, 2.0f)), rotation);
+        data.b[i] = mat4_mul(rotation, mat4_diag(random_range(0.9f, 1.1f)));
+        data.b[i].data[15] = 1.0f;
+    }
+
+    const BenchCase cases[] = {
+        { "vec_math", "mat4_mul", vec_math_mul },
+        { "vec_math", "mat4_inverse", vec_math_inverse },
+        { "vec_math", "look_at", vec_math_look_at },
+        { "vec_math", "perspective", vec_math_perspective },
+        { "vec_math", "rotation", vec_math_rotation },
+        { "vec_math", "vec3_normalize", vec_math_normalize },
+#if defined(BENCH_CGLM)
+        { "cglm", "mat4_mul", cglm_mul },
+        { "cglm", "mat4_inverse", cglm_inverse },
+        { "cglm", "look_at", cglm_look_at },
+        { "cglm", "perspective", cglm_perspective },
+        { "cglm", "rotation", cglm_rotation },
+        { "cglm", "vec3_normalize", cglm_normalize },
+#endif
+    };
+    const int32_t case_count = (int32_t)(sizeof(cases) / sizeof(cases[0]));
+
+#if defined(VEC_MATH_SIMD_AVX)
+    const char* backend = "AVX";
+#elif defined(VEC_MATH_SIMD_SSE2)
+    const char* backend = "SSE2";
+#elif defined(VEC_MATH_SIMD_NEON)
+    const char* backend = "NEON";
+#else
+    const char* backend = "scalar";
+#endif
+    printf("{\"backend\": \"%s\", \"count\": %d, \"runs\": %d, \"results\": [\n", backend, BENCH_COUNT, BENCH_RUNS);
+    for (int32_t c = 0; c < case_count; ++c) {
+        double throughput = bench(cases[c].kernel, &data, 0);
+        double latency = bench(cases[c].kernel, &data, 1);
+        printf("  {\"library\": \"%s\", \"op\": \"%s\", \"throughput_ns\": %.3f, \"latency_ns\": %.3f}%s\n",
+               cases[c].library, cases[c].op, throughput, latency, c + 1 < case_count ? "," : "");
+    }
+    printf("]}\n");
+    // Keeps the chains that only feed `sink` from being optimized out
+    fprintf(stderr, "(checksum %g)\n", (double)data.sink + (double)data.out[0].data[0] + (double)data.out3[0].x);
+
+    free(data.a);
+    free(data.b);
+    free(data.out);
+    free(data.v);
+    free(data.out3);
+    free(data.angles);
+    return 0;
+}
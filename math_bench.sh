@@ -0,0 +1,13 @@
+gcc math_bench.c -Wall -std=c11 -O2 -DVEC_MATH_NO_SIMD -o math_bench_scalar.out -lm -lrt
+gcc math_bench.c -Wall -std=c11 -O2 -o math_bench_sse2.out -lm -lrt
+gcc math_bench.c -Wall -std=c11 -O2 -mavx2 -mfma -o math_bench_avx.out -lm -lrt
+
+# One JSON array with an object per backend
+{
+    echo "["
+    ./math_bench_scalar.out && echo ","
+    ./math_bench_sse2.out && echo ","
+    ./math_bench_avx.out
+    echo "]"
+} > math_bench.json
+cat math_bench.json
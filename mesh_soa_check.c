@@ -0,0 +1,107 @@
+// Round trip of the interleaved <-> SoA conversions of mesh.h: mesh_soa_from_mesh followed by
+// mesh_soa_to_mesh has to give back the original vertex buffer bit for bit, for every vertex
+// count from 0 to MESH_SOA_CHECK_MAX_COUNT (covering the 8 and 4 vertex SIMD loops and every
+// scalar tail) and for both the packed position/normal layout and the layout with baked AO,
+// whose AO floats have to be left untouched. The SoA streams have to match a strided read of
+// the input with padding lanes repeating the last vertex. Exits with EXIT_FAILURE on any
+// mismatch. Build with AVX, SSE2 and -DMESH_NO_SIMD to cover every path (see mesh_soa_check.sh).
+#define _VEC_MATH_IMPLEMENTATION_
+#define _MESH_IMPLEMENTATION_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "libs/vec_math.h"
+#include "libs/mesh.h"
+
+#define MESH_SOA_CHECK_MAX_COUNT 100
+
+static uint32_t rng_state = 0x2545F491u;
+
+static float random_float(float lo, float hi) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return lo + (hi - lo) * (float)(rng_state >> 8) * (1.0f / 16777216.0f);
+}
+
+// Counts the mismatches of one round trip with `floats_per_vertex` floats per vertex, the AO
+// float (if any) after the normal
+static int32_t check_round_trip(int32_t count, int32_t floats_per_vertex) {
+    const size_t size = (size_t)count * floats_per_vertex * sizeof(float);
+    float* original = (float*)malloc(size + sizeof(float));
+    float* restored = (float*)malloc(size + sizeof(float));
+    if (!original || !restored) {
+        return 1;
+    }
+    for (int32_t i = 0; i < count * floats_per_vertex; ++i) {
+        original[i] = random_float(-10.0f, 10.0f);
+    }
+
+    MeshData mesh;
+    memset(&mesh, 0, sizeof(mesh));
+    mesh.vertex_count = count;
+    mesh.vertex_data = original;
+    mesh.vertex_size = floats_per_vertex * (int32_t)sizeof(float);
+    mesh.positions_size = 3 * sizeof(float);
+    mesh.positions_offset = 0;
+    mesh.normals_size = 3 * sizeof(float);
+    mesh.normals_offset = 3 * sizeof(float);
+    if (floats_per_vertex > 6) {
+        mesh.ao_size = sizeof(float);
+        mesh.ao_offset = 6 * sizeof(float);
+    }
+
+    MeshSoA soa;
+    if (mesh_soa_from_mesh(&mesh, &soa)) {
+        return 1;
+    }
+    int32_t mismatches = 0;
+    const float* streams[6] = {soa.x, soa.y, soa.z, soa.nx, soa.ny, soa.nz};
+    for (int32_t s = 0; s < 6; ++s) {
+        for (int32_t i = 0; i < soa.capacity; ++i) {
+            const int32_t v = i < count ? i : count - 1;
+            const float expected = v >= 0 ? original[v * floats_per_vertex + s] : 0.0f;
+            mismatches += memcmp(&streams[s][i], &expected, sizeof(float)) != 0;
+        }
+    }
+
+    // Everything but the positions and normals comes from the original, the sentinel past the
+    // end has to survive
+    for (int32_t i = 0; i < count * floats_per_vertex; ++i) {
+        restored[i] = i % floats_per_vertex < 6 ? -1.0f : original[i];
+    }
+    restored[count * floats_per_vertex] = 12345.0f;
+    mesh.vertex_data = restored;
+    mesh_soa_to_mesh(&soa, &mesh);
+    mismatches += memcmp(original, restored, size) != 0;
+    mismatches += restored[count * floats_per_vertex] != 12345.0f;
+
+    mesh_soa_free(&soa);
+    free(original);
+    free(restored);
+    return mismatches;
+}
+
+int32_t main(void) {
+#if defined(MESH_SIMD_AVX)
+    const char* backend = "AVX";
+#elif defined(MESH_SIMD_SSE2)
+    const char* backend = "SSE2";
+#elif defined(MESH_SIMD_NEON)
+    const char* backend = "NEON";
+#else
+    const char* backend = "scalar";
+#endif
+    int32_t packed_mismatches = 0;
+    int32_t ao_mismatches = 0;
+    for (int32_t count = 0; count <= MESH_SOA_CHECK_MAX_COUNT; ++count) {
+        packed_mismatches += check_round_trip(count, 6);
+        ao_mismatches += check_round_trip(count, 7);
+    }
+    printf("SoA round trip (%s), 0-%d vertices: %d packed mismatches, %d AO layout mismatches\n", backend,
+           MESH_SOA_CHECK_MAX_COUNT, packed_mismatches, ao_mismatches);
+    return packed_mismatches || ao_mismatches ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,5 @@
+gcc mesh_soa_check.c -Wall -std=c11 -O2 -mavx -o mesh_soa_check_avx.out -lm
+gcc mesh_soa_check.c -Wall -std=c11 -O2 -o mesh_soa_check_sse2.out -lm
+gcc mesh_soa_check.c -Wall -std=c11 -O2 -DMESH_NO_SIMD -o mesh_soa_check_scalar.out -lm
+
+./mesh_soa_check_scalar.out && ./mesh_soa_check_sse2.out && ./mesh_soa_check_avx.out
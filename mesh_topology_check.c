@@ -0,0 +1,298 @@
+// Agreement of the half-edge structure of mesh_topology.h with brute force edge maps built from
+// the per-vertex lists of outgoing half-edges. Every twin has to be the unique opposite
+// half-edge of the map or -1 when there is none, twins have to be involutive, and the
+// GL_TRIANGLES_ADJACENCY indices have to put every corner before the vertex opposite its edge in
+// the neighbouring face (the triangle's own third vertex on boundaries). Every one-ring has to
+// list each neighbour of the map exactly once with consecutive neighbours spanning a face, open
+// fans have to run from the outgoing to the incoming boundary edge, and unreferenced vertices
+// have to have an empty ring. The meshes are a closed torus, a closed UV sphere with high valence
+// poles, a torus with a hole and an open grid with an unreferenced vertex, each built with
+// mesh_topology_build and mesh_topology_build_scratch, which have to agree. Exits with
+// EXIT_FAILURE on any mismatch. See mesh_topology_check.sh.
+#define _VEC_MATH_IMPLEMENTATION_
+#define _MESH_IMPLEMENTATION_
+#define _PARALLEL_IMPLEMENTATION_
+#define _MESH_TOPOLOGY_IMPLEMENTATION_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "libs/vec_math.h"
+#include "libs/mesh.h"
+#include "libs/parallel.h"
+#include "libs/mesh_topology.h"
+
+// Large enough for several par_for ranges of the topology build and the adjacency pass
+#define TOPOLOGY_CHECK_RINGS 160
+#define TOPOLOGY_CHECK_SIDES 120
+// Largest valence of the meshes, the poles of the sphere
+#define TOPOLOGY_CHECK_MAX_VALENCE TOPOLOGY_CHECK_SIDES
+
+typedef struct TopologyReport {
+    int32_t twins;
+    int32_t involution;
+    int32_t adjacency;
+    int32_t rings;
+    int32_t fans;
+    int32_t counts;
+    int32_t scratch;
+} TopologyReport;
+
+// Per-vertex lists: `start` has vertex_count + 1 entries into `items`
+typedef struct VertexLists {
+    int32_t* start;
+    int32_t* items;
+} VertexLists;
+
+static void emit_quad(uint32_t* triangles, int32_t* count, uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    // a b on one row, c d on the next, counter-clockwise
+    const uint32_t quad[6] = { a, b, d, a, d, c };
+    memcpy(triangles + 3 * (size_t)*count, quad, sizeof(quad));
+    *count += 2;
+}
+
+// rings x sides torus, closed unless `hole` > 0 quads per side are left out
+static int32_t make_torus(uint32_t* triangles, int32_t rings, int32_t sides, int32_t hole) {
+    int32_t count = 0;
+    for (int32_t r = 0; r < rings; ++r) {
+        for (int32_t s = 0; s < sides; ++s) {
+            if (r >= rings / 4 && r < rings / 4 + hole && s >= sides / 4 && s < sides / 4 + hole) {
+                continue;
+            }
+            const int32_t r1 = (r + 1) % rings;
+            const int32_t s1 = (s + 1) % sides;
+            emit_quad(triangles, &count, (uint32_t)(r * sides + s), (uint32_t)(r * sides + s1),
+                      (uint32_t)(r1 * sides + s), (uint32_t)(r1 * sides + s1));
+        }
+    }
+    return count;
+}
+
+// UV sphere: a pole vertex at either end of rings - 1 rows of `sides` vertices
+static int32_t make_sphere(uint32_t* triangles, int32_t rings, int32_t sides) {
+    const uint32_t south = (uint32_t)(1 + (rings - 1) * sides);
+    int32_t count = 0;
+    for (int32_t s = 0; s < sides; ++s) {
+        const uint32_t s1 = (uint32_t)((s + 1) % sides);
+        const uint32_t north_fan[3] = { 0, 1 + s1, 1 + (uint32_t)s };
+        memcpy(triangles + 3 * (size_t)count++, north_fan, sizeof(north_fan));
+        for (int32_t r = 1; r + 1 < rings; ++r) {
+            const uint32_t row = (uint32_t)(1 + (r - 1) * sides);
+            emit_quad(triangles, &count, row + s, row + s1, row + sides + s, row + sides + s1);
+        }
+        const uint32_t last = (uint32_t)(1 + (rings - 2) * sides);
+        const uint32_t south_fan[3] = { last + s, last + s1, south };
+        memcpy(triangles + 3 * (size_t)count++, south_fan, sizeof(south_fan));
+    }
+    return count;
+}
+
+// n x n quads without wrapping
+static int32_t make_grid(uint32_t* triangles, int32_t n) {
+    int32_t count = 0;
+    for (int32_t y = 0; y < n; ++y) {
+        for (int32_t x = 0; x < n; ++x) {
+            const uint32_t a = (uint32_t)(y * (n + 1) + x);
+            emit_quad(triangles, &count, a, a + 1, a + n + 1, a + n + 2);
+        }
+    }
+    return count;
+}
+
+// Counting sort of (vertex, item) pairs into per-vertex lists
+static int32_t build_lists(VertexLists* lists, int32_t vertex_count, const uint32_t* keys, const int32_t* items,
+                           int32_t count) {
+    lists->start = (int32_t*)calloc((size_t)vertex_count + 1, sizeof(int32_t));
+    lists->items = (int32_t*)malloc((size_t)count * sizeof(int32_t));
+    int32_t* fill = (int32_t*)malloc((size_t)vertex_count * sizeof(int32_t));
+    if (!lists->start || !lists->items || !fill) {
+        return EXIT_FAILURE;
+    }
+    for (int32_t i = 0; i < count; ++i) {
+        lists->start[keys[i] + 1]++;
+    }
+    for (int32_t v = 0; v < vertex_count; ++v) {
+        lists->start[v + 1] += lists->start[v];
+        fill[v] = lists->start[v];
+    }
+    for (int32_t i = 0; i < count; ++i) {
+        lists->items[fill[keys[i]]++] = items[i];
+    }
+    free(fill);
+    return 0;
+}
+
+static void free_lists(VertexLists* lists) {
+    free(lists->start);
+    free(lists->items);
+}
+
+// The half-edge from `a` to `b` whose face continues to `c`, -1 if there is none (c < 0 accepts any face)
+static int32_t find_halfedge(const VertexLists* outgoing, const uint32_t* triangles, uint32_t a, uint32_t b,
+                             int64_t c) {
+    for (int32_t i = outgoing->start[a]; i < outgoing->start[a + 1]; ++i) {
+        const int32_t he = outgoing->items[i];
+        if (triangles[mesh_he_next(he)] == b && (c < 0 || triangles[mesh_he_prev(he)] == (uint32_t)c)) {
+            return he;
+        }
+    }
+    return -1;
+}
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int32_t check_mesh(const char* name, uint32_t* triangles, int32_t vertex_count, int32_t triangle_count,
+                          TopologyReport* report) {
+    memset(report, 0, sizeof(*report));
+    MeshData mesh;
+    memset(&mesh, 0, sizeof(mesh));
+    mesh.vertex_count = vertex_count;
+    mesh.triangle_count = triangle_count;
+    mesh.triangles = triangles;
+
+    MeshTopology topology;
+    MeshTopologyScratch scratch;
+    MeshTopology scratch_topology;
+    if (mesh_topology_build(&mesh, &topology) ||
+        mesh_topology_scratch_create(&scratch, vertex_count, triangle_count) ||
+        mesh_topology_build_scratch(&mesh, &scratch, &scratch_topology)) {
+        fprintf(stderr, "Failed to build the topology of the %s\n", name);
+        return EXIT_FAILURE;
+    }
+
+    // Edge map: outgoing half-edges per vertex, and both endpoints of every half-edge for the neighbours
+    const int32_t halfedge_count = 3 * triangle_count;
+    int32_t* ids = (int32_t*)calloc((size_t)halfedge_count * 2, sizeof(int32_t));
+    uint32_t* ends = (uint32_t*)malloc((size_t)halfedge_count * 2 * sizeof(uint32_t));
+    uint32_t* adjacency = (uint32_t*)malloc((size_t)triangle_count * 6 * sizeof(uint32_t));
+    if (!ids || !ends || !adjacency) {
+        return EXIT_FAILURE;
+    }
+    VertexLists outgoing;
+    VertexLists neighbours;
+    for (int32_t he = 0; he < halfedge_count; ++he) {
+        ids[he] = he;
+    }
+    if (build_lists(&outgoing, vertex_count, triangles, ids, halfedge_count)) {
+        return EXIT_FAILURE;
+    }
+    for (int32_t he = 0; he < halfedge_count; ++he) {
+        ends[2 * he + 0] = triangles[he];
+        ends[2 * he + 1] = triangles[mesh_he_next(he)];
+        ids[2 * he + 0] = (int32_t)triangles[mesh_he_next(he)];
+        ids[2 * he + 1] = (int32_t)triangles[he];
+    }
+    if (build_lists(&neighbours, vertex_count, ends, ids, 2 * halfedge_count)) {
+        return EXIT_FAILURE;
+    }
+
+    // Twins: the unique opposite half-edge of the map, involutive
+    int32_t boundary_edges = 0;
+    mesh_topology_adjacency_indices(&topology, adjacency);
+    for (int32_t he = 0; he < halfedge_count; ++he) {
+        const uint32_t a = triangles[he];
+        const uint32_t b = triangles[mesh_he_next(he)];
+        const int32_t expected = find_halfedge(&outgoing, triangles, b, a, -1);
+        const int32_t twin = topology.twin[he];
+        boundary_edges += expected < 0;
+        report->twins += twin != expected;
+        report->involution += twin >= 0 && (twin == he || topology.twin[twin] != he ||
+                                            mesh_he_origin(&topology, twin) != b ||
+                                            mesh_he_target(&topology, twin) != a);
+
+        const uint32_t opposite = expected >= 0 ? triangles[mesh_he_prev(expected)] : triangles[mesh_he_prev(he)];
+        report->adjacency += adjacency[2 * he] != a || adjacency[2 * he + 1] != opposite;
+    }
+    report->counts += topology.boundary_edge_count != boundary_edges || topology.nonmanifold_edge_count != 0;
+    report->scratch +=
+        memcmp(topology.twin, scratch_topology.twin, (size_t)halfedge_count * sizeof(int32_t)) != 0 ||
+        memcmp(topology.vertex_halfedge, scratch_topology.vertex_halfedge, (size_t)vertex_count * sizeof(int32_t)) != 0;
+
+    // One-rings: every neighbour once, consecutive neighbours span a face, open fans between the boundary edges
+    for (int32_t v = 0; v < vertex_count; ++v) {
+        uint32_t* expected = (uint32_t*)neighbours.items + neighbours.start[v];
+        int32_t expected_count = neighbours.start[v + 1] - neighbours.start[v];
+        qsort(expected, (size_t)expected_count, sizeof(uint32_t), compare_u32);
+        int32_t unique = 0;
+        for (int32_t i = 0; i < expected_count; ++i) {
+            if (i == 0 || expected[i] != expected[i - 1]) {
+                expected[unique++] = expected[i];
+            }
+        }
+
+        uint32_t ring[TOPOLOGY_CHECK_MAX_VALENCE + 1];
+        const int32_t valence = mesh_vertex_one_ring(&topology, (uint32_t)v, ring, TOPOLOGY_CHECK_MAX_VALENCE + 1);
+        if (valence != unique || valence > TOPOLOGY_CHECK_MAX_VALENCE) {
+            report->rings++;
+            continue;
+        }
+        if (valence == 0) {
+            report->rings += topology.vertex_halfedge[v] != -1;
+            continue;
+        }
+        for (int32_t i = 0; i + 1 < valence; ++i) {
+            report->rings += find_halfedge(&outgoing, triangles, (uint32_t)v, ring[i], ring[i + 1]) < 0;
+        }
+        const int32_t closed = find_halfedge(&outgoing, triangles, (uint32_t)v, ring[valence - 1], ring[0]) >= 0;
+        uint32_t sorted[TOPOLOGY_CHECK_MAX_VALENCE];
+        memcpy(sorted, ring, (size_t)valence * sizeof(uint32_t));
+        qsort(sorted, (size_t)valence, sizeof(uint32_t), compare_u32);
+        report->rings += memcmp(sorted, expected, (size_t)valence * sizeof(uint32_t)) != 0;
+
+        // Only fans with no face between the last and the first neighbour are open, and those have to start at
+        // the outgoing boundary edge and end at the incoming one
+        const int32_t outgoing_boundary = find_halfedge(&outgoing, triangles, (uint32_t)v, ring[0], -1) >= 0 &&
+                                          find_halfedge(&outgoing, triangles, ring[0], (uint32_t)v, -1) < 0;
+        const int32_t incoming_boundary = find_halfedge(&outgoing, triangles, ring[valence - 1], (uint32_t)v, -1) >= 0 &&
+                                          find_halfedge(&outgoing, triangles, (uint32_t)v, ring[valence - 1], -1) < 0;
+        const int32_t boundary = !closed;
+        report->fans += boundary != mesh_vertex_is_boundary(&topology, (uint32_t)v) ||
+                        boundary != outgoing_boundary || boundary != incoming_boundary;
+    }
+
+    const int32_t mismatches = report->twins + report->involution + report->adjacency + report->rings +
+                               report->fans + report->counts + report->scratch;
+    printf("%-14s %7d triangles, %5d boundary edges: twins %d, involution %d, adjacency %d, rings %d, fans %d, "
+           "counts %d, scratch %d\n", name, triangle_count, topology.boundary_edge_count, report->twins,
+           report->involution, report->adjacency, report->rings, report->fans, report->counts, report->scratch);
+
+    free_lists(&outgoing);
+    free_lists(&neighbours);
+    free(ids);
+    free(ends);
+    free(adjacency);
+    mesh_topology_scratch_destroy(&scratch);
+    mesh_topology_free(&topology);
+    return mismatches ? EXIT_FAILURE : 0;
+}
+
+int32_t main(void) {
+    const int32_t rings = TOPOLOGY_CHECK_RINGS;
+    const int32_t sides = TOPOLOGY_CHECK_SIDES;
+    uint32_t* triangles = (uint32_t*)malloc((size_t)rings * sides * 6 * sizeof(uint32_t));
+    if (!triangles) {
+        return EXIT_FAILURE;
+    }
+    TopologyReport report;
+    int32_t failed = 0;
+
+    int32_t count = make_torus(triangles, rings, sides, 0);
+    failed |= check_mesh("closed torus", triangles, rings * sides, count, &report);
+    count = make_sphere(triangles, rings, sides);
+    failed |= check_mesh("closed sphere", triangles, 2 + (rings - 1) * sides, count, &report);
+    count = make_torus(triangles, rings, sides, sides / 3);
+    failed |= check_mesh("open torus", triangles, rings * sides, count, &report);
+    // The last vertex is left unreferenced
+    count = make_grid(triangles, sides);
+    failed |= check_mesh("open grid", triangles, (sides + 1) * (sides + 1) + 1, count, &report);
+
+    par_shutdown();
+    free(triangles);
+    return failed ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,3 @@
+gcc mesh_topology_check.c -Wall -std=c11 -O2 -march=native -o mesh_topology_check.out -lm -lpthread
+
+PAR_NUM_THREADS=1 ./mesh_topology_check.out && ./mesh_topology_check.out
@@ -0,0 +1,160 @@
+// Screen space throughput: project() and unproject() per point against the batches of
+// vec_math.h on one thread and the par_for versions of screen_space.h, plus picking rays and
+// box bounds, in nanoseconds per element over 100k elements. Also checks that every version
+// gives the results of the single functions bit for bit. PAR_NUM_THREADS sets the thread
+// count (see screen_space_bench.sh).
+#define _POSIX_C_SOURCE 199309L
+#define _VEC_MATH_IMPLEMENTATION_
+#define _PARALLEL_IMPLEMENTATION_
+#define _SCREEN_SPACE_IMPLEMENTATION_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "libs/vec_math.h"
+#include "libs/parallel.h"
+#include "libs/screen_space.h"
+
+#define BENCH_COUNT 100000
+#define BENCH_RUNS 100
+
+typedef struct BenchData {
+    mat4_t view;
+    mat4_t projection;
+    ScreenCamera camera;
+    vec3_t points[BENCH_COUNT];
+    vec3_t win[BENCH_COUNT];
+    vec3_t out[BENCH_COUNT];
+    vec3_t directions[BENCH_COUNT];
+    vec2_t pixels[BENCH_COUNT];
+    vec3_t maxs[BENCH_COUNT];
+    vec4_t rects[BENCH_COUNT];
+} BenchData;
+
+typedef void (*BenchKernel)(BenchData* data);
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static float random_range(float lo, float hi) {
+    return lo + (hi - lo) * (float)rand() / (float)RAND_MAX;
+}
+
+static void project_single(BenchData* d) {
+    for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+        const vec3_t p = d->points[i];
+        d->out[i] = project(vec4(p.x, p.y, p.z, 1.0f), d->view, d->projection, d->camera.viewport);
+    }
+}
+
+static void project_batched(BenchData* d) {
+    project_batch(d->camera.mvp, d->camera.viewport, d->points, d->out, BENCH_COUNT);
+}
+
+static void project_threaded(BenchData* d) {
+    screen_project_points(&d->camera, d->points, d->out, BENCH_COUNT);
+}
+
+static void unproject_single(BenchData* d) {
+    for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+        const vec4_t p = unproject(d->win[i], d->view, d->projection, d->camera.viewport);
+        d->out[i] = vec3(p.x, p.y, p.z);
+    }
+}
+
+static void unproject_batched(BenchData* d) {
+    unproject_batch(d->camera.inverse_mvp, d->camera.viewport, d->win, d->out, BENCH_COUNT);
+}
+
+static void unproject_threaded(BenchData* d) {
+    screen_unproject_points(&d->camera, d->win, d->out, BENCH_COUNT);
+}
+
+static void pick_rays_threaded(BenchData* d) {
+    screen_pick_rays(&d->camera, d->pixels, d->out, d->directions, BENCH_COUNT);
+}
+
+static void bounds_threaded(BenchData* d) {
+    screen_bounds_aabbs(&d->camera, d->points, d->maxs, d->rects, BENCH_COUNT);
+}
+
+static double bench(BenchKernel kernel, BenchData* data) {
+    double best = 1e30;
+    for (int32_t run = 0; run < BENCH_RUNS; ++run) {
+        double start = now_seconds();
+        kernel(data);
+        double elapsed = now_seconds() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    return best * 1e9 / BENCH_COUNT;
+}
+
+// Number of elements where `kernel` differs from `reference` in the output points
+static int32_t mismatches(BenchKernel reference, BenchKernel kernel, BenchData* data) {
+    static vec3_t expected[BENCH_COUNT];
+    reference(data);
+    memcpy(expected, data->out, sizeof(expected));
+    memset(data->out, 0, sizeof(data->out));
+    kernel(data);
+    int32_t count = 0;
+    for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+        count += memcmp(&expected[i], &data->out[i], sizeof(vec3_t)) != 0;
+    }
+    return count;
+}
+
+int main(void) {
+    BenchData* data = (BenchData*)malloc(sizeof(BenchData));
+    if (!data) {
+        fprintf(stderr, "Failed to allocate the points\n");
+        return EXIT_FAILURE;
+    }
+
+    data->view = look_at(vec3(0.0f, 20.0f, 60.0f), vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f));
+    data->projection = perspective(PI / 3.0f, 16.0f / 9.0f, 0.1f, 500.0f);
+    data->camera = screen_camera(mat4_mul(data->projection, data->view), vec4(0.0f, 0.0f, 1920.0f, 1080.0f));
+
+    // Points and unit boxes in front of the camera, window positions and pixels across the screen
+    srand(1);
+    for (int32_t i = 0; i < BENCH_COUNT; ++i) {
+        data->points[i] = vec3(random_range(-40.0f, 40.0f), random_range(-20.0f, 20.0f), random_range(-40.0f, 40.0f));
+        data->maxs[i] = vec3_add(data->points[i], vec3(1.0f, 1.0f, 1.0f));
+        data->pixels[i] = vec2(random_range(0.0f, 1920.0f), random_range(0.0f, 1080.0f));
+        data->win[i] = vec3(data->pixels[i].x, data->pixels[i].y, random_range(0.0f, 1.0f));
+    }
+
+    printf("%d elements, %d threads\n", BENCH_COUNT, par_worker_count());
+    printf("  mismatches against the single functions: project batch %d, threaded %d, unproject batch %d, threaded %d\n",
+           mismatches(project_single, project_batched, data), mismatches(project_single, project_threaded, data),
+           mismatches(unproject_single, unproject_batched, data), mismatches(unproject_single, unproject_threaded, data));
+
+    const struct {
+        const char* name;
+        BenchKernel single;
+        BenchKernel batch;
+        BenchKernel threaded;
+    } cases[2] = {
+        { "project", project_single, project_batched, project_threaded },
+        { "unproject", unproject_single, unproject_batched, unproject_threaded },
+    };
+    printf("ns per element (best of %d)   single     batch           threaded\n", BENCH_RUNS);
+    for (int32_t c = 0; c < 2; ++c) {
+        double single = bench(cases[c].single, data);
+        double batch = bench(cases[c].batch, data);
+        double threaded = bench(cases[c].threaded, data);
+        printf("  %-26s %8.2f %8.2f (%.1fx) %8.2f (%.1fx)\n", cases[c].name, single, batch, single / batch, threaded,
+               single / threaded);
+    }
+    printf("  %-26s %44.2f\n", "screen_pick_rays", bench(pick_rays_threaded, data));
+    printf("  %-26s %44.2f\n", "screen_bounds_aabbs", bench(bounds_threaded, data));
+
+    par_shutdown();
+    free(data);
+    return 0;
+}
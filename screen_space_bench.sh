@@ -0,0 +1,6 @@
+gcc screen_space_bench.c -Wall -std=c11 -O2 -march=native -o screen_space_bench.out -lm -lrt -lpthread
+gcc screen_space_bench.c -Wall -std=c11 -O2 -DVEC_MATH_NO_SIMD -o screen_space_bench_scalar.out -lm -lrt -lpthread
+
+PAR_NUM_THREADS=1 ./screen_space_bench_scalar.out
+PAR_NUM_THREADS=1 ./screen_space_bench.out
+./screen_space_bench.out
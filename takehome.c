@@ -3,6 +3,19 @@
 #define _GLFW_IMPLEMENTATION_
 #define _GL_HELPERS_IMPLEMENTATION_
 #define _VEC_MATH_IMPLEMENTATION_
+#define _MESH_IMPLEMENTATION_
+#define _PARALLEL_IMPLEMENTATION_
+#define _MESH_TOPOLOGY_IMPLEMENTATION_
+#define _SUBDIVISION_IMPLEMENTATION_
+#define _CONVEX_HULL_IMPLEMENTATION_
+#define _BVH_IMPLEMENTATION_
+#define _AO_BAKE_IMPLEMENTATION_
+#define _SDF_IMPLEMENTATION_
+#define _SCULPT_IMPLEMENTATION_
+#define _POINT_LOD_IMPLEMENTATION_
+#define _IMPOSTER_IMPLEMENTATION_
+#define _DEFORM_IMPLEMENTATION_
+#define _FRUSTUM_IMPLEMENTATION_
 
 // Detect OS
 #define PLATFORM_WINDOWS 0
@@ -53,33 +66,122 @@
 #include "libs/glad.h"
 #include "libs/gl_helpers.h"
 #include "libs/vec_math.h"
+#include "libs/mesh.h"
+#include "libs/parallel.h"
+#include "libs/mesh_topology.h"
+#include "libs/subdivision.h"
+#include "libs/convex_hull.h"
+#include "libs/bvh.h"
+#include "libs/ao_bake.h"
+#include "libs/sdf.h"
+#include "libs/sculpt.h"
+#include "libs/point_lod.h"
+#include "libs/imposter.h"
+#include "libs/deform.h"
+#include "libs/frustum.h"
 
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 600
 
+// Crowd mode: a CROWD_SIDE x CROWD_SIDE grid of model instances receding from the camera
+#define CROWD_SIDE 15
+#define CROWD_COUNT (CROWD_SIDE * CROWD_SIDE)
+// Instances smaller than this radius on screen, in pixels, are drawn as imposters
+#define IMPOSTER_MAX_PIXELS 40.0f
+
+// Loop subdivision levels of the close-up model, and the triangle budget of its buffers - refinement stops at the
+// last level that fits instead of sizing for the worst case of 4^levels growth
+#define SUBDIV_MAX_LEVELS 2
+#define SUBDIV_MAX_TRIANGLES (1 << 20)
+
+// Regions of the streamed vertex buffer of the animated model: the CPU writes one while the GPU
+// may still read the two previous frames
+#define DEFORM_REGION_COUNT 3
+
+// Hardware tessellation modes of the model, cycled with the T key
+typedef enum TessellationMode {
+    TESSELLATION_OFF,
+    TESSELLATION_PHONG,
+    TESSELLATION_PN_TRIANGLES,
+    TESSELLATION_MODE_COUNT
+} TessellationMode;
+
 // Basic datastructures
 typedef struct SceneData {
     GLuint cube_vao;
     GLuint basic_program;
     GLuint model_vao;
+    GLuint model_vbo;
     GLuint model_program;
     GLuint framebuffer;
     GLuint texture;
-} SceneData;
-
-typedef struct MeshData {
-    int32_t vertex_count;
-    int32_t triangle_count;
-    float* vertex_data; // position (3 floats), normals (3 floats)
-    uint32_t* triangles; // 3 x triangle_count
 
-    // Vertex Layout info
-    int32_t vertex_size;
-    int32_t positions_size;
-    int32_t positions_offset;
-    int32_t normals_size;
-    int32_t normals_offset;
-} MeshData;
+    // Adaptively subdivided copy of the model, toggled with the S key
+    GLuint subdiv_vao;
+    GLuint subdiv_vbo;
+    GLuint subdiv_ebo;
+    int32_t subdiv_triangle_count;
+    bool subdivision_enabled;
+    bool subdivision_dirty;
+
+    // Model program with tessellation stages, used when `tessellation_mode` is not TESSELLATION_OFF
+    GLuint tess_program;
+    TessellationMode tessellation_mode;
+
+    // Signed distance field of the model, ray marched on the cube faces instead of
+    // rendering the model offscreen when `sdf_enabled` is set with the D key
+    GLuint sdf_program;
+    GLuint sdf_texture;
+    vec3_t sdf_min;   // Model space corner of the distance texture
+    vec3_t sdf_size;  // Model space extent of the distance texture
+    bool sdf_enabled;
+
+    // Position-only copy of the model for depth-only passes, sharing the model's index buffer.
+    // Depth passes fetch 12 instead of `vertex_size` bytes per vertex.
+    GLuint depth_vao;
+    GLuint depth_vbo;
+    GLuint depth_program;
+    bool depth_prepass;  // Lay down depth before shading the model, toggled with the P key
+
+    // Point splat preview of the model vertices with a level of detail per chunk, toggled with the O key
+    GLuint points_vao;
+    GLuint points_vbo;
+    GLuint points_program;
+    const PointLod* point_lod;
+    int32_t* point_firsts;  // glMultiDrawArrays ranges, one per chunk
+    int32_t* point_counts;
+    bool points_enabled;
+
+    // Octahedral imposter atlas of the model (albedo with baked occlusion, and normal + depth),
+    // drawn as instanced billboards for the far instances of the crowd, toggled with the I key
+    ImposterAtlas imposter_atlas;
+    GLuint imposter_color;
+    GLuint imposter_normal_depth;
+    GLuint imposter_program;
+    GLuint imposter_vao;
+    GLuint imposter_quad_vbo;
+    GLuint imposter_instance_vbo;
+    float crowd_offsets[CROWD_COUNT][3];   // Instance translations in model pass world space
+    float crowd_centers[CROWD_COUNT][3];   // Bounding sphere centers, updated every frame
+    uint32_t crowd_near[CROWD_COUNT];      // Instances drawn as meshes
+    uint32_t crowd_far[CROWD_COUNT];       // Instances drawn as imposters
+    float crowd_spheres[4][CROWD_COUNT];   // Sphere centers and radii as arrays for the frustum culling
+    uint32_t crowd_visible[(CROWD_COUNT + 31) / 32]; // Instances whose sphere touches the view frustum
+    bool crowd_enabled;
+
+    // Brush sculpting with the left mouse button (Shift carves), toggled with the B key
+    bool sculpt_enabled;
+    bool sculpt_stroke;  // The button was down on the previous frame
+
+    // Vertex animation on the CPU (morph targets and a travelling wave), positions and normals
+    // streamed every frame into the next region of `deform_vbo`, toggled with the A key
+    Deformer* deformer;
+    GLuint deform_vao;
+    GLuint deform_vbo;
+    GLsync deform_fences[DEFORM_REGION_COUNT];  // Signalled once the GPU is done with a region
+    int32_t deform_region;                      // Region written this frame
+    bool deform_enabled;
+} SceneData;
 
 float cube_vertices[] = {
 		// positions          // normals           // texture coords
@@ -159,15 +261,17 @@ const char* cube_vrtx_shdr_src =
     uniform mat4 view;
     // `projection` is the projection matrix that transforms vertices from camera space to screen space.
     uniform mat4 projection;
+    // `normalMatrix` transforms normals, the cofactor matrix of the model matrix computed once per draw on the CPU.
+    uniform mat3 normalMatrix;
 
     void main()
     {
         // Transform vertex position from model space to world space using the model matrix.
         FragPos = vec3(model * vec4(aPos, 1.0));
 
-        // Transform the normal vector from model space to world space using the model matrix.
-        // `transpose(inverse(model))` is used to correctly transform normals.
-        Normal = mat3(transpose(inverse(model))) * aNormal;
+        // Transform the normal vector from model space to world space using the normal matrix.
+        // It is `transpose(inverse(model))` up to scale, the fragment shader normalizes.
+        Normal = normalMatrix * aNormal;
 
         // Pass texture coordinates to the fragment shader.
         TexCoords = aTexCoords;
@@ -226,6 +330,145 @@ const char* cube_frag_shdr_src =
     }
 );
 
+// Fragment shader for the cube in signed distance field mode, runs after `cube_vrtx_shdr_src`.
+// Every cube fragment ray marches the model distance field along the ray its texel would have
+// seen in the offscreen model pass, so the cost per pixel is fixed regardless of the mesh size.
+const char* sdf_frag_shdr_src =
+    GLH_SHADER_HEADER
+    GLH_STRINGIFY(
+
+    // Output color of the fragment.
+    out vec4 FragColor;
+
+    // Inputs from the cube vertex shader.
+    in vec3 FragPos;
+    in vec3 Normal;
+    in vec2 TexCoords;
+
+    // `sdf` holds the signed distances of the model in model space, negative inside.
+    uniform sampler3D sdf;
+    // `sdfMin` and `sdfSize` place the distance texture in model space.
+    uniform vec3 sdfMin;
+    uniform vec3 sdfSize;
+    // `meshModel` is the model matrix of the offscreen model pass, a pure rotation.
+    uniform mat4 meshModel;
+    // `meshInverseMVP` maps the clip space of the offscreen model pass back to model space.
+    uniform mat4 meshInverseMVP;
+
+    // Lighting and material uniforms of the model fragment shader, set by `set_texture`.
+    uniform vec3 lightPos;
+    uniform vec3 viewPos;
+    uniform vec3 lightColor;
+    uniform vec3 objectColor;
+    uniform float roughness;
+    uniform float metalness;
+
+    // Signed distance at a model space point.
+    float sceneDistance(vec3 p)
+    {
+        return texture(sdf, (p - sdfMin) / sdfSize).r;
+    }
+
+    // Surface normal from central differences one voxel wide.
+    vec3 sceneNormal(vec3 p, float voxel)
+    {
+        vec2 e = vec2(voxel, 0.0);
+        return normalize(vec3(sceneDistance(p + e.xyy) - sceneDistance(p - e.xyy),
+                              sceneDistance(p + e.yxy) - sceneDistance(p - e.yxy),
+                              sceneDistance(p + e.yyx) - sceneDistance(p - e.yyx)));
+    }
+
+    // Entry and exit distances of a ray through the texture bounds.
+    vec2 boxInterval(vec3 origin, vec3 dir)
+    {
+        vec3 t0 = (sdfMin - origin) / dir;
+        vec3 t1 = (sdfMin + sdfSize - origin) / dir;
+        vec3 tmin = min(t0, t1);
+        vec3 tmax = max(t0, t1);
+        return vec2(max(max(tmin.x, tmin.y), max(tmin.z, 0.0)), min(min(tmax.x, tmax.y), tmax.z));
+    }
+
+    // Soft shadow towards the light: the closest miss relative to the distance travelled
+    // widens the penumbra with distance from the occluder.
+    float softShadow(vec3 origin, vec3 dir, float tmax, float voxel)
+    {
+        float shadow = 1.0;
+        float t = 2.0 * voxel;
+        for (int i = 0; i < 64 && t < tmax; ++i) {
+            float d = sceneDistance(origin + dir * t);
+            shadow = min(shadow, 8.0 * d / t);
+            if (shadow < 0.01) {
+                break;
+            }
+            t += clamp(d, 0.5 * voxel, 4.0 * voxel);
+        }
+        return clamp(shadow, 0.0, 1.0);
+    }
+
+    void main()
+    {
+        // Ray of this texel in the offscreen model pass, in model space.
+        vec2 ndc = TexCoords * 2.0 - 1.0;
+        vec4 nearPoint = meshInverseMVP * vec4(ndc, -1.0, 1.0);
+        vec4 farPoint = meshInverseMVP * vec4(ndc, 1.0, 1.0);
+        vec3 origin = nearPoint.xyz / nearPoint.w;
+        vec3 dir = normalize(farPoint.xyz / farPoint.w - origin);
+        float voxel = sdfSize.x / float(textureSize(sdf, 0).x);
+
+        // Sphere trace through the texture bounds.
+        vec2 span = boxInterval(origin, dir);
+        float t = span.x;
+        bool hit = false;
+        for (int i = 0; i < 128 && t < span.y; ++i) {
+            float d = sceneDistance(origin + dir * t);
+            if (d < 0.25 * voxel) {
+                hit = true;
+                break;
+            }
+            t += max(d, 0.25 * voxel);
+        }
+
+        // Clear color of the offscreen model pass where the ray misses.
+        vec3 color = vec3(0.1);
+        if (hit) {
+            vec3 p = origin + dir * t;
+            // Shade in world space like the model fragment shader.
+            vec3 worldPos = vec3(meshModel * vec4(p, 1.0));
+            vec3 norm = normalize(mat3(meshModel) * sceneNormal(p, voxel));
+            vec3 viewDir = normalize(viewPos - worldPos);
+            vec3 lightDir = normalize(lightPos - worldPos);
+            vec3 halfDir = normalize(viewDir + lightDir);
+
+            vec3 ambient = 0.1 * lightColor;
+            float diff = max(dot(norm, lightDir), 0.0);
+            vec3 diffuse = diff * lightColor;
+            float spec = pow(max(dot(norm, halfDir), 0.5), 64.0);
+            vec3 specular = spec * lightColor;
+
+            vec3 albedo = objectColor * (1.0 - metalness);
+            vec3 ambientColor = ambient * albedo;
+            vec3 diffuseColor = diffuse * albedo;
+            vec3 specularColor = specular * metalness;
+
+            // March the shadow ray in model space, the transpose undoes the rotation.
+            vec3 lightModel = lightPos * mat3(meshModel);
+            vec3 toLight = lightModel - p;
+            vec3 shadowDir = normalize(toLight);
+            float shadowEnd = min(length(toLight), boxInterval(p, shadowDir).y);
+            float shadow = softShadow(p, shadowDir, shadowEnd, voxel);
+
+            color = ambientColor + (diffuseColor + specularColor) * shadow;
+        }
+
+        // Light the cube face exactly like `cube_frag_shdr_src` does with the offscreen texture.
+        vec3 cubeNorm = normalize(Normal);
+        vec3 cubeLightDir = normalize(vec3(1.0, 1.0, 1.0) - FragPos);
+        float cubeDiff = max(dot(cubeNorm, cubeLightDir), 0.0);
+        vec3 cubeLight = vec3(1.0) + cubeDiff * vec3(1.0);
+        FragColor = vec4(color, 1.0) * vec4(cubeLight, 0.8);
+    }
+);
+
 // Shaders for model
 const char* model_vrtx_shdr_src =
     GLH_SHADER_HEADER
@@ -238,6 +481,9 @@ const char* model_vrtx_shdr_src =
     // `aNormal` is the normal vector at the vertex, with layout location 1.
     layout(location = 1) in vec3 aNormal; // Normal attribute
 
+    // `aOcclusion` is the baked ambient occlusion at the vertex, with layout location 2.
+    layout(location = 2) in float aOcclusion; // Ambient occlusion attribute
+
     // Outputs to the fragment shader
     // `FragPos` is the position of the fragment in world space.
     out vec3 FragPos;  // Position of the fragment in world space
@@ -245,6 +491,9 @@ const char* model_vrtx_shdr_src =
     // `Normal` is the normal vector at the fragment, used for lighting calculations.
     out vec3 Normal;   // Normal of the fragment
 
+    // `Occlusion` is the interpolated ambient occlusion, 1.0 meaning fully open.
+    out float Occlusion; // Ambient occlusion of the fragment
+
     // Uniforms used for transformations
     // `model` matrix transforms vertex positions from model space to world space.
     // `view` matrix transforms vertices from world space to camera (view) space.
@@ -252,6 +501,10 @@ const char* model_vrtx_shdr_src =
     uniform mat4 model;       // Model matrix
     uniform mat4 view;        // View matrix
     uniform mat4 projection;  // Projection matrix
+    uniform mat3 normalMatrix; // Cofactor matrix of the model matrix, from the CPU
+
+    // Bit-identical to the depth-only shader, so the depth prepass can be tested with GL_LEQUAL.
+    invariant gl_Position;
 
     void main()
     {
@@ -259,8 +512,11 @@ const char* model_vrtx_shdr_src =
         FragPos = vec3(model * vec4(aPos, 1.0));
 
         // Transform the normal vector from model space to world space.
-        // `transpose(inverse(model))` adjusts normals for correct lighting in world space.
-        Normal = mat3(transpose(inverse(model))) * aNormal;  
+        // The normal matrix is `transpose(inverse(model))` up to scale, computed once per draw instead of per vertex.
+        Normal = normalMatrix * aNormal;
+
+        // Pass the baked ambient occlusion through unchanged.
+        Occlusion = aOcclusion;
 
         // Calculate the final position of the vertex in clip space.
         // Applying the projection matrix after the view matrix determines the final screen position.
@@ -282,6 +538,8 @@ const char* model_frag_shdr_src =
     in vec3 Normal;
     // `TexCoord` is the texture coordinate of the fragment (not used in this shader).
     in vec2 TexCoord;
+    // `Occlusion` is the baked ambient occlusion of the fragment.
+    in float Occlusion;
 
     // Uniforms for lighting and material properties.
     // `lightPos` is the position of the light source in world space.
@@ -327,12 +585,464 @@ const char* model_frag_shdr_src =
         vec3 specularColor = specular * metalness; // Adjust specular color based on metalness.
 
         // Combine ambient, diffuse, and specular components to get the final color.
-        vec3 result = ambientColor + diffuseColor + specularColor;
+        // Baked occlusion darkens the ambient and diffuse terms, highlights stay untouched.
+        vec3 result = (ambientColor + diffuseColor) * Occlusion + specularColor;
         // Set the output fragment color with full opacity.
         FragColor = vec4(result, 1.0);
     }
 );
 
+// Shaders for depth-only passes over the model, reading nothing but the packed positions
+const char* depth_vrtx_shdr_src =
+    GLH_SHADER_HEADER
+    GLH_STRINGIFY(
+
+    // `aPos` is the only attribute of the position-only vertex stream.
+    layout(location = 0) in vec3 aPos;
+
+    // Same transforms as the model vertex shader.
+    uniform mat4 model;
+    uniform mat4 view;
+    uniform mat4 projection;
+
+    // Must match `model_vrtx_shdr_src` exactly for depth equality tests.
+    invariant gl_Position;
+
+    void main()
+    {
+        // Same expression as the model vertex shader, including the 0.4 `w` zoom.
+        vec3 FragPos = vec3(model * vec4(aPos, 1.0));
+        gl_Position = projection * view * vec4(FragPos, 0.4);
+    }
+);
+
+const char* depth_frag_shdr_src =
+    GLH_SHADER_HEADER
+    GLH_STRINGIFY(
+
+    // Depth is written by the fixed function stages, there is no color to compute.
+    void main()
+    {
+    }
+);
+
+// Shaders for the point splat mode, every point drawn as a round splat sized from its radius
+const char* points_vrtx_shdr_src =
+    GLH_SHADER_HEADER
+    GLH_STRINGIFY(
+
+    // Point attributes: position, normal (zero for scans without normals) and splat radius.
+    layout(location = 0) in vec3 aPos;
+    layout(location = 1) in vec3 aNormal;
+    layout(location = 2) in float aRadius;
+
+    // Position and normal in world space for the lighting.
+    out vec3 FragPos;
+    out vec3 Normal;
+
+    // Same transforms as the model vertex shader.
+    uniform mat4 model;
+    uniform mat4 view;
+    uniform mat4 projection;
+    // Height of the render target in pixels, sizes the splats.
+    uniform float viewportHeight;
+
+    void main()
+    {
+        FragPos = vec3(model * vec4(aPos, 1.0));
+        Normal = mat3(model) * aNormal;
+        gl_Position = projection * view * vec4(FragPos, 0.4); // zoom
+
+        // Projected diameter in pixels, the 0.4 zoom cancels out in the division by `w`.
+        gl_PointSize = max(1.0, aRadius * projection[1][1] * viewportHeight / gl_Position.w);
+    }
+);
+
+const char* points_frag_shdr_src =
+    GLH_SHADER_HEADER
+    GLH_STRINGIFY(
+
+    out vec4 FragColor;
+    in vec3 FragPos;
+    in vec3 Normal;
+
+    // Light and material shared with the model pass.
+    uniform vec3 lightPos;
+    uniform vec3 lightColor;
+    uniform vec3 objectColor;
+
+    void main()
+    {
+        // Round splats: drop the corners of the point sprite.
+        vec2 offset = gl_PointCoord * 2.0 - 1.0;
+        if (dot(offset, offset) > 1.0) {
+            discard;
+        }
+
+        // Two-sided diffuse, scan normals are not always oriented. Points without normals stay flat.
+        vec3 light = 0.5 * lightColor;
+        if (dot(Normal, Normal) > 0.0) {
+            float diff = abs(dot(normalize(Normal), normalize(lightPos - FragPos)));
+            light = (0.1 + diff) * lightColor;
+        }
+        FragColor = vec4(objectColor * light, 1.0);
+    }
+);
+
+// Fragment shader of the imposter bake, run after `model_vrtx_shdr_src` once per atlas frame
+const char* imposter_bake_frag_shdr_src =
+    GLH_SHADER_HEADER
+    GLH_STRINGIFY(
+
+    // Albedo with the baked occlusion, alpha marking coverage
+    layout(location = 0) out vec4 Color;
+    // Model space normal in rgb, orthographic depth of the frame in alpha
+    layout(location = 1) out vec4 NormalDepth;
+
+    in vec3 FragPos;
+    in vec3 Normal;
+    in float Occlusion;
+
+    // Material shared with the model pass.
+    uniform vec3 objectColor;
+    uniform float metalness;
+
+    void main()
+    {
+        // Lighting is left to the runtime, which relights with the stored normal.
+        Color = vec4(objectColor * (1.0 - metalness) * Occlusion, 1.0);
+        NormalDepth = vec4(normalize(Normal) * 0.5 + 0.5, gl_FragCoord.z);
+    }
+);
+
+// Shaders of the imposter billboards. The octahedral mapping and frame basis repeat
+// imposter_encode_direction, imposter_decode_direction and imposter_frame_basis of imposter.h.
+const char* imposter_vrtx_shdr_src =
+    GLH_SHADER_HEADER
+    GLH_STRINGIFY(
+
+    // Quad corner in [-1, 1]^2 and the per instance translation.
+    layout(location = 0) in vec2 aCorner;
+    layout(location = 1) in vec3 aOffset;
+
+    // Offset of the quad point from the sphere center in model space, sampled per frame.
+    out vec3 Offset;
+    // World space point on the quad and direction to the eye, for depth and lighting.
+    out vec3 QuadPos;
+    out vec3 ToEye;
+    // The three atlas frames around the view direction and their weights.
+    out vec4 Frames01;
+    out vec2 Frame2;
+    out vec3 Weights;
+
+    uniform mat4 model;
+    uniform mat4 view;
+    uniform mat4 projection;
+    // Camera position in the same world space as `FragPos` of the model shaders.
+    uniform vec3 eyePos;
+    uniform vec3 imposterCenter;
+    uniform float imposterRadius;
+    uniform float imposterGrid;
+
+    vec2 signNotZero(vec2 v)
+    {
+        return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    }
+
+    vec2 encodeDirection(vec3 d)
+    {
+        vec2 p = d.xy / (abs(d.x) + abs(d.y) + abs(d.z));
+        if (d.z < 0.0) {
+            p = (1.0 - abs(p.yx)) * signNotZero(p);
+        }
+        return p;
+    }
+
+    void main()
+    {
+        // Camera facing quad around the instance's bounding sphere
+        mat3 rotation = mat3(model);
+        vec3 center = aOffset + rotation * imposterCenter;
+        ToEye = normalize(eyePos - center);
+        vec3 up = abs(ToEye.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+        vec3 right = normalize(cross(up, ToEye));
+        up = cross(ToEye, right);
+        QuadPos = center + (aCorner.x * right + aCorner.y * up) * imposterRadius;
+        gl_Position = projection * view * vec4(QuadPos, 0.4); // zoom
+
+        // Pick the grid cell half around the model space view direction
+        Offset = transpose(rotation) * (QuadPos - center);
+        vec2 grid = (encodeDirection(transpose(rotation) * ToEye) + 1.0) * 0.5 * (imposterGrid - 1.0);
+        vec2 cell = clamp(floor(grid), vec2(0.0), vec2(imposterGrid - 2.0));
+        vec2 f = grid - cell;
+        Frame2 = cell + vec2(0.0, 1.0);
+        if (f.x + f.y < 1.0) {
+            Frames01 = vec4(cell, cell + vec2(1.0, 0.0));
+            Weights = vec3(1.0 - f.x - f.y, f.x, f.y);
+        } else {
+            Frames01 = vec4(cell + vec2(1.0), cell + vec2(1.0, 0.0));
+            Weights = vec3(f.x + f.y - 1.0, 1.0 - f.y, 1.0 - f.x);
+        }
+    }
+);
+
+const char* imposter_frag_shdr_src =
+    GLH_SHADER_HEADER
+    GLH_STRINGIFY(
+
+    out vec4 FragColor;
+
+    in vec3 Offset;
+    in vec3 QuadPos;
+    in vec3 ToEye;
+    in vec4 Frames01;
+    in vec2 Frame2;
+    in vec3 Weights;
+
+    uniform sampler2D imposterColor;
+    uniform sampler2D imposterNormalDepth;
+    uniform float imposterRadius;
+    uniform float imposterGrid;
+    uniform mat4 model;
+    uniform mat4 view;
+    uniform mat4 projection;
+
+    // Light and material shared with the model pass.
+    uniform vec3 lightPos;
+    uniform vec3 viewPos;
+    uniform vec3 lightColor;
+    uniform float metalness;
+
+    vec2 signNotZero(vec2 v)
+    {
+        return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    }
+
+    vec3 decodeDirection(vec2 p)
+    {
+        vec3 d = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+        if (d.z < 0.0) {
+            d.xy = (1.0 - abs(p.yx)) * signNotZero(p);
+        }
+        return normalize(d);
+    }
+
+    // Atlas coordinates of the quad point in a frame: project it onto the frame's image plane.
+    vec2 frameCoords(vec2 frame)
+    {
+        vec3 d = decodeDirection(frame / (imposterGrid - 1.0) * 2.0 - 1.0);
+        vec3 up = abs(d.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+        vec3 right = normalize(cross(up, d));
+        up = cross(d, right);
+        vec2 uv = vec2(dot(Offset, right), dot(Offset, up)) / (2.0 * imposterRadius) + 0.5;
+        return (frame + clamp(uv, 0.0, 1.0)) / imposterGrid;
+    }
+
+    void main()
+    {
+        vec2 uv0 = frameCoords(Frames01.xy);
+        vec2 uv1 = frameCoords(Frames01.zw);
+        vec2 uv2 = frameCoords(Frame2);
+
+        // Coverage weighted blend, background texels carry no color, normal or depth
+        vec4 c0 = texture(imposterColor, uv0) * Weights.x;
+        vec4 c1 = texture(imposterColor, uv1) * Weights.y;
+        vec4 c2 = texture(imposterColor, uv2) * Weights.z;
+        float coverage = c0.a + c1.a + c2.a;
+        if (coverage < 0.5) {
+            discard;
+        }
+        vec3 albedo = (c0.rgb + c1.rgb + c2.rgb) / coverage;
+        vec4 nd = (texture(imposterNormalDepth, uv0) * Weights.x +
+                   texture(imposterNormalDepth, uv1) * Weights.y +
+                   texture(imposterNormalDepth, uv2) * Weights.z) / coverage;
+
+        // Depth 0 is the near side of the bounding sphere: move the quad point onto the surface
+        vec3 position = QuadPos + ToEye * imposterRadius * (1.0 - 2.0 * nd.a);
+        vec4 clip = projection * view * vec4(position, 0.4);
+        gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+
+        // Same lighting as the model fragment shader, with the baked albedo and occlusion
+        vec3 norm = normalize(mat3(model) * (nd.rgb * 2.0 - 1.0));
+        vec3 viewDir = normalize(viewPos - position);
+        vec3 lightDir = normalize(lightPos - position);
+        vec3 halfDir = normalize(viewDir + lightDir);
+        vec3 ambient = 0.1 * lightColor;
+        vec3 diffuse = max(dot(norm, lightDir), 0.0) * lightColor;
+        vec3 specular = pow(max(dot(norm, halfDir), 0.5), 64.0) * lightColor;
+        FragColor = vec4((ambient + diffuse) * albedo + specular * metalness, 1.0);
+    }
+);
+
+// Shaders for tessellated model, run after `model_vrtx_shdr_src` and before `model_frag_shdr_src`
+const char* model_tesc_shdr_src =
+    GLH_SHADER_HEADER
+    GLH_STRINGIFY(
+
+    // One patch per mesh triangle.
+    layout(vertices = 3) out;
+
+    // Inputs from the vertex shader, in world space.
+    in vec3 FragPos[];
+    in vec3 Normal[];
+    in float Occlusion[];
+
+    // Patch corners passed to the evaluation shader.
+    out vec3 tcPos[];
+    out vec3 tcNormal[];
+    out float tcOcclusion[];
+
+    // PN-triangle control points, computed once per patch.
+    // `pnEdge` holds b210, b120, b021, b012, b102, b201 and `pnNormal` holds n110, n011, n101.
+    patch out vec3 pnEdge[6];
+    patch out vec3 pnCenter;
+    patch out vec3 pnNormal[3];
+
+    // Uniforms used to measure edges on screen.
+    uniform mat4 view;
+    uniform mat4 projection;
+    // `viewport` is the framebuffer size in pixels.
+    uniform vec2 viewport;
+    // `targetEdgePixels` is the length in pixels each generated edge should have.
+    uniform float targetEdgePixels;
+    // `pnTriangles` selects PN triangles (1) or Phong tessellation (0).
+    uniform int pnTriangles;
+
+    // Project a world space position to pixels, using the same zoom as the model vertex shader.
+    vec2 to_screen(vec3 p)
+    {
+        vec4 clip = projection * view * vec4(p, 0.4);
+        return (clip.xy / max(clip.w, 0.0001) * 0.5 + 0.5) * viewport;
+    }
+
+    // Split an edge so that its pieces are about `targetEdgePixels` long on screen.
+    float edge_level(vec2 a, vec2 b)
+    {
+        return clamp(distance(a, b) / targetEdgePixels, 1.0, 64.0);
+    }
+
+    // PN-triangle edge control point near `pi`, on the tangent plane of `pi`.
+    vec3 pn_edge_point(vec3 pi, vec3 pj, vec3 ni)
+    {
+        return (2.0 * pi + pj - dot(pj - pi, ni) * ni) / 3.0;
+    }
+
+    // PN-triangle quadratic normal for the middle of edge `pi`-`pj`.
+    vec3 pn_edge_normal(vec3 pi, vec3 pj, vec3 ni, vec3 nj)
+    {
+        vec3 edge = pj - pi;
+        float v = 2.0 * dot(edge, ni + nj) / dot(edge, edge);
+        return normalize(ni + nj - v * edge);
+    }
+
+    void main()
+    {
+        tcPos[gl_InvocationID] = FragPos[gl_InvocationID];
+        tcNormal[gl_InvocationID] = normalize(Normal[gl_InvocationID]);
+        tcOcclusion[gl_InvocationID] = Occlusion[gl_InvocationID];
+
+        if (gl_InvocationID == 0) {
+            vec3 p0 = FragPos[0];
+            vec3 p1 = FragPos[1];
+            vec3 p2 = FragPos[2];
+            vec3 n0 = normalize(Normal[0]);
+            vec3 n1 = normalize(Normal[1]);
+            vec3 n2 = normalize(Normal[2]);
+
+            // Outer level `i` belongs to the edge opposite corner `i`.
+            vec2 s0 = to_screen(p0);
+            vec2 s1 = to_screen(p1);
+            vec2 s2 = to_screen(p2);
+            gl_TessLevelOuter[0] = edge_level(s1, s2);
+            gl_TessLevelOuter[1] = edge_level(s2, s0);
+            gl_TessLevelOuter[2] = edge_level(s0, s1);
+            gl_TessLevelInner[0] = max(max(gl_TessLevelOuter[0], gl_TessLevelOuter[1]), gl_TessLevelOuter[2]);
+
+            if (pnTriangles != 0) {
+                pnEdge[0] = pn_edge_point(p0, p1, n0);
+                pnEdge[1] = pn_edge_point(p1, p0, n1);
+                pnEdge[2] = pn_edge_point(p1, p2, n1);
+                pnEdge[3] = pn_edge_point(p2, p1, n2);
+                pnEdge[4] = pn_edge_point(p2, p0, n2);
+                pnEdge[5] = pn_edge_point(p0, p2, n0);
+
+                // The center point is pushed out by half the distance between the edge points and the corners.
+                vec3 e = (pnEdge[0] + pnEdge[1] + pnEdge[2] + pnEdge[3] + pnEdge[4] + pnEdge[5]) / 6.0;
+                vec3 v = (p0 + p1 + p2) / 3.0;
+                pnCenter = e + (e - v) * 0.5;
+
+                pnNormal[0] = pn_edge_normal(p0, p1, n0, n1);
+                pnNormal[1] = pn_edge_normal(p1, p2, n1, n2);
+                pnNormal[2] = pn_edge_normal(p2, p0, n2, n0);
+            }
+        }
+    }
+);
+
+const char* model_tese_shdr_src =
+    GLH_SHADER_HEADER
+    GLH_STRINGIFY(
+
+    // Triangle domain, fractional spacing avoids popping while the factors change.
+    layout(triangles, fractional_odd_spacing, ccw) in;
+
+    // Patch corners and PN-triangle control points from the control shader.
+    in vec3 tcPos[];
+    in vec3 tcNormal[];
+    in float tcOcclusion[];
+    patch in vec3 pnEdge[6];
+    patch in vec3 pnCenter;
+    patch in vec3 pnNormal[3];
+
+    // Outputs to the fragment shader, same as the model vertex shader.
+    out vec3 FragPos;
+    out vec3 Normal;
+    out float Occlusion;
+
+    uniform mat4 view;
+    uniform mat4 projection;
+    uniform int pnTriangles;
+    // `phongAlpha` blends between flat (0.0) and fully curved (1.0) Phong tessellation.
+    uniform float phongAlpha;
+
+    // Project `q` onto the tangent plane of corner `i`.
+    vec3 project_to_plane(vec3 q, int i)
+    {
+        return q - dot(q - tcPos[i], tcNormal[i]) * tcNormal[i];
+    }
+
+    void main()
+    {
+        // Barycentric weights of corners 0, 1 and 2.
+        float u = gl_TessCoord.x;
+        float v = gl_TessCoord.y;
+        float w = gl_TessCoord.z;
+
+        if (pnTriangles != 0) {
+            // Cubic Bezier triangle for the position, quadratic for the normal.
+            FragPos = tcPos[0] * u * u * u + tcPos[1] * v * v * v + tcPos[2] * w * w * w
+                    + pnEdge[0] * 3.0 * u * u * v + pnEdge[1] * 3.0 * u * v * v
+                    + pnEdge[2] * 3.0 * v * v * w + pnEdge[3] * 3.0 * v * w * w
+                    + pnEdge[4] * 3.0 * u * w * w + pnEdge[5] * 3.0 * u * u * w
+                    + pnCenter * 6.0 * u * v * w;
+            Normal = tcNormal[0] * u * u + tcNormal[1] * v * v + tcNormal[2] * w * w
+                   + pnNormal[0] * u * v + pnNormal[1] * v * w + pnNormal[2] * u * w;
+        } else {
+            // Phong tessellation: average the projections of the flat point onto the corner tangent planes.
+            vec3 flatPos = u * tcPos[0] + v * tcPos[1] + w * tcPos[2];
+            vec3 phongPos = u * project_to_plane(flatPos, 0) + v * project_to_plane(flatPos, 1) + w * project_to_plane(flatPos, 2);
+            FragPos = mix(flatPos, phongPos, phongAlpha);
+            Normal = u * tcNormal[0] + v * tcNormal[1] + w * tcNormal[2];
+        }
+
+        // Occlusion is interpolated linearly in both modes.
+        Occlusion = u * tcOcclusion[0] + v * tcOcclusion[1] + w * tcOcclusion[2];
+
+        // Same clip space transform and zoom as the model vertex shader.
+        gl_Position = projection * view * vec4(FragPos, 0.4);
+    }
+);
+
 // Implementation of data loading, out of the way
 int32_t load_mesh_data(const char* filename, MeshData* out_data);
 
@@ -385,21 +1095,42 @@ void init_cube(SceneData* scene){
     scene->basic_program = glh_link_program(vrtx_shdr, 0, frag_shdr);
 }
 
+// Configure the model vertex attributes of the currently bound VAO and VBO from the mesh layout
+void init_model_attributes(const MeshData* mesh_data) {
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, mesh_data->vertex_size, (void*)(intptr_t)mesh_data->positions_offset);  
+    // Position attribute: location = 0, 3 components (x, y, z), float type, no normalization,
+    // stride = `mesh_data->vertex_size`, offset = `mesh_data->positions_offset`
+    glEnableVertexAttribArray(0);  // Enable the position attribute
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, mesh_data->vertex_size, (void*)(intptr_t)mesh_data->normals_offset);  
+    // Normal attribute: location = 1, 3 components (x, y, z), float type, no normalization,
+    // stride = `mesh_data->vertex_size`, offset = `mesh_data->normals_offset`
+    glEnableVertexAttribArray(1);  // Enable the normal attribute
+
+    if (mesh_data->ao_size) {
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, mesh_data->vertex_size, (void*)(intptr_t)mesh_data->ao_offset);
+        // Ambient occlusion attribute: location = 2, 1 component, float type, no normalization,
+        // stride = `mesh_data->vertex_size`, offset = `mesh_data->ao_offset`
+        glEnableVertexAttribArray(2);  // Enable the ambient occlusion attribute
+    }
+}
+
 // Initialize model function - called once, sets up data for rendering
 void init_model(SceneData* scene, MeshData* mesh_data) {
     // Initialize VAO (Vertex Array Object), VBO (Vertex Buffer Object), and EBO (Element Buffer Object)
     glGenVertexArrays(1, &scene->model_vao);  // Generate a new VAO and store its ID in `scene->model_vao`
-    GLuint vbo, ebo;
-    glGenBuffers(1, &vbo);  // Generate a new VBO and store its ID in `vbo`
+    GLuint ebo;
+    glGenBuffers(1, &scene->model_vbo);  // Generate a new VBO and store its ID in `scene->model_vbo`
     glGenBuffers(1, &ebo);  // Generate a new EBO and store its ID in `ebo`
 
     glBindVertexArray(scene->model_vao);  // Bind the VAO to configure its vertex attributes
 
     // Bind and configure the VBO
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);  // Bind the VBO to `GL_ARRAY_BUFFER`
-    glBufferData(GL_ARRAY_BUFFER, mesh_data->vertex_count * mesh_data->vertex_size, mesh_data->vertex_data, GL_STATIC_DRAW);  
+    glBindBuffer(GL_ARRAY_BUFFER, scene->model_vbo);  // Bind the VBO to `GL_ARRAY_BUFFER`
+    glBufferData(GL_ARRAY_BUFFER, mesh_data->vertex_count * mesh_data->vertex_size, mesh_data->vertex_data, GL_DYNAMIC_DRAW);  
     // Upload vertex data to the VBO. `mesh_data->vertex_count` is the number of vertices,
     // `mesh_data->vertex_size` is the size of each vertex in bytes, and `mesh_data->vertex_data` is the data pointer.
+    // Sculpting rewrites small ranges of it, hence the dynamic usage hint.
 
     // Bind and configure the EBO
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);  // Bind the EBO to `GL_ELEMENT_ARRAY_BUFFER`
@@ -408,15 +1139,42 @@ void init_model(SceneData* scene, MeshData* mesh_data) {
     // `sizeof(uint32_t)` is the size of each index, and `mesh_data->triangles` is the data pointer.
 
     // Set up vertex attributes
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, mesh_data->vertex_size, (void*)mesh_data->positions_offset);  
-    // Position attribute: location = 0, 3 components (x, y, z), float type, no normalization,
-    // stride = `mesh_data->vertex_size`, offset = `mesh_data->positions_offset`
-    glEnableVertexAttribArray(0);  // Enable the position attribute
+    init_model_attributes(mesh_data);
+
+    // Meshes without baked ambient occlusion read this constant instead
+    glVertexAttrib1f(2, 1.0f);
+
+    // Position-only stream for depth-only passes: its own VAO over a packed copy of the
+    // positions, reusing the model's index buffer
+    float* positions = (float*)malloc(mesh_data->vertex_count * 3 * sizeof(float));
+    if (positions) {
+        mesh_pack_positions(mesh_data, 0, mesh_data->vertex_count, positions);
+        glGenVertexArrays(1, &scene->depth_vao);
+        glGenBuffers(1, &scene->depth_vbo);
+        glBindVertexArray(scene->depth_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, scene->depth_vbo);
+        glBufferData(GL_ARRAY_BUFFER, mesh_data->vertex_count * 3 * sizeof(float), positions, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        free(positions);
+    }
 
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, mesh_data->vertex_size, (void*)mesh_data->normals_offset);  
-    // Normal attribute: location = 1, 3 components (x, y, z), float type, no normalization,
-    // stride = `mesh_data->vertex_size`, offset = `mesh_data->normals_offset`
-    glEnableVertexAttribArray(1);  // Enable the normal attribute
+    // Streamed positions and normals of the animated model, DEFORM_REGION_COUNT frames worth.
+    // Ambient occlusion does not animate and still comes from the model's buffer.
+    glGenVertexArrays(1, &scene->deform_vao);
+    glGenBuffers(1, &scene->deform_vbo);
+    glBindVertexArray(scene->deform_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, scene->deform_vbo);
+    glBufferData(GL_ARRAY_BUFFER, DEFORM_REGION_COUNT * mesh_data->vertex_count * 6 * sizeof(float), NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glEnableVertexAttribArray(0);  // Pointed at the current region by deform_model
+    glEnableVertexAttribArray(1);
+    if (mesh_data->ao_size) {
+        glBindBuffer(GL_ARRAY_BUFFER, scene->model_vbo);
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, mesh_data->vertex_size, (void*)(intptr_t)mesh_data->ao_offset);
+        glEnableVertexAttribArray(2);
+    }
 
     // Unbind the buffers
     // Unbind the VBO (optional)
@@ -431,9 +1189,288 @@ void init_model(SceneData* scene, MeshData* mesh_data) {
     GLuint frag_shdr = glh_compile_shader_src(GL_FRAGMENT_SHADER, model_frag_shdr_src);  
     // Link shaders into a program and store its ID in `scene->model_program`
     scene->model_program = glh_link_program(vrtx_shdr, 0, frag_shdr);
+
+    // Depth-only program for the position-only stream
+    GLuint depth_vrtx_shdr = glh_compile_shader_src(GL_VERTEX_SHADER, depth_vrtx_shdr_src);
+    GLuint depth_frag_shdr = glh_compile_shader_src(GL_FRAGMENT_SHADER, depth_frag_shdr_src);
+    scene->depth_program = glh_link_program(depth_vrtx_shdr, 0, depth_frag_shdr);
+}
+
+// Initialize tessellation function - called once, builds the model program with tessellation stages
+void init_tessellation(SceneData* scene) {
+    // The tessellation stages sit between the unchanged model vertex and fragment shaders
+    GLuint vrtx_shdr = glh_compile_shader_src(GL_VERTEX_SHADER, model_vrtx_shdr_src);
+    GLuint tesc_shdr = glh_compile_shader_src(GL_TESS_CONTROL_SHADER, model_tesc_shdr_src);
+    GLuint tese_shdr = glh_compile_shader_src(GL_TESS_EVALUATION_SHADER, model_tese_shdr_src);
+    GLuint frag_shdr = glh_compile_shader_src(GL_FRAGMENT_SHADER, model_frag_shdr_src);
+    scene->tess_program = glh_link_program_tess(vrtx_shdr, tesc_shdr, tese_shdr, 0, frag_shdr);
+
+    // Every mesh triangle is drawn as one patch
+    glPatchParameteri(GL_PATCH_VERTICES, 3);
+}
+
+// Initialize signed distance field function - called once, uploads the baked grid as a 3D texture
+void init_sdf(SceneData* scene, const SdfGrid* grid) {
+    glGenTextures(1, &scene->sdf_texture);
+    glBindTexture(GL_TEXTURE_3D, scene->sdf_texture);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_R32F, grid->resolution[0], grid->resolution[1], grid->resolution[2],
+                 0, GL_RED, GL_FLOAT, grid->distances);
+
+    // Trilinear filtering interpolates the distances between voxel centers
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_3D, 0);
+
+    scene->sdf_min = grid->min;
+    scene->sdf_size = vec3(grid->resolution[0] * grid->voxel_size,
+                           grid->resolution[1] * grid->voxel_size,
+                           grid->resolution[2] * grid->voxel_size);
+
+    // The cube keeps its vertex shader, only the fragment shader marches the field
+    GLuint vrtx_shdr = glh_compile_shader_src(GL_VERTEX_SHADER, cube_vrtx_shdr_src);
+    GLuint frag_shdr = glh_compile_shader_src(GL_FRAGMENT_SHADER, sdf_frag_shdr_src);
+    scene->sdf_program = glh_link_program(vrtx_shdr, 0, frag_shdr);
+}
+
+// Initialize point splats function - called once, uploads every level of the point hierarchy
+void init_points(SceneData* scene, const PointLod* lod) {
+    glGenVertexArrays(1, &scene->points_vao);
+    glGenBuffers(1, &scene->points_vbo);
+    glBindVertexArray(scene->points_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, scene->points_vbo);
+    glBufferData(GL_ARRAY_BUFFER, lod->point_count * POINT_LOD_STRIDE * sizeof(float), lod->points, GL_STATIC_DRAW);
+
+    // Position, normal and radius, tightly packed
+    GLsizei stride = POINT_LOD_STRIDE * sizeof(float);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    // One draw range per chunk, refilled every frame
+    scene->point_lod = lod;
+    scene->point_firsts = (int32_t*)malloc(lod->chunk_count * sizeof(int32_t));
+    scene->point_counts = (int32_t*)malloc(lod->chunk_count * sizeof(int32_t));
+
+    // The vertex shader sizes the splats
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    GLuint vrtx_shdr = glh_compile_shader_src(GL_VERTEX_SHADER, points_vrtx_shdr_src);
+    GLuint frag_shdr = glh_compile_shader_src(GL_FRAGMENT_SHADER, points_frag_shdr_src);
+    scene->points_program = glh_link_program(vrtx_shdr, 0, frag_shdr);
+}
+
+// Orientations of the model (0.5 rad/s about X) and of the cube (0.15 rad/s about the XY diagonal)
+// at `time` seconds. Everything that rebuilds their transforms - rendering, picking, refinement,
+// the ray marcher - starts from these, so the matrices agree bit for bit.
+quat_t model_orientation(float time) {
+    return quat_from_axis_angle(vec3(1.0f, 0.0f, 0.0f), time * 0.5f);
+}
+
+quat_t cube_orientation(float time) {
+    return quat_from_axis_angle(vec3(0.7071068f, 0.7071068f, 0.0f), time * 0.15f);
+}
+
+// Refine the model for the current close-up view and upload it - called whenever subdivision is switched on
+void refine_model(SceneData* scene, LoopSubdivider* subdiv, MeshData* mesh, MeshTopology* topology) {
+    // Rebuild the transform used by render_model, including the 0.4 `w` zoom applied in the vertex shader
+    mat4_t model = quat_to_mat4(model_orientation((float)glfwGetTime()));
+    mat4_t zoom = mat4_identity();
+    zoom.data[15] = 0.4f;
+    mat4_t view = look_at(vec3(0.0f, 0.0f, 3.0f), vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f));
+    mat4_t projection = perspective(deg2rad(45.0f), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.1f, 100.0f);
+
+    // Refine triangles longer than 6 pixels on screen or bending more than 20 degrees, down to 2 pixels
+    LoopSubdivParams params = {0};
+    params.mvp = mat4_mul(projection, mat4_mul(view, mat4_mul(zoom, model)));
+    params.viewport = vec2((float)WINDOW_WIDTH, (float)WINDOW_HEIGHT);
+    params.max_edge_pixels = 6.0f;
+    params.max_normal_angle = deg2rad(20.0f);
+    params.min_edge_pixels = 2.0f;
+    params.max_levels = SUBDIV_MAX_LEVELS;
+    int32_t levels = loop_subdiv_refine(subdiv, mesh, topology, &params);
+    const MeshData* refined = subdiv->result;
+    printf("Subdivision: %d levels, %d -> %d triangles%s\n", levels, mesh->triangle_count, refined->triangle_count,
+           subdiv->capacity_reached ? " (buffers full)" : "");
+
+    // Create the buffers on first use, later refinements reuse them
+    if (!scene->subdiv_vao) {
+        glGenVertexArrays(1, &scene->subdiv_vao);
+        glGenBuffers(1, &scene->subdiv_vbo);
+        glGenBuffers(1, &scene->subdiv_ebo);
+        glBindVertexArray(scene->subdiv_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, scene->subdiv_vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene->subdiv_ebo);
+        init_model_attributes(refined);
+        glBindVertexArray(0);
+    }
+
+    // Upload the refined vertices and triangles
+    glBindBuffer(GL_ARRAY_BUFFER, scene->subdiv_vbo);
+    glBufferData(GL_ARRAY_BUFFER, refined->vertex_count * refined->vertex_size, refined->vertex_data, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(scene->subdiv_vao);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, refined->triangle_count * 3 * sizeof(uint32_t), refined->triangles, GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    scene->subdiv_triangle_count = refined->triangle_count;
+}
+
+// Keyboard handler - toggles the optional render paths
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    SceneData* scene = (SceneData*)glfwGetWindowUserPointer(window);
+    if (action != GLFW_PRESS) {
+        return;
+    }
+    if (key == GLFW_KEY_S) {
+        // Subdivide for the current view every time it is switched on
+        scene->subdivision_enabled = !scene->subdivision_enabled;
+        scene->subdivision_dirty = scene->subdivision_enabled;
+    }
+    if (key == GLFW_KEY_T) {
+        // Cycle off -> Phong -> PN triangles
+        const char* names[TESSELLATION_MODE_COUNT] = { "off", "Phong", "PN triangles" };
+        scene->tessellation_mode = (TessellationMode)((scene->tessellation_mode + 1) % TESSELLATION_MODE_COUNT);
+        printf("Tessellation: %s\n", names[scene->tessellation_mode]);
+    }
+    if (key == GLFW_KEY_D && scene->sdf_texture) {
+        // Ray march the distance field on the cube instead of rendering the model offscreen
+        scene->sdf_enabled = !scene->sdf_enabled;
+        printf("SDF ray marching: %s\n", scene->sdf_enabled ? "on" : "off");
+    }
+    if (key == GLFW_KEY_P && scene->depth_vao) {
+        // Lay down depth with the position-only stream first, then shade each visible pixel once
+        scene->depth_prepass = !scene->depth_prepass;
+        printf("Depth prepass: %s\n", scene->depth_prepass ? "on" : "off");
+    }
+    if (key == GLFW_KEY_O && scene->point_lod) {
+        // Preview the vertices as point splats instead of rasterizing the triangles
+        scene->points_enabled = !scene->points_enabled;
+        printf("Point splats: %s\n", scene->points_enabled ? "on" : "off");
+    }
+    if (key == GLFW_KEY_I && scene->imposter_program) {
+        // Draw a crowd of instances, the distant ones as imposters
+        scene->crowd_enabled = !scene->crowd_enabled;
+        printf("Imposter crowd: %s\n", scene->crowd_enabled ? "on" : "off");
+    }
+    if (key == GLFW_KEY_A && scene->deformer) {
+        // Animate the vertices on the CPU and stream them to the GPU every frame
+        scene->deform_enabled = !scene->deform_enabled;
+        printf("Vertex animation: %s\n", scene->deform_enabled ? "on" : "off");
+    }
+    if (key == GLFW_KEY_B) {
+        // Sculpt the model under the cursor while the left mouse button is held
+        scene->sculpt_enabled = !scene->sculpt_enabled;
+        printf("Sculpting: %s\n", scene->sculpt_enabled ? "on" : "off");
+    }
+}
+
+// Ray through normalized device coordinates `ndc`, from the near to the far plane of `inverse_mvp`
+void unproject_ray(mat4_t inverse_mvp, vec2_t ndc, vec3_t* out_origin, vec3_t* out_direction, float* out_length) {
+    vec4_t near_point = mat4_vec4_mul(inverse_mvp, vec4(ndc.x, ndc.y, -1.0f, 1.0f));
+    vec4_t far_point = mat4_vec4_mul(inverse_mvp, vec4(ndc.x, ndc.y, 1.0f, 1.0f));
+    vec3_t origin = vec3_scalar_div(vec3(near_point.x, near_point.y, near_point.z), near_point.w);
+    vec3_t segment = vec3_sub(vec3_scalar_div(vec3(far_point.x, far_point.y, far_point.z), far_point.w), origin);
+    *out_origin = origin;
+    *out_length = vec3_norm(segment);
+    *out_direction = vec3_scalar_div(segment, *out_length);
+}
+
+// Find the model triangle under the cursor: the cursor ray hits the cube, the cube texture
+// coordinates locate the texel of the offscreen model pass, and the ray of that texel hits the model
+int32_t pick_model(GLFWwindow* window, const Bvh* cube_bvh, const Bvh* model_bvh, vec3_t* out_point, uint32_t* out_triangle) {
+    double cursor_x, cursor_y;
+    int32_t width, height;
+    glfwGetCursorPos(window, &cursor_x, &cursor_y);
+    glfwGetWindowSize(window, &width, &height);
+    vec2_t ndc = vec2(2.0f * (float)cursor_x / (float)width - 1.0f, 1.0f - 2.0f * (float)cursor_y / (float)height);
+
+    // Same camera and cube rotation as frame()
+    float time = (float)glfwGetTime();
+    mat4_t view = look_at(vec3(0.0f, 0.0f, 3.0f), vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f));
+    mat4_t projection = perspective(deg2rad(45.0f), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.1f, 100.0f);
+    mat4_t cube_model = quat_to_mat4(cube_orientation(time));
+    vec3_t origin, direction;
+    float length;
+    unproject_ray(mat4_inverse(mat4_mul(projection, mat4_mul(view, cube_model))), ndc, &origin, &direction, &length);
+    BvhHit hit;
+    if (!bvh_intersect(cube_bvh, origin, direction, length, &hit)) {
+        return 0;
+    }
+
+    // Interpolate the texture coordinates of the cube face, they span the whole offscreen image
+    const float* corners[3];
+    for (int32_t c = 0; c < 3; ++c) {
+        corners[c] = &cube_vertices[(3 * hit.triangle + c) * 8 + 6];
+    }
+    float w = 1.0f - hit.u - hit.v;
+    vec2_t uv = vec2(w * corners[0][0] + hit.u * corners[1][0] + hit.v * corners[2][0],
+                     w * corners[0][1] + hit.u * corners[1][1] + hit.v * corners[2][1]);
+
+    // Same model transform as render_model, including the 0.4 `w` zoom
+    mat4_t model = quat_to_mat4(model_orientation(time));
+    mat4_t zoom = mat4_identity();
+    zoom.data[15] = 0.4f;
+    mat4_t inverse_mvp = mat4_inverse(mat4_mul(projection, mat4_mul(view, mat4_mul(zoom, model))));
+    unproject_ray(inverse_mvp, vec2(2.0f * uv.x - 1.0f, 2.0f * uv.y - 1.0f), &origin, &direction, &length);
+    if (!bvh_intersect(model_bvh, origin, direction, length, &hit)) {
+        return 0;
+    }
+    *out_point = vec3_add(origin, vec3_scalar_mul(direction, hit.t));
+    *out_triangle = hit.triangle;
+    return 1;
+}
+
+// Apply one brush dab under the cursor and push only the vertex ranges it changed to the GPU
+void sculpt_model(SceneData* scene, GLFWwindow* window, Sculptor* sculptor, MeshData* mesh, const MeshTopology* topology,
+                  Bvh* bvh, const Bvh* cube_bvh) {
+    vec3_t point;
+    uint32_t triangle;
+    if (!pick_model(window, cube_bvh, bvh, &point, &triangle)) {
+        return;
+    }
+
+    // Brush size follows the model size, Shift carves instead of building up
+    float scale = mesh->has_bounds ? mesh->sphere_radius : 1.0f;
+    SculptBrush brush = {0};
+    brush.radius = 0.08f * scale;
+    brush.strength = 0.004f * scale;
+    if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) {
+        brush.strength = -brush.strength;
+    }
+    if (!sculpt_dab(sculptor, mesh, topology, bvh, point, triangle, &brush)) {
+        return;
+    }
+
+    // Vertices are uploaded whole, positions and normals both changed
+    glBindBuffer(GL_ARRAY_BUFFER, scene->model_vbo);
+    for (int32_t r = 0; r < sculptor->range_count; ++r) {
+        GLintptr offset = (GLintptr)sculptor->ranges[r][0] * mesh->vertex_size;
+        GLsizeiptr size = (GLsizeiptr)(sculptor->ranges[r][1] - sculptor->ranges[r][0]) * mesh->vertex_size;
+        glBufferSubData(GL_ARRAY_BUFFER, offset, size, (const char*)mesh->vertex_data + offset);
+    }
+
+    // The position-only stream gets the same ranges, packed through a small stack buffer
+    if (scene->depth_vbo) {
+        float positions[3 * 1024];
+        glBindBuffer(GL_ARRAY_BUFFER, scene->depth_vbo);
+        for (int32_t r = 0; r < sculptor->range_count; ++r) {
+            for (int32_t first = sculptor->ranges[r][0]; first < sculptor->ranges[r][1]; first += 1024) {
+                int32_t count = sculptor->ranges[r][1] - first < 1024 ? sculptor->ranges[r][1] - first : 1024;
+                mesh_pack_positions(mesh, first, count, positions);
+                glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)first * 3 * sizeof(float), count * 3 * sizeof(float), positions);
+            }
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-void set_texture(SceneData* scene) {
+void set_texture(SceneData* scene, GLuint program) {
     // Define light and material properties
     vec3_t lightPos = vec3(0.0f, 1.0f, 2.0f);  // Position of the light in world space
     vec3_t lightColor = vec3(1.0f, 1.0f, 1.0f);  // Color of the light (white)
@@ -444,12 +1481,12 @@ void set_texture(SceneData* scene) {
 
     // Pass light properties to the fragment shader
     // Get the location of the uniform variables in the fragment shader
-    GLint lightPosLoc = glGetUniformLocation(scene->model_program, "lightPos");
-    GLint lightColorLoc = glGetUniformLocation(scene->model_program, "lightColor");
-    GLint objectColorLoc = glGetUniformLocation(scene->model_program, "objectColor");
-    GLint ambientStrengthLoc = glGetUniformLocation(scene->model_program, "ambientStrength");
-    GLint roughnessLoc = glGetUniformLocation(scene->model_program, "roughness");
-    GLint metalnessLoc = glGetUniformLocation(scene->model_program, "metalness");
+    GLint lightPosLoc = glGetUniformLocation(program, "lightPos");
+    GLint lightColorLoc = glGetUniformLocation(program, "lightColor");
+    GLint objectColorLoc = glGetUniformLocation(program, "objectColor");
+    GLint ambientStrengthLoc = glGetUniformLocation(program, "ambientStrength");
+    GLint roughnessLoc = glGetUniformLocation(program, "roughness");
+    GLint metalnessLoc = glGetUniformLocation(program, "metalness");
 
     // Set the values of the uniform variables
     glUniform3fv(lightPosLoc, 1, (const GLfloat*)&lightPos);  // Pass the light position as a vec3
@@ -521,13 +1558,15 @@ void init_texture(SceneData* scene, MeshData* mesh) {
     glUniformMatrix4fv(model_loc, 1, GL_FALSE, (const GLfloat*)&model);
     glUniformMatrix4fv(view_loc, 1, GL_FALSE, (const GLfloat*)&view);
     glUniformMatrix4fv(proj_loc, 1, GL_FALSE, (const GLfloat*)&projection);
+    mat3_t normal_matrix = mat4_normal_matrix(model);
+    glUniformMatrix3fv(glGetUniformLocation(scene->model_program, "normalMatrix"), 1, GL_FALSE, normal_matrix.data);
 
     // Set the clear color and use the shader program
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glUseProgram(scene->model_program);
 
     // Bind the texture and render the model
-    set_texture(scene);
+    set_texture(scene, scene->model_program);
     glBindVertexArray(scene->model_vao);
     glDrawElements(GL_TRIANGLES, mesh->triangle_count * 3, GL_UNSIGNED_INT, 0);
     glBindVertexArray(0);
@@ -537,6 +1576,121 @@ void init_texture(SceneData* scene, MeshData* mesh) {
 
 }
 
+// Create an atlas texture for the imposter bake
+GLuint init_imposter_texture(GLenum internal_format, GLenum type, int32_t size) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, size, size, 0, GL_RGBA, type, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+// Initialize imposters function - called once, bakes the model from every atlas frame direction
+// and sets up the instanced billboards and the crowd layout
+void init_imposters(SceneData* scene, MeshData* mesh) {
+    ImposterAtlas* atlas = &scene->imposter_atlas;
+    imposter_atlas_init(atlas, mesh, 12, 128);
+    int32_t size = atlas->grid * atlas->frame_size;
+
+    // Two color targets sharing one depth buffer, cleared to zero coverage
+    GLuint framebuffer, depth_buffer;
+    scene->imposter_color = init_imposter_texture(GL_RGBA8, GL_UNSIGNED_BYTE, size);
+    scene->imposter_normal_depth = init_imposter_texture(GL_RGBA16F, GL_FLOAT, size);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, scene->imposter_color, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, scene->imposter_normal_depth, 0);
+    glGenRenderbuffers(1, &depth_buffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_buffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, size, size);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_buffer);
+    GLenum draw_buffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, draw_buffers);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "Imposter framebuffer is not complete!\n");
+    }
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // The model vertex shader applies a 0.4 `w` zoom, a 0.4 model scale cancels it
+    // so the frame cameras work in plain model space
+    GLuint vrtx_shdr = glh_compile_shader_src(GL_VERTEX_SHADER, model_vrtx_shdr_src);
+    GLuint frag_shdr = glh_compile_shader_src(GL_FRAGMENT_SHADER, imposter_bake_frag_shdr_src);
+    GLuint bake_program = glh_link_program(vrtx_shdr, 0, frag_shdr);
+    glUseProgram(bake_program);
+    set_texture(scene, bake_program);
+    mat4_t model = mat4_identity();
+    model.data[0] = model.data[5] = model.data[10] = 0.4f;
+    mat4_t projection = imposter_frame_projection(atlas);
+    glUniformMatrix4fv(glGetUniformLocation(bake_program, "model"), 1, GL_FALSE, (const GLfloat*)&model);
+    glUniformMatrix4fv(glGetUniformLocation(bake_program, "projection"), 1, GL_FALSE, (const GLfloat*)&projection);
+    // The shared vertex shader takes its normals through `normalMatrix`, unset it stays all zero
+    mat3_t normal_matrix = mat4_normal_matrix(model);
+    glUniformMatrix3fv(glGetUniformLocation(bake_program, "normalMatrix"), 1, GL_FALSE, normal_matrix.data);
+
+    // One viewport per frame
+    glBindVertexArray(scene->model_vao);
+    for (int32_t y = 0; y < atlas->grid; ++y) {
+        for (int32_t x = 0; x < atlas->grid; ++x) {
+            mat4_t view = imposter_frame_view(atlas, x, y);
+            glUniformMatrix4fv(glGetUniformLocation(bake_program, "view"), 1, GL_FALSE, (const GLfloat*)&view);
+            glViewport(x * atlas->frame_size, y * atlas->frame_size, atlas->frame_size, atlas->frame_size);
+            glDrawElements(GL_TRIANGLES, mesh->triangle_count * 3, GL_UNSIGNED_INT, 0);
+        }
+    }
+    glBindVertexArray(0);
+    glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &depth_buffer);
+    glDeleteProgram(bake_program);
+
+    // Zero coverage around every frame keeps the mip levels from bleeding color into the billboards
+    glBindTexture(GL_TEXTURE_2D, scene->imposter_color);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, scene->imposter_normal_depth);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Billboards: one quad as a triangle strip, one translation per instance
+    const float corners[8] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+    glGenVertexArrays(1, &scene->imposter_vao);
+    glGenBuffers(1, &scene->imposter_quad_vbo);
+    glGenBuffers(1, &scene->imposter_instance_vbo);
+    glBindVertexArray(scene->imposter_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, scene->imposter_quad_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, scene->imposter_instance_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(scene->crowd_offsets), NULL, GL_STREAM_DRAW);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    vrtx_shdr = glh_compile_shader_src(GL_VERTEX_SHADER, imposter_vrtx_shdr_src);
+    frag_shdr = glh_compile_shader_src(GL_FRAGMENT_SHADER, imposter_frag_shdr_src);
+    scene->imposter_program = glh_link_program(vrtx_shdr, 0, frag_shdr);
+
+    // Crowd rows recede from the camera, the middle of the first row is the usual model position
+    float spacing = 2.5f * atlas->radius;
+    for (int32_t row = 0; row < CROWD_SIDE; ++row) {
+        for (int32_t column = 0; column < CROWD_SIDE; ++column) {
+            float* offset = scene->crowd_offsets[row * CROWD_SIDE + column];
+            offset[0] = (float)(column - CROWD_SIDE / 2) * spacing;
+            offset[1] = 0.0f;
+            offset[2] = -(float)row * spacing;
+        }
+    }
+}
+
 // Frame function - called on every frame, performs the rendering
 void frame(SceneData* scene, MeshData* mesh_data) {
     // Clear the screen and set the background color
@@ -548,35 +1702,248 @@ void frame(SceneData* scene, MeshData* mesh_data) {
     vec3_t center = vec3(0.0f, 0.0f, 0.0f); // Point the camera is looking at
     vec3_t up = vec3(0.0f, 1.0f, 0.0f); // Up direction for the camera
 
-    // Use the shader program for rendering the cube
-    glUseProgram(scene->basic_program);
+    // Use the shader program for rendering the cube, or the one ray marching the distance field
+    GLuint program = scene->sdf_enabled ? scene->sdf_program : scene->basic_program;
+    glUseProgram(program);
 
-    // Create rotation matrices for the cube
-    float angle = (float)glfwGetTime() * 0.15f; // Rotation angle (changes over time)
-    vec3_t axis = vec3(0.7071068f, 0.7071068f, 0.0f); // Rotation axis (normalized)
-    mat4_t model = mat4_make_rotation(axis, angle); // Model matrix for rotation
+    // Rotation matrix of the cube, from its orientation at the current time
+    mat4_t model = quat_to_mat4(cube_orientation((float)glfwGetTime()));
     mat4_t view = look_at(eye, center, up); // View matrix for camera
     mat4_t projection = perspective(deg2rad(45.0f), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.1f, 100.0f); // Projection matrix
 
     // Set uniform variables in the shader program
-    GLuint model_loc = glGetUniformLocation(scene->basic_program, "model");
-    GLuint view_loc = glGetUniformLocation(scene->basic_program, "view");
-    GLuint proj_loc = glGetUniformLocation(scene->basic_program, "projection");
-    GLuint textureLoc = glGetUniformLocation(scene->basic_program, "simple_texture");
+    GLuint model_loc = glGetUniformLocation(program, "model");
+    GLuint view_loc = glGetUniformLocation(program, "view");
+    GLuint proj_loc = glGetUniformLocation(program, "projection");
 
     glUniformMatrix4fv(model_loc, 1, GL_FALSE, (const GLfloat*)&model); // Set the model matrix
     glUniformMatrix4fv(view_loc, 1, GL_FALSE, (const GLfloat*)&view); // Set the view matrix
     glUniformMatrix4fv(proj_loc, 1, GL_FALSE, (const GLfloat*)&projection); // Set the projection matrix
-    glUniform1i(textureLoc, 0); // Set texture unit 0
+    mat3_t normal_matrix = mat4_normal_matrix(model);
+    glUniformMatrix3fv(glGetUniformLocation(program, "normalMatrix"), 1, GL_FALSE, normal_matrix.data); // Set the normal matrix
+
+    if (scene->sdf_enabled) {
+        // Rebuild the model pass transform of render_model, including the 0.4 `w` zoom,
+        // so every cube texel marches the ray it would have rasterized
+        mat4_t mesh_model = quat_to_mat4(model_orientation((float)glfwGetTime()));
+        mat4_t zoom = mat4_identity();
+        zoom.data[15] = 0.4f;
+        mat4_t mesh_inverse_mvp = mat4_inverse(mat4_mul(projection, mat4_mul(view, mat4_mul(zoom, mesh_model))));
+
+        glUniformMatrix4fv(glGetUniformLocation(program, "meshModel"), 1, GL_FALSE, (const GLfloat*)&mesh_model);
+        glUniformMatrix4fv(glGetUniformLocation(program, "meshInverseMVP"), 1, GL_FALSE, (const GLfloat*)&mesh_inverse_mvp);
+        glUniform3fv(glGetUniformLocation(program, "sdfMin"), 1, (const GLfloat*)&scene->sdf_min);
+        glUniform3fv(glGetUniformLocation(program, "sdfSize"), 1, (const GLfloat*)&scene->sdf_size);
+        glUniform1i(glGetUniformLocation(program, "sdf"), 0); // Set texture unit 0
+        set_texture(scene, program); // Same light and material as the model pass
+    } else {
+        glUniform1i(glGetUniformLocation(program, "simple_texture"), 0); // Set texture unit 0
+    }
 
     // Render the cube
     glBindVertexArray(scene->cube_vao); // Bind the VAO for the cube
-    glBindTexture(GL_TEXTURE_2D, scene->texture); // Bind the texture for the cube
+    if (scene->sdf_enabled) {
+        glBindTexture(GL_TEXTURE_3D, scene->sdf_texture); // Bind the distance field for the cube
+    } else {
+        glBindTexture(GL_TEXTURE_2D, scene->texture); // Bind the texture for the cube
+    }
     glDrawArrays(GL_TRIANGLES, 0, 36); // Draw the cube (assuming 36 vertices for a cube)
-    glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+    glBindTexture(GL_TEXTURE_3D, 0); // Unbind the textures
+    glBindTexture(GL_TEXTURE_2D, 0);
     glBindVertexArray(0); // Unbind the VAO
 }
 
+// Depth-only draw of the model through the position-only stream, shared by every pass that
+// needs depth but no shading
+void render_model_depth(SceneData* scene, const MeshData* mesh, mat4_t model, mat4_t view, mat4_t projection) {
+    glUseProgram(scene->depth_program);
+    glUniformMatrix4fv(glGetUniformLocation(scene->depth_program, "model"), 1, GL_FALSE, (const GLfloat*)&model);
+    glUniformMatrix4fv(glGetUniformLocation(scene->depth_program, "view"), 1, GL_FALSE, (const GLfloat*)&view);
+    glUniformMatrix4fv(glGetUniformLocation(scene->depth_program, "projection"), 1, GL_FALSE, (const GLfloat*)&projection);
+
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glBindVertexArray(scene->depth_vao);
+    glDrawElements(GL_TRIANGLES, mesh->triangle_count * 3, GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+// Draw the point hierarchy with the level of every chunk picked for about 2 pixel point spacing
+void render_model_points(SceneData* scene, mat4_t model, mat4_t view, mat4_t projection) {
+    const PointLod* lod = scene->point_lod;
+    GLuint program = scene->points_program;
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "model"), 1, GL_FALSE, (const GLfloat*)&model);
+    glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, (const GLfloat*)&view);
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, (const GLfloat*)&projection);
+    glUniform1f(glGetUniformLocation(program, "viewportHeight"), (float)WINDOW_HEIGHT);
+    set_texture(scene, program);
+
+    // Camera in model space: the 0.4 `w` zoom scales the world by 2.5 and the model matrix only rotates
+    vec3_t eye = mat4_vec3_mul(mat4_transpose(model), vec3(0.0f, 0.0f, 3.0f * 0.4f), 0);
+    float pixels_per_unit = projection.data[5] * 0.5f * (float)WINDOW_HEIGHT;
+    int32_t draw_count = point_lod_select(lod, eye, pixels_per_unit, 2.0f, scene->point_firsts, scene->point_counts);
+
+    glBindVertexArray(scene->points_vao);
+    glMultiDrawArrays(GL_POINTS, scene->point_firsts, scene->point_counts, draw_count);
+    glBindVertexArray(0);
+}
+
+// Draw the crowd: instances large on screen as meshes, the rest as one instanced draw of imposters
+void render_model_crowd(SceneData* scene, const MeshData* mesh, mat4_t model, mat4_t view, mat4_t projection) {
+    const ImposterAtlas* atlas = &scene->imposter_atlas;
+
+    // The model shaders place `FragPos` at 0.4 times the camera space scale, so is the eye
+    vec3_t eye = vec3(0.0f, 0.0f, 3.0f * 0.4f);
+    // Split and cull by the current bounds, sculpting can outgrow the sphere the atlas was baked with
+    vec3_t sphere_center = mesh->has_bounds ? mesh->sphere_center : atlas->center;
+    float radius = mesh->has_bounds ? mesh->sphere_radius : atlas->radius;
+    vec3_t center = mat4_vec3_mul(model, sphere_center, 0);
+    for (int32_t i = 0; i < CROWD_COUNT; ++i) {
+        scene->crowd_centers[i][0] = scene->crowd_offsets[i][0] + center.x;
+        scene->crowd_centers[i][1] = scene->crowd_offsets[i][1] + center.y;
+        scene->crowd_centers[i][2] = scene->crowd_offsets[i][2] + center.z;
+    }
+    float pixels_per_unit = projection.data[5] * 0.5f * (float)WINDOW_HEIGHT;
+    int32_t far_count = 0;
+    int32_t near_count = imposter_split_instances(&scene->crowd_centers[0][0], CROWD_COUNT, radius, eye,
+                                                  pixels_per_unit, IMPOSTER_MAX_PIXELS,
+                                                  scene->crowd_near, scene->crowd_far, &far_count);
+
+    // Frustum in `FragPos` space, the 0.4 `w` zoom folded into the matrix
+    mat4_t zoom = mat4_identity();
+    zoom.data[15] = 0.4f;
+    Frustum frustum;
+    frustum_from_matrix(&frustum, mat4_mul(mat4_mul(projection, view), zoom));
+
+    // Every instance by its bounding sphere in one batch, then the few near ones by the tighter box
+    for (int32_t i = 0; i < CROWD_COUNT; ++i) {
+        scene->crowd_spheres[0][i] = scene->crowd_centers[i][0];
+        scene->crowd_spheres[1][i] = scene->crowd_centers[i][1];
+        scene->crowd_spheres[2][i] = scene->crowd_centers[i][2];
+        scene->crowd_spheres[3][i] = radius;
+    }
+    FrustumSpheres spheres = {scene->crowd_spheres[0], scene->crowd_spheres[1],
+                              scene->crowd_spheres[2], scene->crowd_spheres[3]};
+    frustum_cull_spheres(&frustum, &spheres, CROWD_COUNT, scene->crowd_visible);
+
+    vec3_t box_center = vec3(0.0f, 0.0f, 0.0f);
+    vec3_t box_axes[3];
+    if (mesh->has_bounds) {
+        frustum_obb_transform(&mesh->obb, model, &box_center, box_axes);
+    }
+    int32_t visible_count = 0;
+    for (int32_t i = 0; i < near_count; ++i) {
+        uint32_t index = scene->crowd_near[i];
+        if (!frustum_mask_test(scene->crowd_visible, index)) {
+            continue;
+        }
+        const float* offset = scene->crowd_offsets[index];
+        if (mesh->has_bounds &&
+            !frustum_test_obb(&frustum, vec3_add(box_center, vec3(offset[0], offset[1], offset[2])), box_axes)) {
+            continue;
+        }
+        scene->crowd_near[visible_count++] = index;
+    }
+    near_count = visible_count;
+    visible_count = 0;
+    for (int32_t i = 0; i < far_count; ++i) {
+        if (frustum_mask_test(scene->crowd_visible, scene->crowd_far[i])) {
+            scene->crowd_far[visible_count++] = scene->crowd_far[i];
+        }
+    }
+    far_count = visible_count;
+
+    // Near instances: the full mesh, one draw each
+    glUseProgram(scene->model_program);
+    set_texture(scene, scene->model_program);
+    glUniformMatrix4fv(glGetUniformLocation(scene->model_program, "view"), 1, GL_FALSE, (const GLfloat*)&view);
+    glUniformMatrix4fv(glGetUniformLocation(scene->model_program, "projection"), 1, GL_FALSE, (const GLfloat*)&projection);
+    // The instances only differ by a translation, they share the normal matrix
+    mat3_t normal_matrix = mat4_normal_matrix(model);
+    glUniformMatrix3fv(glGetUniformLocation(scene->model_program, "normalMatrix"), 1, GL_FALSE, normal_matrix.data);
+    GLint model_loc = glGetUniformLocation(scene->model_program, "model");
+    glBindVertexArray(scene->model_vao);
+    for (int32_t i = 0; i < near_count; ++i) {
+        const float* offset = scene->crowd_offsets[scene->crowd_near[i]];
+        mat4_t instance = mat4_mul(mat4_make_translation(vec3(offset[0], offset[1], offset[2])), model);
+        glUniformMatrix4fv(model_loc, 1, GL_FALSE, (const GLfloat*)&instance);
+        glDrawElements(GL_TRIANGLES, mesh->triangle_count * 3, GL_UNSIGNED_INT, 0);
+    }
+
+    // Far instances: their translations streamed into the instance buffer, four vertices each
+    if (far_count > 0) {
+        float offsets[CROWD_COUNT][3];
+        for (int32_t i = 0; i < far_count; ++i) {
+            memcpy(offsets[i], scene->crowd_offsets[scene->crowd_far[i]], sizeof(offsets[i]));
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, scene->imposter_instance_vbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(offsets), NULL, GL_STREAM_DRAW); // Orphan last frame's data
+        glBufferSubData(GL_ARRAY_BUFFER, 0, far_count * sizeof(offsets[0]), offsets);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        GLuint program = scene->imposter_program;
+        glUseProgram(program);
+        set_texture(scene, program);
+        glUniformMatrix4fv(glGetUniformLocation(program, "model"), 1, GL_FALSE, (const GLfloat*)&model);
+        glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, (const GLfloat*)&view);
+        glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, (const GLfloat*)&projection);
+        glUniform3fv(glGetUniformLocation(program, "eyePos"), 1, (const GLfloat*)&eye);
+        glUniform3fv(glGetUniformLocation(program, "imposterCenter"), 1, (const GLfloat*)&atlas->center);
+        glUniform1f(glGetUniformLocation(program, "imposterRadius"), atlas->radius);
+        glUniform1f(glGetUniformLocation(program, "imposterGrid"), (float)atlas->grid);
+        glUniform1i(glGetUniformLocation(program, "imposterColor"), 0);
+        glUniform1i(glGetUniformLocation(program, "imposterNormalDepth"), 1);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, scene->imposter_color);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, scene->imposter_normal_depth);
+
+        glBindVertexArray(scene->imposter_vao);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, far_count);
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glBindVertexArray(0);
+}
+
+// Animate the model for this frame and write it into the next region of the streamed buffer.
+// The region was last drawn DEFORM_REGION_COUNT - 1 frames ago, its fence rarely blocks, and the
+// unsynchronized mapping keeps the driver from stalling on the regions still in flight.
+void deform_model(SceneData* scene, const MeshData* mesh) {
+    Deformer* deformer = scene->deformer;
+    float time = (float)glfwGetTime();
+    deformer->weights[0] = 0.5f + 0.5f * sinf(time * 1.1f);  // Inflate
+    deformer->weights[1] = 0.5f + 0.5f * sinf(time * 0.7f);  // Stretch
+    deformer->wave.phase = -3.0f * time;
+
+    int32_t region = (scene->deform_region + 1) % DEFORM_REGION_COUNT;
+    GLsizeiptr region_size = (GLsizeiptr)mesh->vertex_count * 6 * sizeof(float);
+    if (scene->deform_fences[region]) {
+        glClientWaitSync(scene->deform_fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        glDeleteSync(scene->deform_fences[region]);
+        scene->deform_fences[region] = 0;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, scene->deform_vbo);
+    void* vertices = glMapBufferRange(GL_ARRAY_BUFFER, region * region_size, region_size,
+                                      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (vertices) {
+        deform_run(deformer, vertices, 6 * sizeof(float), 0, 3 * sizeof(float));
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+
+    // Point the position and normal attributes at the fresh region
+    glBindVertexArray(scene->deform_vao);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(region * region_size));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(region * region_size + 3 * sizeof(float)));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    scene->deform_region = region;
+}
+
 void render_model(SceneData* scene, MeshData* mesh) {
     // Bind the framebuffer object (FBO) to render to it
     glBindFramebuffer(GL_FRAMEBUFFER, scene->framebuffer);
@@ -593,40 +1960,92 @@ void render_model(SceneData* scene, MeshData* mesh) {
     vec3_t center = vec3(0.0f, 0.0f, 0.0f);  // Point the camera is looking at
     vec3_t up = vec3(0.0f, 1.0f, 0.0f);      // Up direction for the camera
 
-    // Use the shader program for rendering
-    glUseProgram(scene->model_program);
-
-    // Calculate the rotation angle based on elapsed time for animation
-    float angle = (float)glfwGetTime() * 0.5f; // Rotate at 0.5 radians per second
-    vec3_t axis = vec3(1.0f, 0.0f, 0.0f);     // Rotation around the X-axis
+    // Use the shader program for rendering, the tessellated one draws the triangles as patches
+    bool tessellate = scene->tessellation_mode != TESSELLATION_OFF;
+    GLuint program = tessellate ? scene->tess_program : scene->model_program;
+    GLenum primitive = tessellate ? GL_PATCHES : GL_TRIANGLES;
 
-    // Create the transformation matrices
-    mat4_t model = mat4_make_rotation(axis, angle); // Model matrix with rotation
+    // Create the transformation matrices, the model rotating with its orientation at the current time
+    mat4_t model = quat_to_mat4(model_orientation((float)glfwGetTime())); // Model matrix with rotation
     mat4_t view = look_at(eye, center, up);         // View matrix for camera
     mat4_t projection = perspective(deg2rad(45.0f), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.1f, 100.0f); // Perspective projection matrix
 
+    // The crowd replaces the single model
+    if (scene->crowd_enabled) {
+        render_model_crowd(scene, mesh, model, view, projection);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return;
+    }
+
+    // Point splats replace the triangles entirely
+    if (scene->points_enabled) {
+        render_model_points(scene, model, view, projection);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return;
+    }
+
+    // The animated model replaces the base mesh, the subdivided copy is not animated
+    bool subdivided = scene->subdivision_enabled && scene->subdiv_vao;
+    bool deform = scene->deform_enabled && !subdivided;
+    if (deform) {
+        deform_model(scene, mesh);
+    }
+
+    // The prepass only matches the plain base mesh, tessellated, subdivided or animated surfaces differ from it
+    bool prepass = scene->depth_prepass && !tessellate && !subdivided && !deform;
+    if (prepass) {
+        render_model_depth(scene, mesh, model, view, projection);
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_FALSE);
+    }
+    glUseProgram(program);
+
     // Retrieve the locations of the uniform variables in the shader
-    GLuint model_loc = glGetUniformLocation(scene->model_program, "model");
-    GLuint view_loc = glGetUniformLocation(scene->model_program, "view");
-    GLuint proj_loc = glGetUniformLocation(scene->model_program, "projection");
+    GLuint model_loc = glGetUniformLocation(program, "model");
+    GLuint view_loc = glGetUniformLocation(program, "view");
+    GLuint proj_loc = glGetUniformLocation(program, "projection");
 
-    // Set the transformation matrices in the shader
+    // Set the transformation matrices in the shader, the normal matrix computed once here rather than per vertex
     glUniformMatrix4fv(model_loc, 1, GL_FALSE, (const GLfloat*)&model);
     glUniformMatrix4fv(view_loc, 1, GL_FALSE, (const GLfloat*)&view);
     glUniformMatrix4fv(proj_loc, 1, GL_FALSE, (const GLfloat*)&projection);
+    mat3_t normal_matrix = mat4_normal_matrix(model);
+    glUniformMatrix3fv(glGetUniformLocation(program, "normalMatrix"), 1, GL_FALSE, normal_matrix.data);
+
+    // Tessellation factors aim for 8 pixel edges, Phong tessellation uses the usual 3/4 shape factor
+    if (tessellate) {
+        glUniform2f(glGetUniformLocation(program, "viewport"), (float)WINDOW_WIDTH, (float)WINDOW_HEIGHT);
+        glUniform1f(glGetUniformLocation(program, "targetEdgePixels"), 8.0f);
+        glUniform1i(glGetUniformLocation(program, "pnTriangles"), scene->tessellation_mode == TESSELLATION_PN_TRIANGLES);
+        glUniform1f(glGetUniformLocation(program, "phongAlpha"), 0.75f);
+    }
 
     // Bind and set up the texture
-    set_texture(scene);
-
-    // Bind the vertex array object (VAO) for the model
-    glBindVertexArray(scene->model_vao);
+    set_texture(scene, program);
 
+    // Bind the vertex array object (VAO) for the model, or its subdivided copy
     // Draw the model using the element buffer
-    glDrawElements(GL_TRIANGLES, mesh->triangle_count * 3, GL_UNSIGNED_INT, 0);
+    if (subdivided) {
+        glBindVertexArray(scene->subdiv_vao);
+        glDrawElements(primitive, scene->subdiv_triangle_count * 3, GL_UNSIGNED_INT, 0);
+    } else if (deform) {
+        glBindVertexArray(scene->deform_vao);
+        glDrawElements(primitive, mesh->triangle_count * 3, GL_UNSIGNED_INT, 0);
+        scene->deform_fences[scene->deform_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    } else {
+        glBindVertexArray(scene->model_vao);
+        glDrawElements(primitive, mesh->triangle_count * 3, GL_UNSIGNED_INT, 0);
+    }
 
     // Unbind the VAO
     glBindVertexArray(0);
 
+    // Restore the default depth state after the prepass
+    if (prepass) {
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+    }
+
     // Unbind the framebuffer object to render to the default framebuffer (the screen)
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
@@ -678,18 +2097,167 @@ int32_t main(int32_t argc, char** argv) {
         printf("  Normal Size:   %d bytes | Offset: %d bytes\n", mesh.normals_size, mesh.normals_offset);
     }
 
+    // Build the half-edge connectivity once, shared by every topology-dependent algorithm
+    MeshTopology topology = {0};
+    if (!mesh_topology_build(&mesh, &topology)) {
+        printf("Topology: %d boundary edges, %d non-manifold edges (%d worker threads)\n",
+               topology.boundary_edge_count, topology.nonmanifold_edge_count, par_worker_count());
+    } else {
+        fprintf(stderr, "Failed to build the mesh topology, sculpting and subdivision are disabled\n");
+    }
+
+    // Fit the culling volumes to the convex hull once, they are cached in the mesh
+    if (!mesh_compute_bounds(&mesh)) {
+        printf("Bounds: OBB half extents %.3f x %.3f x %.3f, sphere radius %.3f\n",
+               mesh.obb.half_extents.x, mesh.obb.half_extents.y, mesh.obb.half_extents.z, mesh.sphere_radius);
+    }
+
+    // Build the triangle BVH, shared by every ray and distance query on the model
+    Bvh bvh = {0};
+    if (bvh_build(&mesh, &bvh)) {
+        fprintf(stderr, "Failed to build BVH\n");
+    }
+
+    // Bake ambient occlusion into the vertices before they are uploaded
+    float scale = mesh.has_bounds ? mesh.sphere_radius : 1.0f;
+    AoBakeParams ao_params = {0};
+    ao_params.ray_count = 32;                 // Hemisphere rays per vertex
+    ao_params.max_distance = 0.5f * scale;    // Ignore occluders farther than half the model size
+    ao_params.bias = 0.001f * scale;          // Lift ray origins off the surface
+    float* ao = (float*)malloc(mesh.vertex_count * sizeof(float));
+    if (ao && bvh.nodes && !ao_bake(&mesh, &bvh, &ao_params, ao) && !mesh_append_ao(&mesh, ao)) {
+        printf("Ambient occlusion: %d rays per vertex\n", ao_params.ray_count);
+    }
+    free(ao);
+
+    // Bake the signed distance field for the ray marched render mode
+    SdfGrid sdf = {0};
+    if (bvh.nodes && !sdf_bake(&mesh, &bvh, 96, 2, &sdf)) {
+        printf("SDF: %d x %d x %d voxels of %.4f\n", sdf.resolution[0], sdf.resolution[1], sdf.resolution[2], sdf.voxel_size);
+    }
+
+    // Build the point hierarchy for the point splat mode, 256^3 cells at the finest level
+    PointLod point_lod = {0};
+    if (!point_lod_build(&mesh, 8, &point_lod)) {
+        printf("Point LOD: %d levels, %d points, %d chunks\n", point_lod.level_count, point_lod.point_count, point_lod.chunk_count);
+    }
+
     // Initialize scene data and resources
     SceneData scene = {0}; // Initialize scene data structure
     init_cube(&scene);     // Initialize cube data
     init_model(&scene, &mesh); // Initialize model with mesh data
+    init_tessellation(&scene); // Initialize the tessellated model program
     init_texture(&scene, &mesh); // Initialize texture for the model
+    if (sdf.distances) {
+        init_sdf(&scene, &sdf);  // Upload the distance field, the CPU copy is no longer needed
+        sdf_free(&sdf);
+    }
+    if (point_lod.points) {
+        init_points(&scene, &point_lod); // Upload every level of the point hierarchy
+    }
+    init_imposters(&scene, &mesh); // Bake the imposter atlas and lay out the crowd
+
+    LoopSubdivider subdiv = {0}; // Allocated the first time subdivision is switched on
+
+    // Route keyboard input to the scene
+    glfwSetWindowUserPointer(window, &scene);
+    glfwSetKeyCallback(window, key_callback);
+
+    // Sculpting scratch, and a BVH over the cube faces to find the texel under the cursor
+    Sculptor sculptor = {0};
+    if (sculptor_create(&sculptor, &mesh)) {
+        fprintf(stderr, "Failed to allocate the sculpting scratch, sculpting is disabled\n");
+    }
+    static uint32_t cube_indices[36];
+    for (uint32_t i = 0; i < 36; ++i) {
+        cube_indices[i] = i;
+    }
+    MeshData cube_mesh = {0};
+    cube_mesh.vertex_count = 36;
+    cube_mesh.triangle_count = 12;
+    cube_mesh.vertex_data = cube_vertices;
+    cube_mesh.triangles = cube_indices;
+    cube_mesh.vertex_size = 8 * sizeof(float);
+    cube_mesh.positions_size = 3 * sizeof(float);
+    Bvh cube_bvh = {0};
+    bvh_build(&cube_mesh, &cube_bvh);
+
+    // Vertex animation: SoA copy of the mesh and two morph targets, inflated along the normals
+    // and stretched along y about the bounding sphere, plus a wave travelling up the model
+    MeshSoA deform_base = {0};
+    MeshSoA deform_target = {0};
+    Deformer deformer = {0};
+    if (!mesh_soa_from_mesh(&mesh, &deform_base) && !mesh_soa_from_mesh(&mesh, &deform_target)) {
+        deformer_init(&deformer, &deform_base);
+        float center_y = mesh.has_bounds ? mesh.sphere_center.y : 0.0f;
+        for (int32_t i = 0; i < deform_target.capacity; ++i) {
+            deform_target.x[i] += 0.06f * scale * deform_base.nx[i];
+            deform_target.y[i] += 0.06f * scale * deform_base.ny[i];
+            deform_target.z[i] += 0.06f * scale * deform_base.nz[i];
+        }
+        int32_t inflate = deformer_add_target(&deformer, &deform_target);
+        // Scaling y by 1.2 scales the normals' y by 1 / 1.2, the kernel renormalizes
+        for (int32_t i = 0; i < deform_target.capacity; ++i) {
+            deform_target.x[i] = deform_base.x[i];
+            deform_target.y[i] = center_y + 1.2f * (deform_base.y[i] - center_y);
+            deform_target.z[i] = deform_base.z[i];
+            deform_target.ny[i] = deform_base.ny[i] / 1.2f;
+        }
+        int32_t stretch = deformer_add_target(&deformer, &deform_target);
+        // frame() drives the weights of targets 0 and 1, animate only with both in place
+        if (inflate == 0 && stretch == 1) {
+            deformer.wave.wave_vector = vec3(0.0f, 2.0f * PI / (0.4f * scale), 0.0f);
+            deformer.wave.amplitude = 0.01f * scale;
+            scene.deformer = &deformer;
+        } else {
+            fprintf(stderr, "Failed to add the morph targets, vertex animation is disabled\n");
+        }
+    }
+    mesh_soa_free(&deform_target);
 
     // Set the viewport size to match the window dimensions
     glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
 
     // Run the rendering loop until the window is closed
     while (!glfwWindowShouldClose(window)) {
-        render_model(&scene, &mesh); // Render the model
+        // Sculpt while the left mouse button is held, the subdivided copy follows once the stroke ends
+        bool stroke = scene.sculpt_enabled && !scene.sdf_enabled && bvh.nodes && topology.twin && sculptor.moved &&
+                      glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+        if (stroke) {
+            sculpt_model(&scene, window, &sculptor, &mesh, &topology, &bvh, &cube_bvh);
+        } else if (scene.sculpt_stroke) {
+            scene.subdivision_dirty = scene.subdivision_enabled;
+            // Refit the culling volumes to the sculpted surface, a failure keeps the previous ones
+            mesh_compute_bounds(&mesh);
+            // The morph targets are deltas and carry over to the sculpted base
+            if (scene.deformer) {
+                mesh_soa_free(&deform_base);
+                if (mesh_soa_from_mesh(&mesh, &deform_base)) {
+                    scene.deformer = NULL;
+                    scene.deform_enabled = false;
+                }
+            }
+        }
+        scene.sculpt_stroke = stroke;
+
+        // Subdivide the model when it was just switched on
+        if (scene.subdivision_dirty) {
+            // Every split edge adds one vertex and at least one triangle, so the vertex budget follows the triangle one
+            if (topology.twin && !subdiv.max_triangles &&
+                loop_subdiv_create(&subdiv, &mesh, mesh.vertex_count + SUBDIV_MAX_TRIANGLES, SUBDIV_MAX_TRIANGLES)) {
+                fprintf(stderr, "Failed to allocate the subdivision buffers, subdivision stays off\n");
+                scene.subdivision_enabled = false;
+            }
+            if (topology.twin && subdiv.max_triangles) {
+                refine_model(&scene, &subdiv, &mesh, &topology);
+            }
+            scene.subdivision_dirty = false;
+        }
+
+        // The ray marched distance field replaces the offscreen model pass
+        if (!scene.sdf_enabled) {
+            render_model(&scene, &mesh); // Render the model
+        }
         frame(&scene, &mesh);        // Update the frame (for animation, etc.)
         
         // Swap the front and back buffers to display the rendered image
@@ -702,10 +2270,47 @@ int32_t main(int32_t argc, char** argv) {
     // Clean up resources before exiting
     glDeleteVertexArrays(1, &scene.cube_vao);  // Delete the cube's VAO
     glDeleteVertexArrays(1, &scene.model_vao); // Delete the model's VAO
+    glDeleteBuffers(1, &scene.model_vbo);      // Delete the model's vertex buffer
+    glDeleteVertexArrays(1, &scene.depth_vao); // Delete the position-only VAO and buffer
+    glDeleteBuffers(1, &scene.depth_vbo);
+    glDeleteVertexArrays(1, &scene.subdiv_vao); // Delete the subdivided model's VAO
+    glDeleteBuffers(1, &scene.subdiv_vbo);      // Delete the subdivided model's buffers
+    glDeleteBuffers(1, &scene.subdiv_ebo);
     glDeleteProgram(scene.basic_program);      // Delete the basic shader program
     glDeleteProgram(scene.model_program);      // Delete the model shader program
+    glDeleteProgram(scene.tess_program);       // Delete the tessellated model shader program
+    glDeleteProgram(scene.depth_program);      // Delete the depth-only shader program
+    glDeleteVertexArrays(1, &scene.points_vao); // Delete the point splat VAO, buffer and program
+    glDeleteBuffers(1, &scene.points_vbo);
+    glDeleteProgram(scene.points_program);
+    free(scene.point_firsts);
+    free(scene.point_counts);
+    glDeleteVertexArrays(1, &scene.imposter_vao); // Delete the imposter billboards and atlas
+    glDeleteBuffers(1, &scene.imposter_quad_vbo);
+    glDeleteBuffers(1, &scene.imposter_instance_vbo);
+    glDeleteProgram(scene.imposter_program);
+    glDeleteTextures(1, &scene.imposter_color);
+    glDeleteTextures(1, &scene.imposter_normal_depth);
+    glDeleteVertexArrays(1, &scene.deform_vao); // Delete the streamed animation buffer and its fences
+    glDeleteBuffers(1, &scene.deform_vbo);
+    for (int32_t i = 0; i < DEFORM_REGION_COUNT; ++i) {
+        if (scene.deform_fences[i]) {
+            glDeleteSync(scene.deform_fences[i]);
+        }
+    }
+    glDeleteProgram(scene.sdf_program);        // Delete the distance field shader program
+    glDeleteTextures(1, &scene.sdf_texture);   // Delete the distance field texture
     free(mesh.vertex_data);   // Free the vertex data memory
     free(mesh.triangles);     // Free the triangle index memory
+    mesh_topology_free(&topology); // Free the half-edge connectivity
+    loop_subdiv_destroy(&subdiv);  // Free the subdivision buffers
+    bvh_free(&bvh);                // Free the BVH
+    bvh_free(&cube_bvh);           // Free the cube picking BVH
+    sculptor_destroy(&sculptor);   // Free the sculpting scratch
+    point_lod_free(&point_lod);    // Free the point hierarchy
+    deformer_destroy(&deformer);   // Free the morph targets
+    mesh_soa_free(&deform_base);
+    par_shutdown();           // Join the worker threads
     glfwDestroyWindow(window); // Destroy the GLFW window
     glfwTerminate();           // Terminate GLFW
     return 0; // Return success code
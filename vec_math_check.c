@@ -0,0 +1,416 @@
+// Agreement and speed of the SIMD mat4 / vec4 kernels of vec_math.h against
+// the scalar reference versions, and of the batch functions against loops over
+// the single element ones. Everything except mat4_inverse has to match
+// bit for bit; mat4_inverse uses a different cofactor expansion and is held
+// to VEC_MATH_CHECK_INVERSE_ULP units in the last place of the largest element
+// of each inverse column, both paths are also measured against a double
+// precision inverse. Exits with EXIT_FAILURE when a kernel disagrees.
+// Build once per backend (see vec_math_check.sh). ISO C modes (-std=c11)
+// keep gcc from contracting the scalar code into fused multiply-adds, which
+// bit for bit agreement relies on. -fno-ipa-icf keeps gcc from folding
+// identical functions (every kernel and its reference in a scalar build) into
+// thunks that copy the by-value arguments once more, which skews the timings.
+#define _POSIX_C_SOURCE 199309L
+#define _VEC_MATH_IMPLEMENTATION_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "libs/vec_math.h"
+
+#define VEC_MATH_CHECK_COUNT 100000
+#define VEC_MATH_CHECK_INVERSE_ULP 512.0f
+// Timed passes go over the first VEC_MATH_CHECK_TIMED inputs, which stay in L1
+#define VEC_MATH_CHECK_TIMED 256
+#define VEC_MATH_CHECK_RUNS 2000
+// Points per call of the timed point kernels
+#define VEC_MATH_CHECK_BLOCK 16
+
+static uint32_t rng_state = 0x9E3779B9u;
+
+static float random_float(float lo, float hi) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return lo + (hi - lo) * (float)(rng_state >> 8) * (1.0f / 16777216.0f);
+}
+
+// Random model matrix (rotation, some shear and scale, translation), now and
+// then premultiplied by a projection: the kind of matrices the renderer inverts
+static mat4_t random_matrix(void) {
+    vec3_t axis = vec3_normalize(vec3(random_float(-1, 1), random_float(-1, 1), random_float(-1, 1) + 0.01f));
+    mat4_t m = mat4_make_rotation(axis, random_float(0.0f, 6.28f));
+    for (int32_t c = 0; c < 3; ++c) {
+        for (int32_t r = 0; r < 3; ++r) {
+            m.col[c].data[r] = m.col[c].data[r] * random_float(0.5f, 2.0f) + random_float(-0.2f, 0.2f);
+        }
+    }
+    m.col[3] = vec4(random_float(-10, 10), random_float(-10, 10), random_float(-10, 10), 1.0f);
+    if (random_float(0, 1) < 0.25f) {
+        m = mat4_mul(perspective(random_float(0.5f, 1.5f), random_float(0.5f, 2.0f), 0.1f, 100.0f), m);
+    }
+    return m;
+}
+
+static vec4_t random_vec4(void) {
+    return vec4(random_float(-10, 10), random_float(-10, 10), random_float(-10, 10), random_float(-10, 10));
+}
+
+// Gauss-Jordan inverse with partial pivoting in double precision
+static void inverse_double(const mat4_t* m, double out[16]) {
+    double rows[4][8];
+    for (int32_t r = 0; r < 4; ++r) {
+        for (int32_t c = 0; c < 4; ++c) {
+            rows[r][c] = m->data[4 * c + r];
+            rows[r][c + 4] = r == c ? 1.0 : 0.0;
+        }
+    }
+    for (int32_t c = 0; c < 4; ++c) {
+        int32_t pivot = c;
+        for (int32_t r = c + 1; r < 4; ++r) {
+            pivot = fabs(rows[r][c]) > fabs(rows[pivot][c]) ? r : pivot;
+        }
+        for (int32_t k = 0; k < 8; ++k) {
+            double t = rows[c][k];
+            rows[c][k] = rows[pivot][k];
+            rows[pivot][k] = t;
+        }
+        double scale = 1.0 / rows[c][c];
+        for (int32_t k = 0; k < 8; ++k) {
+            rows[c][k] *= scale;
+        }
+        for (int32_t r = 0; r < 4; ++r) {
+            double f = rows[r][c];
+            for (int32_t k = 0; r != c && k < 8; ++k) {
+                rows[r][k] -= f * rows[c][k];
+            }
+        }
+    }
+    for (int32_t r = 0; r < 4; ++r) {
+        for (int32_t c = 0; c < 4; ++c) {
+            out[4 * c + r] = rows[r][c + 4];
+        }
+    }
+}
+
+// Number of elements that differ in their bits
+static int32_t count_mismatches(const float* a, const float* b, int32_t count) {
+    int32_t mismatches = 0;
+    for (int32_t i = 0; i < count; ++i) {
+        mismatches += memcmp(&a[i], &b[i], sizeof(float)) != 0;
+    }
+    return mismatches;
+}
+
+typedef mat4_t (*Mat4Binary)(mat4_t a, mat4_t b);
+typedef vec4_t (*Mat4Vec4)(mat4_t m, vec4_t v);
+typedef mat4_t (*Mat4Unary)(mat4_t m);
+typedef void (*PointsKernel)(mat4_t m, const vec3_t* v, vec3_t* out, int32_t count);
+
+#define CHECK_NOINLINE __attribute__((noinline))
+
+// The points batch against a loop over the scalar function, both out of line
+static CHECK_NOINLINE void points_batch(mat4_t m, const vec3_t* v, vec3_t* out, int32_t count) {
+    mat4_vec3_mul_batch(m, v, out, count, 1);
+}
+
+static CHECK_NOINLINE void points_scalar(mat4_t m, const vec3_t* v, vec3_t* out, int32_t count) {
+    for (int32_t i = 0; i < count; ++i) {
+        out[i] = mat4_vec3_mul_scalar(m, v[i], 1);
+    }
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int32_t main(void) {
+#if defined(VEC_MATH_SIMD_AVX)
+    const char* backend = "AVX";
+#elif defined(VEC_MATH_SIMD_SSE2)
+    const char* backend = "SSE2";
+#elif defined(VEC_MATH_SIMD_NEON)
+    const char* backend = "NEON";
+#else
+    const char* backend = "scalar";
+#endif
+    mat4_t* a = (mat4_t*)malloc(VEC_MATH_CHECK_COUNT * sizeof(mat4_t));
+    mat4_t* b = (mat4_t*)malloc(VEC_MATH_CHECK_COUNT * sizeof(mat4_t));
+    mat4_t* out = (mat4_t*)malloc(VEC_MATH_CHECK_COUNT * sizeof(mat4_t));
+    vec4_t* v = (vec4_t*)malloc(VEC_MATH_CHECK_COUNT * sizeof(vec4_t));
+    vec4_t* out4 = (vec4_t*)malloc(VEC_MATH_CHECK_COUNT * sizeof(vec4_t));
+    vec3_t* v3 = (vec3_t*)malloc(VEC_MATH_CHECK_COUNT * sizeof(vec3_t));
+    vec3_t* out3 = (vec3_t*)malloc(VEC_MATH_CHECK_COUNT * sizeof(vec3_t));
+    if (!a || !b || !out || !v || !out4 || !v3 || !out3) {
+        return EXIT_FAILURE;
+    }
+    for (int32_t i = 0; i < VEC_MATH_CHECK_COUNT; ++i) {
+        a[i] = random_matrix();
+        b[i] = random_matrix();
+        v[i] = random_vec4();
+        v3[i] = vec4_to_vec3(v[i]);
+    }
+
+    // Bit for bit kernels
+    int32_t mismatches[10] = {0};
+    for (int32_t i = 0; i < VEC_MATH_CHECK_COUNT; ++i) {
+        mat4_t m = mat4_mul(a[i], b[i]);
+        mat4_t ms = mat4_mul_scalar(a[i], b[i]);
+        mismatches[0] += count_mismatches(m.data, ms.data, 16);
+        vec4_t p = mat4_vec4_mul(a[i], v[i]);
+        vec4_t ps = mat4_vec4_mul_scalar(a[i], v[i]);
+        mismatches[1] += count_mismatches(p.data, ps.data, 4);
+        vec3_t q = mat4_vec3_mul(a[i], vec4_to_vec3(v[i]), i & 1);
+        vec3_t qs = mat4_vec3_mul_scalar(a[i], vec4_to_vec3(v[i]), i & 1);
+        mismatches[2] += count_mismatches(q.data, qs.data, 3);
+        m = mat4_transpose(a[i]);
+        ms = mat4_transpose_scalar(a[i]);
+        mismatches[3] += count_mismatches(m.data, ms.data, 16);
+
+        // Element-wise operations against the plain expressions
+        vec4_t x = v[i];
+        vec4_t y = v[(i + 1) % VEC_MATH_CHECK_COUNT];
+        float s = y.w;
+        vec4_t e = vec4_add(x, y);
+        vec4_t r = vec4(x.x + y.x, x.y + y.y, x.z + y.z, x.w + y.w);
+        mismatches[4] += count_mismatches(e.data, r.data, 4);
+        e = vec4_sub(x, y);
+        r = vec4(x.x - y.x, x.y - y.y, x.z - y.z, x.w - y.w);
+        mismatches[4] += count_mismatches(e.data, r.data, 4);
+        e = vec4_mul(x, y);
+        r = vec4(x.x * y.x, x.y * y.y, x.z * y.z, x.w * y.w);
+        mismatches[4] += count_mismatches(e.data, r.data, 4);
+        e = vec4_div(x, y);
+        r = vec4(x.x / y.x, x.y / y.y, x.z / y.z, x.w / y.w);
+        mismatches[4] += count_mismatches(e.data, r.data, 4);
+        e = vec4_scalar_mul(x, s);
+        r = vec4(x.x * s, x.y * s, x.z * s, x.w * s);
+        mismatches[4] += count_mismatches(e.data, r.data, 4);
+        float denom = 1.0f / s;
+        e = vec4_scalar_div(x, s);
+        r = vec4(x.x * denom, x.y * denom, x.z * denom, x.w * denom);
+        mismatches[4] += count_mismatches(e.data, r.data, 4);
+        m = mat4_add(a[i], b[i]);
+        for (int32_t k = 0; k < 16; ++k) {
+            mismatches[5] += m.data[k] != a[i].data[k] + b[i].data[k];
+        }
+        m = mat4_scalar_mul(a[i], s);
+        for (int32_t k = 0; k < 16; ++k) {
+            mismatches[5] += m.data[k] != a[i].data[k] * s;
+        }
+    }
+
+    // Batches over the whole arrays against the single element functions. The
+    // count is odd so the scalar tail after the 4-wide steps runs too.
+    const int32_t n = VEC_MATH_CHECK_COUNT - 1;
+    const mat4_t m = a[0];
+    const mat3_t nm = mat3_transpose(mat3_inverse(mat4_to_mat3(m)));
+    for (int32_t is_point = 0; is_point < 2; ++is_point) {
+        mat4_vec3_mul_batch(m, v3, out3, n, is_point);
+        for (int32_t i = 0; i < n; ++i) {
+            vec3_t r = mat4_vec3_mul(m, v3[i], is_point);
+            mismatches[6] += count_mismatches(out3[i].data, r.data, 3);
+        }
+    }
+    mat4_normal_mul_batch(m, v3, out3, n);
+    for (int32_t i = 0; i < n; ++i) {
+        vec3_t r = vec3_normalize(mat3_vec3_mul(nm, v3[i]));
+        mismatches[6] += count_mismatches(out3[i].data, r.data, 3);
+    }
+    vec3_normalize_batch(v3, out3, n);
+    for (int32_t i = 0; i < n; ++i) {
+        vec3_t r = vec3_normalize(v3[i]);
+        mismatches[6] += count_mismatches(out3[i].data, r.data, 3);
+    }
+    mat4_vec4_mul_batch(m, v, out4, n);
+    for (int32_t i = 0; i < n; ++i) {
+        vec4_t r = mat4_vec4_mul(m, v[i]);
+        mismatches[6] += count_mismatches(out4[i].data, r.data, 4);
+    }
+    vec4_normalize_batch(v, out4, n);
+    for (int32_t i = 0; i < n; ++i) {
+        vec4_t r = vec4_normalize(v[i]);
+        mismatches[6] += count_mismatches(out4[i].data, r.data, 4);
+    }
+    mat4_mul_batch(m, b, out, n);
+    for (int32_t i = 0; i < n; ++i) {
+        mat4_t r = mat4_mul(m, b[i]);
+        mismatches[6] += count_mismatches(out[i].data, r.data, 16);
+    }
+    mat4_batch_mul(b, m, out, n);
+    for (int32_t i = 0; i < n; ++i) {
+        mat4_t r = mat4_mul(b[i], m);
+        mismatches[6] += count_mismatches(out[i].data, r.data, 16);
+    }
+
+    const quat_t* qa = (const quat_t*)v;
+    const quat_t* qb = (const quat_t*)(v + 1);
+    quat_t* qout = (quat_t*)out4;
+    quat_mul_batch(qa[0], qb, qout, n);
+    for (int32_t i = 0; i < n; ++i) {
+        quat_t r = quat_mul(qa[0], qb[i]);
+        mismatches[6] += count_mismatches(qout[i].data, r.data, 4);
+    }
+    quat_nlerp_batch(qa, qb, 0.3f, qout, n);
+    for (int32_t i = 0; i < n; ++i) {
+        quat_t r = quat_nlerp(qa[i], qb[i], 0.3f);
+        mismatches[6] += count_mismatches(qout[i].data, r.data, 4);
+    }
+    quat_normalize_batch(qa, qout, n);
+    for (int32_t i = 0; i < n; ++i) {
+        quat_t r = quat_normalize(qa[i]);
+        mismatches[6] += count_mismatches(qout[i].data, r.data, 4);
+    }
+    quat_to_mat4_batch(qa, out, n);
+    for (int32_t i = 0; i < n; ++i) {
+        mat4_t r = quat_to_mat4(qa[i]);
+        mismatches[6] += count_mismatches(out[i].data, r.data, 16);
+    }
+
+    // Wide vectors: every lane against the vec3_t functions, eight vectors at a
+    // time through the packed and the separate array layouts
+    float* soa = (float*)out4;
+    for (int32_t i = 0; i + 16 <= VEC_MATH_CHECK_COUNT; i += 8) {
+        vec3x8_t p = vec3x8_load_aos(v3 + i);
+        vec3x8_t q = vec3x8_load_aos(v3 + i + 8);
+        vec3x8_t c = vec3x8_normalize(vec3x8_cross(p, q));
+        vec3x8_t t = mat4_vec3x8_mul(&a[i], vec3x8_sub(p, q), 1);
+        float8_t d = vec3x8_dot(p, q);
+        float8_t nearer = float8_less(vec3x8_dot(p, p), vec3x8_dot(q, q));
+        vec3x8_t closest = vec3x8_select(nearer, p, q);
+        int bits = float8_bits(nearer);
+        vec3x8_store_aos(out3 + i, c);
+        vec3x8_store(soa, soa + 8, soa + 16, t);
+        for (int32_t k = 0; k < 8; ++k) {
+            vec3_t r = vec3_normalize(vec3_cross(v3[i + k], v3[i + k + 8]));
+            mismatches[7] += count_mismatches(out3[i + k].data, r.data, 3);
+            r = mat4_vec3_mul(a[i], vec3_sub(v3[i + k], v3[i + k + 8]), 1);
+            vec3_t lane = vec3(soa[k], soa[8 + k], soa[16 + k]);
+            mismatches[7] += count_mismatches(lane.data, r.data, 3);
+            float dot = vec3_dot(v3[i + k], v3[i + k + 8]);
+            mismatches[7] += count_mismatches(&d.data[k], &dot, 1);
+            int is_nearer = vec3_norm_sq(v3[i + k]) < vec3_norm_sq(v3[i + k + 8]);
+            mismatches[7] += ((bits >> k) & 1) != is_nearer;
+            lane = vec3x8_lane(closest, k);
+            mismatches[7] += count_mismatches(lane.data, v3[i + k + (is_nearer ? 0 : 8)].data, 3);
+        }
+    }
+    // The fast wide functions against the fast single ones, angles up to a few hundred radians
+    for (int32_t i = 0; i + 8 <= VEC_MATH_CHECK_COUNT; i += 8) {
+        vec3x8_t p = vec3x8_load_aos(v3 + i);
+        float8_t length_sq = vec3x8_dot(p, p);
+        float8_t rsqrt = float8_rsqrt_fast(length_sq);
+        float8_t s, c;
+        float8_sincos_fast(float8_mul(p.x, float8_splat(100.0f)), &s, &c);
+        vec3x8_store_aos(out3 + i, vec3x8_normalize_fast(p));
+        for (int32_t k = 0; k < 8; ++k) {
+            vec3_t r = vec3_normalize_fast(v3[i + k]);
+            mismatches[7] += count_mismatches(out3[i + k].data, r.data, 3);
+            float expected[3];
+            expected[0] = scalar_rsqrt_fast(length_sq.data[k]);
+            scalar_sincos_fast(v3[i + k].x * 100.0f, &expected[1], &expected[2]);
+            mismatches[7] += count_mismatches(&rsqrt.data[k], &expected[0], 1);
+            mismatches[7] += count_mismatches(&s.data[k], &expected[1], 1);
+            mismatches[7] += count_mismatches(&c.data[k], &expected[2], 1);
+        }
+    }
+
+    // Inverse: distances in ULP of the largest element of each column, between
+    // the two paths and from each path to the double precision inverse
+    double max_ulp = 0.0;
+    double max_ulp_exact = 0.0;
+    double max_ulp_exact_scalar = 0.0;
+    for (int32_t i = 0; i < VEC_MATH_CHECK_COUNT; ++i) {
+        mat4_t inv = mat4_inverse(a[i]);
+        mat4_t inv_scalar = mat4_inverse_scalar(a[i]);
+        double exact[16];
+        inverse_double(&a[i], exact);
+        for (int32_t c = 0; c < 4; ++c) {
+            float largest = 0.0f;
+            for (int32_t r = 0; r < 4; ++r) {
+                largest = fmaxf(largest, fabsf((float)exact[4 * c + r]));
+            }
+            double ulp = (double)(nextafterf(largest, INFINITY) - largest);
+            for (int32_t r = 0; r < 4; ++r) {
+                int32_t k = 4 * c + r;
+                max_ulp = fmax(max_ulp, fabs((double)inv.data[k] - (double)inv_scalar.data[k]) / ulp);
+                max_ulp_exact = fmax(max_ulp_exact, fabs((double)inv.data[k] - exact[k]) / ulp);
+                max_ulp_exact_scalar = fmax(max_ulp_exact_scalar, fabs((double)inv_scalar.data[k] - exact[k]) / ulp);
+            }
+        }
+    }
+
+    printf("vec_math %s backend, %d random inputs\n", backend, VEC_MATH_CHECK_COUNT);
+    const char* names[8] = { "mat4_mul", "mat4_vec4_mul", "mat4_vec3_mul", "mat4_transpose", "vec4 element-wise", "mat4 element-wise", "batches", "wide vectors" };
+    int32_t failed = 0;
+    for (int32_t k = 0; k < 8; ++k) {
+        printf("  %-20s %s (%d mismatches)\n", names[k], mismatches[k] ? "FAIL" : "bit exact", mismatches[k]);
+        failed |= mismatches[k] != 0;
+    }
+    failed |= !(max_ulp <= VEC_MATH_CHECK_INVERSE_ULP);
+    printf("  %-20s %s (max %.1f ULP of the column maximum, bound %.0f; from the exact inverse %.1f, scalar %.1f)\n",
+           "mat4_inverse", max_ulp <= VEC_MATH_CHECK_INVERSE_ULP ? "ok" : "FAIL", max_ulp,
+           (double)VEC_MATH_CHECK_INVERSE_ULP, max_ulp_exact, max_ulp_exact_scalar);
+
+    // Best of VEC_MATH_CHECK_RUNS passes over the timed inputs, nanoseconds per
+    // call. Both sides are called through a volatile function pointer with the
+    // same signature, so they pay the same out-of-line call and by-value
+    // argument copies, and neither is inlined into or vectorized across the
+    // timing loop. The sides alternate within a run so clock changes hit both.
+    double best[8];
+    for (int32_t k = 0; k < 8; ++k) {
+        best[k] = 1e30;
+    }
+    for (int32_t run = 0; run < VEC_MATH_CHECK_RUNS; ++run) {
+        for (int32_t side = 0; side < 2; ++side) {
+            Mat4Binary volatile mul = side ? mat4_mul_scalar : mat4_mul;
+            Mat4Vec4 volatile mul4 = side ? mat4_vec4_mul_scalar : mat4_vec4_mul;
+            Mat4Unary volatile inverse = side ? mat4_inverse_scalar : mat4_inverse;
+            PointsKernel volatile points = side ? points_scalar : points_batch;
+            double t[5];
+            t[0] = now_seconds();
+            for (int32_t i = 0; i < VEC_MATH_CHECK_TIMED; ++i) {
+                out[i] = mul(a[i], b[i]);
+            }
+            t[1] = now_seconds();
+            for (int32_t i = 0; i < VEC_MATH_CHECK_TIMED; ++i) {
+                out4[i] = mul4(a[i], v[i]);
+            }
+            t[2] = now_seconds();
+            for (int32_t i = 0; i < VEC_MATH_CHECK_TIMED; ++i) {
+                out[i] = inverse(a[i]);
+            }
+            t[3] = now_seconds();
+            for (int32_t i = 0; i < VEC_MATH_CHECK_TIMED; i += VEC_MATH_CHECK_BLOCK) {
+                points(a[0], v3 + i, out3 + i, VEC_MATH_CHECK_BLOCK);
+            }
+            t[4] = now_seconds();
+            for (int32_t k = 0; k < 4; ++k) {
+                best[2 * k + side] = t[k + 1] - t[k] < best[2 * k + side] ? t[k + 1] - t[k] : best[2 * k + side];
+            }
+        }
+    }
+    printf("%-16s %10s %10s %8s\n", "ns per call", backend, "scalar", "speedup");
+    const char* timed[4] = { "mat4_mul", "mat4_vec4_mul", "mat4_inverse", "points batch" };
+    for (int32_t k = 0; k < 4; ++k) {
+        double simd = best[2 * k] * 1e9 / VEC_MATH_CHECK_TIMED;
+        double scalar = best[2 * k + 1] * 1e9 / VEC_MATH_CHECK_TIMED;
+        printf("%-16s %10.2f %10.2f %7.2fx\n", timed[k], simd, scalar, scalar / simd);
+    }
+    printf("(checksum %g %g %g)\n", (double)out4[VEC_MATH_CHECK_TIMED / 2].w, (double)out[VEC_MATH_CHECK_TIMED / 2].data[5],
+           (double)out3[VEC_MATH_CHECK_TIMED / 2].y);
+
+    free(a);
+    free(b);
+    free(out);
+    free(v);
+    free(out4);
+    free(v3);
+    free(out3);
+    return failed ? EXIT_FAILURE : 0;
+}
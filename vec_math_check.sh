@@ -0,0 +1,5 @@
+gcc vec_math_check.c -Wall -std=c11 -O2 -fno-ipa-icf -o vec_math_check_sse2.out -lm
+gcc vec_math_check.c -Wall -std=c11 -O2 -fno-ipa-icf -mavx2 -mfma -o vec_math_check_avx.out -lm
+gcc vec_math_check.c -Wall -std=c11 -O2 -fno-ipa-icf -DVEC_MATH_NO_SIMD -o vec_math_check_scalar.out -lm
+
+./vec_math_check_scalar.out && ./vec_math_check_sse2.out && ./vec_math_check_avx.out
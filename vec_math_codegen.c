@@ -0,0 +1,100 @@
+// Cost of the by-value mat4 interface against the pointer variants on the
+// transform chain the renderer runs per instance: mvp = projection * view *
+// translation * model and its inverse for picking. vec_math.h is compiled in
+// its own translation unit here (the library is normally used that way), so
+// the by-value calls do not inline and every product copies its arguments
+// and result through the stack, while the static inline pointer variants fold
+// into the loop. Both chains must agree bit for bit. vec_math_codegen.sh also
+// counts the instructions and stack accesses of the two loops.
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "libs/vec_math.h"
+
+#define VEC_MATH_CODEGEN_COUNT 1024
+#define VEC_MATH_CODEGEN_RUNS 2000
+
+typedef struct Chain {
+    mat4_t projection;
+    mat4_t view;
+    mat4_t model;
+    const mat4_t* translations;
+    mat4_t* mvp;
+    mat4_t* inverse_mvp;
+    int32_t count;
+} Chain;
+
+__attribute__((noinline)) void chain_by_value(Chain* chain) {
+    for (int32_t i = 0; i < chain->count; ++i) {
+        chain->mvp[i] = mat4_mul(chain->projection, mat4_mul(chain->view, mat4_mul(chain->translations[i], chain->model)));
+        chain->inverse_mvp[i] = mat4_inverse(chain->mvp[i]);
+    }
+}
+
+__attribute__((noinline)) void chain_pointer(Chain* chain) {
+    for (int32_t i = 0; i < chain->count; ++i) {
+        mat4_t instance, eye;
+        mat4_mul_ptr(&chain->translations[i], &chain->model, &instance);
+        mat4_mul_ptr(&chain->view, &instance, &eye);
+        mat4_mul_ptr(&chain->projection, &eye, &chain->mvp[i]);
+        mat4_inverse_ptr(&chain->mvp[i], &chain->inverse_mvp[i]);
+    }
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int32_t main(void) {
+    mat4_t* translations = (mat4_t*)malloc(VEC_MATH_CODEGEN_COUNT * sizeof(mat4_t));
+    mat4_t* mvp = (mat4_t*)malloc(2 * VEC_MATH_CODEGEN_COUNT * sizeof(mat4_t));
+    mat4_t* inverse_mvp = (mat4_t*)malloc(2 * VEC_MATH_CODEGEN_COUNT * sizeof(mat4_t));
+    if (!translations || !mvp || !inverse_mvp) {
+        return EXIT_FAILURE;
+    }
+    for (int32_t i = 0; i < VEC_MATH_CODEGEN_COUNT; ++i) {
+        translations[i] = mat4_make_translation(vec3((float)(i % 32) - 16.0f, 0.0f, (float)(i / 32) - 16.0f));
+    }
+    Chain chain;
+    chain.projection = perspective(deg2rad(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    chain.view = look_at(vec3(0.0f, 0.0f, 3.0f), vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f));
+    chain.model = mat4_mul(mat4_make_rotation(vec3(1.0f, 0.0f, 0.0f), 0.7f), mat4_diag(0.4f));
+    chain.model.data[15] = 1.0f;
+    chain.translations = translations;
+    chain.count = VEC_MATH_CODEGEN_COUNT;
+
+    double best[2] = { 1e30, 1e30 };
+    for (int32_t run = 0; run < VEC_MATH_CODEGEN_RUNS; ++run) {
+        for (int32_t k = 0; k < 2; ++k) {
+            chain.mvp = mvp + k * VEC_MATH_CODEGEN_COUNT;
+            chain.inverse_mvp = inverse_mvp + k * VEC_MATH_CODEGEN_COUNT;
+            double start = now_seconds();
+            if (k == 0) {
+                chain_by_value(&chain);
+            } else {
+                chain_pointer(&chain);
+            }
+            double elapsed = now_seconds() - start;
+            best[k] = elapsed < best[k] ? elapsed : best[k];
+        }
+    }
+    int32_t same = memcmp(mvp, mvp + VEC_MATH_CODEGEN_COUNT, VEC_MATH_CODEGEN_COUNT * sizeof(mat4_t)) == 0 &&
+                   memcmp(inverse_mvp, inverse_mvp + VEC_MATH_CODEGEN_COUNT, VEC_MATH_CODEGEN_COUNT * sizeof(mat4_t)) == 0;
+
+    printf("mvp and inverse of %d instances, ns per instance (best of %d)\n", VEC_MATH_CODEGEN_COUNT, VEC_MATH_CODEGEN_RUNS);
+    printf("  by value %8.2f\n", best[0] * 1e9 / VEC_MATH_CODEGEN_COUNT);
+    printf("  pointer  %8.2f (%.2fx)\n", best[1] * 1e9 / VEC_MATH_CODEGEN_COUNT, best[0] / best[1]);
+    printf("  results %s\n", same ? "bit exact" : "DIFFER");
+
+    free(translations);
+    free(mvp);
+    free(inverse_mvp);
+    return same ? 0 : EXIT_FAILURE;
+}
@@ -0,0 +1,25 @@
+printf '#define _VEC_MATH_IMPLEMENTATION_\n#include <stdint.h>\n#include <stdio.h>\n#include "libs/vec_math.h"\n' > vec_math_codegen_impl.c
+
+for target in sse2 avx; do
+    flags="-Wall -std=c11 -O2"
+    [ "$target" = avx ] && flags="$flags -mavx2 -mfma"
+    gcc $flags -c vec_math_codegen_impl.c -o vec_math_codegen_impl_$target.o
+    gcc $flags -S vec_math_codegen.c -o vec_math_codegen_$target.s
+    gcc $flags vec_math_codegen.c vec_math_codegen_impl_$target.o -o vec_math_codegen_$target.out -lm
+
+    # Instructions, stack accesses and calls in each chain function
+    echo "$target"
+    for fn in chain_by_value chain_pointer; do
+        awk -v fn="$fn" '
+            $0 == fn ":" { inside = 1; next }
+            inside && /\.cfi_endproc/ { inside = 0 }
+            inside && /^\t[a-z]/ && !/^\t\./ {
+                instructions++
+                if (/\(%rsp\)|\(%rbp\)/) stack++
+                if (/^\tcall/) calls++
+            }
+            END { printf "  %-15s %4d instructions, %3d stack accesses, %d calls\n", fn, instructions, stack, calls }
+        ' vec_math_codegen_$target.s
+    done
+    ./vec_math_codegen_$target.out || exit 1
+done
@@ -0,0 +1,236 @@
+// Error and speed of the fast approximations of vec_math.h against the libm based functions.
+// Errors are the largest over VEC_MATH_FAST_SAMPLES inputs against double precision, in ULP of
+// the reference and absolute; timings are nanoseconds per element over VEC_MATH_FAST_COUNT
+// elements (best of VEC_MATH_FAST_RUNS). The table in the FAST APPROXIMATIONS section of
+// vec_math.h comes from this program (see vec_math_fast_bench.sh).
+#define _POSIX_C_SOURCE 199309L
+#define _VEC_MATH_IMPLEMENTATION_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "libs/vec_math.h"
+
+#define VEC_MATH_FAST_SAMPLES (1 << 24)
+#define VEC_MATH_FAST_COUNT 4096
+#define VEC_MATH_FAST_RUNS 200
+
+typedef struct FastData {
+    float* x;
+    float* sin;
+    float* cos;
+    vec3_t* v;
+    vec3_t* out3;
+    mat4_t* out;
+} FastData;
+
+typedef void (*FastKernel)(FastData* data);
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Uniform in [0, 1) from a 64-bit LCG, reproducible on every platform
+static double random_unit(uint64_t* state) {
+    *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+    return (double)(*state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Distance of `value` from the exact `reference` in units of the float spacing at the reference
+static double ulp_error(float value, double reference) {
+    float r = fabsf((float)reference);
+    double ulp = (double)(nextafterf(r, INFINITY) - r);
+    return fabs((double)value - reference) / ulp;
+}
+
+static void sincos_libm(FastData* d) {
+    for (int32_t i = 0; i < VEC_MATH_FAST_COUNT; ++i) {
+        d->sin[i] = sinf(d->x[i]);
+        d->cos[i] = cosf(d->x[i]);
+    }
+}
+
+static void sincos_fast(FastData* d) {
+    for (int32_t i = 0; i < VEC_MATH_FAST_COUNT; ++i) {
+        scalar_sincos_fast(d->x[i], &d->sin[i], &d->cos[i]);
+    }
+}
+
+static void sincos_batch_fast(FastData* d) {
+    scalar_sincos_batch_fast(d->x, d->sin, d->cos, VEC_MATH_FAST_COUNT);
+}
+
+static void normalize_libm(FastData* d) {
+    for (int32_t i = 0; i < VEC_MATH_FAST_COUNT; ++i) {
+        d->out3[i] = vec3_normalize(d->v[i]);
+    }
+}
+
+static void normalize_fast(FastData* d) {
+    for (int32_t i = 0; i < VEC_MATH_FAST_COUNT; ++i) {
+        d->out3[i] = vec3_normalize_fast(d->v[i]);
+    }
+}
+
+static void normalize_batch(FastData* d) {
+    vec3_normalize_batch(d->v, d->out3, VEC_MATH_FAST_COUNT);
+}
+
+static void normalize_batch_fast(FastData* d) {
+    vec3_normalize_batch_fast(d->v, d->out3, VEC_MATH_FAST_COUNT);
+}
+
+static void rotation_libm(FastData* d) {
+    for (int32_t i = 0; i < VEC_MATH_FAST_COUNT; ++i) {
+        d->out[i] = mat4_make_rotation(d->v[i], d->x[i]);
+    }
+}
+
+static void rotation_fast(FastData* d) {
+    for (int32_t i = 0; i < VEC_MATH_FAST_COUNT; ++i) {
+        d->out[i] = mat4_make_rotation_fast(d->v[i], d->x[i]);
+    }
+}
+
+static void perspective_libm(FastData* d) {
+    for (int32_t i = 0; i < VEC_MATH_FAST_COUNT; ++i) {
+        d->out[i] = perspective(d->sin[i], 4.0f / 3.0f, 0.1f, 100.0f);
+    }
+}
+
+static void perspective_fast_kernel(FastData* d) {
+    for (int32_t i = 0; i < VEC_MATH_FAST_COUNT; ++i) {
+        d->out[i] = perspective_fast(d->sin[i], 4.0f / 3.0f, 0.1f, 100.0f);
+    }
+}
+
+static double bench(FastKernel kernel, FastData* data) {
+    double best = 1e30;
+    for (int32_t run = 0; run < VEC_MATH_FAST_RUNS; ++run) {
+        double start = now_seconds();
+        kernel(data);
+        double elapsed = now_seconds() - start;
+        best = elapsed < best ? elapsed : best;
+    }
+    return best * 1e9 / VEC_MATH_FAST_COUNT;
+}
+
+int main(void) {
+#if defined(VEC_MATH_SIMD_AVX)
+    const char* backend = "AVX";
+#elif defined(VEC_MATH_SIMD_SSE2)
+    const char* backend = "SSE2";
+#elif defined(VEC_MATH_SIMD_NEON)
+    const char* backend = "NEON";
+#else
+    const char* backend = "scalar";
+#endif
+    printf("vec_math %s backend, errors over %d inputs\n", backend, VEC_MATH_FAST_SAMPLES);
+
+    // rsqrt, log-uniform over [1e-30, 1e30]
+    uint64_t state = 1;
+    double rsqrt_ulp = 0.0;
+    for (int32_t i = 0; i < VEC_MATH_FAST_SAMPLES; ++i) {
+        float x = (float)pow(10.0, -30.0 + 60.0 * random_unit(&state));
+        rsqrt_ulp = fmax(rsqrt_ulp, ulp_error(scalar_rsqrt_fast(x), 1.0 / sqrt((double)x)));
+    }
+    printf("  %-20s %-20s %8.2f ULP\n", "scalar_rsqrt_fast", "[1e-30, 1e30]", rsqrt_ulp);
+
+    // sincos, both outputs, in ULP and absolute
+    const float ranges[2] = { 100.0f, 8192.0f };
+    for (int32_t k = 0; k < 2; ++k) {
+        double max_ulp = 0.0;
+        double max_abs = 0.0;
+        for (int32_t i = 0; i < VEC_MATH_FAST_SAMPLES; ++i) {
+            float x = (float)((2.0 * random_unit(&state) - 1.0) * ranges[k]);
+            float s, c;
+            scalar_sincos_fast(x, &s, &c);
+            double rs = sin((double)x);
+            double rc = cos((double)x);
+            max_ulp = fmax(max_ulp, fmax(ulp_error(s, rs), ulp_error(c, rc)));
+            max_abs = fmax(max_abs, fmax(fabs((double)s - rs), fabs((double)c - rc)));
+        }
+        char range[32];
+        snprintf(range, sizeof(range), "|x| <= %g", (double)ranges[k]);
+        printf("  %-20s %-20s %8.2f ULP, %.2e absolute\n", "scalar_sincos_fast", range, max_ulp, max_abs);
+    }
+
+    // normalize, the length of the result and its components
+    double length_error = 0.0;
+    double component_ulp = 0.0;
+    for (int32_t i = 0; i < VEC_MATH_FAST_SAMPLES; ++i) {
+        double p[3];
+        for (int32_t c = 0; c < 3; ++c) {
+            p[c] = (2.0 * random_unit(&state) - 1.0) * pow(10.0, -3.0 + 6.0 * random_unit(&state));
+        }
+        vec3_t v = vec3((float)p[0], (float)p[1], (float)p[2]);
+        vec3_t n = vec3_normalize_fast(v);
+        double length = sqrt((double)v.x * v.x + (double)v.y * v.y + (double)v.z * v.z);
+        double n_length = sqrt((double)n.x * n.x + (double)n.y * n.y + (double)n.z * n.z);
+        length_error = fmax(length_error, fabs(n_length - 1.0));
+        for (int32_t c = 0; c < 3; ++c) {
+            component_ulp = fmax(component_ulp, ulp_error(n.data[c], (double)v.data[c] / length));
+        }
+    }
+    printf("  %-20s %-20s %8.2f ULP, length off by %.2e\n", "vec3_normalize_fast", "|v| in [1e-3, 1e3]", component_ulp, length_error);
+
+    // Timings
+    FastData data;
+    data.x = (float*)malloc(VEC_MATH_FAST_COUNT * sizeof(float));
+    data.sin = (float*)malloc(VEC_MATH_FAST_COUNT * sizeof(float));
+    data.cos = (float*)malloc(VEC_MATH_FAST_COUNT * sizeof(float));
+    data.v = (vec3_t*)malloc(VEC_MATH_FAST_COUNT * sizeof(vec3_t));
+    data.out3 = (vec3_t*)malloc(VEC_MATH_FAST_COUNT * sizeof(vec3_t));
+    data.out = (mat4_t*)malloc(VEC_MATH_FAST_COUNT * sizeof(mat4_t));
+    if (!data.x || !data.sin || !data.cos || !data.v || !data.out3 || !data.out) {
+        fprintf(stderr, "Failed to allocate the inputs\n");
+        return EXIT_FAILURE;
+    }
+    for (int32_t i = 0; i < VEC_MATH_FAST_COUNT; ++i) {
+        data.x[i] = (float)((2.0 * random_unit(&state) - 1.0) * 2.0 * PI);
+        data.v[i] = vec3((float)random_unit(&state) - 0.5f, (float)random_unit(&state) - 0.5f, (float)random_unit(&state) + 0.1f);
+    }
+
+    const struct {
+        const char* name;
+        FastKernel exact;
+        FastKernel fast;
+        FastKernel batch;
+    } cases[4] = {
+        { "sincos", sincos_libm, sincos_fast, sincos_batch_fast },
+        { "vec3_normalize", normalize_libm, normalize_fast, normalize_batch_fast },
+        { "mat4_make_rotation", rotation_libm, rotation_fast, NULL },
+        { "perspective", perspective_libm, perspective_fast_kernel, NULL },
+    };
+    printf("ns per element (best of %d)   libm      fast     fast batch\n", VEC_MATH_FAST_RUNS);
+    for (int32_t c = 0; c < 4; ++c) {
+        if (c == 3) {
+            // Field of view angles for the perspectives
+            for (int32_t i = 0; i < VEC_MATH_FAST_COUNT; ++i) {
+                data.sin[i] = 0.5f + 0.25f * fabsf(data.x[i]);
+            }
+        }
+        double exact = bench(cases[c].exact, &data);
+        double fast = bench(cases[c].fast, &data);
+        printf("  %-24s %9.2f %9.2f (%.2fx)", cases[c].name, exact, fast, exact / fast);
+        if (cases[c].batch) {
+            double batch = bench(cases[c].batch, &data);
+            printf(" %9.2f (%.2fx)", batch, exact / batch);
+        }
+        printf("\n");
+    }
+    printf("  %-24s %9.2f\n", "vec3_normalize_batch", bench(normalize_batch, &data));
+
+    free(data.x);
+    free(data.sin);
+    free(data.cos);
+    free(data.v);
+    free(data.out3);
+    free(data.out);
+    return 0;
+}
@@ -0,0 +1,7 @@
+gcc vec_math_fast_bench.c -Wall -std=c11 -O2 -DVEC_MATH_NO_SIMD -o vec_math_fast_bench_scalar.out -lm -lrt
+gcc vec_math_fast_bench.c -Wall -std=c11 -O2 -o vec_math_fast_bench_sse2.out -lm -lrt
+gcc vec_math_fast_bench.c -Wall -std=c11 -O2 -mavx2 -mfma -o vec_math_fast_bench_avx.out -lm -lrt
+
+./vec_math_fast_bench_scalar.out
+./vec_math_fast_bench_sse2.out
+./vec_math_fast_bench_avx.out
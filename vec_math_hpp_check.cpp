@@ -0,0 +1,145 @@
+// Checks of the vec_math.hpp expression templates: every operator against the
+// C function it stands for, bit for bit, including the products that write
+// into one of their operands, and a fused expression over an array of mat4
+// against the same loop written with the SIMD helpers of vec_math.h and with
+// the C functions. vec_math_hpp_check.sh also counts the instructions of the
+// three loops, the expression and the hand-written one should compile to the
+// same code.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define _VEC_MATH_IMPLEMENTATION_
+#include "libs/vec_math.h"
+#include "libs/vec_math.hpp"
+
+#define VEC_MATH_HPP_CHECK_COUNT 256
+
+namespace vm = vec_math;
+
+// out = a * s + b - a over arrays of matrices, three ways
+extern "C" __attribute__((noinline)) void blend_expression(mat4_t* out, const mat4_t* a, const mat4_t* b, float s, int32_t count) {
+    for (int32_t i = 0; i < count; ++i) {
+        vm::wrap(out[i]) = vm::wrap(a[i]) * s + vm::wrap(b[i]) - vm::wrap(a[i]);
+    }
+}
+
+extern "C" __attribute__((noinline)) void blend_hand(mat4_t* out, const mat4_t* a, const mat4_t* b, float s, int32_t count) {
+    for (int32_t i = 0; i < count; ++i) {
+#if defined(VEC_MATH__SIMD4)
+        vec_math__v4 k = vec_math__splat(s);
+        for (int32_t j = 0; j < 16; j += 4) {
+            vec_math__v4 x = vec_math__load(a[i].data + j);
+            vec_math__store(out[i].data + j, vec_math__sub(vec_math__add(vec_math__mul(x, k), vec_math__load(b[i].data + j)), x));
+        }
+#else
+        for (int32_t j = 0; j < 16; ++j) {
+            out[i].data[j] = a[i].data[j] * s + b[i].data[j] - a[i].data[j];
+        }
+#endif
+    }
+}
+
+extern "C" __attribute__((noinline)) void blend_c(mat4_t* out, const mat4_t* a, const mat4_t* b, float s, int32_t count) {
+    for (int32_t i = 0; i < count; ++i) {
+        out[i] = mat4_sub(mat4_add(mat4_scalar_mul(a[i], s), b[i]), a[i]);
+    }
+}
+
+static int32_t differs(const void* a, const void* b, size_t size) {
+    return memcmp(a, b, size) != 0;
+}
+
+int32_t main(void) {
+    vec3_t a3 = vec3(1.1f, 2.3f, -0.7f);
+    vec3_t b3 = vec3(0.3f, -4.1f, 2.2f);
+    vec4_t a4 = vec4(1.1f, 2.3f, -0.7f, 0.9f);
+    vec4_t b4 = vec4(0.3f, -4.1f, 2.2f, 1.7f);
+    mat4_t ma = mat4_mul(perspective(0.9f, 1.3f, 0.1f, 20.0f), look_at(vec3(1.0f, 2.0f, 3.0f), vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f)));
+    mat4_t mb = mat4_make_rotation(vec3_normalize(vec3(1.0f, 1.0f, 0.0f)), 0.7f);
+    vm::vec3 x = a3, y = b3;
+    vm::vec4 p = a4, q = b4;
+    vm::mat4 wa = ma, wb = mb;
+    int32_t mismatches = 0;
+
+    // Element-wise expressions
+    vm::vec3 r3 = x * 2.5f + y;
+    vec3_t c3 = vec3_add(vec3_scalar_mul(a3, 2.5f), b3);
+    mismatches += differs(&r3, &c3, sizeof(c3));
+    vm::vec4 r4 = (p - q) / 3.0f;
+    vec4_t c4 = vec4_scalar_div(vec4_sub(a4, b4), 3.0f);
+    mismatches += differs(&r4, &c4, sizeof(c4));
+    vm::wrap(c4) = -vm::wrap(c4) * p;
+    r4 = vec4_mul(vec4_scalar_mul(r4, -1.0f), a4);
+    mismatches += differs(&r4, &c4, sizeof(c4));
+    x += y;
+    c3 = vec3_add(a3, b3);
+    mismatches += differs(&x, &c3, sizeof(c3));
+
+    // Products, written into a distinct matrix and into either operand
+    vm::mat4 m = wa * wb;
+    mat4_t cm = mat4_mul(ma, mb);
+    mismatches += differs(&m, &cm, sizeof(cm));
+    m = m * wb;
+    cm = mat4_mul(cm, mb);
+    mismatches += differs(&m, &cm, sizeof(cm));
+    m = wa * m;
+    cm = mat4_mul(ma, cm);
+    mismatches += differs(&m, &cm, sizeof(cm));
+    m = m * m;
+    cm = mat4_mul(cm, cm);
+    mismatches += differs(&m, &cm, sizeof(cm));
+    m = wa * wb + wa * 0.5f;
+    cm = mat4_add(mat4_mul(ma, mb), mat4_scalar_mul(ma, 0.5f));
+    mismatches += differs(&m, &cm, sizeof(cm));
+    vm::vec4 v = wa * (p + q);
+    vec4_t cv = mat4_vec4_mul(ma, vec4_add(a4, b4));
+    mismatches += differs(&v, &cv, sizeof(cv));
+    v = wa * v;
+    cv = mat4_vec4_mul(ma, cv);
+    mismatches += differs(&v, &cv, sizeof(cv));
+
+    // Whole-operand operations
+    vm::vec3 n = vm::normalize(vm::cross(x, y));
+    vec3_t cn = vec3_normalize(vec3_cross(c3, b3));
+    mismatches += differs(&n, &cn, sizeof(cn));
+    mismatches += vm::dot(x + y, y) != vec3_dot(vec3_add(c3, b3), b3);
+    m = vm::inverse(wa * wb);
+    cm = mat4_inverse(mat4_mul(ma, mb));
+    mismatches += differs(&m, &cm, sizeof(cm));
+    m = vm::transpose(wa - wb);
+    cm = mat4_transpose(mat4_sub(ma, mb));
+    mismatches += differs(&m, &cm, sizeof(cm));
+    vm::vec3 t = vm::transform_point(wa, x - y);
+    vec3_t ct = mat4_vec3_mul(ma, vec3_sub(c3, b3), 1);
+    mismatches += differs(&t, &ct, sizeof(ct));
+
+    // The array loops
+    mat4_t* mats = (mat4_t*)malloc(5 * VEC_MATH_HPP_CHECK_COUNT * sizeof(mat4_t));
+    if (!mats) {
+        return EXIT_FAILURE;
+    }
+    mat4_t* a = mats;
+    mat4_t* b = mats + VEC_MATH_HPP_CHECK_COUNT;
+    for (int32_t i = 0; i < VEC_MATH_HPP_CHECK_COUNT; ++i) {
+        a[i] = mat4_mul(ma, mat4_make_translation(vec3((float)i, 0.5f, -0.25f * (float)i)));
+        b[i] = mat4_mul(mb, mat4_make_rotation(vec3(0.0f, 1.0f, 0.0f), 0.01f * (float)i));
+    }
+    for (int32_t k = 0; k < 3; ++k) {
+        mat4_t* out = mats + (2 + k) * VEC_MATH_HPP_CHECK_COUNT;
+        if (k == 0) {
+            blend_expression(out, a, b, 0.3f, VEC_MATH_HPP_CHECK_COUNT);
+        } else if (k == 1) {
+            blend_hand(out, a, b, 0.3f, VEC_MATH_HPP_CHECK_COUNT);
+        } else {
+            blend_c(out, a, b, 0.3f, VEC_MATH_HPP_CHECK_COUNT);
+        }
+    }
+    mismatches += differs(mats + 2 * VEC_MATH_HPP_CHECK_COUNT, mats + 3 * VEC_MATH_HPP_CHECK_COUNT, VEC_MATH_HPP_CHECK_COUNT * sizeof(mat4_t));
+    mismatches += differs(mats + 2 * VEC_MATH_HPP_CHECK_COUNT, mats + 4 * VEC_MATH_HPP_CHECK_COUNT, VEC_MATH_HPP_CHECK_COUNT * sizeof(mat4_t));
+    free(mats);
+
+    printf("  %d mismatches against the C functions\n", mismatches);
+    return mismatches == 0 ? 0 : EXIT_FAILURE;
+}
@@ -0,0 +1,19 @@
+for target in scalar sse2 avx; do
+    flags="-Wall -std=c++11 -O2 -ffp-contract=off"
+    [ "$target" = scalar ] && flags="$flags -DVEC_MATH_NO_SIMD"
+    [ "$target" = avx ] && flags="$flags -mavx2 -mfma"
+    g++ $flags -S vec_math_hpp_check.cpp -o vec_math_hpp_check_$target.s
+    g++ $flags vec_math_hpp_check.cpp -o vec_math_hpp_check_$target.out -lm
+
+    # Instructions in each loop, the expression matching the hand-written one
+    echo "$target"
+    for fn in blend_expression blend_hand blend_c; do
+        awk -v fn="$fn" '
+            $0 == fn ":" { inside = 1; next }
+            inside && /\.cfi_endproc/ { inside = 0 }
+            inside && /^\t[a-z]/ && !/^\t\./ { instructions++ }
+            END { printf "  %-17s %4d instructions\n", fn, instructions }
+        ' vec_math_hpp_check_$target.s
+    done
+    ./vec_math_hpp_check_$target.out || exit 1
+done
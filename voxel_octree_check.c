@@ -0,0 +1,313 @@
+// Agreement and speed of the voxelizer and octree of voxel_octree.h. Every cell of a 64^3 build
+// is looked up with svo_find and compared with a brute force separating axis test of each
+// triangle against every voxel around its bounds (box normals, triangle normal and the nine edge
+// cross products, in double precision): a voxel the triangle overlaps by more than
+// VOXEL_CHECK_BAND voxels has to be occupied, a voxel it misses by more than that has to be
+// empty, voxels inside the band may go either way. Every inner level has to hold exactly the
+// parents of the level below. The timing builds 512^3 and 1024^3 octrees of bumpy tori with
+// 360k triangles and with 360k vertices and reports the best of VOXEL_CHECK_RUNS builds.
+// Exits with EXIT_FAILURE on any mismatch. See voxel_octree_check.sh.
+#define _POSIX_C_SOURCE 199309L
+#define _VEC_MATH_IMPLEMENTATION_
+#define _MESH_IMPLEMENTATION_
+#define _PARALLEL_IMPLEMENTATION_
+#define _VOXEL_OCTREE_IMPLEMENTATION_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "libs/vec_math.h"
+#include "libs/mesh.h"
+#include "libs/parallel.h"
+#include "libs/voxel_octree.h"
+
+#define VOXEL_CHECK_DEPTH 6
+#define VOXEL_CHECK_BAND 1e-3
+// Random triangles added to the small torus of the check
+#define VOXEL_CHECK_RANDOM 3000
+#define VOXEL_CHECK_RUNS 3
+
+typedef struct CheckVertex {
+    vec3_t position;
+    vec3_t normal;
+} CheckVertex;
+
+static uint32_t rng_state = 0x1B873593u;
+
+static float random_float(float lo, float hi) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return lo + (hi - lo) * (float)(rng_state >> 8) * (1.0f / 16777216.0f);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void mesh_init(MeshData* mesh, CheckVertex* vertices, int32_t vertex_count, uint32_t* triangles,
+                      int32_t triangle_count) {
+    memset(mesh, 0, sizeof(*mesh));
+    mesh->vertex_count = vertex_count;
+    mesh->triangle_count = triangle_count;
+    mesh->vertex_data = (float*)vertices;
+    mesh->triangles = triangles;
+    mesh->vertex_size = (int32_t)sizeof(CheckVertex);
+    mesh->positions_size = 3 * sizeof(float);
+    mesh->positions_offset = 0;
+    mesh->normals_size = 3 * sizeof(float);
+    mesh->normals_offset = 3 * sizeof(float);
+}
+
+// Torus around the z axis with a ripple on the tube, rings x sides vertices
+static void bumpy_torus(CheckVertex* vertices, uint32_t* triangles, int32_t rings, int32_t sides) {
+    for (int32_t i = 0; i < rings; ++i) {
+        for (int32_t j = 0; j < sides; ++j) {
+            float u = 2.0f * PI * (float)i / (float)rings;
+            float v = 2.0f * PI * (float)j / (float)sides;
+            float tube = 0.3f + 0.02f * sinf(7.0f * u) * cosf(5.0f * v);
+            vec3_t normal = vec3(cosf(u) * cosf(v), sinf(u) * cosf(v), sinf(v));
+            CheckVertex* vertex = &vertices[i * sides + j];
+            vertex->position = vec3((1.0f + tube * cosf(v)) * cosf(u), (1.0f + tube * cosf(v)) * sinf(u), tube * sinf(v));
+            vertex->normal = normal;
+        }
+    }
+    for (int32_t i = 0; i < rings; ++i) {
+        for (int32_t j = 0; j < sides; ++j) {
+            uint32_t a = (uint32_t)(i * sides + j);
+            uint32_t b = (uint32_t)(((i + 1) % rings) * sides + j);
+            uint32_t c = (uint32_t)(((i + 1) % rings) * sides + (j + 1) % sides);
+            uint32_t d = (uint32_t)(i * sides + (j + 1) % sides);
+            uint32_t* out = &triangles[6 * (i * sides + j)];
+            out[0] = a;
+            out[1] = b;
+            out[2] = c;
+            out[3] = a;
+            out[4] = c;
+            out[5] = d;
+        }
+    }
+}
+
+// Projections of the triangle onto `axis` against the box radius along it
+static int32_t separated(const double v[3][3], const double axis[3], double half) {
+    double p0 = v[0][0] * axis[0] + v[0][1] * axis[1] + v[0][2] * axis[2];
+    double p1 = v[1][0] * axis[0] + v[1][1] * axis[1] + v[1][2] * axis[2];
+    double p2 = v[2][0] * axis[0] + v[2][1] * axis[1] + v[2][2] * axis[2];
+    double lo = fmin(p0, fmin(p1, p2));
+    double hi = fmax(p0, fmax(p1, p2));
+    double r = half * (fabs(axis[0]) + fabs(axis[1]) + fabs(axis[2]));
+    return lo > r || hi < -r;
+}
+
+// Triangle `t` (grid space, voxel units) against the box of half size `half` around `center`
+static int32_t triangle_box_overlap(const double t[3][3], const double center[3], double half) {
+    double v[3][3];
+    for (int32_t c = 0; c < 3; ++c) {
+        for (int32_t k = 0; k < 3; ++k) {
+            v[c][k] = t[c][k] - center[k];
+        }
+    }
+    double e[3][3];
+    for (int32_t i = 0; i < 3; ++i) {
+        for (int32_t k = 0; k < 3; ++k) {
+            e[i][k] = v[(i + 1) % 3][k] - v[i][k];
+        }
+    }
+    for (int32_t k = 0; k < 3; ++k) {
+        double axis[3] = { 0.0, 0.0, 0.0 };
+        axis[k] = 1.0;
+        if (separated(v, axis, half)) {
+            return 0;
+        }
+    }
+    double normal[3] = { e[0][1] * e[1][2] - e[0][2] * e[1][1], e[0][2] * e[1][0] - e[0][0] * e[1][2],
+                         e[0][0] * e[1][1] - e[0][1] * e[1][0] };
+    if (separated(v, normal, half)) {
+        return 0;
+    }
+    for (int32_t i = 0; i < 3; ++i) {
+        for (int32_t k = 0; k < 3; ++k) {
+            double box[3] = { 0.0, 0.0, 0.0 };
+            box[k] = 1.0;
+            double axis[3] = { box[1] * e[i][2] - box[2] * e[i][1], box[2] * e[i][0] - box[0] * e[i][2],
+                               box[0] * e[i][1] - box[1] * e[i][0] };
+            if (separated(v, axis, half)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// Marks every voxel as 2 (must be occupied), 1 (within the band) or 0 (must be empty)
+static void brute_force(const MeshData* mesh, const VoxelOctree* octree, uint8_t* expected) {
+    const int32_t resolution = 1 << octree->depth;
+    const double h = octree->voxel_size;
+    const double origin[3] = { octree->min.x, octree->min.y, octree->min.z };
+    for (int32_t triangle = 0; triangle < mesh->triangle_count; ++triangle) {
+        double t[3][3];
+        int32_t lo[3];
+        int32_t hi[3];
+        for (int32_t c = 0; c < 3; ++c) {
+            const CheckVertex* vertex = (const CheckVertex*)mesh->vertex_data + mesh->triangles[3 * triangle + c];
+            for (int32_t k = 0; k < 3; ++k) {
+                t[c][k] = ((double)vertex->position.data[k] - origin[k]) / h;
+            }
+        }
+        // One voxel of margin around the bounds catches range errors of the voxelizer
+        for (int32_t k = 0; k < 3; ++k) {
+            lo[k] = (int32_t)floor(fmin(t[0][k], fmin(t[1][k], t[2][k]))) - 1;
+            hi[k] = (int32_t)floor(fmax(t[0][k], fmax(t[1][k], t[2][k]))) + 1;
+            lo[k] = lo[k] < 0 ? 0 : lo[k];
+            hi[k] = hi[k] >= resolution ? resolution - 1 : hi[k];
+        }
+        for (int32_t z = lo[2]; z <= hi[2]; ++z) {
+            for (int32_t y = lo[1]; y <= hi[1]; ++y) {
+                for (int32_t x = lo[0]; x <= hi[0]; ++x) {
+                    uint8_t* cell = &expected[((size_t)z * resolution + y) * resolution + x];
+                    if (*cell == 2) {
+                        continue;
+                    }
+                    const double center[3] = { x + 0.5, y + 0.5, z + 0.5 };
+                    if (triangle_box_overlap(t, center, 0.5 - VOXEL_CHECK_BAND)) {
+                        *cell = 2;
+                    } else if (triangle_box_overlap(t, center, 0.5 + VOXEL_CHECK_BAND)) {
+                        *cell = 1;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Returns the number of mismatching cells over every level
+static int64_t check_octree(const MeshData* mesh, const VoxelOctree* octree, int64_t* out_band) {
+    const int32_t depth = octree->depth;
+    const int32_t resolution = 1 << depth;
+    uint8_t* expected = (uint8_t*)calloc((size_t)resolution * resolution * resolution, 1);
+    if (!expected) {
+        return -1;
+    }
+    brute_force(mesh, octree, expected);
+
+    // Leaves against the brute force, inner levels against the leaves below them
+    int64_t mismatches = 0;
+    int64_t band = 0;
+    int64_t leaves = 0;
+    for (int32_t z = 0; z < resolution; ++z) {
+        for (int32_t y = 0; y < resolution; ++y) {
+            for (int32_t x = 0; x < resolution; ++x) {
+                const uint8_t want = expected[((size_t)z * resolution + y) * resolution + x];
+                const int32_t occupied = svo_find(octree, depth, x, y, z) >= 0;
+                band += want == 1;
+                leaves += occupied;
+                mismatches += (want == 2 && !occupied) || (want == 0 && occupied);
+            }
+        }
+    }
+    mismatches += leaves != octree->levels[depth].node_count;
+    for (int32_t level = depth - 1; level >= 0; --level) {
+        const int32_t cells = 1 << level;
+        const int32_t span = resolution / cells;
+        int64_t nodes = 0;
+        for (int32_t z = 0; z < cells; ++z) {
+            for (int32_t y = 0; y < cells; ++y) {
+                for (int32_t x = 0; x < cells; ++x) {
+                    int32_t any = 0;
+                    for (int32_t k = 0; k < span * span * span && !any; ++k) {
+                        any = svo_find(octree, depth, x * span + k % span, y * span + k / span % span,
+                                       z * span + k / (span * span)) >= 0;
+                    }
+                    const int32_t node = svo_find(octree, level, x, y, z);
+                    nodes += node >= 0;
+                    mismatches += any != (node >= 0);
+                }
+            }
+        }
+        mismatches += nodes != octree->levels[level].node_count;
+    }
+    free(expected);
+    *out_band = band;
+    return mismatches;
+}
+
+int32_t main(void) {
+    // Check mesh: a small torus and random triangles from tiny to a quarter of the box across
+    const int32_t rings = 48;
+    const int32_t sides = 24;
+    const int32_t check_vertices = rings * sides + 3 * VOXEL_CHECK_RANDOM;
+    const int32_t check_triangles = 2 * rings * sides + VOXEL_CHECK_RANDOM;
+    // Timed tori, rings x sides vertices and twice as many triangles
+    const int32_t timed_rings[2] = { 300, 424 };
+    const int32_t timed_sides[2] = { 600, 848 };
+    const int32_t timed_vertices = timed_rings[1] * timed_sides[1];
+    CheckVertex* vertices = (CheckVertex*)malloc((size_t)timed_vertices * sizeof(CheckVertex));
+    uint32_t* triangles = (uint32_t*)malloc((size_t)timed_vertices * 6 * sizeof(uint32_t));
+    if (!vertices || !triangles) {
+        return EXIT_FAILURE;
+    }
+    bumpy_torus(vertices, triangles, rings, sides);
+    for (int32_t i = 0; i < VOXEL_CHECK_RANDOM; ++i) {
+        const vec3_t center = vec3(random_float(-1.2f, 1.2f), random_float(-1.2f, 1.2f), random_float(-0.3f, 0.3f));
+        const float size = i % 3 == 0 ? 0.005f : i % 3 == 1 ? 0.05f : 0.6f;
+        for (int32_t c = 0; c < 3; ++c) {
+            CheckVertex* vertex = &vertices[rings * sides + 3 * i + c];
+            vertex->position = vec3_add(center, vec3(random_float(-size, size), random_float(-size, size),
+                                                     random_float(-size, size)));
+            vertex->normal = vec3(0.0f, 0.0f, 1.0f);
+            triangles[6 * rings * sides + 3 * i + c] = (uint32_t)(rings * sides + 3 * i + c);
+        }
+    }
+    MeshData mesh;
+    mesh_init(&mesh, vertices, check_vertices, triangles, check_triangles);
+
+    VoxelOctree octree;
+    if (svo_build(&mesh, VOXEL_CHECK_DEPTH, &octree)) {
+        fprintf(stderr, "Failed to build the check octree\n");
+        return EXIT_FAILURE;
+    }
+    int64_t band = 0;
+    int64_t mismatches = check_octree(&mesh, &octree, &band);
+    printf("%d threads\n", par_worker_count());
+    printf("  %d^3 check, %d triangles, %d leaves: %lld mismatches, %lld cells within %.0e voxels of a triangle\n",
+           1 << VOXEL_CHECK_DEPTH, check_triangles, octree.levels[VOXEL_CHECK_DEPTH].node_count,
+           (long long)mismatches, (long long)band, VOXEL_CHECK_BAND);
+    svo_free(&octree);
+
+    // Timed builds
+    for (int32_t i = 0; i < 4; ++i) {
+        const int32_t depth = 9 + i % 2;
+        const int32_t vertex_count = timed_rings[i / 2] * timed_sides[i / 2];
+        bumpy_torus(vertices, triangles, timed_rings[i / 2], timed_sides[i / 2]);
+        mesh_init(&mesh, vertices, vertex_count, triangles, 2 * vertex_count);
+        double best = 1e30;
+        int32_t leaves = 0;
+        size_t bytes = 0;
+        for (int32_t run = 0; run < VOXEL_CHECK_RUNS; ++run) {
+            double start = now_seconds();
+            if (svo_build(&mesh, depth, &octree)) {
+                fprintf(stderr, "Failed to build the %d^3 octree\n", 1 << depth);
+                return EXIT_FAILURE;
+            }
+            double elapsed = now_seconds() - start;
+            best = elapsed < best ? elapsed : best;
+            leaves = octree.levels[depth].node_count;
+            bytes = svo_memory_size(&octree);
+            svo_free(&octree);
+        }
+        printf("  %4d^3 build, %d vertices, %d triangles: %.3f s (best of %d), %d leaves, %.1f MB\n", 1 << depth,
+               mesh.vertex_count, mesh.triangle_count, best, VOXEL_CHECK_RUNS, leaves, (double)bytes / (1 << 20));
+    }
+
+    par_shutdown();
+    free(vertices);
+    free(triangles);
+    return mismatches == 0 ? 0 : EXIT_FAILURE;
+}
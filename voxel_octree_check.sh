@@ -0,0 +1,3 @@
+gcc voxel_octree_check.c -Wall -std=c11 -O2 -march=native -o voxel_octree_check.out -lm -lrt -lpthread
+
+PAR_NUM_THREADS=1 ./voxel_octree_check.out && ./voxel_octree_check.out